@@ -31,6 +31,8 @@ class Graphics
     GLint m_viewMatrix;
     GLint m_modelMatrix;
 
+    // model matrices of the planet and moon
+    SceneGraph m_graph;
     Object *m_planet;
     Object *m_moon;
 };
@@ -3,11 +3,12 @@
 
 #include <vector>
 #include "graphics_headers.h"
+#include "scenegraph.h"
 
 class Object
 {
   public:
-    Object();
+    Object(SceneGraph * graph);
     ~Object();
     void Update(unsigned int dt);
     void Render();
@@ -18,12 +19,12 @@ class Object
     void SetPlanetOrbiting(Object * planet);
 
     glm::mat4 GetModel();
-    glm::mat4 GetTranslationMatrix();
 
   private:
-    glm::mat4 model;
-    glm::mat4 origin;
-    glm::mat4 translationMatrix;
+    // the orbit node moves around the parent's orbit node, the body node under it spins
+    SceneGraph * m_graph;
+    unsigned int m_orbit;
+    unsigned int m_body;
     std::vector<Vertex> Vertices;
     std::vector<unsigned int> Indices;
     GLuint VB;
@@ -38,8 +39,6 @@ class Object
     int rotationDirection;
     bool isRotating;
     bool isSpinning;
-    bool isMoon;
-    Object * m_planet;
 };
 
 #endif /* OBJECT_H */
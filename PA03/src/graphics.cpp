@@ -45,8 +45,8 @@ bool Graphics::Initialize(int width, int height, char * vertexShader, char * fra
   }
 
   // Create the object
-  m_planet = new Object();
-  m_moon = new Object();
+  m_planet = new Object(&m_graph);
+  m_moon = new Object(&m_graph);
   m_moon->SetPlanetOrbiting(m_planet);
 
   // Set up the shaders
@@ -114,6 +114,7 @@ void Graphics::Update(unsigned int dt)
   // Update the object
   m_planet->Update(dt);
   m_moon->Update(dt);
+  m_graph.Update();
 }
 
 void Graphics::KeyboardEvent(SDL_Keycode key) {
@@ -3,7 +3,7 @@
 
 using namespace std;
 
-Object::Object()
+Object::Object(SceneGraph * graph)
 {
   /*
     # Blender File for a Cube
@@ -64,6 +64,11 @@ Object::Object()
   }
 
   angle = 0.0f;
+  translation = 0.0f;
+
+  m_graph = graph;
+  m_orbit = m_graph->Add();
+  m_body = m_graph->Add(m_orbit);
 
   glGenBuffers(1, &VB);
   glBindBuffer(GL_ARRAY_BUFFER, VB);
@@ -77,15 +82,14 @@ Object::Object()
   rotationDirection = 1;
   isSpinning = true;
   isRotating = true;
-  origin = glm::mat4(1.0);
   radius = 10;
   spinSpeed = 1;
   rotationSpeed = 1;
 }
 
 void Object::SetPlanetOrbiting(Object * planet) {
-  m_planet = planet;
-  isMoon = true;
+  // follows the planet around its orbit, but not its spin
+  m_graph->SetParent(m_orbit, planet->m_orbit);
   spinSpeed = 0.5;
   rotationSpeed = 5;
   radius = 5;
@@ -117,30 +121,21 @@ void Object::PauseSpin(){
 
 void Object::Update(unsigned int dt)
 {
-  float multiplier = 1000;
+  // only what changed is marked, the graph recomputes the model matrices in Graphics::Update
   if(isSpinning) {
     angle += dt * M_PI/1000 * spinSpeed * spinDirection;
+    m_graph->SetRotation(m_body, glm::angleAxis(angle, glm::vec3(0.0, 1.0, 0.0)));
   }
 
   if(isRotating) {
     translation += dt * M_PI/1000 * rotationSpeed * rotationDirection;
+    m_graph->SetTranslation(m_orbit, glm::vec3(sin(translation/10) * radius, 0.0, cos(translation/10) * radius));
   }
-  translationMatrix = glm::translate(glm::vec3(sin(translation/10) * radius, 0.0, cos(translation/10) * radius));
-
-  if(isMoon) {
-    translationMatrix *= m_planet->GetTranslationMatrix();
-  }
-  model = glm::rotate(translationMatrix * origin, (angle), glm::vec3(0.0, 1.0, 0.0));
 }
 
 glm::mat4 Object::GetModel()
 {
-  return model;
-}
-
-glm::mat4 Object::GetTranslationMatrix()
-{
-  return translationMatrix;
+  return m_graph->World(m_body);
 }
 
 void Object::Render()
@@ -0,0 +1,287 @@
+
+#include "scenegraph.h"
+
+#include <chrono>
+#include <random>
+#include <cmath>
+#include <cstdio>
+#include <algorithm>
+
+// nodes per task when a level is split across threads
+static const unsigned int CHUNK = 8192;
+
+SceneGraph::SceneGraph() {
+  last_updated = 0;
+  sorted = true;
+  frame = 0;
+}
+
+unsigned int SceneGraph::Add(int p) {
+
+  unsigned int node = parent.size();
+  parent.push_back(p);
+  slot.push_back(node);
+
+  parent_slot.push_back(p >= 0 ? (int)slot[p] : -1);
+  translation.push_back(glm::vec3(0.0f));
+  rotation.push_back(glm::quat(1.0f, 0.0f, 0.0f, 0.0f));
+  scale.push_back(glm::vec3(1.0f));
+  world.push_back(glm::mat4(1.0f));
+  dirty.push_back(1);
+  stamp.push_back(0);
+
+  sorted = false;
+  return node;
+}
+
+void SceneGraph::SetParent(unsigned int node, int p) {
+
+  parent[node] = p;
+  dirty[slot[node]] = 1;
+  sorted = false;
+}
+
+void SceneGraph::Clear() {
+
+  parent.clear();
+  slot.clear();
+  parent_slot.clear();
+  translation.clear();
+  rotation.clear();
+  scale.clear();
+  world.clear();
+  dirty.clear();
+  stamp.clear();
+  levels.clear();
+  sorted = true;
+}
+
+unsigned int SceneGraph::Size() const {
+  return parent.size();
+}
+
+void SceneGraph::SetTranslation(unsigned int node, const glm::vec3& t) {
+  unsigned int s = slot[node];
+  translation[s] = t;
+  dirty[s] = 1;
+}
+
+void SceneGraph::SetRotation(unsigned int node, const glm::quat& r) {
+  unsigned int s = slot[node];
+  rotation[s] = r;
+  dirty[s] = 1;
+}
+
+void SceneGraph::SetScale(unsigned int node, const glm::vec3& sc) {
+  unsigned int s = slot[node];
+  scale[s] = sc;
+  dirty[s] = 1;
+}
+
+void SceneGraph::SetLocal(unsigned int node, const glm::vec3& t, const glm::quat& r, const glm::vec3& sc) {
+  unsigned int s = slot[node];
+  translation[s] = t;
+  rotation[s] = r;
+  scale[s] = sc;
+  dirty[s] = 1;
+}
+
+const glm::mat4& SceneGraph::World(unsigned int node) const {
+  return world[slot[node]];
+}
+
+void SceneGraph::Sort() {
+
+  unsigned int n = parent.size();
+
+  // depth of every node, walking up only as far as the first node already known
+  std::vector<int> depth(n, -1);
+  std::vector<unsigned int> chain;
+  unsigned int deepest = 0;
+  for(unsigned int i = 0; i < n; i++) {
+
+    int d = 0;
+    for(int h = i; h >= 0; h = parent[h]) {
+      if(depth[h] >= 0) {
+        d = depth[h] + 1;
+        break;
+      }
+      chain.push_back(h);
+    }
+    while(!chain.empty()) {
+      depth[chain.back()] = d++;
+      chain.pop_back();
+    }
+    deepest = std::max(deepest, (unsigned int)depth[i]);
+  }
+
+  // counting sort by depth, siblings keep the order they were added in
+  levels.assign(deepest + 2, 0);
+  for(unsigned int i = 0; i < n; i++) {
+    levels[depth[i] + 1]++;
+  }
+  for(unsigned int l = 1; l < levels.size(); l++) {
+    levels[l] += levels[l - 1];
+  }
+
+  std::vector<unsigned int> next(levels.begin(), levels.end() - 1), new_slot(n);
+  for(unsigned int i = 0; i < n; i++) {
+    new_slot[i] = next[depth[i]]++;
+  }
+
+  // move everything stored by slot to its new place
+  std::vector<glm::vec3> t(n), sc(n);
+  std::vector<glm::quat> r(n);
+  std::vector<glm::mat4> w(n);
+  std::vector<unsigned char> dt(n);
+  std::vector<unsigned int> st(n);
+  for(unsigned int i = 0; i < n; i++) {
+
+    unsigned int from = slot[i], to = new_slot[i];
+    parent_slot[to] = parent[i] >= 0 ? (int)new_slot[parent[i]] : -1;
+    t[to] = translation[from];
+    r[to] = rotation[from];
+    sc[to] = scale[from];
+    w[to] = world[from];
+    dt[to] = dirty[from];
+    st[to] = stamp[from];
+  }
+  translation.swap(t);
+  rotation.swap(r);
+  scale.swap(sc);
+  world.swap(w);
+  dirty.swap(dt);
+  stamp.swap(st);
+  slot.swap(new_slot);
+
+  sorted = true;
+}
+
+unsigned int SceneGraph::UpdateRange(unsigned int begin, unsigned int end) {
+
+  unsigned int count = 0;
+  for(unsigned int s = begin; s < end; s++) {
+
+    // parents are a level up, already done this Update
+    int p = parent_slot[s];
+    if(!dirty[s] && (p < 0 || stamp[p] != frame)) continue;
+
+    glm::mat4 local = glm::mat4_cast(rotation[s]);
+    local[0] *= scale[s].x;
+    local[1] *= scale[s].y;
+    local[2] *= scale[s].z;
+    local[3] = glm::vec4(translation[s], 1.0f);
+
+    world[s] = p < 0 ? local : world[p] * local;
+    dirty[s] = 0;
+    stamp[s] = frame;
+    count++;
+  }
+  return count;
+}
+
+void SceneGraph::Update(const ParallelFor& parallel_for) {
+
+  if(!sorted) Sort();
+
+  frame++;
+  last_updated = 0;
+
+  for(unsigned int l = 0; l + 1 < levels.size(); l++) {
+
+    unsigned int begin = levels[l], end = levels[l + 1];
+    if(!parallel_for || end - begin < 2 * CHUNK) {
+      last_updated += UpdateRange(begin, end);
+      continue;
+    }
+
+    unsigned int tasks = (end - begin + CHUNK - 1) / CHUNK;
+    std::vector<unsigned int> counts(tasks);
+    parallel_for(tasks, [&](unsigned int t) {
+      counts[t] = UpdateRange(begin + t * CHUNK, std::min(end, begin + (t + 1) * CHUNK));
+    });
+    for(unsigned int c : counts) {
+      last_updated += c;
+    }
+  }
+}
+
+void SceneGraph::Benchmark(unsigned int count, const ParallelFor& parallel_for, unsigned int frames) {
+
+  if(!count) return;
+
+  std::mt19937 rng(1);
+  std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+
+  auto random_rotation = [&]() {
+    glm::vec3 axis = glm::normalize(glm::vec3(unit(rng), unit(rng), unit(rng)) + glm::vec3(0.0f, 1e-3f, 0.0f));
+    return glm::angleAxis(unit(rng) * 3.14159265f, axis);
+  };
+
+  // eight children per node, about seven levels at a million
+  SceneGraph graph;
+  std::vector<std::vector<unsigned int>> children(count);
+  for(unsigned int i = 0; i < count; i++) {
+
+    int p = i ? (int)((i - 1) / 8) : -1;
+    graph.Add(p);
+    if(p >= 0) children[p].push_back(i);
+
+    graph.SetLocal(i, glm::vec3(unit(rng), unit(rng), unit(rng)) * 10.0f, random_rotation(), glm::vec3(1.0f + 0.1f * unit(rng)));
+  }
+  graph.Update();
+
+  auto time = [&](std::function<void()> fn) {
+    auto start = std::chrono::high_resolution_clock::now();
+    for(unsigned int f = 0; f < frames; f++) fn();
+    return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count() / frames;
+  };
+
+  // the way it used to be done, every matrix from scratch down a pointer tree
+  std::vector<glm::mat4> naive(count);
+  std::function<void(unsigned int, const glm::mat4&)> walk = [&](unsigned int node, const glm::mat4& up) {
+
+    unsigned int s = graph.slot[node];
+    glm::mat4 local = glm::translate(glm::mat4(1.0f), graph.translation[s]) * glm::mat4_cast(graph.rotation[s]) * glm::scale(glm::mat4(1.0f), graph.scale[s]);
+    naive[node] = up * local;
+    for(unsigned int c : children[node]) {
+      walk(c, naive[node]);
+    }
+  };
+  double naive_ms = time([&]() { walk(0, glm::mat4(1.0f)); });
+
+  float max_error = 0.0f;
+  for(unsigned int i = 0; i < count; i++) {
+    for(int c = 0; c < 4; c++) {
+      glm::vec4 d = naive[i][c] - graph.World(i)[c];
+      max_error = std::max(max_error, std::max(std::max(fabsf(d.x), fabsf(d.y)), std::max(fabsf(d.z), fabsf(d.w))));
+    }
+  }
+
+  // everything moved
+  auto touch_all = [&]() {
+    for(unsigned int i = 0; i < count; i++) graph.dirty[i] = 1;
+  };
+  double full_ms = time([&]() { touch_all(); graph.Update(); });
+  double full_parallel_ms = parallel_for ? time([&]() { touch_all(); graph.Update(parallel_for); }) : 0.0;
+
+  // a handful moved, mostly leaves like most nodes are
+  unsigned int moved = std::max(1u, count / 100), updated = 0;
+  std::uniform_int_distribution<unsigned int> any(0, count - 1);
+  double some_ms = time([&]() {
+    for(unsigned int m = 0; m < moved; m++) {
+      graph.SetRotation(any(rng), random_rotation());
+    }
+    graph.Update(parallel_for);
+    updated = graph.last_updated;
+  });
+
+  printf("%u nodes, %u levels, %u frames\n", count, (unsigned int)graph.levels.size() - 1, frames);
+  printf("  recursive from scratch: %8.3f ms\n", naive_ms);
+  printf("  flat, all changed:      %8.3f ms\n", full_ms);
+  if(parallel_for) {
+    printf("  flat, all changed, mt:  %8.3f ms\n", full_parallel_ms);
+  }
+  printf("  flat, %u changed:    %8.3f ms (%u matrices)\n", moved, some_ms, updated);
+  printf("  largest difference from recursive: %g\n", max_error);
+}
@@ -0,0 +1,30 @@
+#ifndef OBJLOADER_H
+#define OBJLOADER_H
+
+#include <vector>
+#include "graphics_headers.h"
+
+// Wavefront OBJ reader. The file is mapped into memory and split into
+// line-aligned chunks that are parsed on their own threads, then identical
+// v/vt/vn corners are merged into one vertex.
+class ObjLoader
+{
+  public:
+    struct Mesh
+    {
+      // one entry per unique vertex - texcoords / normals are empty if the file has none
+      std::vector<glm::vec3> positions;
+      std::vector<glm::vec2> texcoords;
+      std::vector<glm::vec3> normals;
+      // polygons are fanned into triangles, 3 indices each
+      std::vector<unsigned int> indices;
+    };
+
+    // threads = 0 uses every core
+    static bool Load(const char * objectFile, Mesh & mesh, unsigned int threads = 0);
+
+    // write a grid x grid quad OBJ with texcoords and normals, time loading it, print MB/s
+    static void Benchmark(unsigned int grid);
+};
+
+#endif /* OBJLOADER_H */
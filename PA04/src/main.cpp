@@ -1,6 +1,8 @@
 #include <iostream>
+#include <cstdlib>
 
 #include "engine.h"
+#include "objloader.h"
 
 
 int main(int argc, char **argv)
@@ -25,6 +27,12 @@ int main(int argc, char **argv)
 			model = argv[i+1];
 			modelGiven = true;
 		}
+
+		// time the OBJ parser on a generated grid and quit
+		if(string(argv[i]) == "-b" && i + 1 < argc) {
+			ObjLoader::Benchmark(atoi(argv[i+1]));
+			return 0;
+		}
 	}
 	Engine * engine;
 	if(modelGiven){
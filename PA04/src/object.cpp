@@ -1,6 +1,6 @@
 #include "object.h"
+#include "objloader.h"
 #include <math.h>
-#include <fstream>
 
 using namespace std;
 
@@ -27,42 +27,19 @@ Object::~Object()
 }
 
 bool Object::LoadModel(char * objectFile) {
-  ifstream fin(objectFile);
-  string line;
-  while(!fin.eof()) {
-    char firstLetter;
-    fin >> ws;
-		fin >> firstLetter;
-    if(firstLetter == 'v') {
-      cout << "Vertex" << endl;
-      float x, y, z;
-      fin >> x;
-      fin >> y;
-      fin >> z;
-      glm::vec3 tempVertex = glm::vec3(x, y, z);
-      cout << "(" << tempVertex.x << ", " << tempVertex.y << ", " << tempVertex.z << ")" << endl;
-      glm::vec3 tempColor = glm::vec3(x, y, z);
-      Vertex temp = Vertex(tempVertex, tempColor);
-      Vertices.push_back(temp);
-    }else if(firstLetter == 'f') {
-      cout << "Face" << endl;
-      unsigned int temp;
-      fin >> temp;
-      cout << "(" << temp;
-      Indices.push_back(temp-1);
-      fin >> temp;
-      cout << ", " << temp;
-      Indices.push_back(temp-1);
-      fin >> temp;
-      cout << ", " << temp << ")" << endl;
-      Indices.push_back(temp-1);
-    }else {
-      string s;
-      getline(fin, s);
-    }
-    fin >> ws;
-	}
-  fin.close();
+  ObjLoader::Mesh mesh;
+  if(!ObjLoader::Load(objectFile, mesh)) {
+    return false;
+  }
+
+  // color the model by its position
+  Vertices.reserve(mesh.positions.size());
+  for(const glm::vec3 & position : mesh.positions) {
+    Vertices.push_back(Vertex(position, position));
+  }
+  Indices.swap(mesh.indices);
+
+  cout << objectFile << ": " << Vertices.size() << " vertices, " << Indices.size() / 3 << " triangles" << endl;
   return true;
 }
 
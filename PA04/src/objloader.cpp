@@ -0,0 +1,483 @@
+#include "objloader.h"
+#include <cmath>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using namespace std;
+
+namespace
+{
+  // one polygon corner as written in the file
+  struct Corner
+  {
+    int v, vt, vn;
+  };
+
+  // set on a Corner component that was a negative (relative) index - it then
+  // holds the chunk-local position and the chunk's offset is added later
+  const unsigned char REL_V = 1, REL_VT = 2, REL_VN = 4;
+
+  struct Chunk
+  {
+    const char * begin;
+    const char * end;
+
+    vector<glm::vec3> positions;
+    vector<glm::vec2> texcoords;
+    vector<glm::vec3> normals;
+
+    vector<Corner> corners;
+    vector<unsigned char> relative;
+    // number of corners of each polygon
+    vector<unsigned int> polygons;
+
+    // where this chunk's v / vt / vn start in the whole file
+    int v_offset, vt_offset, vn_offset;
+
+    // resolved, 0-based, fanned into triangles; -1 for a missing vt / vn
+    vector<Corner> triangles;
+
+    bool ok;
+    string error;
+  };
+
+  inline bool IsSpace(char c)
+  {
+    return c == ' ' || c == '\t' || c == '\r';
+  }
+
+  inline const char * SkipSpace(const char * p, const char * end)
+  {
+    while(p < end && IsSpace(*p)) p++;
+    return p;
+  }
+
+  // [+-]digits[.digits][(e|E)[+-]digits] - no locale, no iostream
+  const char * ParseFloat(const char * p, const char * end, float & out)
+  {
+    static const double pow10[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+                                   1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+    p = SkipSpace(p, end);
+    const char * start = p;
+
+    bool negative = false;
+    if(p < end && (*p == '-' || *p == '+')) {
+      negative = *p++ == '-';
+    }
+
+    unsigned long long mantissa = 0;
+    int exponent = 0, digits = 0;
+
+    for(; p < end && *p >= '0' && *p <= '9'; p++, digits++) {
+      if(mantissa < 1000000000000000000ull) mantissa = mantissa * 10 + (*p - '0');
+      else exponent++;
+    }
+    if(p < end && *p == '.') {
+      for(p++; p < end && *p >= '0' && *p <= '9'; p++, digits++) {
+        if(mantissa < 1000000000000000000ull) {
+          mantissa = mantissa * 10 + (*p - '0');
+          exponent--;
+        }
+      }
+    }
+    if(!digits) {
+      return start;
+    }
+
+    if(p < end && (*p == 'e' || *p == 'E')) {
+      const char * e = p + 1;
+      bool e_negative = false;
+      if(e < end && (*e == '-' || *e == '+')) {
+        e_negative = *e++ == '-';
+      }
+      if(e < end && *e >= '0' && *e <= '9') {
+        int value = 0;
+        for(; e < end && *e >= '0' && *e <= '9'; e++) {
+          if(value < 10000) value = value * 10 + (*e - '0');
+        }
+        exponent += e_negative ? -value : value;
+        p = e;
+      }
+    }
+
+    double value = (double)mantissa;
+    if(exponent < 0) {
+      value = -exponent <= 22 ? value / pow10[-exponent] : value * pow(10.0, exponent);
+    } else if(exponent > 0) {
+      value = exponent <= 22 ? value * pow10[exponent] : value * pow(10.0, exponent);
+    }
+
+    out = (float)(negative ? -value : value);
+    return p;
+  }
+
+  const char * ParseInt(const char * p, const char * end, int & out)
+  {
+    const char * start = p;
+
+    bool negative = false;
+    if(p < end && *p == '-') {
+      negative = true;
+      p++;
+    }
+
+    int value = 0;
+    const char * digits = p;
+    for(; p < end && *p >= '0' && *p <= '9'; p++) {
+      value = value * 10 + (*p - '0');
+    }
+    if(p == digits) {
+      return start;
+    }
+
+    out = negative ? -value : value;
+    return p;
+  }
+
+  // a face index as written: 1-based, or negative counting back from the last one so far
+  bool Index(int raw, size_t count, int & out, unsigned char & relative, unsigned char flag)
+  {
+    if(raw > 0) {
+      out = raw;
+    } else if(raw < 0) {
+      out = (int)count + raw;
+      relative |= flag;
+    } else {
+      return false;
+    }
+    return true;
+  }
+
+  void ParseChunk(Chunk & c)
+  {
+    const char * p = c.begin;
+    const char * end = c.end;
+    c.ok = true;
+
+    while(p < end) {
+
+      p = SkipSpace(p, end);
+      const char * line_end = (const char *)memchr(p, '\n', end - p);
+      if(!line_end) line_end = end;
+
+      if(line_end - p >= 2 && p[0] == 'v' && IsSpace(p[1])) {
+
+        glm::vec3 v(0.0f);
+        const char * q = ParseFloat(p + 2, line_end, v.x);
+        q = ParseFloat(q, line_end, v.y);
+        q = ParseFloat(q, line_end, v.z);
+        c.positions.push_back(v);
+
+      } else if(line_end - p >= 3 && p[0] == 'v' && p[1] == 't' && IsSpace(p[2])) {
+
+        glm::vec2 vt(0.0f);
+        const char * q = ParseFloat(p + 3, line_end, vt.x);
+        q = ParseFloat(q, line_end, vt.y);
+        c.texcoords.push_back(vt);
+
+      } else if(line_end - p >= 3 && p[0] == 'v' && p[1] == 'n' && IsSpace(p[2])) {
+
+        glm::vec3 vn(0.0f);
+        const char * q = ParseFloat(p + 3, line_end, vn.x);
+        q = ParseFloat(q, line_end, vn.y);
+        q = ParseFloat(q, line_end, vn.z);
+        c.normals.push_back(vn);
+
+      } else if(line_end - p >= 2 && p[0] == 'f' && IsSpace(p[1])) {
+
+        // v, v/vt, v//vn or v/vt/vn per corner
+        unsigned int count = 0;
+        const char * q = SkipSpace(p + 2, line_end);
+        // a comment can follow the last corner
+        while(q < line_end && *q != '#') {
+
+          Corner corner = {0, 0, 0};
+          unsigned char relative = 0;
+          int raw = 0;
+
+          const char * next = ParseInt(q, line_end, raw);
+          if(next == q || !Index(raw, c.positions.size(), corner.v, relative, REL_V)) {
+            c.ok = false;
+            c.error = "bad face: " + string(p, line_end);
+            return;
+          }
+          q = next;
+
+          if(q < line_end && *q == '/') {
+            q++;
+            // no digits after a slash means no index, not the one before it again
+            next = ParseInt(q, line_end, raw);
+            if(next != q) {
+              Index(raw, c.texcoords.size(), corner.vt, relative, REL_VT);
+              q = next;
+            }
+            if(q < line_end && *q == '/') {
+              q++;
+              next = ParseInt(q, line_end, raw);
+              if(next != q) {
+                Index(raw, c.normals.size(), corner.vn, relative, REL_VN);
+                q = next;
+              }
+            }
+          }
+
+          c.corners.push_back(corner);
+          c.relative.push_back(relative);
+          count++;
+
+          q = SkipSpace(q, line_end);
+        }
+
+        if(count < 3) {
+          c.ok = false;
+          c.error = "face with fewer than 3 corners: " + string(p, line_end);
+          return;
+        }
+        c.polygons.push_back(count);
+      }
+
+      // comments, groups, materials, smoothing groups are skipped
+      p = line_end + 1;
+    }
+  }
+
+  // make indices global and 0-based, check them, fan polygons into triangles
+  void ResolveChunk(Chunk & c, int positions, int texcoords, int normals)
+  {
+    if(!c.ok) return;
+
+    for(size_t i = 0; i < c.corners.size(); i++) {
+
+      Corner & corner = c.corners[i];
+      unsigned char relative = c.relative[i];
+
+      corner.v = relative & REL_V ? c.v_offset + corner.v : corner.v - 1;
+      corner.vt = relative & REL_VT ? c.vt_offset + corner.vt : corner.vt - 1;
+      corner.vn = relative & REL_VN ? c.vn_offset + corner.vn : corner.vn - 1;
+
+      if(corner.v < 0 || corner.v >= positions || corner.vt < -1 || corner.vt >= texcoords || corner.vn < -1 || corner.vn >= normals) {
+        c.ok = false;
+        c.error = "face index out of range";
+        return;
+      }
+    }
+
+    size_t first = 0;
+    for(unsigned int count : c.polygons) {
+      for(unsigned int i = 1; i + 1 < count; i++) {
+        c.triangles.push_back(c.corners[first]);
+        c.triangles.push_back(c.corners[first + i]);
+        c.triangles.push_back(c.corners[first + i + 1]);
+      }
+      first += count;
+    }
+  }
+
+  inline unsigned int Hash(const Corner & c)
+  {
+    unsigned int h = (unsigned int)c.v * 73856093u ^ (unsigned int)c.vt * 19349663u ^ (unsigned int)c.vn * 83492791u;
+    h ^= h >> 16;
+    h *= 0x85ebca6bu;
+    h ^= h >> 13;
+    return h;
+  }
+
+  template<typename T>
+  void Append(vector<T> & out, const vector<T> & in)
+  {
+    out.insert(out.end(), in.begin(), in.end());
+  }
+}
+
+bool ObjLoader::Load(const char * objectFile, Mesh & mesh, unsigned int threads)
+{
+  mesh = Mesh();
+
+  int fd = open(objectFile, O_RDONLY);
+  if(fd < 0) {
+    cerr << "Unable to open " << objectFile << endl;
+    return false;
+  }
+
+  struct stat st;
+  if(fstat(fd, &st) != 0) {
+    close(fd);
+    return false;
+  }
+  size_t size = st.st_size;
+  if(!size) {
+    close(fd);
+    return true;
+  }
+
+  void * mapped = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if(mapped == MAP_FAILED) {
+    cerr << "Unable to map " << objectFile << endl;
+    return false;
+  }
+  madvise(mapped, size, MADV_SEQUENTIAL);
+
+  const char * data = (const char *)mapped;
+  const char * data_end = data + size;
+
+  if(!threads) threads = max(1u, thread::hardware_concurrency());
+  // not worth a thread per 64 KB
+  threads = max(1u, min(threads, (unsigned int)(size >> 16) + 1));
+
+  // cut at line boundaries
+  vector<Chunk> chunks(threads);
+  const char * p = data;
+  for(unsigned int i = 0; i < threads; i++) {
+    chunks[i].begin = p;
+    if(i + 1 == threads) {
+      p = data_end;
+    } else {
+      p = max(p, data + size / threads * (i + 1));
+      const char * nl = (const char *)memchr(p, '\n', data_end - p);
+      p = nl ? nl + 1 : data_end;
+    }
+    chunks[i].end = p;
+  }
+
+  vector<thread> workers;
+  for(unsigned int i = 1; i < threads; i++) {
+    workers.push_back(thread(ParseChunk, ref(chunks[i])));
+  }
+  ParseChunk(chunks[0]);
+  for(auto & t : workers) t.join();
+  workers.clear();
+
+  // every chunk's vertex data starts where the previous one's ended
+  int positions = 0, texcoords = 0, normals = 0;
+  for(auto & c : chunks) {
+    c.v_offset = positions;
+    c.vt_offset = texcoords;
+    c.vn_offset = normals;
+    positions += c.positions.size();
+    texcoords += c.texcoords.size();
+    normals += c.normals.size();
+  }
+
+  for(unsigned int i = 1; i < threads; i++) {
+    workers.push_back(thread(ResolveChunk, ref(chunks[i]), positions, texcoords, normals));
+  }
+  ResolveChunk(chunks[0], positions, texcoords, normals);
+  for(auto & t : workers) t.join();
+
+  munmap(mapped, size);
+
+  vector<glm::vec3> all_positions, all_normals;
+  vector<glm::vec2> all_texcoords;
+  size_t corners = 0;
+
+  for(auto & c : chunks) {
+    if(!c.ok) {
+      cerr << objectFile << ": " << c.error << endl;
+      return false;
+    }
+    Append(all_positions, c.positions);
+    Append(all_texcoords, c.texcoords);
+    Append(all_normals, c.normals);
+    corners += c.triangles.size();
+  }
+
+  // merge identical v/vt/vn tuples - open addressing, at most one vertex per corner
+  size_t capacity = 16;
+  while(capacity < corners * 2) capacity <<= 1;
+  vector<int> table(capacity, -1);
+  vector<Corner> unique;
+
+  mesh.indices.reserve(corners);
+  for(auto & c : chunks) {
+    for(const Corner & corner : c.triangles) {
+
+      size_t slot = Hash(corner) & (capacity - 1);
+      while(table[slot] >= 0) {
+        const Corner & other = unique[table[slot]];
+        if(other.v == corner.v && other.vt == corner.vt && other.vn == corner.vn) break;
+        slot = (slot + 1) & (capacity - 1);
+      }
+
+      if(table[slot] < 0) {
+        table[slot] = unique.size();
+        unique.push_back(corner);
+      }
+      mesh.indices.push_back(table[slot]);
+    }
+  }
+
+  mesh.positions.reserve(unique.size());
+  for(const Corner & corner : unique) {
+    mesh.positions.push_back(all_positions[corner.v]);
+  }
+  if(!all_texcoords.empty()) {
+    mesh.texcoords.reserve(unique.size());
+    for(const Corner & corner : unique) {
+      mesh.texcoords.push_back(corner.vt >= 0 ? all_texcoords[corner.vt] : glm::vec2(0.0f));
+    }
+  }
+  if(!all_normals.empty()) {
+    mesh.normals.reserve(unique.size());
+    for(const Corner & corner : unique) {
+      mesh.normals.push_back(corner.vn >= 0 ? all_normals[corner.vn] : glm::vec3(0.0f));
+    }
+  }
+
+  return true;
+}
+
+void ObjLoader::Benchmark(unsigned int grid)
+{
+  const char * file = "objloader_benchmark.obj";
+
+  FILE * out = fopen(file, "w");
+  if(!out) {
+    cerr << "Unable to write " << file << endl;
+    return;
+  }
+
+  for(unsigned int y = 0; y <= grid; y++) {
+    for(unsigned int x = 0; x <= grid; x++) {
+      float u = (float)x / grid, v = (float)y / grid;
+      fprintf(out, "v %f %f %f\n", u * 2.0f - 1.0f, sinf(u * 6.2831853f) * cosf(v * 6.2831853f) * 0.1f, v * 2.0f - 1.0f);
+      fprintf(out, "vt %f %f\n", u, v);
+      fprintf(out, "vn 0.000000 1.000000 0.000000\n");
+    }
+  }
+  for(unsigned int y = 0; y < grid; y++) {
+    for(unsigned int x = 0; x < grid; x++) {
+      unsigned int a = y * (grid + 1) + x + 1, b = a + 1, c = a + grid + 2, d = a + grid + 1;
+      fprintf(out, "f %u/%u/%u %u/%u/%u %u/%u/%u %u/%u/%u\n", a, a, a, b, b, b, c, c, c, d, d, d);
+    }
+  }
+
+  long bytes = ftell(out);
+  fclose(out);
+
+  unsigned int cores = max(1u, thread::hardware_concurrency());
+  for(unsigned int threads = 1; ; threads = min(threads * 2, cores)) {
+
+    Mesh mesh;
+    auto start = chrono::high_resolution_clock::now();
+    bool ok = Load(file, mesh, threads);
+    double ms = chrono::duration<double, milli>(chrono::high_resolution_clock::now() - start).count();
+
+    if(!ok) break;
+
+    printf("%u threads: %.1f MB in %.1f ms, %.1f MB/s (%zu vertices, %zu triangles)\n",
+           threads, bytes / 1048576.0, ms, bytes / 1048576.0 / (ms / 1000.0), mesh.positions.size(), mesh.indices.size() / 3);
+
+    if(threads == cores) break;
+  }
+
+  remove(file);
+}
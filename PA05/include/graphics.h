@@ -23,8 +23,6 @@ public:
 	void EvtCamera(int dx, int dy);
 
 private:
-	GLuint VAO;
-
 	std::string ErrorString(GLenum error);
 
 	Camera *m_camera;
@@ -33,6 +31,7 @@ private:
 	
 	std::string scene_path;
 	bool load_failed;
+	bool optimize_meshes;
 
 	GLint m_projectionMatrix;
 	GLint m_viewMatrix;
@@ -12,22 +12,35 @@ public:
 	Scene(std::string file);
 	~Scene();
 
-	bool Load(std::string file);
+	// optimize reorders each mesh for the vertex cache / overdraw / fetches, merges small
+	// meshes sharing a material and uses 16-bit indices where they fit
+	bool Load(std::string file, bool optimize = true);
 	void Render();
 	void Clear();
 
 private:
 
+	// meshes with fewer vertices than this are merged with others of the same material
+	static const unsigned int MERGE_MAX_VERTICES = 4096;
+
 	struct Mesh {
 
-		GLuint VBO, IBO;
+		// VAO holds the buffer bindings and attribute layout, configured once at load
+		GLuint VAO, VBO, IBO;
 
 		std::vector<Vertex> 		vertices;
 		std::vector<unsigned int> 	indices; 
 
+		// what is actually in IBO - GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+		GLenum index_type;
+		GLsizei num_indices;
+
 		unsigned int material;
 	};
 
+	// create the buffers for m, from its vertices / indices
+	void Upload(Mesh& m, bool short_indices);
+
 	std::vector<Mesh> meshes;
 };
 
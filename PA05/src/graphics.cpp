@@ -1,5 +1,6 @@
 
 #include "graphics.h"
+#include "glstate.h"
 #include <imgui.h>
 
 Graphics::Graphics() {
@@ -8,6 +9,7 @@ Graphics::Graphics() {
 	m_shader = nullptr;
 	m_scene = nullptr;
 	load_failed = false;
+	optimize_meshes = true;
 }
 
 Graphics::~Graphics() {
@@ -29,8 +31,6 @@ Graphics::~Graphics() {
 		delete m_scene;
 		m_scene = nullptr;
 	}
-
-	glDeleteVertexArrays(1, &VAO);
 }
 
 bool Graphics::Initialize(int width, int height, std::vector<std::string> args) {
@@ -50,10 +50,6 @@ bool Graphics::Initialize(int width, int height, std::vector<std::string> args)
 		return false;
 	}
 
-	// For OpenGL 3
-	glGenVertexArrays(1, &VAO);
-	glBindVertexArray(VAO);
-
 	// Init Camera
 	m_camera = new Camera();
 
@@ -61,8 +57,9 @@ bool Graphics::Initialize(int width, int height, std::vector<std::string> args)
 	scene_path = args.size() ? args[0] : "../data/box.obj";
 	scene_path.resize(200);
 
+	// the path is padded with NULs for the text box, only what's before them is the file name
 	m_scene = new Scene();
-	if(!m_scene->Load(scene_path)) {
+	if(!m_scene->Load(scene_path.c_str(), optimize_meshes)) {
 
 		printf("Scene failed to Initialize\n");
 		return false;
@@ -123,7 +120,7 @@ bool Graphics::Initialize(int width, int height, std::vector<std::string> args)
 	}
 	
 	//enable depth testing
-	glEnable(GL_DEPTH_TEST);
+	GLState::Enable(GL_DEPTH_TEST, true);
 	glDepthFunc(GL_LESS);
 	
 	return true;
@@ -132,15 +129,17 @@ bool Graphics::Initialize(int width, int height, std::vector<std::string> args)
 void Graphics::Update(unsigned int dt) {
 	
 	ImGui::SetNextWindowPos(ImVec2(20, 20));
-	ImGui::SetNextWindowSize(ImVec2(250, 100));
+	ImGui::SetNextWindowSize(ImVec2(250, 140));
 	ImGui::Begin("Menu", nullptr, ImGuiWindowFlags_NoSavedSettings);
 	ImGui::InputText("File", (char*)scene_path.data(), 200);
+	ImGui::Checkbox("Optimize meshes", &optimize_meshes);
 	if(ImGui::Button("Load")) {
-		load_failed = !m_scene->Load(scene_path);
+		load_failed = !m_scene->Load(scene_path.c_str(), optimize_meshes);
 	}
 	if(load_failed) {
 		ImGui::Text("Failed to load model!");
 	}
+	ImGui::Text("GL state changes: %u (%u skipped)", GLState::last_changes, GLState::last_skipped);
 	ImGui::End();
 }
 
@@ -150,13 +149,13 @@ void Graphics::EvtCamera(int dx, int dy) {
 
 void Graphics::Render(int w, int h) {
   
+	GLState::ResetCounters();
+
 	//clear the screen
 	glClearColor(0.0, 0.0, 0.2, 1.0);
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 	
-	glDisable(GL_BLEND);
-
-	glBindVertexArray(VAO);
+	GLState::Enable(GL_BLEND, false);
 
 	// Start the correct program
 	m_shader->Enable();
@@ -0,0 +1,299 @@
+
+#include "meshoptimizer.h"
+
+#include <cmath>
+#include <algorithm>
+
+// LRU cache the Forsyth scores are tuned for - larger than any real one so it
+// works well across hardware
+static const int FORSYTH_CACHE = 32;
+
+static float VertexScore(int cache_pos, unsigned int remaining) {
+
+	// nothing left to draw with this vertex
+	if(!remaining) return -1.0f;
+
+	float score = 0.0f;
+	if(cache_pos >= 0) {
+		// used by the triangle just emitted - a fixed score so strips don't run away in one direction
+		if(cache_pos < 3) score = 0.75f;
+		else score = powf(1.0f - (cache_pos - 3) / (float)(FORSYTH_CACHE - 3), 1.5f);
+	}
+
+	// favour finishing off vertices with few triangles left, so they don't get stranded
+	return score + 2.0f / sqrtf((float)remaining);
+}
+
+// FIFO cache simulation; a vertex is cached if it was loaded within the last cache_size misses
+struct FifoCache {
+
+	FifoCache(size_t num_vertices, unsigned int size) : stamps(num_vertices, 0), size(size), time(size + 1) {}
+
+	// true if v had to be transformed
+	bool Miss(unsigned int v) {
+		if(time - stamps[v] > size) {
+			stamps[v] = time++;
+			return true;
+		}
+		return false;
+	}
+
+	// everything is evicted
+	void Flush() {
+		time += size + 1;
+	}
+
+	std::vector<unsigned int> stamps;
+	unsigned int size, time;
+};
+
+MeshOptimizer::Stats MeshOptimizer::Analyze(const std::vector<unsigned int>& indices, size_t num_vertices, unsigned int cache_size) {
+
+	Stats s = {0.0f, 0.0f};
+	if(indices.empty()) return s;
+
+	FifoCache cache(num_vertices, cache_size);
+	std::vector<bool> used(num_vertices, false);
+
+	unsigned int misses = 0, unique = 0;
+	for(unsigned int v : indices) {
+		misses += cache.Miss(v);
+		if(!used[v]) {
+			used[v] = true;
+			unique++;
+		}
+	}
+
+	s.acmr = (float)misses / (indices.size() / 3);
+	s.atvr = (float)misses / unique;
+	return s;
+}
+
+void MeshOptimizer::Optimize(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices, float threshold) {
+
+	OptimizeVertexCache(indices, vertices.size());
+	OptimizeOverdraw(indices, vertices, threshold);
+	OptimizeVertexFetch(vertices, indices);
+}
+
+void MeshOptimizer::OptimizeVertexCache(std::vector<unsigned int>& indices, size_t num_vertices) {
+
+	size_t num_tris = indices.size() / 3;
+	if(!num_tris) return;
+
+	// triangles using each vertex; the first live[v] entries are the ones not emitted yet
+	std::vector<unsigned int> live(num_vertices, 0), offsets(num_vertices + 1, 0);
+	for(unsigned int v : indices) live[v]++;
+	for(size_t v = 0; v < num_vertices; v++) offsets[v + 1] = offsets[v] + live[v];
+
+	std::vector<unsigned int> adjacency(indices.size());
+	{
+		std::vector<unsigned int> cursor(offsets.begin(), offsets.end() - 1);
+		for(size_t i = 0; i < indices.size(); i++) {
+			adjacency[cursor[indices[i]]++] = i / 3;
+		}
+	}
+
+	std::vector<int> cache_pos(num_vertices, -1);
+	std::vector<float> vertex_score(num_vertices);
+	for(size_t v = 0; v < num_vertices; v++) {
+		vertex_score[v] = VertexScore(-1, live[v]);
+	}
+
+	std::vector<float> tri_score(num_tris);
+	std::vector<bool> emitted(num_tris, false);
+
+	int best = 0;
+	for(size_t t = 0; t < num_tris; t++) {
+		tri_score[t] = vertex_score[indices[t * 3]] + vertex_score[indices[t * 3 + 1]] + vertex_score[indices[t * 3 + 2]];
+		if(tri_score[t] > tri_score[best]) best = t;
+	}
+
+	std::vector<unsigned int> out;
+	out.reserve(indices.size());
+
+	std::vector<unsigned int> cache, next_cache;
+	cache.reserve(FORSYTH_CACHE + 3);
+	next_cache.reserve(FORSYTH_CACHE + 3);
+
+	size_t scan = 0;
+	for(size_t n = 0; n < num_tris; n++) {
+
+		// nothing in the cache touches a live triangle - start again from the first one left
+		if(best < 0) {
+			while(emitted[scan]) scan++;
+			best = scan;
+		}
+
+		const unsigned int* tri = &indices[best * 3];
+		out.insert(out.end(), tri, tri + 3);
+		emitted[best] = true;
+
+		// the triangle's vertices move to the front, everything else shifts back
+		next_cache.assign(tri, tri + 3);
+		for(unsigned int v : cache) {
+			if(v != tri[0] && v != tri[1] && v != tri[2]) next_cache.push_back(v);
+		}
+
+		for(int i = 0; i < 3; i++) {
+			unsigned int v = tri[i];
+			unsigned int* adj = &adjacency[offsets[v]];
+			for(unsigned int j = 0; j < live[v]; j++) {
+				if(adj[j] == (unsigned int)best) {
+					std::swap(adj[j], adj[live[v] - 1]);
+					live[v]--;
+					break;
+				}
+			}
+		}
+
+		// rescore everything that moved, including what just fell out of the cache
+		for(size_t i = 0; i < next_cache.size(); i++) {
+			unsigned int v = next_cache[i];
+			cache_pos[v] = i < FORSYTH_CACHE ? i : -1;
+
+			float score = VertexScore(cache_pos[v], live[v]);
+			float diff = score - vertex_score[v];
+			vertex_score[v] = score;
+
+			for(unsigned int j = 0; j < live[v]; j++) {
+				tri_score[adjacency[offsets[v] + j]] += diff;
+			}
+		}
+
+		// the next triangle is the best one touching the cache
+		best = -1;
+		float best_score = -1.0f;
+		if(next_cache.size() > FORSYTH_CACHE) next_cache.resize(FORSYTH_CACHE);
+
+		for(unsigned int v : next_cache) {
+			for(unsigned int j = 0; j < live[v]; j++) {
+				unsigned int t = adjacency[offsets[v] + j];
+				if(tri_score[t] > best_score) {
+					best_score = tri_score[t];
+					best = t;
+				}
+			}
+		}
+
+		cache.swap(next_cache);
+	}
+
+	indices.swap(out);
+}
+
+void MeshOptimizer::OptimizeOverdraw(std::vector<unsigned int>& indices, const std::vector<Vertex>& vertices, float threshold) {
+
+	size_t num_tris = indices.size() / 3;
+	if(!num_tris) return;
+
+	FifoCache cache(vertices.size(), 16);
+
+	// hard boundaries - a triangle missing on all three vertices starts from a cold cache anyway,
+	// so the order can be broken there for free
+	std::vector<size_t> hard;
+	for(size_t t = 0; t < num_tris; t++) {
+		unsigned int misses = cache.Miss(indices[t * 3]) + cache.Miss(indices[t * 3 + 1]) + cache.Miss(indices[t * 3 + 2]);
+		if(t == 0 || misses == 3) hard.push_back(t);
+	}
+	hard.push_back(num_tris);
+
+	// soft boundaries - split again wherever the run so far is already within threshold of
+	// its cluster's ACMR, giving the sort more freedom at a small cost in cache hits
+	std::vector<size_t> clusters;
+	for(size_t c = 0; c + 1 < hard.size(); c++) {
+
+		size_t start = hard[c], end = hard[c + 1];
+
+		cache.Flush();
+		unsigned int misses = 0;
+		for(size_t t = start; t < end; t++) {
+			misses += cache.Miss(indices[t * 3]) + cache.Miss(indices[t * 3 + 1]) + cache.Miss(indices[t * 3 + 2]);
+		}
+		float target = (float)misses / (end - start) * threshold;
+
+		cache.Flush();
+		misses = 0;
+		for(size_t t = start; t < end; t++) {
+			if(t == start) clusters.push_back(t);
+
+			misses += cache.Miss(indices[t * 3]) + cache.Miss(indices[t * 3 + 1]) + cache.Miss(indices[t * 3 + 2]);
+
+			if(t + 1 < end && (float)misses / (t - start + 1) <= target) {
+				cache.Flush();
+				misses = 0;
+				start = t + 1;
+			}
+		}
+	}
+	clusters.push_back(num_tris);
+
+	size_t num_clusters = clusters.size() - 1;
+
+	// area weighted centroid and normal of every cluster, and of the whole mesh
+	std::vector<glm::vec3> centroids(num_clusters), normals(num_clusters);
+	glm::vec3 mesh_centroid(0.0f);
+	float mesh_area = 0.0f;
+
+	for(size_t c = 0; c < num_clusters; c++) {
+
+		glm::vec3 centroid(0.0f), normal(0.0f);
+		float area = 0.0f;
+
+		for(size_t t = clusters[c]; t < clusters[c + 1]; t++) {
+			const glm::vec3& a = vertices[indices[t * 3]].pos;
+			const glm::vec3& b = vertices[indices[t * 3 + 1]].pos;
+			const glm::vec3& d = vertices[indices[t * 3 + 2]].pos;
+
+			glm::vec3 n = glm::cross(b - a, d - a);
+			float tri_area = glm::length(n);
+
+			centroid += (a + b + d) * (tri_area / 3.0f);
+			normal += n;
+			area += tri_area;
+		}
+
+		mesh_centroid += centroid;
+		mesh_area += area;
+
+		centroids[c] = area > 0.0f ? centroid / area : centroid;
+		float len = glm::length(normal);
+		normals[c] = len > 0.0f ? normal / len : normal;
+	}
+
+	if(mesh_area > 0.0f) mesh_centroid /= mesh_area;
+
+	// clusters on the outside facing out occlude the rest, draw them first
+	std::vector<float> keys(num_clusters);
+	std::vector<size_t> order(num_clusters);
+	for(size_t c = 0; c < num_clusters; c++) {
+		keys[c] = glm::dot(centroids[c] - mesh_centroid, normals[c]);
+		order[c] = c;
+	}
+	std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return keys[a] > keys[b]; });
+
+	std::vector<unsigned int> out;
+	out.reserve(indices.size());
+	for(size_t c : order) {
+		out.insert(out.end(), indices.begin() + clusters[c] * 3, indices.begin() + clusters[c + 1] * 3);
+	}
+
+	indices.swap(out);
+}
+
+void MeshOptimizer::OptimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices) {
+
+	std::vector<unsigned int> remap(vertices.size(), ~0u);
+	std::vector<Vertex> out;
+	out.reserve(vertices.size());
+
+	for(unsigned int& v : indices) {
+		if(remap[v] == ~0u) {
+			remap[v] = out.size();
+			out.push_back(vertices[v]);
+		}
+		v = remap[v];
+	}
+
+	vertices.swap(out);
+}
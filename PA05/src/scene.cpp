@@ -1,10 +1,10 @@
 
 #include "scene.h"
+#include "glstate.h"
+#include "cookedmodel.h"
+#include "meshoptimizer.h"
 
-#include <assimp/Importer.hpp> 		//includes the importer, which is used to read our obj file
-#include <assimp/scene.h> 			//includes the aiScene object
-#include <assimp/postprocess.h> 	//includes the postprocessing variables for the importer
-#include <assimp/color4.h> 			//includes the aiColor4 object, which is used to handle the colors from the Scene objects
+#include <chrono>
 
 Scene::Scene() {}
 
@@ -18,73 +18,92 @@ Scene::~Scene() {
 
 void Scene::Clear() {
 	for(auto& m : meshes) {
+		GLState::DeleteVertexArray(m.VAO);
 		glDeleteBuffers(1, &m.VBO);
 		glDeleteBuffers(1, &m.IBO);
 	}
 	meshes.clear();
 }
 
-bool Scene::Load(std::string file) {
+bool Scene::Load(std::string file, bool optimize) {
 
 	Clear();
 
-	Assimp::Importer import;
-
-	// load file
-	const aiScene* scene = import.ReadFile(file.c_str(), aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_JoinIdenticalVertices);
-	if(!scene) {
-		std::cerr << "Error reading file " << file << ": " << import.GetErrorString() << std::endl;
+	CookedModel model;
+	if(!model.Load(file)) {
 		return false;
 	}
 
-	const aiVector3D zeroVec(0.0f, 0.0f, 0.0f);
+	auto start = std::chrono::high_resolution_clock::now();
 
 	// for each mesh in the file
-	for(unsigned int mesh_idx = 0; mesh_idx < scene->mNumMeshes; mesh_idx++) {
-		const aiMesh* aiM = scene->mMeshes[mesh_idx];
-
-		Mesh m;
-		m.material = aiM->mMaterialIndex;
+	for(auto& sub : model.meshes) {
 
-		// for each vertex in the mesh
-		for(unsigned int vert_idx = 0; vert_idx < aiM->mNumVertices; vert_idx++) {
-			const aiVector3D* pos = &aiM->mVertices[vert_idx];
-			const aiVector3D* norm = &aiM->mNormals[vert_idx];
-			const aiVector3D* texcoord = aiM->HasTextureCoords(0) ? &aiM->mTextureCoords[0][vert_idx] : &zeroVec;
+		// small meshes are appended to the last one with the same material while it still fits 16-bit indices
+		if(optimize && sub.num_vertices < MERGE_MAX_VERTICES) {
 
-			// translate vetex data
-			Vertex vert;
-			vert.pos = glm::vec3(pos->x, pos->y, pos->z);
-			vert.normal = glm::vec3(norm->x, norm->y, norm->z);
-			vert.texcoord = glm::vec2(texcoord->x, texcoord->y);
+			Mesh* merged = nullptr;
+			for(auto& m : meshes) {
+				if(m.material == sub.material && m.vertices.size() < MERGE_MAX_VERTICES && m.vertices.size() + sub.num_vertices <= 65536) {
+					merged = &m;
+				}
+			}
 
-			m.vertices.push_back(vert);
+			if(merged) {
+				unsigned int base = merged->vertices.size();
+				merged->vertices.insert(merged->vertices.end(), sub.vertices, sub.vertices + sub.num_vertices);
+				for(unsigned int i = 0; i < sub.num_indices; i++) {
+					merged->indices.push_back(base + sub.indices[i]);
+				}
+				continue;
+			}
 		}
 
-		// for each face in the mesh
-		for(unsigned int face_idx = 0; face_idx < aiM->mNumFaces; face_idx++) {
-			const aiFace* face = &aiM->mFaces[face_idx];
+		Mesh m;
+		m.material = sub.material;
 
-			// collect face indicies
-			for(unsigned int idx = 0; idx < 3; idx++) {
-				m.indices.push_back(face->mIndices[idx]);
-			}
-		}
+		// cooked data is already laid out as Vertex / index arrays
+		m.vertices.assign(sub.vertices, sub.vertices + sub.num_vertices);
+		m.indices.assign(sub.indices, sub.indices + sub.num_indices);
 
-		// send vertex / index information to GPU
-		glGenBuffers(1, &m.VBO);
-		glGenBuffers(1, &m.IBO);
+		meshes.push_back(std::move(m));
+	}
 
-		glBindBuffer(GL_ARRAY_BUFFER, m.VBO);
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m.IBO);
+	MeshOptimizer::Stats before = {0.0f, 0.0f}, after = {0.0f, 0.0f};
+	size_t total_tris = 0, total_verts = 0, optimized_verts = 0, short_meshes = 0;
 
-		glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex) * m.vertices.size(), &m.vertices[0], GL_STATIC_DRAW);
-		glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int) * m.indices.size(), &m.indices[0], GL_STATIC_DRAW);
+	for(auto& m : meshes) {
 
-		glBindBuffer(GL_ARRAY_BUFFER, 0);
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+		// weighted by size so the totals are per triangle / vertex of the whole model
+		size_t tris = m.indices.size() / 3, verts = m.vertices.size();
+		MeshOptimizer::Stats s = MeshOptimizer::Analyze(m.indices, verts);
+		before.acmr += s.acmr * tris;
+		before.atvr += s.atvr * verts;
 
-		meshes.push_back(std::move(m));
+		if(optimize) {
+			MeshOptimizer::Optimize(m.vertices, m.indices);
+			s = MeshOptimizer::Analyze(m.indices, m.vertices.size());
+		}
+		after.acmr += s.acmr * tris;
+		after.atvr += s.atvr * m.vertices.size();
+
+		total_tris += tris;
+		total_verts += verts;
+		optimized_verts += m.vertices.size();
+
+		Upload(m, optimize && m.vertices.size() <= 65536);
+		short_meshes += m.index_type == GL_UNSIGNED_SHORT;
+	}
+
+	if(total_tris) {
+		printf("%s: %u meshes in %zu draws, %zu with 16-bit indices\n", file.c_str(), (unsigned int)model.meshes.size(), meshes.size(), short_meshes);
+		if(optimize) {
+			double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+			printf("  ACMR %.3f -> %.3f, ATVR %.3f -> %.3f, optimized in %.1f ms\n",
+			       before.acmr / total_tris, after.acmr / total_tris, before.atvr / total_verts, after.atvr / optimized_verts, ms);
+		} else {
+			printf("  ACMR %.3f, ATVR %.3f (as imported)\n", before.acmr / total_tris, before.atvr / total_verts);
+		}
 	}
 
 	return true;
@@ -92,26 +111,46 @@ bool Scene::Load(std::string file) {
 
 void Scene::Render() {
 
-	glEnableVertexAttribArray(0);
-	glEnableVertexAttribArray(1);
-	glEnableVertexAttribArray(2);
-
 	for(auto& m : meshes) {
 
-		glBindBuffer(GL_ARRAY_BUFFER, m.VBO);
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m.IBO);
+		GLState::BindVertexArray(m.VAO);
+		glDrawElements(GL_TRIANGLES, m.num_indices, m.index_type, 0);
+	}
+}
+
+void Scene::Upload(Mesh& m, bool short_indices) {
+
+	m.num_indices = m.indices.size();
+	m.index_type = short_indices ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
 
-		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), 0);
-		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex,normal));
-		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex,texcoord));
+	// send vertex / index information to GPU
+	glGenVertexArrays(1, &m.VAO);
+	glGenBuffers(1, &m.VBO);
+	glGenBuffers(1, &m.IBO);
 
-		glDrawElements(GL_TRIANGLES, m.indices.size(), GL_UNSIGNED_INT, 0);
+	// the element buffer binding and attribute pointers are captured by the VAO
+	GLState::BindVertexArray(m.VAO);
+	glBindBuffer(GL_ARRAY_BUFFER, m.VBO);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m.IBO);
 
-		glBindBuffer(GL_ARRAY_BUFFER, 0);
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex) * m.vertices.size(), m.vertices.data(), GL_STATIC_DRAW);
+
+	if(short_indices) {
+		// half the index bandwidth
+		std::vector<unsigned short> indices(m.indices.begin(), m.indices.end());
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned short) * indices.size(), indices.data(), GL_STATIC_DRAW);
+	} else {
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int) * m.indices.size(), m.indices.data(), GL_STATIC_DRAW);
 	}
 
-	glDisableVertexAttribArray(0);
-	glDisableVertexAttribArray(1);
-	glDisableVertexAttribArray(2);
+	glEnableVertexAttribArray(0);
+	glEnableVertexAttribArray(1);
+	glEnableVertexAttribArray(2);
+
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), 0);
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex,normal));
+	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex,texcoord));
+
+	GLState::BindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
 }
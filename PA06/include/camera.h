@@ -14,6 +14,8 @@ public:
 	void reset();
 	void update();
 	void move(int dx, int dy);
+	// orbit to an absolute yaw / pitch in degrees
+	void set(float _yaw, float _pitch);
 
 	const float sens = 0.5f;
 
@@ -7,6 +7,7 @@
 #include "window.h"
 #include "graphics.h"
 #include "imgui_impl.h"
+#include "benchmark.h"
 #include <imgui.h>
 
 class Engine {
@@ -17,6 +18,8 @@ public:
 	
 	bool Initialize(std::vector<std::string> args);
 	void Run();
+	// render a scripted, fixed-timestep run offscreen and report frame timings
+	void RunHeadless();
 	void Events();
 	
 	unsigned int getDT();
@@ -24,6 +27,9 @@ public:
   
 private:
 
+	// simulate and render a single frame over dT
+	void Frame(unsigned int dT);
+
 	void KeyboardEvts();
 	void MouseEvts();
 	void WindowEvts();
@@ -40,6 +46,7 @@ private:
 	SDL_Event m_event;
 
 	Graphics *m_graphics;
+	Benchmark m_benchmark;
 	unsigned int m_DT;
 	long long m_currentTimeMillis;
 	bool m_running;
@@ -15,24 +15,33 @@ public:
 	Graphics();
 	~Graphics();
 
-	bool Initialize(int width, int height, std::vector<std::string> args);
+	// headless renders into an offscreen framebuffer instead of the window
+	bool Initialize(int width, int height, std::vector<std::string> args, bool headless = false);
 	
 	void Update(unsigned int dt);
 	void Render(int w, int h);
 
 	void EvtCamera(int dx, int dy);
+	// place the camera along the scripted benchmark path, t in [0, 1)
+	void FollowCameraPath(float t);
+	// load the current model again, with or without the mesh optimizer
+	bool ReloadScene(bool optimize);
 
 private:
-	GLuint VAO;
-
 	std::string ErrorString(GLenum error);
 
+	// offscreen render target for headless mode
+	bool CreateOffscreenTarget(int width, int height);
+	bool headless;
+	GLuint offscreen_fbo, offscreen_color, offscreen_depth;
+
 	Camera *m_camera;
 	Shader *m_shader;
 	Scene  *m_scene;
 	
 	std::string scene_path;
 	bool load_failed;
+	bool optimize_meshes;
 
 	GLint m_projectionMatrix;
 	GLint m_viewMatrix;
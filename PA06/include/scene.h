@@ -12,19 +12,57 @@ public:
 	Scene(std::string file);
 	~Scene();
 
-	bool Load(std::string file);
+	// optimize reorders each mesh for the vertex cache / overdraw / fetches, merges small
+	// meshes sharing a material and uses 16-bit indices where they fit
+	bool Load(std::string file, bool optimize = true);
 	void Render();
 	void Clear();
 
+	// LOD selection, shared by every scene
+		// camera and screen size used to project LOD errors, call once a frame before rendering
+	static void SetView(const glm::mat4& view, const glm::mat4& proj, int screen_height);
+	static bool use_lods;
+	// how far the simplified surface may be off on screen before a finer LOD is drawn, in pixels
+	static float lod_pixel_error;
+	// triangles drawn since SetView, and how many that would have been without LODs
+	static unsigned int triangles, full_triangles;
+	// totals from the last complete frame
+	static unsigned int last_triangles, last_full_triangles;
+
 private:
 
+	// meshes with fewer vertices than this are merged with others of the same material
+	static const unsigned int MERGE_MAX_VERTICES = 4096;
+	// meshes with fewer triangles than this are always drawn in full
+	static const unsigned int LOD_MIN_TRIANGLES = 1024;
+
 	struct Mesh {
 
-		GLuint VBO, IBO;
+		// VAO holds the buffer bindings and attribute layout, configured once at load
+		GLuint VAO, VBO, IBO;
 
 		std::vector<Vertex> 		vertices;
 		std::vector<unsigned int> 	indices; 
 
+		// what is actually in IBO - GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+		GLenum index_type;
+
+		// LOD 0 is the full mesh, the simplified ones follow it in indices / IBO
+		struct Lod {
+
+			unsigned int first;
+			GLsizei count;
+			// how far the surface moved from LOD 0, in model units
+			float error;
+		};
+		std::vector<Lod> lods;
+
+		// bounding sphere, for the distance to the camera
+		glm::vec3 center;
+		float radius;
+
+		// material index in the file, meshes are only merged within one
+		unsigned int source_material;
 		unsigned int material;
 		bool textured;
 	};
@@ -34,6 +72,15 @@ private:
 		GLuint tex;
 	};
 
+	// append simplified copies of m's triangles to its indices
+	void GenerateLods(Mesh& m, bool optimize);
+	// create the buffers for m, from its vertices / indices
+	void Upload(Mesh& m, bool short_indices);
+
+	static glm::vec3 eye;
+	// pixels covered by one model unit at distance one
+	static float proj_scale;
+
 	std::vector<Mesh> 		meshes;
 	std::vector<Texture> 	textures;
 };
@@ -11,6 +11,8 @@ public:
 	Window();
 	~Window();
 	bool Initialize(const string &name, int* width, int* height);
+	// create an offscreen openGL context with no window or display (EGL surfaceless)
+	bool InitializeHeadless(int width, int height);
 	void Swap();
 
 	SDL_Window* GetWindow() const;
@@ -18,6 +20,11 @@ public:
 private:
 	SDL_Window* gWindow;
 	SDL_GLContext gContext;
+
+	// EGLDisplay / EGLContext for headless mode - kept opaque so EGL headers stay out of the engine
+	bool headless;
+	void* eglDisplay;
+	void* eglContext;
 };
 
 #endif /* WINDOW_H */
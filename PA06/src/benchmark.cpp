@@ -0,0 +1,263 @@
+
+#include "benchmark.h"
+#include "glstate.h"
+
+#include <algorithm>
+#include <fstream>
+#include <cstdio>
+#include <cstdlib>
+
+unsigned int Benchmark::draw_calls = 0;
+unsigned int Benchmark::triangles = 0;
+GLuint Benchmark::draw_query = 0;
+bool Benchmark::timing = false;
+
+Benchmark::Benchmark() {}
+
+Benchmark::~Benchmark() {}
+
+void Benchmark::ParseArgs(std::vector<std::string>& args) {
+
+	std::vector<std::string> rest;
+
+	for(unsigned int i = 0; i < args.size(); i++) {
+
+		if(args[i] == "--headless") {
+			headless = true;
+		} else if(args[i] == "--compare") {
+			compare = true;
+		} else if(args[i] == "--frames" && i + 1 < args.size()) {
+			frames = std::max(1, atoi(args[++i].c_str()));
+		} else if(args[i] == "--png-dir" && i + 1 < args.size()) {
+			png_dir = args[++i];
+			if(png_dir.back() != '/' && png_dir.back() != '\\') {
+				png_dir.append("/");
+			}
+			if(!png_every) png_every = 1;
+		} else if(args[i] == "--png-every" && i + 1 < args.size()) {
+			png_every = std::max(1, atoi(args[++i].c_str()));
+		} else {
+			rest.push_back(args[i]);
+		}
+	}
+
+	args.swap(rest);
+
+	frame_times.reserve(frames);
+	frame_draw_calls.reserve(frames);
+	frame_triangles.reserve(frames);
+	frame_state_changes.reserve(frames);
+	frame_draw_times.reserve(frames);
+}
+
+void Benchmark::Reset() {
+
+	frame = 0;
+	frame_times.clear();
+	frame_draw_calls.clear();
+	frame_triangles.clear();
+	frame_state_changes.clear();
+	frame_draw_times.clear();
+}
+
+float Benchmark::Progress() {
+
+	return (float)frame / (float)frames;
+}
+
+bool Benchmark::Done() {
+
+	return frame >= frames;
+}
+
+void Benchmark::BeginFrame() {
+
+	// timer queries are core in 3.3, the context asks for 3.2
+	if(!draw_query && (GLEW_VERSION_3_3 || GLEW_ARB_timer_query)) {
+		glGenQueries(1, &draw_query);
+	}
+	timing = draw_query != 0;
+
+	draw_calls = 0;
+	triangles = 0;
+	frame_start = std::chrono::high_resolution_clock::now();
+}
+
+void Benchmark::BeginTimedDraw() {
+
+	if(timing) glBeginQuery(GL_TIME_ELAPSED, draw_query);
+}
+
+void Benchmark::EndTimedDraw() {
+
+	if(timing) glEndQuery(GL_TIME_ELAPSED);
+}
+
+void Benchmark::EndFrame(int w, int h) {
+
+	// make sure the frame has actually been rendered before stopping the clock
+	glFinish();
+
+	auto frame_end = std::chrono::high_resolution_clock::now();
+	frame_times.push_back(std::chrono::duration<double, std::milli>(frame_end - frame_start).count());
+	frame_draw_calls.push_back(draw_calls);
+	frame_triangles.push_back(triangles);
+	frame_state_changes.push_back(GLState::changes);
+
+	if(timing) {
+		GLuint64 ns = 0;
+		glGetQueryObjectui64v(draw_query, GL_QUERY_RESULT, &ns);
+		frame_draw_times.push_back(ns / 1e6);
+		timing = false;
+	}
+
+	if(png_dir.size() && png_every && frame % png_every == 0) {
+
+		std::vector<unsigned char> rgba(w * h * 4);
+		glPixelStorei(GL_PACK_ALIGNMENT, 1);
+		glReadPixels(0, 0, w, h, GL_RGBA, GL_UNSIGNED_BYTE, rgba.data());
+
+		char name[32];
+		snprintf(name, sizeof(name), "frame_%05d.png", frame);
+		if(!WritePNG(png_dir + name, w, h, rgba)) {
+			std::cerr << "Failed to write frame to " << png_dir << name << std::endl;
+		}
+	}
+
+	frame++;
+}
+
+void Benchmark::Report(const std::string& label) {
+
+	if(frame_times.empty()) return;
+
+	std::vector<double> sorted = frame_times;
+	std::sort(sorted.begin(), sorted.end());
+
+	double total = 0.0, total_draws = 0.0, total_changes = 0.0, total_triangles = 0.0;
+	for(double t : frame_times) total += t;
+	for(unsigned int d : frame_draw_calls) total_draws += d;
+	for(unsigned int t : frame_triangles) total_triangles += t;
+	for(unsigned int c : frame_state_changes) total_changes += c;
+
+	unsigned int p99_idx = std::min((unsigned int)sorted.size() - 1, (unsigned int)(sorted.size() * 0.99));
+
+	std::cout << "Benchmark" << (label.size() ? " (" + label + ")" : "") << ": " << frame_times.size() << " frames" << std::endl;
+	std::cout << "  avg frame time: " << total / frame_times.size() << " ms" << std::endl;
+	std::cout << "  p99 frame time: " << sorted[p99_idx] << " ms" << std::endl;
+	std::cout << "  min/max:        " << sorted.front() << " / " << sorted.back() << " ms" << std::endl;
+	std::cout << "  avg draw calls: " << total_draws / frame_draw_calls.size() << std::endl;
+	std::cout << "  avg triangles:  " << total_triangles / frame_triangles.size() << std::endl;
+	std::cout << "  avg GL state changes: " << total_changes / frame_state_changes.size() << std::endl;
+
+	if(frame_draw_times.size()) {
+		std::vector<double> draws = frame_draw_times;
+		std::sort(draws.begin(), draws.end());
+
+		double total_draw = 0.0;
+		for(double t : draws) total_draw += t;
+
+		std::cout << "  avg scene draw (GPU): " << total_draw / draws.size() << " ms" << std::endl;
+		std::cout << "  p99 scene draw (GPU): " << draws[std::min(draws.size() - 1, (size_t)(draws.size() * 0.99))] << " ms" << std::endl;
+	}
+}
+
+static unsigned int crc32(unsigned int crc, const unsigned char* data, size_t len) {
+
+	static unsigned int table[256];
+	static bool init = false;
+
+	if(!init) {
+		for(unsigned int n = 0; n < 256; n++) {
+			unsigned int c = n;
+			for(int k = 0; k < 8; k++) {
+				c = c & 1 ? 0xedb88320u ^ (c >> 1) : c >> 1;
+			}
+			table[n] = c;
+		}
+		init = true;
+	}
+
+	crc = ~crc;
+	for(size_t i = 0; i < len; i++) {
+		crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+	}
+	return ~crc;
+}
+
+static void put32(std::vector<unsigned char>& out, unsigned int v) {
+
+	out.push_back(v >> 24);
+	out.push_back(v >> 16);
+	out.push_back(v >> 8);
+	out.push_back(v);
+}
+
+static void chunk(std::ofstream& fout, const char* type, const std::vector<unsigned char>& data) {
+
+	std::vector<unsigned char> buf;
+	put32(buf, data.size());
+	buf.insert(buf.end(), type, type + 4);
+	buf.insert(buf.end(), data.begin(), data.end());
+	put32(buf, crc32(0, buf.data() + 4, buf.size() - 4));
+
+	fout.write((const char*)buf.data(), buf.size());
+}
+
+// uncompressed (stored) deflate stream - golden images only need to be exact, not small
+bool Benchmark::WritePNG(std::string path, int w, int h, const std::vector<unsigned char>& rgba) {
+
+	std::ofstream fout(path, std::ios::binary);
+	if(!fout.good()) return false;
+
+	static const unsigned char signature[] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+	fout.write((const char*)signature, sizeof(signature));
+
+	std::vector<unsigned char> ihdr;
+	put32(ihdr, w);
+	put32(ihdr, h);
+	ihdr.push_back(8);	// bit depth
+	ihdr.push_back(6);	// RGBA
+	ihdr.push_back(0);
+	ihdr.push_back(0);
+	ihdr.push_back(0);
+	chunk(fout, "IHDR", ihdr);
+
+	// filter byte + flipped scanlines
+	size_t stride = w * 4;
+	std::vector<unsigned char> raw;
+	raw.reserve((stride + 1) * h);
+	for(int y = h - 1; y >= 0; y--) {
+		raw.push_back(0);
+		raw.insert(raw.end(), rgba.begin() + y * stride, rgba.begin() + (y + 1) * stride);
+	}
+
+	std::vector<unsigned char> idat = {0x78, 0x01};
+	unsigned int a = 1, b = 0;
+	for(size_t pos = 0; pos < raw.size() || pos == 0; ) {
+
+		size_t len = std::min(raw.size() - pos, (size_t)65535);
+		bool last = pos + len >= raw.size();
+
+		idat.push_back(last ? 1 : 0);
+		idat.push_back(len & 0xff);
+		idat.push_back(len >> 8);
+		idat.push_back(~len & 0xff);
+		idat.push_back((~len >> 8) & 0xff);
+		idat.insert(idat.end(), raw.begin() + pos, raw.begin() + pos + len);
+
+		for(size_t i = pos; i < pos + len; i++) {
+			a = (a + raw[i]) % 65521;
+			b = (b + a) % 65521;
+		}
+
+		pos += len;
+		if(last) break;
+	}
+	put32(idat, (b << 16) | a);
+	chunk(fout, "IDAT", idat);
+
+	chunk(fout, "IEND", std::vector<unsigned char>());
+
+	return fout.good();
+}
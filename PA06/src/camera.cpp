@@ -34,6 +34,13 @@ void Camera::move(int dx, int dy) {
 	update();
 }
 
+void Camera::set(float _yaw, float _pitch) {
+
+	yaw = _yaw;
+	pitch = _pitch;
+	update();
+}
+
 glm::mat4 Camera::GetProjection(float w, float h) {
   
 	return glm::perspective(45.0f, w/h, 0.01f, 100.0f);
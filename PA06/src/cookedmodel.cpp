@@ -0,0 +1,324 @@
+
+#include "cookedmodel.h"
+
+#include <assimp/Importer.hpp> 		//includes the importer, which is used to read our obj file
+#include <assimp/scene.h> 			//includes the aiScene object
+#include <assimp/postprocess.h> 	//includes the postprocessing variables for the importer
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <fstream>
+#include <thread>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+const unsigned int CookedModel::import_flags = aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_JoinIdenticalVertices;
+
+// bump whenever the layout below or the Vertex struct changes
+static const uint32_t COOKED_VERSION = 1;
+static const char COOKED_MAGIC[4] = {'C', 'O', 'O', 'K'};
+// vertex and index blobs start on a cache line
+static const uint64_t COOKED_ALIGN = 64;
+
+struct CookedHeader {
+	char magic[4];
+	uint32_t version;
+	uint32_t import_flags;
+	uint32_t vertex_size;
+
+	// source file this was cooked from - a different mtime only forces a re-cook if the contents changed too
+	uint64_t source_size;
+	int64_t source_mtime;
+	uint64_t source_hash;
+
+	uint32_t num_meshes;
+	uint32_t num_materials;
+};
+
+struct CookedMesh {
+	uint64_t vertex_offset;
+	uint64_t index_offset;
+	uint32_t num_vertices;
+	uint32_t num_indices;
+	uint32_t material;
+	uint32_t pad;
+};
+
+// followed by num_meshes CookedMesh, then num_materials (uint32_t length, chars) texture paths, then the blobs
+
+static_assert(sizeof(CookedHeader) == 48, "cooked header must not depend on the compiler's padding");
+static_assert(sizeof(CookedMesh) == 32, "cooked mesh entry must not depend on the compiler's padding");
+
+// FNV-1a over the whole file
+static bool HashFile(const std::string& file, uint64_t& hash) {
+
+	std::ifstream fin(file, std::ios::binary);
+	if(!fin.good()) return false;
+
+	hash = 14695981039346656037ull;
+
+	std::vector<char> chunk(1 << 16);
+	while(fin) {
+		fin.read(chunk.data(), chunk.size());
+		std::streamsize n = fin.gcount();
+		for(std::streamsize i = 0; i < n; i++) {
+			hash = (hash ^ (unsigned char)chunk[i]) * 1099511628211ull;
+		}
+	}
+
+	return true;
+}
+
+static void Align(std::vector<char>& out) {
+
+	out.resize((out.size() + COOKED_ALIGN - 1) / COOKED_ALIGN * COOKED_ALIGN, 0);
+}
+
+CookedModel::CookedModel() {
+	mapped = nullptr;
+	mapped_size = 0;
+	from_cache = false;
+	load_ms = 0.0;
+}
+
+CookedModel::~CookedModel() {
+	Unmap();
+}
+
+void CookedModel::Unmap() {
+	if(mapped) {
+		munmap(mapped, mapped_size);
+		mapped = nullptr;
+		mapped_size = 0;
+	}
+	buffer.clear();
+	meshes.clear();
+	materials.clear();
+}
+
+bool CookedModel::Load(const std::string& file) {
+
+	auto start = std::chrono::high_resolution_clock::now();
+
+	Unmap();
+
+	from_cache = false;
+	if(Map(file + ".cooked")) {
+
+		const CookedHeader* header = (const CookedHeader*)mapped;
+
+		struct stat st;
+		if(stat(file.c_str(), &st) != 0) {
+			// shipped without the source, nothing to validate against
+			from_cache = true;
+		} else if((uint64_t)st.st_size == header->source_size) {
+
+			uint64_t hash;
+			from_cache = (int64_t)st.st_mtime == header->source_mtime || (HashFile(file, hash) && hash == header->source_hash);
+		}
+
+		if(!from_cache) Unmap();
+	}
+
+	if(!from_cache && !Cook(file)) {
+		return false;
+	}
+
+	load_ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+	std::cout << "Loaded " << file << (from_cache ? " from cooked copy" : " with Assimp") << " in " << load_ms << " ms" << std::endl;
+
+	return true;
+}
+
+bool CookedModel::Map(const std::string& path) {
+
+	int fd = open(path.c_str(), O_RDONLY);
+	if(fd < 0) return false;
+
+	struct stat st;
+	if(fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(CookedHeader)) {
+		close(fd);
+		return false;
+	}
+
+	void* data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if(data == MAP_FAILED) return false;
+
+	mapped = data;
+	mapped_size = st.st_size;
+
+	if(!Parse((const char*)mapped, mapped_size)) {
+		std::cerr << "Ignoring outdated or corrupt cooked model " << path << std::endl;
+		Unmap();
+		return false;
+	}
+
+	return true;
+}
+
+bool CookedModel::Parse(const char* data, size_t size) {
+
+	const CookedHeader* header = (const CookedHeader*)data;
+
+	if(memcmp(header->magic, COOKED_MAGIC, 4) || header->version != COOKED_VERSION ||
+	   header->import_flags != import_flags || header->vertex_size != sizeof(Vertex)) {
+		return false;
+	}
+
+	size_t pos = sizeof(CookedHeader);
+	if((size - pos) / sizeof(CookedMesh) < header->num_meshes) return false;
+
+	const CookedMesh* entries = (const CookedMesh*)(data + pos);
+	pos += sizeof(CookedMesh) * header->num_meshes;
+
+	// material texture paths
+	for(unsigned int mat_idx = 0; mat_idx < header->num_materials; mat_idx++) {
+
+		uint32_t len;
+		if(size - pos < sizeof(len)) return false;
+		memcpy(&len, data + pos, sizeof(len));
+		pos += sizeof(len);
+
+		if(size - pos < len) return false;
+		materials.push_back(std::string(data + pos, len));
+		pos += len;
+	}
+
+	// blobs are used in place
+	for(unsigned int mesh_idx = 0; mesh_idx < header->num_meshes; mesh_idx++) {
+		const CookedMesh& e = entries[mesh_idx];
+
+		if(e.vertex_offset % COOKED_ALIGN || e.index_offset % COOKED_ALIGN ||
+		   e.vertex_offset > size || (size - e.vertex_offset) / sizeof(Vertex) < e.num_vertices ||
+		   e.index_offset > size || (size - e.index_offset) / sizeof(unsigned int) < e.num_indices) {
+			return false;
+		}
+
+		SubMesh m;
+		m.vertices = (const Vertex*)(data + e.vertex_offset);
+		m.indices = (const unsigned int*)(data + e.index_offset);
+		m.num_vertices = e.num_vertices;
+		m.num_indices = e.num_indices;
+		m.material = e.material;
+
+		meshes.push_back(m);
+	}
+
+	return true;
+}
+
+bool CookedModel::Cook(const std::string& file) {
+
+	Unmap();
+
+	struct stat st;
+	uint64_t hash;
+	if(stat(file.c_str(), &st) != 0 || !HashFile(file, hash)) {
+		std::cerr << "Error reading file " << file << std::endl;
+		return false;
+	}
+
+	Assimp::Importer import;
+
+	// load file
+	const aiScene* scene = import.ReadFile(file.c_str(), import_flags);
+	if(!scene) {
+		std::cerr << "Error reading file " << file << ": " << import.GetErrorString() << std::endl;
+		return false;
+	}
+
+	CookedHeader header;
+	memcpy(header.magic, COOKED_MAGIC, 4);
+	header.version = COOKED_VERSION;
+	header.import_flags = import_flags;
+	header.vertex_size = sizeof(Vertex);
+	header.source_size = st.st_size;
+	header.source_mtime = st.st_mtime;
+	header.source_hash = hash;
+	header.num_meshes = scene->mNumMeshes;
+	header.num_materials = scene->mNumMaterials;
+
+	std::vector<char> out(sizeof(CookedHeader) + sizeof(CookedMesh) * scene->mNumMeshes, 0);
+	memcpy(out.data(), &header, sizeof(header));
+
+	// for each material, the diffuse (color) texture if it has one
+	for(unsigned int mat_idx = 0; mat_idx < scene->mNumMaterials; mat_idx++) {
+		const aiMaterial* mat = scene->mMaterials[mat_idx];
+
+		aiString path;
+		if(mat->GetTextureCount(aiTextureType_DIFFUSE) == 0 ||
+		   mat->GetTexture(aiTextureType_DIFFUSE, 0, &path, nullptr, nullptr, nullptr, nullptr, nullptr) != AI_SUCCESS) {
+			path.Clear();
+		}
+
+		uint32_t len = path.length;
+		out.insert(out.end(), (const char*)&len, (const char*)&len + sizeof(len));
+		out.insert(out.end(), path.C_Str(), path.C_Str() + len);
+	}
+
+	const aiVector3D zeroVec(0.0f, 0.0f, 0.0f);
+
+	// for each mesh in the file
+	for(unsigned int mesh_idx = 0; mesh_idx < scene->mNumMeshes; mesh_idx++) {
+		const aiMesh* aiM = scene->mMeshes[mesh_idx];
+
+		CookedMesh e;
+		memset(&e, 0, sizeof(e));
+		e.num_vertices = aiM->mNumVertices;
+		e.num_indices = aiM->mNumFaces * 3;
+		e.material = aiM->mMaterialIndex;
+
+		// translate vetex data
+		Align(out);
+		e.vertex_offset = out.size();
+		out.resize(out.size() + sizeof(Vertex) * e.num_vertices);
+
+		Vertex* verts = (Vertex*)(out.data() + e.vertex_offset);
+		for(unsigned int vert_idx = 0; vert_idx < aiM->mNumVertices; vert_idx++) {
+			const aiVector3D* pos = &aiM->mVertices[vert_idx];
+			const aiVector3D* norm = &aiM->mNormals[vert_idx];
+			const aiVector3D* texcoord = aiM->HasTextureCoords(0) ? &aiM->mTextureCoords[0][vert_idx] : &zeroVec;
+
+			verts[vert_idx] = Vertex(glm::vec3(pos->x, pos->y, pos->z), glm::vec3(norm->x, norm->y, norm->z), glm::vec2(texcoord->x, texcoord->y));
+		}
+
+		// collect face indicies
+		Align(out);
+		e.index_offset = out.size();
+		out.resize(out.size() + sizeof(unsigned int) * e.num_indices);
+
+		unsigned int* indices = (unsigned int*)(out.data() + e.index_offset);
+		for(unsigned int face_idx = 0; face_idx < aiM->mNumFaces; face_idx++) {
+			const aiFace* face = &aiM->mFaces[face_idx];
+
+			for(unsigned int idx = 0; idx < 3; idx++) {
+				indices[face_idx * 3 + idx] = face->mIndices[idx];
+			}
+		}
+
+		memcpy(out.data() + sizeof(CookedHeader) + sizeof(CookedMesh) * mesh_idx, &e, sizeof(e));
+	}
+
+	// write to a temporary and rename so a crash never leaves a half-written copy behind
+		// named per thread, two loads of the same file can cook it at once
+	std::string path = file + ".cooked";
+	std::string tmp = path + "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+	std::ofstream fout(tmp, std::ios::binary);
+	fout.write(out.data(), out.size());
+	fout.close();
+
+	if(!fout.good() || rename(tmp.c_str(), path.c_str()) != 0) {
+		std::cerr << "Could not write cooked model " << path << ", keeping it in memory" << std::endl;
+		remove(tmp.c_str());
+	}
+
+	buffer.swap(out);
+	return Parse(buffer.data(), buffer.size());
+}
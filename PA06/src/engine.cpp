@@ -22,17 +22,24 @@ Engine::~Engine() {
 }
 
 bool Engine::Initialize(std::vector<std::string> args) {
+
+	m_benchmark.ParseArgs(args);
   	
   	// Start a window
 	m_window = new Window();
-	if(!m_window->Initialize(m_WINDOW_NAME, &w, &h)) {
+	if(m_benchmark.headless) {
+		if(!m_window->InitializeHeadless(w, h)) {
+			printf("The headless context failed to initialize.\n");
+			return false;
+		}
+	} else if(!m_window->Initialize(m_WINDOW_NAME, &w, &h)) {
 		printf("The window failed to initialize.\n");
 		return false;
 	}
 	
 	// Start the graphics
 	m_graphics = new Graphics();
-	if(!m_graphics->Initialize(w, h, args)) {
+	if(!m_graphics->Initialize(w, h, args, m_benchmark.headless)) {
 		printf("The graphics failed to initialize.\n");
 		return false;
 	}
@@ -49,6 +56,11 @@ bool Engine::Initialize(std::vector<std::string> args) {
 void Engine::Run() {
 	
 	m_running = true;
+
+	if(m_benchmark.headless) {
+		RunHeadless();
+		return;
+	}
 	
 	while(m_running) {
 
@@ -59,17 +71,54 @@ void Engine::Run() {
 
 		Events();
 
-		// Update and render the graphics
-		m_graphics->Update(m_DT);
-		m_graphics->Render(w, h);
-		
-		ImGui::Render();
+		Frame(m_DT);
 
 		// Swap to the Window
 		m_window->Swap();
 	}
 }
 
+void Engine::RunHeadless() {
+
+	ImGui::GetIO().DisplaySize = ImVec2((float)w, (float)h);
+
+	// the same path twice - the model as imported, then through the mesh optimizer
+	for(int pass = m_benchmark.compare ? 0 : 1; pass < 2; pass++) {
+
+		if(m_benchmark.compare && !m_graphics->ReloadScene(pass == 1)) {
+			printf("The model failed to reload.\n");
+			return;
+		}
+
+		m_benchmark.Reset();
+
+		// fixed timestep so every run renders the same frames
+		const unsigned int dT = 16;
+
+		while(!m_benchmark.Done()) {
+
+			m_benchmark.BeginFrame();
+			ImGui_ImplSdlGL3_NewFrame(nullptr);
+
+			m_graphics->FollowCameraPath(m_benchmark.Progress());
+			Frame(dT);
+
+			m_benchmark.EndFrame(w, h);
+		}
+
+		m_benchmark.Report(m_benchmark.compare ? (pass ? "optimized" : "as imported") : "");
+	}
+}
+
+void Engine::Frame(unsigned int dT) {
+
+	// Update and render the graphics
+	m_graphics->Update(dT);
+	m_graphics->Render(w, h);
+	
+	ImGui::Render();
+}
+
 void Engine::Events() {
 
 	while(SDL_PollEvent(&m_event) != 0) {
@@ -0,0 +1,148 @@
+
+#include "glstate.h"
+
+unsigned int GLState::changes = 0;
+unsigned int GLState::skipped = 0;
+unsigned int GLState::last_changes = 0;
+unsigned int GLState::last_skipped = 0;
+
+// 0xffffffff never names a real GL object, so it marks "unknown"
+static const GLuint unknown = 0xffffffff;
+
+static GLuint program = unknown;
+static GLuint vao = unknown;
+static GLuint texture_2d = unknown;
+static GLuint texture_cube = unknown;
+static GLuint texture_array = unknown;
+
+static int blend = -1, depth_test = -1, cull_face = -1, depth_mask = -1;
+static GLenum blend_src = 0, blend_dst = 0;
+
+// returns true if the cached value had to change
+static bool Update(GLuint& cached, GLuint value) {
+
+	if(cached == value) {
+		GLState::skipped++;
+		return false;
+	}
+	cached = value;
+	GLState::changes++;
+	return true;
+}
+
+static bool Update(int& cached, bool value) {
+
+	if(cached == (int)value) {
+		GLState::skipped++;
+		return false;
+	}
+	cached = value;
+	GLState::changes++;
+	return true;
+}
+
+void GLState::UseProgram(GLuint p) {
+
+	if(Update(program, p)) {
+		glUseProgram(p);
+	}
+}
+
+void GLState::BindVertexArray(GLuint v) {
+
+	if(Update(vao, v)) {
+		glBindVertexArray(v);
+	}
+}
+
+void GLState::BindTexture(GLenum target, GLuint texture) {
+
+	GLuint* cached = nullptr;
+	switch(target) {
+	case GL_TEXTURE_2D: cached = &texture_2d; break;
+	case GL_TEXTURE_CUBE_MAP: cached = &texture_cube; break;
+	case GL_TEXTURE_2D_ARRAY: cached = &texture_array; break;
+	default:
+		glBindTexture(target, texture);
+		changes++;
+		return;
+	}
+
+	if(Update(*cached, texture)) {
+		glBindTexture(target, texture);
+	}
+}
+
+void GLState::Enable(GLenum cap, bool enable) {
+
+	int* cached = nullptr;
+	switch(cap) {
+	case GL_BLEND: cached = &blend; break;
+	case GL_DEPTH_TEST: cached = &depth_test; break;
+	case GL_CULL_FACE: cached = &cull_face; break;
+	default:
+		enable ? glEnable(cap) : glDisable(cap);
+		changes++;
+		return;
+	}
+
+	if(Update(*cached, enable)) {
+		enable ? glEnable(cap) : glDisable(cap);
+	}
+}
+
+void GLState::DepthMask(bool write) {
+
+	if(Update(depth_mask, write)) {
+		glDepthMask(write ? GL_TRUE : GL_FALSE);
+	}
+}
+
+void GLState::BlendFunc(GLenum src, GLenum dst) {
+
+	if(blend_src == src && blend_dst == dst) {
+		skipped++;
+		return;
+	}
+	blend_src = src;
+	blend_dst = dst;
+	changes++;
+	glBlendFunc(src, dst);
+}
+
+void GLState::DeleteProgram(GLuint p) {
+
+	// a program that is in use stays bound until the next glUseProgram
+	if(program == p) program = unknown;
+	glDeleteProgram(p);
+}
+
+void GLState::DeleteVertexArray(GLuint v) {
+
+	// deleting a bound object reverts the binding to zero
+	if(vao == v) vao = 0;
+	glDeleteVertexArrays(1, &v);
+}
+
+void GLState::DeleteTexture(GLuint texture) {
+
+	if(texture_2d == texture) texture_2d = 0;
+	if(texture_cube == texture) texture_cube = 0;
+	if(texture_array == texture) texture_array = 0;
+	glDeleteTextures(1, &texture);
+}
+
+void GLState::Invalidate() {
+
+	program = vao = unknown;
+	texture_2d = texture_cube = texture_array = unknown;
+	blend = depth_test = cull_face = depth_mask = -1;
+	blend_src = blend_dst = 0;
+}
+
+void GLState::ResetCounters() {
+
+	last_changes = changes;
+	last_skipped = skipped;
+	changes = skipped = 0;
+}
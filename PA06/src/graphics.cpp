@@ -1,5 +1,7 @@
 
 #include "graphics.h"
+#include "glstate.h"
+#include "benchmark.h"
 #include <imgui.h>
 
 Graphics::Graphics() {
@@ -8,6 +10,10 @@ Graphics::Graphics() {
 	m_shader = nullptr;
 	m_scene = nullptr;
 	load_failed = false;
+	optimize_meshes = true;
+
+	headless = false;
+	offscreen_fbo = offscreen_color = offscreen_depth = 0;
 }
 
 Graphics::~Graphics() {
@@ -30,15 +36,27 @@ Graphics::~Graphics() {
 		m_scene = nullptr;
 	}
 
-	glDeleteVertexArrays(1, &VAO);
+	if(offscreen_fbo) {
+		glDeleteFramebuffers(1, &offscreen_fbo);
+		glDeleteRenderbuffers(1, &offscreen_color);
+		glDeleteRenderbuffers(1, &offscreen_depth);
+	}
 }
 
-bool Graphics::Initialize(int width, int height, std::vector<std::string> args) {
+bool Graphics::Initialize(int width, int height, std::vector<std::string> args, bool _headless) {
   
 	glewExperimental = GL_TRUE;
+	headless = _headless;
 
 	auto status = glewInit();
 
+#ifdef GLEW_ERROR_NO_GLX_DISPLAY
+	// an EGL context has no GLX display, but the core GL entry points are still loaded
+	if(headless && status == GLEW_ERROR_NO_GLX_DISPLAY) {
+		status = GLEW_OK;
+	}
+#endif
+
 	// This is here to grab the error that comes from glew init.
 	// This error is an GL_INVALID_ENUM that has no effects on the performance
 	glGetError();
@@ -50,9 +68,9 @@ bool Graphics::Initialize(int width, int height, std::vector<std::string> args)
 		return false;
 	}
 
-	// For OpenGL 3
-	glGenVertexArrays(1, &VAO);
-	glBindVertexArray(VAO);
+	if(headless && !CreateOffscreenTarget(width, height)) {
+		return false;
+	}
 
 	// Init Camera
 	m_camera = new Camera();
@@ -61,8 +79,9 @@ bool Graphics::Initialize(int width, int height, std::vector<std::string> args)
 	scene_path = args.size() ? args[0] : "../data/earth.obj";
 	scene_path.resize(200);
 
+	// the path is padded with NULs for the text box, only what's before them is the file name
 	m_scene = new Scene();
-	if(!m_scene->Load(scene_path)) {
+	if(!m_scene->Load(scene_path.c_str(), optimize_meshes)) {
 
 		printf("Scene failed to Initialize\n");
 		return false;
@@ -123,7 +142,7 @@ bool Graphics::Initialize(int width, int height, std::vector<std::string> args)
 	}
 	
 	//enable depth testing
-	glEnable(GL_DEPTH_TEST);
+	GLState::Enable(GL_DEPTH_TEST, true);
 	glDepthFunc(GL_LESS);
 	
 	return true;
@@ -132,15 +151,20 @@ bool Graphics::Initialize(int width, int height, std::vector<std::string> args)
 void Graphics::Update(unsigned int dt) {
 	
 	ImGui::SetNextWindowPos(ImVec2(20, 20));
-	ImGui::SetNextWindowSize(ImVec2(250, 100));
+	ImGui::SetNextWindowSize(ImVec2(250, 200));
 	ImGui::Begin("Menu", nullptr, ImGuiWindowFlags_NoSavedSettings);
 	ImGui::InputText("File", (char*)scene_path.data(), 200);
+	ImGui::Checkbox("Optimize meshes", &optimize_meshes);
 	if(ImGui::Button("Load")) {
-		load_failed = !m_scene->Load(scene_path);
+		load_failed = !m_scene->Load(scene_path.c_str(), optimize_meshes);
 	}
 	if(load_failed) {
 		ImGui::Text("Failed to load model!");
 	}
+	ImGui::Checkbox("LODs", &Scene::use_lods);
+	ImGui::SliderFloat("LOD error (px)", &Scene::lod_pixel_error, 0.25f, 16.0f);
+	ImGui::Text("Triangles: %u of %u", Scene::last_triangles, Scene::last_full_triangles);
+	ImGui::Text("GL state changes: %u (%u skipped)", GLState::last_changes, GLState::last_skipped);
 	ImGui::End();
 }
 
@@ -148,15 +172,55 @@ void Graphics::EvtCamera(int dx, int dy) {
 	m_camera->move(dx, dy);
 }
 
+void Graphics::FollowCameraPath(float t) {
+
+	// one full orbit of the model while sweeping from above down to the side
+	m_camera->set(360.0f * t, 60.0f - 50.0f * t);
+}
+
+bool Graphics::ReloadScene(bool optimize) {
+
+	optimize_meshes = optimize;
+	load_failed = !m_scene->Load(scene_path.c_str(), optimize_meshes);
+	return !load_failed;
+}
+
+bool Graphics::CreateOffscreenTarget(int width, int height) {
+
+	glGenFramebuffers(1, &offscreen_fbo);
+	glGenRenderbuffers(1, &offscreen_color);
+	glGenRenderbuffers(1, &offscreen_depth);
+
+	glBindRenderbuffer(GL_RENDERBUFFER, offscreen_color);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+	glBindRenderbuffer(GL_RENDERBUFFER, offscreen_depth);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, offscreen_fbo);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, offscreen_color);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, offscreen_depth);
+
+	if(glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+		std::cerr << "Offscreen framebuffer incomplete" << std::endl;
+		return false;
+	}
+
+	// everything (including reads for PNG output) goes through this framebuffer from now on
+	glViewport(0, 0, width, height);
+
+	return true;
+}
+
 void Graphics::Render(int w, int h) {
   
+	GLState::ResetCounters();
+
 	//clear the screen
 	glClearColor(0.0, 0.0, 0.2, 1.0);
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 	
-	glDisable(GL_BLEND);
-
-	glBindVertexArray(VAO);
+	GLState::Enable(GL_BLEND, false);
 
 	// Start the correct program
 	m_shader->Enable();
@@ -164,10 +228,13 @@ void Graphics::Render(int w, int h) {
 	// Send in the projection and view to the shader
 	glUniformMatrix4fv(m_projectionMatrix, 1, GL_FALSE, glm::value_ptr(m_camera->GetProjection(w, h))); 
 	glUniformMatrix4fv(m_viewMatrix, 1, GL_FALSE, glm::value_ptr(m_camera->GetView())); 
+	Scene::SetView(m_camera->GetView(), m_camera->GetProjection(w, h), h);
 	
 	// Render the object
 	glUniformMatrix4fv(m_modelMatrix, 1, GL_FALSE, glm::value_ptr(glm::mat4(1.0)));
+	Benchmark::BeginTimedDraw();
 	m_scene->Render();
+	Benchmark::EndTimedDraw();
 
 	// Get any errors from OpenGL
 	auto error = glGetError();
@@ -1,14 +1,28 @@
 
 #include "scene.h"
+#include "glstate.h"
+#include "cookedmodel.h"
+#include "meshoptimizer.h"
+#include "meshsimplifier.h"
+#include "benchmark.h"
 
-#include <assimp/Importer.hpp> 		//includes the importer, which is used to read our obj file
-#include <assimp/scene.h> 			//includes the aiScene object
-#include <assimp/postprocess.h> 	//includes the postprocessing variables for the importer
-#include <assimp/color4.h> 			//includes the aiColor4 object, which is used to handle the colors from the Scene objects
+#include <chrono>
 
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 
+bool Scene::use_lods = true;
+float Scene::lod_pixel_error = 1.0f;
+unsigned int Scene::triangles = 0;
+unsigned int Scene::full_triangles = 0;
+unsigned int Scene::last_triangles = 0;
+unsigned int Scene::last_full_triangles = 0;
+glm::vec3 Scene::eye;
+float Scene::proj_scale = 1.0f;
+
+// triangle count of each LOD after the first, relative to the full mesh
+static const float LOD_RATIOS[] = {0.5f, 0.25f, 0.1f, 0.03f};
+
 Scene::Scene() {}
 
 Scene::Scene(std::string file) {
@@ -21,154 +35,254 @@ Scene::~Scene() {
 
 void Scene::Clear() {
 	for(auto& m : meshes) {
+		GLState::DeleteVertexArray(m.VAO);
 		glDeleteBuffers(1, &m.VBO);
 		glDeleteBuffers(1, &m.IBO);
 	}
 	for(auto& t : textures) {
-		glDeleteTextures(1, &t.tex);
+		GLState::DeleteTexture(t.tex);
 	}
 	meshes.clear();
 	textures.clear();
 }
 
-bool Scene::Load(std::string file) {
+bool Scene::Load(std::string file, bool optimize) {
 
 	std::string dir = file.substr(0, file.find_last_of("\\/") + 1);
 
 	Clear();
 
-	Assimp::Importer import;
-
-	// load file
-	const aiScene* scene = import.ReadFile(file.c_str(), aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_JoinIdenticalVertices);
-	if(!scene) {
-		std::cerr << "Error reading file " << file << ": " << import.GetErrorString() << std::endl;
+	CookedModel model;
+	if(!model.Load(file)) {
 		return false;
 	}
 
-	const aiVector3D zeroVec(0.0f, 0.0f, 0.0f);
+	auto start = std::chrono::high_resolution_clock::now();
 
 	// for each mesh in the file
-	for(unsigned int mesh_idx = 0; mesh_idx < scene->mNumMeshes; mesh_idx++) {
-		const aiMesh* aiM = scene->mMeshes[mesh_idx];
+	for(auto& sub : model.meshes) {
 
-		Mesh m;
-		m.textured = aiM->mMaterialIndex != 0;
-		m.material = aiM->mMaterialIndex - 1;
-
-		// for each vertex in the mesh
-		for(unsigned int vert_idx = 0; vert_idx < aiM->mNumVertices; vert_idx++) {
-			const aiVector3D* pos = &aiM->mVertices[vert_idx];
-			const aiVector3D* norm = &aiM->mNormals[vert_idx];
-			const aiVector3D* texcoord = aiM->HasTextureCoords(0) ? &aiM->mTextureCoords[0][vert_idx] : &zeroVec;
-
-			// translate vetex data
-			Vertex vert;
-			vert.pos = glm::vec3(pos->x, pos->y, pos->z);
-			vert.normal = glm::vec3(norm->x, norm->y, norm->z);
-			vert.texcoord = glm::vec2(texcoord->x, texcoord->y);
-
-			m.vertices.push_back(vert);
-		}
+		// small meshes are appended to the last one with the same material while it still fits 16-bit indices
+		if(optimize && sub.num_vertices < MERGE_MAX_VERTICES) {
 
-		// for each face in the mesh
-		for(unsigned int face_idx = 0; face_idx < aiM->mNumFaces; face_idx++) {
-			const aiFace* face = &aiM->mFaces[face_idx];
+			Mesh* merged = nullptr;
+			for(auto& m : meshes) {
+				if(m.source_material == sub.material && m.vertices.size() < MERGE_MAX_VERTICES && m.vertices.size() + sub.num_vertices <= 65536) {
+					merged = &m;
+				}
+			}
 
-			// collect face indicies
-			for(unsigned int idx = 0; idx < 3; idx++) {
-				m.indices.push_back(face->mIndices[idx]);
+			if(merged) {
+				unsigned int base = merged->vertices.size();
+				merged->vertices.insert(merged->vertices.end(), sub.vertices, sub.vertices + sub.num_vertices);
+				for(unsigned int i = 0; i < sub.num_indices; i++) {
+					merged->indices.push_back(base + sub.indices[i]);
+				}
+				continue;
 			}
 		}
 
-		// send vertex / index information to GPU
-		glGenBuffers(1, &m.VBO);
-		glGenBuffers(1, &m.IBO);
+		Mesh m;
+		m.source_material = sub.material;
+		m.textured = sub.material != 0;
+		m.material = sub.material - 1;
 
-		glBindBuffer(GL_ARRAY_BUFFER, m.VBO);
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m.IBO);
+		// cooked data is already laid out as Vertex / index arrays
+		m.vertices.assign(sub.vertices, sub.vertices + sub.num_vertices);
+		m.indices.assign(sub.indices, sub.indices + sub.num_indices);
 
-		glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex) * m.vertices.size(), &m.vertices[0], GL_STATIC_DRAW);
-		glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int) * m.indices.size(), &m.indices[0], GL_STATIC_DRAW);
+		meshes.push_back(std::move(m));
+	}
 
-		glBindBuffer(GL_ARRAY_BUFFER, 0);
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	MeshOptimizer::Stats before = {0.0f, 0.0f}, after = {0.0f, 0.0f};
+	size_t total_tris = 0, total_verts = 0, optimized_verts = 0, short_meshes = 0;
 
-		meshes.push_back(std::move(m));
+	for(auto& m : meshes) {
+
+		// weighted by size so the totals are per triangle / vertex of the whole model
+		size_t tris = m.indices.size() / 3, verts = m.vertices.size();
+		MeshOptimizer::Stats s = MeshOptimizer::Analyze(m.indices, verts);
+		before.acmr += s.acmr * tris;
+		before.atvr += s.atvr * verts;
+
+		if(optimize) {
+			MeshOptimizer::Optimize(m.vertices, m.indices);
+			s = MeshOptimizer::Analyze(m.indices, m.vertices.size());
+		}
+		after.acmr += s.acmr * tris;
+		after.atvr += s.atvr * m.vertices.size();
+
+		total_tris += tris;
+		total_verts += verts;
+		optimized_verts += m.vertices.size();
+
+		GenerateLods(m, optimize);
+		Upload(m, optimize && m.vertices.size() <= 65536);
+		short_meshes += m.index_type == GL_UNSIGNED_SHORT;
+	}
+
+	if(total_tris) {
+		printf("%s: %u meshes in %zu draws, %zu with 16-bit indices\n", file.c_str(), (unsigned int)model.meshes.size(), meshes.size(), short_meshes);
+		for(auto& m : meshes) {
+			if(m.lods.size() < 2) continue;
+			printf("  LODs:");
+			for(auto& l : m.lods) printf(" %u (%.3g)", (unsigned int)l.count / 3, l.error);
+			printf("\n");
+		}
+		if(optimize) {
+			double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+			printf("  ACMR %.3f -> %.3f, ATVR %.3f -> %.3f, optimized in %.1f ms\n",
+			       before.acmr / total_tris, after.acmr / total_tris, before.atvr / total_verts, after.atvr / optimized_verts, ms);
+		} else {
+			printf("  ACMR %.3f, ATVR %.3f (as imported)\n", before.acmr / total_tris, before.atvr / total_verts);
+		}
 	}
 
 	// for each material
-	for(unsigned int mat_idx = 0; mat_idx < scene->mNumMaterials; mat_idx++) {
-		const aiMaterial* mat = scene->mMaterials[mat_idx];
+	for(auto& path : model.materials) {
 
-		if(mat->GetTextureCount(aiTextureType_DIFFUSE) > 0) {
+		// if the diffuse (color) texture is there
+		if(path.size()) {
 
-			aiString path;
+			Texture t;
 
-			// if the diffuse (color) texture is there
-			if(mat->GetTexture(aiTextureType_DIFFUSE, 0, &path, nullptr, nullptr, nullptr, nullptr, nullptr) == AI_SUCCESS) {
+			// load file
+			int w, h;
+			std::string full_path = dir + path;
+			unsigned char* bitmap = stbi_load(full_path.c_str(), &w, &h, nullptr, 4);
+			if(!bitmap) {
+				std::cerr << "Failed to load texture from " << full_path.c_str() << std::endl;
+				return false;
+			}
 
-				Texture t;
+			// Set up OpenGL texture
+			glGenTextures(1, &t.tex);
+			GLState::BindTexture(GL_TEXTURE_2D, t.tex);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, bitmap);
+			glGenerateMipmap(GL_TEXTURE_2D);
 
-				// load file
-				int w, h;
-				std::string full_path = dir + path.C_Str();
-				unsigned char* bitmap = stbi_load(full_path.c_str(), &w, &h, nullptr, 4);
-				if(!bitmap) {
-					std::cerr << "Failed to load texture from " << full_path.c_str() << std::endl;
-					return false;
-				}
+			// free image loaded from file
+			stbi_image_free(bitmap);
 
-				// Set up OpenGL texture
-				glGenTextures(1, &t.tex);
-				glBindTexture(GL_TEXTURE_2D, t.tex);
-				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-				glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, bitmap);
-				glGenerateMipmap(GL_TEXTURE_2D);
-				glBindTexture(GL_TEXTURE_2D, 0);
-
-				// free image loaded from file
-				stbi_image_free(bitmap);
-
-				textures.push_back(t);
-			}
+			textures.push_back(t);
 		}
 	}
 
 	return true;
 }
 
-void Scene::Render() {
+void Scene::SetView(const glm::mat4& view, const glm::mat4& proj, int screen_height) {
 
-	glEnableVertexAttribArray(0);
-	glEnableVertexAttribArray(1);
-	glEnableVertexAttribArray(2);
+	eye = glm::vec3(glm::inverse(view)[3]);
+	proj_scale = proj[1][1] * screen_height / 2.0f;
 
-	for(auto& m : meshes) {
+	last_triangles = triangles;
+	last_full_triangles = full_triangles;
+	triangles = full_triangles = 0;
+}
 
-		glBindBuffer(GL_ARRAY_BUFFER, m.VBO);
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m.IBO);
+void Scene::Render() {
 
-		glActiveTexture(GL_TEXTURE0);
-		if(m.textured) {
-			glBindTexture(GL_TEXTURE_2D, textures[m.material].tex);
+	for(auto& m : meshes) {
+
+		// the coarsest LOD whose error still projects to less than lod_pixel_error
+		const Mesh::Lod* lod = &m.lods[0];
+		if(use_lods) {
+			float distance = std::max(glm::length(m.center - eye) - m.radius, 1e-6f);
+			for(auto& l : m.lods) {
+				if(l.error * proj_scale / distance <= lod_pixel_error) lod = &l;
+			}
 		}
 
-		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), 0);
-		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex,normal));
-		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex,texcoord));
+		GLState::BindVertexArray(m.VAO);
+		GLState::BindTexture(GL_TEXTURE_2D, m.textured ? textures[m.material].tex : 0);
+
+		size_t index_size = m.index_type == GL_UNSIGNED_SHORT ? sizeof(unsigned short) : sizeof(unsigned int);
+		glDrawElements(GL_TRIANGLES, lod->count, m.index_type, (void*)(lod->first * index_size));
+		Benchmark::draw_calls++;
+		Benchmark::triangles += lod->count / 3;
 
-		glDrawElements(GL_TRIANGLES, m.indices.size(), GL_UNSIGNED_INT, 0);
+		triangles += lod->count / 3;
+		full_triangles += m.lods[0].count / 3;
+	}
+}
 
-		glBindTexture(GL_TEXTURE_2D, 0);
-		glBindBuffer(GL_ARRAY_BUFFER, 0);
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+void Scene::GenerateLods(Mesh& m, bool optimize) {
+
+	glm::vec3 lo = m.vertices.size() ? m.vertices[0].pos : glm::vec3(0.0f), hi = lo;
+	for(auto& v : m.vertices) {
+		lo = glm::min(lo, v.pos);
+		hi = glm::max(hi, v.pos);
+	}
+	m.center = (lo + hi) * 0.5f;
+	m.radius = 0.0f;
+	for(auto& v : m.vertices) {
+		m.radius = std::max(m.radius, glm::length(v.pos - m.center));
 	}
 
-	glDisableVertexAttribArray(0);
-	glDisableVertexAttribArray(1);
-	glDisableVertexAttribArray(2);
+	Mesh::Lod full = {0, (GLsizei)m.indices.size(), 0.0f};
+	m.lods.assign(1, full);
+
+	size_t full_tris = m.indices.size() / 3;
+	if(full_tris < LOD_MIN_TRIANGLES) return;
+
+	// each LOD is simplified from the one before, so the errors add up
+	std::vector<unsigned int> prev(m.indices), lod;
+	float error = 0.0f;
+
+	for(float ratio : LOD_RATIOS) {
+
+		error += MeshSimplifier::Simplify(m.vertices, prev, (size_t)(full_tris * ratio) * 3, lod);
+
+		// stuck on borders / flips, more levels would just be copies
+		if(lod.size() > prev.size() * 9 / 10) break;
+
+		if(optimize) MeshOptimizer::OptimizeVertexCache(lod, m.vertices.size());
+
+		Mesh::Lod l = {(unsigned int)m.indices.size(), (GLsizei)lod.size(), error};
+		m.lods.push_back(l);
+		m.indices.insert(m.indices.end(), lod.begin(), lod.end());
+
+		prev.swap(lod);
+	}
+}
+
+void Scene::Upload(Mesh& m, bool short_indices) {
+
+	m.index_type = short_indices ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+
+	// send vertex / index information to GPU
+	glGenVertexArrays(1, &m.VAO);
+	glGenBuffers(1, &m.VBO);
+	glGenBuffers(1, &m.IBO);
+
+	// the element buffer binding and attribute pointers are captured by the VAO
+	GLState::BindVertexArray(m.VAO);
+	glBindBuffer(GL_ARRAY_BUFFER, m.VBO);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m.IBO);
+
+	glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex) * m.vertices.size(), m.vertices.data(), GL_STATIC_DRAW);
+
+	if(short_indices) {
+		// half the index bandwidth
+		std::vector<unsigned short> indices(m.indices.begin(), m.indices.end());
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned short) * indices.size(), indices.data(), GL_STATIC_DRAW);
+	} else {
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int) * m.indices.size(), m.indices.data(), GL_STATIC_DRAW);
+	}
+
+	glEnableVertexAttribArray(0);
+	glEnableVertexAttribArray(1);
+	glEnableVertexAttribArray(2);
+
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), 0);
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex,normal));
+	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex,texcoord));
+
+	GLState::BindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
 }
@@ -0,0 +1,14 @@
+
+#version 330
+
+// per orbit - unit circle to orbit, and the number of segments along it
+layout (location = 1) in mat4 i_model;
+layout (location = 5) in float i_segments;
+
+uniform mat4 view, proj;
+
+void main() {
+	// vertices past the last segment stay on the first point
+	float t = 6.28318531 * min(float(gl_VertexID), i_segments) / i_segments;
+	gl_Position = proj * view * i_model * vec4(cos(t), 0.0, sin(t), 1.0);
+}
@@ -0,0 +1,18 @@
+#version 330
+
+smooth in vec3 f_norm;
+smooth in vec3 f_pos;
+
+out vec4 color;
+
+uniform vec3 lightColor;
+uniform vec3 lightPos;
+uniform float ambientStrength;
+
+void main() {
+	vec3 ambient = ambientStrength * lightColor;
+	vec3 lightDir = normalize(lightPos - f_pos);
+	float diff = clamp(dot(normalize(f_norm), lightDir), 0.0, 1.0);
+	vec3 diffuse = diff * lightColor;
+	color = vec4((ambient + diffuse) * vec3(0.45, 0.4, 0.36), 1.0);
+}
@@ -0,0 +1,23 @@
+#version 330
+
+layout (location = 0) in vec3 v_pos;
+layout (location = 1) in vec3 v_norm;
+
+// per rock - position and size, rotation quaternion
+layout (location = 3) in vec4 i_pos_scale;
+layout (location = 4) in vec4 i_rotation;
+
+smooth out vec3 f_norm;
+smooth out vec3 f_pos;
+
+uniform mat4 view, proj;
+
+vec3 rotate(vec4 q, vec3 v) {
+	return v + 2.0 * cross(q.xyz, cross(q.xyz, v) + q.w * v);
+}
+
+void main() {
+	f_pos = i_pos_scale.xyz + i_pos_scale.w * rotate(i_rotation, v_pos);
+	f_norm = rotate(i_rotation, v_norm);
+	gl_Position = proj * view * vec4(f_pos, 1.0);
+}
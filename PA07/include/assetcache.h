@@ -0,0 +1,33 @@
+#ifndef ASSETCACHE_H
+#define ASSETCACHE_H
+
+#include <string>
+#include <memory>
+#include <unordered_map>
+
+#include "scene.h"
+
+// Shares GPU meshes and textures between every Scene that loads the same file.
+// Entries are held weakly: an asset lives as long as some Scene references it,
+// and asking for a file that is already loaded is a single hash lookup.
+// Misses are handed to the AssetLoader and returned empty straight away.
+class AssetCache {
+public:
+	// mesh idx of a model file, starts loading on first use
+	static std::shared_ptr<Scene::Mesh> GetMesh(const std::string& file, int idx);
+	// texture file, starts loading on first use
+	static std::shared_ptr<Scene::Texture> GetTexture(const std::string& file);
+
+	// print live asset counts, their GPU memory, and cache hits/misses
+	static void Report();
+
+private:
+	static std::unordered_map<std::string, std::weak_ptr<Scene::Mesh>> meshes;
+	static std::unordered_map<std::string, std::weak_ptr<Scene::Texture>> textures;
+
+	static unsigned int mesh_hits, mesh_loads, texture_hits, texture_loads;
+	// time spent on misses, on the loader threads and on the render thread
+	static double read_ms, upload_ms;
+};
+
+#endif // ASSETCACHE_H
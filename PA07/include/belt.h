@@ -0,0 +1,59 @@
+#ifndef BELT_H
+#define BELT_H
+
+#include <vector>
+#include "graphics_headers.h"
+
+// A belt of small rocks on circular orbits, drawn as one instanced low-poly mesh.
+// Every frame the worker threads move the rocks in chunks, cull each one against
+// the view frustum and write the survivors' instance data, which is packed into
+// one buffer and drawn with a single glDrawElementsInstanced.
+class Belt {
+public:
+	Belt();
+	~Belt();
+
+	// scatter count rocks between inner and outer, orbiting a mass gm (G = 1) at the origin
+		// rock sizes follow the width of the belt
+	void Generate(unsigned int count, float inner, float outer, float gm);
+	unsigned int Size() const;
+
+	// move every rock on by dt, applied during the next Render
+	void Update(float dt);
+	// move and cull the rocks on the worker threads, then draw the visible ones
+		// the rock shader must be bound, view_proj is the camera's proj * view, rocks are placed relative to origin
+	void Render(const glm::mat4& view_proj, const glm::dvec3& origin);
+
+	// frustum culling, off draws every rock
+	bool culling;
+
+	// rocks drawn by the last Render, and the time moving / culling / packing them took
+	unsigned int last_visible;
+	double last_cull_ms;
+
+private:
+	// position and size, then rotation as a quaternion - matches rock.v
+	struct Instance {
+		glm::vec4 pos_scale;
+		glm::vec4 rotation;
+	};
+
+	// icosphere with its vertices pushed in and out, shared by every rock
+	void CreateMesh();
+
+	// per rock - angles in radians, rates per unit of time
+	std::vector<float> radius, height, angle, rate;
+	std::vector<float> scale, axis_x, axis_y, axis_z, spin, spin_rate;
+	float pending;
+
+	// visible rocks of each chunk, packed into the instance buffer after culling
+	std::vector<std::vector<Instance>> chunks;
+
+	GLuint vao, vbo, ibo, instance_vbo;
+	GLsizei index_count;
+	// farthest any vertex of the mesh is from its centre
+	float mesh_radius;
+	size_t capacity;
+};
+
+#endif // BELT_H
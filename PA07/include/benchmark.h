@@ -0,0 +1,54 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <vector>
+#include <string>
+#include <chrono>
+
+#include "graphics_headers.h"
+
+// Frame-throughput benchmark for headless runs
+class Benchmark {
+public:
+	Benchmark();
+	~Benchmark();
+
+	// read --headless, --frames, --png-dir, --png-every from the command-line arguments
+	void ParseArgs(const std::vector<std::string>& args);
+
+	// start timing a frame
+	void BeginFrame();
+	// wait for the GPU, record the frame, and optionally dump it as a PNG
+	void EndFrame(int w, int h);
+	// print average/p99 frame time, draw calls and GL state changes
+	void Report();
+
+	// position along the scripted camera path, [0, 1)
+	float Progress();
+	// whether the requested number of frames has been rendered
+	bool Done();
+
+	bool headless = false;
+	int frames = 600;
+	int png_every = 0;
+	std::string png_dir;
+
+	// incremented by every glDraw* call made while rendering a frame
+	static unsigned int draw_calls;
+	// triangles submitted by the model draws in a frame
+	static unsigned int triangles;
+
+private:
+	// write an RGBA framebuffer to disk, flipped to top-down row order
+	bool WritePNG(std::string path, int w, int h, const std::vector<unsigned char>& rgba);
+
+	int frame = 0;
+	std::chrono::high_resolution_clock::time_point frame_start;
+
+	std::vector<double> frame_times;
+	std::vector<unsigned int> frame_draw_calls;
+	std::vector<unsigned int> frame_triangles;
+	std::vector<unsigned int> frame_state_changes;
+};
+
+#endif // BENCHMARK_H
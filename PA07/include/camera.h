@@ -18,7 +18,10 @@ enum class CameraType : int {
 class Camera {
 public:
 	virtual glm::mat4 GetProjection(float w, float h) = 0;
+	// rotation only, the camera sits at the origin - everything is drawn relative to GetPosition
+		// so world positions far from the sun don't lose float precision on the way to the GPU
 	virtual glm::mat4 GetView() = 0;
+	virtual glm::dvec3 GetPosition() = 0;
 	// for the skybox transform
 	virtual glm::mat4 GetViewWithoutTranslate() = 0;
 
@@ -45,6 +48,7 @@ public:
 
 	glm::mat4 GetProjection(float w, float h);
 	glm::mat4 GetView();
+	glm::dvec3 GetPosition();
 	glm::mat4 GetViewWithoutTranslate();
 	void reset();
 	void update();
@@ -52,7 +56,7 @@ public:
 	void setDistance(float d);
 
 private:
-	glm::vec3 pos, lookingAt;
+	glm::dvec3 pos, lookingAt;
 	float pitch, yaw, radius;
 
 	friend class Graphics;
@@ -67,6 +71,7 @@ public:
 
 	glm::mat4 GetProjection(float w, float h);
 	glm::mat4 GetView();
+	glm::dvec3 GetPosition();
 	glm::mat4 GetViewWithoutTranslate();
 	void reset();
 	void update();
@@ -75,7 +80,8 @@ public:
 
 private:
 	unsigned int last_update;
-	glm::vec3 pos, front, up, right, globalUp;
+	glm::dvec3 pos;
+	glm::vec3 front, up, right, globalUp;
 	float pitch, yaw, speed;
 
 	friend class Graphics;
@@ -92,6 +98,7 @@ public:
 	void set(Planet* track);
 	glm::mat4 GetProjection(float w, float h);
 	glm::mat4 GetView();
+	glm::dvec3 GetPosition();
 	glm::mat4 GetViewWithoutTranslate();
 	
 	void reset();
@@ -100,7 +107,8 @@ public:
 	void setDistance(float d) {}
 
 private:
-	glm::vec3 pos, direction;
+	glm::dvec3 pos;
+	glm::vec3 direction;
 
 	friend class Graphics;
 };
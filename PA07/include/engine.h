@@ -9,6 +9,7 @@
 #include "graphics.h"
 #include "imgui_impl.h"
 #include "solarsystem.h"
+#include "benchmark.h"
 #include <imgui.h>
 
 class Engine {
@@ -21,6 +22,8 @@ public:
 	bool Initialize(std::vector<std::string> args);
 	// run the game loop
 	void Run();
+	// render a scripted, fixed-timestep run offscreen and report frame timings
+	void RunHeadless();
 	// process SDL events
 	void Events();
 	
@@ -30,6 +33,9 @@ public:
   
 private:
 
+	// simulate and render a single frame over dT
+	void Frame(unsigned int dT);
+
 	// process SDL keyboard events
 	void KeyboardEvts();
 	// process SDL mouse events
@@ -56,8 +62,13 @@ private:
 	Graphics *m_graphics;
 	
 	// Timing
+	Benchmark m_benchmark;
 	unsigned int m_DT;
 	long long m_currentTimeMillis;
+	long long m_startTimeMillis;
+	// frames rendered, and whether assets are still streaming in
+	unsigned int m_frames;
+	bool m_loading;
 	bool m_running;
 };
 
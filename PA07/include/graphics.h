@@ -12,6 +12,8 @@
 
 struct MatLocs {
 	GLint model, rotate, ambient;
+	// camera position, model matrices are built relative to it
+	glm::dvec3 origin;
 };
 
 class Graphics {
@@ -20,8 +22,8 @@ public:
 	Graphics();
 	~Graphics();
 
-	// setup openGL
-	bool Initialize(int width, int height);
+	// setup openGL - headless renders into an offscreen framebuffer instead of the window
+	bool Initialize(int width, int height, bool headless = false);
 	
 	// update camera simulation
 	void Update(unsigned int dt, Planet* tracked);
@@ -29,6 +31,10 @@ public:
 	MatLocs BeginPlanetRender(int w, int h);
 	// setup rendering context for paths
 	GLint BeginPathRender(int w, int h);
+	// setup rendering context for orbit paths, returns the height in pixels of one unit at distance one
+	float BeginOrbitRender(int w, int h);
+	// setup rendering context for the asteroid belt, returns proj * view for culling
+	glm::mat4 BeginBeltRender(int w, int h);
 	// render skybox
 	void RenderSkybox(int w, int h);
 	// clear window
@@ -43,17 +49,23 @@ public:
 	void SetCameraDistance(float d);
 	// check if using a planet-tracking camera
 	bool IsTracking();
+	// world position of the current camera - views are built with it at the origin
+	glm::dvec3 GetCameraPosition();
+	// place the camera along the scripted benchmark path, t in [0, 1)
+	void FollowCameraPath(float t);
 
 private:
 	// get a pointer to the current camera (orbit_camrea, free_camera, or tracking_camera)
 	Camera* GetCamera();
 
+	// offscreen render target for headless mode
+	bool CreateOffscreenTarget(int width, int height);
+	bool headless = false;
+	GLuint offscreen_fbo = 0, offscreen_color = 0, offscreen_depth = 0;
+
 	// set up the skybox cubemap texture
 	bool CreateCubeMap(std::string file);
 	GLuint cubemap_tex, cubemap_vbo, cubemap_vao;
-	
-	// VAOs for mesh rendering
-	GLuint planet_VAO, path_VAO;
 
 	// get openGL error as string
 	std::string ErrorString(GLenum error);
@@ -65,7 +77,7 @@ private:
 	TrackingCamera 	tracking_camera;
 
 	// shaders
-	Shader *m_planet_shader, *m_cubemap_shader, *m_path_shader;
+	Shader *m_planet_shader, *m_cubemap_shader, *m_path_shader, *m_rock_shader, *m_orbit_shader;
 };
 
 #endif /* GRAPHICS_H */
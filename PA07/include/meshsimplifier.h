@@ -0,0 +1,19 @@
+#ifndef MESHSIMPLIFIER_H
+#define MESHSIMPLIFIER_H
+
+#include <vector>
+#include "graphics_headers.h"
+
+// Quadric error edge-collapse simplification for building LOD chains. Vertices
+// are only ever collapsed onto other existing vertices, so every LOD indexes the
+// same vertex buffer and costs nothing but an index range.
+class MeshSimplifier {
+public:
+	// collapse edges until at most target_indices are left, or until nothing more can go
+	// without opening a border or flipping a triangle
+		// returns the largest distance the surface moved, in model units
+	static float Simplify(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices,
+	                      size_t target_indices, std::vector<unsigned int>& out);
+};
+
+#endif // MESHSIMPLIFIER_H
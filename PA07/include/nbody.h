@@ -0,0 +1,70 @@
+#ifndef NBODY_H
+#define NBODY_H
+
+#include <vector>
+#include "graphics_headers.h"
+
+// Direct gravitational simulation of point masses. Every step rebuilds a
+// Barnes-Hut octree over the bodies, works out each body's acceleration from it
+// on the worker pool, and integrates with kick-drift-kick leapfrog, which keeps
+// orbits from slowly gaining or losing energy the way Euler steps do.
+// Masses are gravitational parameters (G = 1), in scene units and days.
+class NBody {
+public:
+	NBody();
+
+	void Clear();
+	// add a body, returns its index
+	unsigned int Add(glm::vec3 pos, glm::vec3 vel, float mass);
+	unsigned int Size() const;
+
+	// advance every body by dt
+	void Step(float dt);
+
+	glm::vec3 Position(unsigned int i) const;
+	glm::vec3 Velocity(unsigned int i) const;
+
+	// cells further away than their size / theta are treated as one mass
+	float theta;
+	// added to every squared distance, so close passes don't fling bodies away
+	float softening;
+
+	// milliseconds each phase of the last Step took
+	double build_ms, force_ms, integrate_ms;
+
+	// step count bodies in a disk around one star, printing the time per phase and the force error against direct summation
+	static void Benchmark(unsigned int count, unsigned int steps = 20);
+
+private:
+	// octree cell holding the sorted bodies begin .. end - 1, internal cells have count
+		// children starting at first
+	struct Node {
+		float cx, cy, cz, mass;
+		float size;
+		unsigned int begin, end, first, count;
+		bool leaf;
+	};
+
+	// cells and bodies acting on one group
+	struct Interactions {
+		std::vector<float> x, y, z, m;
+	};
+
+	void Build();
+	void BuildNode(unsigned int node, unsigned int begin, unsigned int end, glm::vec3 center, float half, unsigned int depth);
+	void Forces();
+	// one walk of the tree per group of nearby bodies gathers what acts on them, then each body sums the list
+	void GroupForces(const Node& group, Interactions& list);
+
+	std::vector<float> x, y, z, vx, vy, vz, ax, ay, az, m;
+	// accelerations match the current positions
+	bool forces_valid;
+
+	std::vector<Node> nodes;
+	std::vector<unsigned int> groups;
+	// body indices in tree order, and their positions / masses copied in that order for the leaves
+	std::vector<unsigned int> order, scratch;
+	std::vector<float> sx, sy, sz, sm;
+};
+
+#endif // NBODY_H
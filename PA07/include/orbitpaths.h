@@ -0,0 +1,41 @@
+#ifndef ORBITPATHS_H
+#define ORBITPATHS_H
+
+#include <vector>
+#include "graphics_headers.h"
+#include "orbits.h"
+
+// Every orbit in the orbit table drawn as one instanced line strip. An orbit is
+// an affine image of the unit circle, so nothing but one transform and a segment
+// count per orbit is sent each frame - orbit.v builds the circle's points from
+// gl_VertexID. The segment count follows how big the orbit is on screen near
+// the camera, so distant orbits are a handful of lines and the one the camera
+// sits on is smooth.
+class OrbitPaths {
+public:
+	OrbitPaths();
+	~OrbitPaths();
+
+	// draw every orbit relative to origin, the orbit path shader must be bound
+		// proj_scale is the height in pixels of one unit at distance one
+	void Render(const Orbits& orbits, const glm::dvec3& origin, float proj_scale);
+
+	// how far in pixels a segment may stray from the real orbit
+	float pixel_error;
+
+	// segments drawn by the last Render
+	unsigned int last_segments;
+
+private:
+	// unit circle to orbit, then the points along it - matches orbit.v
+	struct Instance {
+		glm::mat4 model;
+		float segments;
+	};
+
+	std::vector<Instance> instances;
+
+	GLuint vao, vbo;
+};
+
+#endif // ORBITPATHS_H
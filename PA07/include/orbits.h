@@ -0,0 +1,65 @@
+#ifndef ORBITS_H
+#define ORBITS_H
+
+#include <vector>
+#include "graphics_headers.h"
+
+// Every orbiting body in one structure-of-arrays table. Positions come from each
+// body's Keplerian orbit around its parent, and parents are always added before
+// their children, so one pass in index order places the whole hierarchy.
+// Kepler's equation is solved with a fixed number of Newton steps and no branches,
+// so the solver loop is vectorized across bodies by the compiler.
+class Orbits {
+public:
+	// add a body orbiting parent (-1 for the origin), returns its index
+		// its orbit and spin start out zero, the body sits on its parent
+	unsigned int Add(int parent);
+	void Clear();
+	unsigned int Size() const;
+
+	// a semi-major axis, e eccentricity (< 1) - orient turns the x/z orbit plane into world space
+		// the parent sits at a focus, periapsis is along orient's x axis
+	void SetOrbit(unsigned int i, float a, float e, const glm::mat3& orient);
+	// mean motion and spin rate in radians per unit of time passed to Update
+	void SetMotion(unsigned int i, float mean_motion, float mean_anomaly, float spin_rate, float spin);
+
+	// advance every body by dt and solve for the new positions
+	void Update(float dt);
+
+	glm::dvec3 Position(unsigned int i) const;
+	// position of i's parent, the origin for top level bodies
+	glm::dvec3 ParentPosition(unsigned int i) const;
+	float Spin(unsigned int i) const;
+	int Parent(unsigned int i) const;
+
+	// velocity along the orbit relative to the parent, per unit of time
+	glm::vec3 Velocity(unsigned int i) const;
+	// mass of the parent (G = 1) that would make i's orbit a real two body orbit, 0 if i doesn't move
+	float GM(unsigned int i) const;
+	// move i somewhere else until the next Update, for positions simulated elsewhere
+	void SetPosition(unsigned int i, glm::dvec3 pos);
+	// maps the unit circle in the x/z plane onto i's orbit, relative to origin
+		// the columns are the semi-major axis, the orbit normal, the semi-minor axis and the ellipse's centre
+	glm::mat4 PathTransform(unsigned int i, const glm::dvec3& origin) const;
+
+	// propagate count bodies around one star, steps times, against a scalar libm solver, and print timings
+	static void Benchmark(unsigned int count, unsigned int steps = 100);
+
+private:
+	std::vector<int> parent;
+
+	// orbit shape - b is the semi-minor axis
+	std::vector<float> a, b, e;
+	// orbit plane axes in world space, p towards periapsis
+	std::vector<float> px, py, pz, qx, qy, qz;
+
+	// radians
+	std::vector<float> mean_motion, mean_anomaly;
+	std::vector<float> spin_rate, spin;
+
+	// world position, from the last Update
+		// each orbit is solved in floats, but the sums down the hierarchy far from the sun need doubles
+	std::vector<double> x, y, z;
+};
+
+#endif // ORBITS_H
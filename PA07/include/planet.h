@@ -6,6 +6,8 @@
 #include <string>
 #include <picojson.h>
 #include "scene.h"
+#include "orbits.h"
+#include "scenegraph.h"
 
 struct ss_settings;
 struct MatLocs;
@@ -17,20 +19,24 @@ public:
 	Planet(std::string json);
 	~Planet();
 
-	// get model matrix based on current attributes
-	glm::mat4 getModel();
 	// get position based on current attributes
-	glm::vec3 getPos();
+	glm::dvec3 getPos();
 
 private:
 	friend class SolarSystem;
 
 	// render planet, moons, rings based on settings
 	void Render(const MatLocs& matlocs, const ss_settings& settings);
-	// render orbit path
-	void RenderPath(GLint shaderMdlmx);
-	// simulate planet movement over dT based on settings
-	void Update(unsigned int dT, const ss_settings& settings, glm::mat4 translation = glm::mat4(1.0f));
+	// add this planet and its moons to the orbit table, orbiting parent (-1 for the origin)
+	void AddToOrbits(Orbits& table, int parent = -1);
+	// nodes for this planet's orbit frame, its body and its rings, and the same for its moons
+	void AddToGraph(SceneGraph& graph);
+	// move the orbit frames to where the orbit table has them relative to origin and spin the bodies
+		// the graph works out the model matrices on its next Update
+	void Place(const glm::dvec3& origin);
+	// orbit shape and transforms for the current settings, parent_tilt is the parent's orbit tilt
+		// movement itself is done by the orbit table
+	void SetupOrbit(const ss_settings& settings, const glm::mat4& parent_tilt = glm::mat4(1.0f));
 	// load model/textures into planet scene
 	bool LoadScene();
 	// free planet scene assets
@@ -40,8 +46,6 @@ private:
 	bool LoadJSON(std::string json);
 	// load attributes from JSON object
 	void LoadJSONObj(const picojson::object& obj);
-	// update current planet movement angles, called from Update
-	void UpdateAngles(unsigned int dT, const ss_settings& settings);
 
 	struct ScaleResult {
 		float orbit_radius, scaled_diameter, scaled_inclination_orbit;
@@ -49,14 +53,12 @@ private:
 	// get neccesary values for modifying simulation settings
 	ScaleResult ScaleForSettings(const ss_settings& settings);
 
-	// generate orbit trace to highlight orbit path
-	void GenerateOrbitTrace(const ss_settings& settings); 
-
 	// ring structure
 	struct Ring {
 		std::string model, texture;
 		float tilt;
 		Scene scene;
+		unsigned int node;
 	};
 
 	// attributes
@@ -70,23 +72,26 @@ private:
 	float rank, inclination_orbit, inclination_equator, orbital_eccentricity;
 
 	// transformations
-	glm::mat4 parentmx, scalemx, rotatemx, tiltmx, orbittiltmx, translatemx;
-	glm::vec3 pos_for_tracking;
+	glm::mat4 tiltmx, orbittiltmx;
+	float scaled_diameter = 0.0f;
+
+	// row in the orbit table holding position and spin
+	Orbits* orbits = nullptr;
+	unsigned int body = 0;
+
+	// the orbit frame - position and orbit tilt - with the body and rings under it
+	SceneGraph* graph = nullptr;
+	unsigned int frame_node = 0, body_node = 0;
 
 	// children
 	std::vector<Planet> moons;
 	std::vector<Ring> rings;
 
-	// for tracing orbit & movement paths
-	std::vector<glm::vec3> orbit_trace;
-	GLuint orbit_trace_vao, orbit_trace_vbo;
-
-	std::vector<glm::vec3> movement_trace;
 
 	// scene
 	Scene scene;
 
-	// current position
+	// starting position
 	float current_orbit_angle	= 0.0f;
 	float current_rotate_angle 	= 0.0f;
 };
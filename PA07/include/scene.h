@@ -3,7 +3,9 @@
 #define MESH_H
 
 #include <vector>
+#include <memory>
 #include "graphics_headers.h"
+#include "assetloader.h"
 
 class Scene {
 
@@ -12,35 +14,104 @@ public:
 	~Scene();
 
 	// load model mesh from file - loads only first mesh
+		// shared with every other scene that loaded the same file
+		// loads in the background, nothing is drawn until it arrives
 	bool LoadModel(std::string file);
 	// load texture from file to be associated with mesh
+		// shared with every other scene that loaded the same file
+		// loads in the background, a grey placeholder is drawn until it arrives
 	bool LoadTexture(std::string file);
 
 	// render the scene (model + texture)
-		// setup the model matrix BEFOREHAND
-	void Render();
-	// free mesh asset
+		// setup the model matrix BEFOREHAND, modelmx is only used to pick the LOD
+	void Render(const glm::mat4& modelmx);
+	// release this scene's reference to its mesh
 	void DeleteMesh();
-	// free texture asset
+	// release this scene's reference to its texture
 	void DeleteTexture();
+
+	// LOD selection, shared by every scene
+		// camera and screen size used to project LOD errors, call once a frame before rendering
+	static void SetView(const glm::mat4& view, const glm::mat4& proj, int screen_height);
+	static bool use_lods;
+	// how far the simplified surface may be off on screen before a finer LOD is drawn, in pixels
+	static float lod_pixel_error;
+	// triangles drawn since SetView, and how many that would have been without LODs
+	static unsigned int triangles, full_triangles;
+	// totals from the last complete frame
+	static unsigned int last_triangles, last_full_triangles;
 	
 private:
+	friend class AssetCache;
+
+	// meshes with fewer triangles than this are always drawn in full
+	static const unsigned int LOD_MIN_TRIANGLES = 1024;
 
 	struct Mesh {
 
-		GLuint VBO, IBO;
+		Mesh();
+		~Mesh();
+
+		// VAO holds the buffer bindings and attribute layout, configured once at load
+		GLuint VAO, VBO, IBO;
 
 		std::vector<Vertex> 		vertices;
 		std::vector<unsigned int> 	indices; 
+
+		// LOD 0 is the full mesh, the simplified ones follow it in indices / IBO
+		struct Lod {
+
+			unsigned int first;
+			GLsizei count;
+			// how far the surface moved from LOD 0, in model units
+			float error;
+		};
+		std::vector<Lod> lods;
+
+		// bounding sphere in model space, for the distance to the camera
+		glm::vec3 center;
+		float radius;
+
+		// background load filling this mesh in
+		std::shared_ptr<AssetLoader::Task> pending;
 	};
 
 	struct Texture {
 
+		Texture();
+		~Texture();
+
 		GLuint handle;
+		// GPU memory including the mip chain
+		size_t bytes;
 	};
 
-	Mesh mesh;
-	Texture texture;
+	// decoded RGBA8 pixels waiting to be uploaded
+	struct Image {
+
+		Image();
+		~Image();
+
+		int w, h;
+		unsigned char* pixels;
+	};
+
+	// only called by AssetCache on a miss
+		// read from disk into the CPU-side arrays / pixels, safe on any thread
+	static bool ReadMesh(const std::string& file, int idx, Mesh& mesh);
+	static bool ReadTexture(const std::string& file, Image& image);
+		// append simplified copies of the mesh's triangles to its indices
+	static void GenerateLods(Mesh& mesh);
+		// create the GL objects, render thread only
+	static void UploadMesh(Mesh& mesh);
+	static void UploadTexture(Texture& texture, const Image& image);
+
+	static glm::vec3 eye;
+	// pixels covered by one world unit at distance one
+	static float proj_scale;
+
+	std::shared_ptr<Mesh> mesh;
+	std::shared_ptr<Texture> texture;
 };
 
 #endif // MESH_H
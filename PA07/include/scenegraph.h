@@ -0,0 +1,75 @@
+#ifndef SCENEGRAPH_H
+#define SCENEGRAPH_H
+
+#include <vector>
+#include <functional>
+#include "graphics_headers.h"
+#include <glm/gtc/quaternion.hpp>
+
+// Transform hierarchy kept in flat arrays. Each node has a parent and a local
+// translation / rotation / scale; setting any of them marks the node dirty, and
+// Update recomputes the world matrix of every dirty node and everything under it,
+// leaving the rest alone. Internally the nodes are stored sorted by depth, so
+// Update is one linear pass over each level with every parent already final, and
+// big levels can be split across threads.
+class SceneGraph {
+public:
+	// runs fn(0) .. fn(count - 1), possibly on other threads, returning once all are done
+	typedef std::function<void(unsigned int, std::function<void(unsigned int)>)> ParallelFor;
+
+	SceneGraph();
+
+	// add a node under parent (-1 for a root), returns its handle
+		// it starts out at the parent's origin with no rotation or scale
+	unsigned int Add(int parent = -1);
+	// move node under another parent, keeping its local transform - never under itself or its children
+	void SetParent(unsigned int node, int parent);
+	void Clear();
+	unsigned int Size() const;
+
+	void SetTranslation(unsigned int node, const glm::vec3& t);
+	void SetRotation(unsigned int node, const glm::quat& r);
+	void SetScale(unsigned int node, const glm::vec3& s);
+	// translation, then rotation, then scale - T * R * S
+	void SetLocal(unsigned int node, const glm::vec3& t, const glm::quat& r, const glm::vec3& s);
+
+	// recompute world matrices below every node changed since the last Update
+		// levels bigger than a chunk are split across parallel_for when there is one
+	void Update(const ParallelFor& parallel_for = nullptr);
+
+	// as of the last Update
+	const glm::mat4& World(unsigned int node) const;
+
+	// world matrices recomputed by the last Update
+	unsigned int last_updated;
+
+	// count nodes in a wide tree, timing a full Update, an Update with a few changed
+	// nodes and recomputing everything recursively from scratch, then prints them
+	static void Benchmark(unsigned int count, const ParallelFor& parallel_for = nullptr, unsigned int frames = 20);
+
+private:
+	// depth sort the nodes after the hierarchy changed
+	void Sort();
+	// nodes begin .. end - 1, all on one level
+	unsigned int UpdateRange(unsigned int begin, unsigned int end);
+
+	// by handle
+	std::vector<int> parent;
+	std::vector<unsigned int> slot;
+
+	// by slot - parents always come before their children
+	std::vector<int> parent_slot;
+	std::vector<glm::vec3> translation, scale;
+	std::vector<glm::quat> rotation;
+	std::vector<glm::mat4> world;
+	// local transform changed / the Update that last recomputed world
+	std::vector<unsigned char> dirty;
+	std::vector<unsigned int> stamp;
+
+	// first slot of each level, then the end
+	std::vector<unsigned int> levels;
+	bool sorted;
+	unsigned int frame;
+};
+
+#endif // SCENEGRAPH_H
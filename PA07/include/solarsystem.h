@@ -3,6 +3,10 @@
 #define SOLARSYSTEM_H
 
 #include "planet.h"
+#include "orbits.h"
+#include "nbody.h"
+#include "belt.h"
+#include "orbitpaths.h"
 #include <vector>
 #include <string>
 
@@ -21,6 +25,11 @@ struct ss_settings {
 	bool do_time_scale		= true;		// use time_scale or use real-time (incredibly slow)
 	bool do_distance_scale	= false;	// use distance_scale or use accurate relative distances (incredibly huge) - independent of diameter_scale
 	bool do_orbit_path		= true;		// render orbit paths
+	bool do_gravity			= false;	// simulate gravity between every body instead of following fixed orbits
+	int asteroids			= 20000;	// bodies in the asteroid belt, only while simulating gravity
+	float max_step			= 0.05f;	// longest gravity step, in days
+	int max_steps			= 8;		// most gravity steps per frame - past that the simulation runs slower than time_scale
+	int belt_rocks			= 100000;	// rocks in the instanced asteroid belt
 	int track_planet_idx 	= 0;		// planet currently being tracked by tracking camera
 };
 
@@ -36,12 +45,21 @@ public:
 	bool LoadPlanets(std::string dir);
 	// update system simulation by dT
 	void Update(unsigned int dT);	
-	// generate planet paths
-	void GenPaths();
+	// fit every orbit to the current settings
+	void SetupOrbits();
+	// start simulating gravity from where everything is on its orbit now
+	void StartGravity();
+	// scatter belt_rocks rocks between mars and jupiter
+	void SetupBelt();
 	// render planets
 	void Render(const MatLocs& matlocs);
-	// render planet paths
-	void RenderPaths(GLint shaderMdlmx);
+	// render the asteroid belt, view_proj is the camera's proj * view
+	void RenderBelt(const glm::mat4& view_proj, const glm::dvec3& origin);
+	// render orbit paths relative to origin, the camera position
+		// proj_scale is the height in pixels of one unit at distance one
+	void RenderPaths(float proj_scale, const glm::dvec3& origin);
+	// render the simulated asteroids as points relative to origin
+	void RenderAsteroids(GLint shaderMdlmx, const glm::dvec3& origin);
 	// render UI
 	void UI(bool track);
 	// get relative scale to set how far away the orbiting camera orbits
@@ -53,6 +71,24 @@ private:
 
 	ss_settings settings;
 	std::vector<Planet> planets;
+
+	// positions and spins of every planet and moon
+	Orbits orbits;
+	// model matrices of every planet, moon and ring
+	SceneGraph graph;
+	OrbitPaths paths;
+
+	// every planet and moon at their orbit table index, then the asteroids
+	NBody nbody;
+	unsigned int first_asteroid = 0;
+	GLuint asteroid_vao = 0, asteroid_vbo = 0;
+
+	// rocks drawn instanced, separate from the gravity simulation
+	Belt belt;
+
+	// gravity steps and the time spent in each phase over the last frame
+	unsigned int last_steps = 0;
+	double last_build_ms = 0.0, last_force_ms = 0.0, last_integrate_ms = 0.0;
 };
 
 #endif // SOLARSYSTEM_H
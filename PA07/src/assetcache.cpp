@@ -0,0 +1,121 @@
+
+#include "assetcache.h"
+
+#include <chrono>
+#include <cstdio>
+
+std::unordered_map<std::string, std::weak_ptr<Scene::Mesh>> AssetCache::meshes;
+std::unordered_map<std::string, std::weak_ptr<Scene::Texture>> AssetCache::textures;
+
+unsigned int AssetCache::mesh_hits = 0;
+unsigned int AssetCache::mesh_loads = 0;
+unsigned int AssetCache::texture_hits = 0;
+unsigned int AssetCache::texture_loads = 0;
+double AssetCache::read_ms = 0.0;
+double AssetCache::upload_ms = 0.0;
+
+std::shared_ptr<Scene::Mesh> AssetCache::GetMesh(const std::string& file, int idx) {
+
+	std::string key = file + "#" + std::to_string(idx);
+
+	std::weak_ptr<Scene::Mesh>& entry = meshes[key];
+	if(std::shared_ptr<Scene::Mesh> mesh = entry.lock()) {
+		mesh_hits++;
+		return mesh;
+	}
+
+	// handed out empty, filled in once the worker has read it and the render thread uploaded it
+	std::shared_ptr<Scene::Mesh> mesh = std::make_shared<Scene::Mesh>();
+	std::weak_ptr<Scene::Mesh> weak = mesh;
+
+	std::shared_ptr<Scene::Mesh> staging = std::make_shared<Scene::Mesh>();
+	std::shared_ptr<double> ms = std::make_shared<double>(0.0);
+
+	mesh->pending = AssetLoader::Load([=]() {
+
+		auto start = std::chrono::high_resolution_clock::now();
+		Scene::ReadMesh(file, idx, *staging);
+		*ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+	}, [=]() {
+
+		read_ms += *ms;
+
+		// nobody wants it anymore, or it failed to load and stays empty
+		std::shared_ptr<Scene::Mesh> mesh = weak.lock();
+		if(!mesh || staging->indices.empty()) return;
+
+		auto start = std::chrono::high_resolution_clock::now();
+		mesh->vertices.swap(staging->vertices);
+		mesh->indices.swap(staging->indices);
+		mesh->lods.swap(staging->lods);
+		mesh->center = staging->center;
+		mesh->radius = staging->radius;
+		Scene::UploadMesh(*mesh);
+		upload_ms += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	});
+
+	mesh_loads++;
+	entry = mesh;
+	return mesh;
+}
+
+std::shared_ptr<Scene::Texture> AssetCache::GetTexture(const std::string& file) {
+
+	std::weak_ptr<Scene::Texture>& entry = textures[file];
+	if(std::shared_ptr<Scene::Texture> texture = entry.lock()) {
+		texture_hits++;
+		return texture;
+	}
+
+	std::shared_ptr<Scene::Texture> texture = std::make_shared<Scene::Texture>();
+	std::weak_ptr<Scene::Texture> weak = texture;
+
+	std::shared_ptr<Scene::Image> staging = std::make_shared<Scene::Image>();
+	std::shared_ptr<double> ms = std::make_shared<double>(0.0);
+
+	AssetLoader::Load([=]() {
+
+		auto start = std::chrono::high_resolution_clock::now();
+		Scene::ReadTexture(file, *staging);
+		*ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+	}, [=]() {
+
+		read_ms += *ms;
+
+		std::shared_ptr<Scene::Texture> texture = weak.lock();
+		if(!texture || !staging->pixels) return;
+
+		auto start = std::chrono::high_resolution_clock::now();
+		Scene::UploadTexture(*texture, *staging);
+		upload_ms += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	});
+
+	texture_loads++;
+	entry = texture;
+	return texture;
+}
+
+void AssetCache::Report() {
+
+	unsigned int live_meshes = 0, live_textures = 0;
+	size_t mesh_bytes = 0, texture_bytes = 0;
+
+	for(auto& i : meshes) {
+		if(std::shared_ptr<Scene::Mesh> m = i.second.lock()) {
+			live_meshes++;
+			mesh_bytes += m->vertices.size() * sizeof(Vertex) + m->indices.size() * sizeof(unsigned int);
+		}
+	}
+	for(auto& i : textures) {
+		if(std::shared_ptr<Scene::Texture> t = i.second.lock()) {
+			live_textures++;
+			texture_bytes += t->bytes;
+		}
+	}
+
+	printf("Assets: %u meshes (%.2f MB), %u textures (%.2f MB)\n", live_meshes, mesh_bytes / 1048576.0, live_textures, texture_bytes / 1048576.0);
+	printf("  mesh loads %u, hits %u; texture loads %u, hits %u\n", mesh_loads, mesh_hits, texture_loads, texture_hits);
+	printf("  %.1f ms reading on the loader threads, %.1f ms uploading on the render thread\n", read_ms, upload_ms);
+}
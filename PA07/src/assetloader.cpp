@@ -0,0 +1,253 @@
+
+#include "assetloader.h"
+#include "glstate.h"
+
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+
+GLuint AssetLoader::placeholder = 0;
+double AssetLoader::frame_budget_ms = 2.0;
+
+std::vector<std::thread> AssetLoader::workers;
+std::deque<std::shared_ptr<AssetLoader::Task>> AssetLoader::queued;
+std::deque<std::shared_ptr<AssetLoader::Task>> AssetLoader::ready;
+std::deque<std::function<void()>> AssetLoader::jobs;
+std::mutex AssetLoader::lock;
+std::condition_variable AssetLoader::work_cv;
+std::condition_variable AssetLoader::ready_cv;
+unsigned int AssetLoader::outstanding = 0;
+bool AssetLoader::stopping = false;
+
+void AssetLoader::Start() {
+
+	const unsigned char grey[4] = {128, 128, 128, 255};
+
+	glGenTextures(1, &placeholder);
+	GLState::BindTexture(GL_TEXTURE_2D, placeholder);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, grey);
+
+	StartWorkers();
+}
+
+void AssetLoader::StartWorkers() {
+
+	// leave a core for the render thread
+	unsigned int threads = std::max(2u, std::thread::hardware_concurrency()) - 1;
+
+	stopping = false;
+	for(unsigned int i = 0; i < threads; i++) {
+		workers.push_back(std::thread(Worker));
+	}
+}
+
+void AssetLoader::Stop() {
+
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		stopping = true;
+	}
+	work_cv.notify_all();
+
+	for(auto& t : workers) {
+		t.join();
+	}
+	workers.clear();
+
+	// whatever never got uploaded is dropped along with the assets waiting for it
+	for(auto& task : queued) {
+		task->read = task->upload = nullptr;
+	}
+	for(auto& task : ready) {
+		task->read = task->upload = nullptr;
+	}
+	queued.clear();
+	ready.clear();
+	jobs.clear();
+	outstanding = 0;
+
+	if(placeholder) {
+		GLState::DeleteTexture(placeholder);
+		placeholder = 0;
+	}
+}
+
+std::shared_ptr<AssetLoader::Task> AssetLoader::Load(std::function<void()> read, std::function<void()> upload) {
+
+	std::shared_ptr<Task> task = std::make_shared<Task>();
+	task->read = read;
+	task->upload = upload;
+	task->state = Task::QUEUED;
+
+	// not started - load in place
+	if(workers.empty()) {
+		task->read();
+		task->state = Task::READ;
+		outstanding++;
+		Upload(task);
+		return task;
+	}
+
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		queued.push_back(task);
+		outstanding++;
+	}
+	work_cv.notify_one();
+
+	return task;
+}
+
+void AssetLoader::Worker() {
+
+	for(;;) {
+
+		std::shared_ptr<Task> task;
+		std::function<void()> job;
+		{
+			std::unique_lock<std::mutex> guard(lock);
+			work_cv.wait(guard, [] { return stopping || !jobs.empty() || !queued.empty(); });
+			if(stopping) return;
+
+			// the frame is waiting on these, so they go ahead of any reads
+			if(!jobs.empty()) {
+				job = jobs.front();
+				jobs.pop_front();
+			} else {
+				task = queued.front();
+				queued.pop_front();
+				task->state = Task::READING;
+			}
+		}
+
+		if(job) {
+			job();
+			continue;
+		}
+
+		task->read();
+
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			if(task->upload) {
+				task->state = Task::READ;
+				ready.push_back(task);
+			} else {
+				task->state = Task::DONE;
+				task->read = nullptr;
+				outstanding--;
+			}
+		}
+		ready_cv.notify_all();
+	}
+}
+
+void AssetLoader::Upload(const std::shared_ptr<Task>& task) {
+
+	if(task->upload) task->upload();
+
+	std::lock_guard<std::mutex> guard(lock);
+	task->read = task->upload = nullptr;
+	task->state = Task::DONE;
+	outstanding--;
+}
+
+void AssetLoader::ParallelFor(unsigned int count, std::function<void(unsigned int)> fn) {
+
+	struct Range {
+		std::atomic<unsigned int> next;
+		unsigned int done = 0;
+		std::mutex lock;
+		std::condition_variable cv;
+	};
+	std::shared_ptr<Range> range = std::make_shared<Range>();
+	range->next = 0;
+
+	// helpers that only get to run after the calling thread took every index find nothing left
+	auto run = [range, count, fn]() {
+		unsigned int i;
+		while((i = range->next++) < count) {
+			fn(i);
+
+			std::lock_guard<std::mutex> guard(range->lock);
+			if(++range->done == count) range->cv.notify_all();
+		}
+	};
+
+	unsigned int helpers = std::min((unsigned int)workers.size(), count ? count - 1 : 0);
+	if(helpers) {
+		std::lock_guard<std::mutex> guard(lock);
+		for(unsigned int i = 0; i < helpers; i++) {
+			jobs.push_back(run);
+		}
+	}
+	work_cv.notify_all();
+	run();
+
+	std::unique_lock<std::mutex> guard(range->lock);
+	range->cv.wait(guard, [&] { return range->done == count; });
+}
+
+void AssetLoader::Update(double budget_ms) {
+
+	auto start = std::chrono::high_resolution_clock::now();
+
+	do {
+		std::shared_ptr<Task> task;
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			if(ready.empty()) return;
+
+			task = ready.front();
+			ready.pop_front();
+		}
+		Upload(task);
+
+	} while(std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count() < budget_ms);
+}
+
+void AssetLoader::Wait(const std::shared_ptr<Task>& task) {
+
+	std::unique_lock<std::mutex> guard(lock);
+
+	for(;;) {
+
+		if(task->state == Task::DONE) return;
+
+		if(task->state == Task::QUEUED || task->state == Task::READ) {
+
+			std::deque<std::shared_ptr<Task>>& from = task->state == Task::QUEUED ? queued : ready;
+			from.erase(std::find(from.begin(), from.end(), task));
+			bool read = task->state == Task::READ;
+			task->state = Task::READING;
+			guard.unlock();
+
+			// do it here rather than wait for a worker or the next frame
+			if(!read) task->read();
+			Upload(task);
+			return;
+		}
+
+		ready_cv.wait(guard);
+	}
+}
+
+void AssetLoader::Finish() {
+
+	for(;;) {
+
+		Update(1e9);
+
+		std::unique_lock<std::mutex> guard(lock);
+		if(!outstanding) return;
+		if(ready.empty()) ready_cv.wait(guard);
+	}
+}
+
+bool AssetLoader::Idle() {
+
+	std::lock_guard<std::mutex> guard(lock);
+	return !outstanding;
+}
@@ -0,0 +1,276 @@
+
+#include "belt.h"
+#include "assetloader.h"
+#include "benchmark.h"
+#include "glstate.h"
+
+#include <map>
+#include <cmath>
+#include <chrono>
+#include <random>
+#include <cstring>
+#include <cstddef>
+#include <algorithm>
+
+// rocks per task when moving and culling
+static const unsigned int CHUNK = 16384;
+
+static const float TWO_PI = 6.28318531f;
+
+Belt::Belt() {
+	culling = true;
+	last_visible = 0;
+	last_cull_ms = 0.0;
+	pending = 0.0f;
+	vao = vbo = ibo = instance_vbo = 0;
+	index_count = 0;
+	mesh_radius = 1.0f;
+	capacity = 0;
+}
+
+Belt::~Belt() {
+
+	if(vao) {
+		GLState::DeleteVertexArray(vao);
+		glDeleteBuffers(1, &vbo);
+		glDeleteBuffers(1, &ibo);
+		glDeleteBuffers(1, &instance_vbo);
+	}
+}
+
+unsigned int Belt::Size() const {
+	return radius.size();
+}
+
+void Belt::Generate(unsigned int count, float inner, float outer, float gm) {
+
+	if(!vao) CreateMesh();
+
+	std::mt19937 rng(1);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f), around(0.0f, TWO_PI), tilt(-0.03f, 0.03f);
+
+	for(auto v : {&radius, &height, &angle, &rate, &scale, &axis_x, &axis_y, &axis_z, &spin, &spin_rate}) {
+		v->resize(count);
+	}
+
+	float size = (outer - inner) * 0.004f;
+	for(unsigned int i = 0; i < count; i++) {
+
+		radius[i] = inner + (outer - inner) * unit(rng);
+		height[i] = radius[i] * tilt(rng);
+		angle[i] = around(rng);
+		rate[i] = sqrtf(gm / (radius[i] * radius[i] * radius[i]));
+
+		// mostly small rocks with the odd bigger one
+		float u = unit(rng);
+		scale[i] = size * (0.25f + 0.75f * u * u * u);
+
+		glm::vec3 axis = glm::normalize(glm::vec3(unit(rng) - 0.5f, unit(rng) - 0.5f, unit(rng) - 0.5f) + glm::vec3(0.0f, 0.0f, 1e-4f));
+		axis_x[i] = axis.x; axis_y[i] = axis.y; axis_z[i] = axis.z;
+		spin[i] = around(rng);
+		spin_rate[i] = rate[i] * (5.0f + 20.0f * unit(rng));
+	}
+
+	chunks.resize((count + CHUNK - 1) / CHUNK);
+}
+
+void Belt::Update(float dt) {
+	pending += dt;
+}
+
+void Belt::Render(const glm::mat4& view_proj, const glm::dvec3& origin) {
+
+	unsigned int n = Size();
+	last_visible = 0;
+	if(!n) return;
+
+	auto start = std::chrono::high_resolution_clock::now();
+
+	// the frustum planes, pointing inwards
+	glm::vec4 planes[6];
+	glm::vec4 row[4];
+	for(int r = 0; r < 4; r++) {
+		row[r] = glm::vec4(view_proj[0][r], view_proj[1][r], view_proj[2][r], view_proj[3][r]);
+	}
+	for(int p = 0; p < 3; p++) {
+		planes[2 * p] = row[3] + row[p];
+		planes[2 * p + 1] = row[3] - row[p];
+	}
+	for(auto& p : planes) {
+		p = p / glm::length(glm::vec3(p));
+	}
+
+	float dt = pending;
+	pending = 0.0f;
+
+	// the belt is centred on the sun, so only its offset from the camera needs doubles
+	glm::vec3 center = glm::vec3(-origin);
+
+	AssetLoader::ParallelFor(chunks.size(), [&](unsigned int c) {
+
+		std::vector<Instance>& out = chunks[c];
+		out.clear();
+
+		unsigned int end = std::min(n, (c + 1) * CHUNK);
+		for(unsigned int i = c * CHUNK; i < end; i++) {
+
+			// kept in [0, 2pi) so single precision never runs out over a long run
+			angle[i] += rate[i] * dt;
+			if(angle[i] >= TWO_PI) angle[i] -= TWO_PI * floorf(angle[i] / TWO_PI);
+			spin[i] += spin_rate[i] * dt;
+			if(spin[i] >= TWO_PI) spin[i] -= TWO_PI * floorf(spin[i] / TWO_PI);
+
+			glm::vec3 pos = center + glm::vec3(radius[i] * cosf(angle[i]), height[i], radius[i] * sinf(angle[i]));
+
+			if(culling) {
+				float bound = -scale[i] * mesh_radius;
+				bool inside = true;
+				for(int p = 0; p < 6 && inside; p++) {
+					inside = planes[p].x * pos.x + planes[p].y * pos.y + planes[p].z * pos.z + planes[p].w >= bound;
+				}
+				if(!inside) continue;
+			}
+
+			float half = spin[i] * 0.5f, s = sinf(half);
+			Instance instance;
+			instance.pos_scale = glm::vec4(pos, scale[i]);
+			instance.rotation = glm::vec4(axis_x[i] * s, axis_y[i] * s, axis_z[i] * s, cosf(half));
+			out.push_back(instance);
+		}
+	});
+
+	std::vector<size_t> offsets(chunks.size());
+	size_t total = 0;
+	for(unsigned int c = 0; c < chunks.size(); c++) {
+		offsets[c] = total;
+		total += chunks[c].size();
+	}
+
+	glBindBuffer(GL_ARRAY_BUFFER, instance_vbo);
+
+	// orphan last frame's storage rather than waiting on the draw still reading it
+	size_t bytes = total * sizeof(Instance);
+	if(bytes > capacity) {
+		capacity = std::max(bytes, capacity * 2);
+	}
+	glBufferData(GL_ARRAY_BUFFER, capacity, nullptr, GL_STREAM_DRAW);
+
+	bool packed = false;
+	if(total) {
+		char* dest = (char*)glMapBufferRange(GL_ARRAY_BUFFER, 0, bytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+		if(dest) {
+
+			AssetLoader::ParallelFor(chunks.size(), [&](unsigned int c) {
+				if(!chunks[c].empty()) memcpy(dest + offsets[c] * sizeof(Instance), chunks[c].data(), chunks[c].size() * sizeof(Instance));
+			});
+
+			// the store can be lost (mode switches and the like), skip a frame when it is
+			packed = glUnmapBuffer(GL_ARRAY_BUFFER) == GL_TRUE;
+		}
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	last_cull_ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	if(!packed) return;
+
+	GLState::BindVertexArray(vao);
+	glDrawElementsInstanced(GL_TRIANGLES, index_count, GL_UNSIGNED_INT, 0, total);
+	Benchmark::draw_calls++;
+	Benchmark::triangles += index_count / 3 * total;
+
+	last_visible = total;
+}
+
+void Belt::CreateMesh() {
+
+	// icosahedron
+	const float t = (1.0f + sqrtf(5.0f)) / 2.0f;
+	std::vector<glm::vec3> points = {
+		{-1, t, 0}, {1, t, 0}, {-1, -t, 0}, {1, -t, 0},
+		{0, -1, t}, {0, 1, t}, {0, -1, -t}, {0, 1, -t},
+		{t, 0, -1}, {t, 0, 1}, {-t, 0, -1}, {-t, 0, 1}
+	};
+	std::vector<unsigned int> faces = {
+		0, 11, 5,  0, 5, 1,  0, 1, 7,  0, 7, 10,  0, 10, 11,
+		1, 5, 9,  5, 11, 4,  11, 10, 2,  10, 7, 6,  7, 1, 8,
+		3, 9, 4,  3, 4, 2,  3, 2, 6,  3, 6, 8,  3, 8, 9,
+		4, 9, 5,  2, 4, 11,  6, 2, 10,  8, 6, 7,  9, 8, 1
+	};
+
+	// split every triangle in four once, 80 triangles
+	std::map<std::pair<unsigned int, unsigned int>, unsigned int> midpoints;
+	auto midpoint = [&](unsigned int a, unsigned int b) -> unsigned int {
+
+		auto key = std::make_pair(std::min(a, b), std::max(a, b));
+		auto found = midpoints.find(key);
+		if(found != midpoints.end()) return found->second;
+
+		points.push_back((points[a] + points[b]) * 0.5f);
+		return midpoints[key] = points.size() - 1;
+	};
+
+	std::vector<unsigned int> indices;
+	for(unsigned int f = 0; f < faces.size(); f += 3) {
+
+		unsigned int a = faces[f], b = faces[f + 1], c = faces[f + 2];
+		unsigned int ab = midpoint(a, b), bc = midpoint(b, c), ca = midpoint(c, a);
+		for(unsigned int i : {a, ab, ca, b, bc, ab, c, ca, bc, ab, bc, ca}) {
+			indices.push_back(i);
+		}
+	}
+
+	// onto a lumpy sphere
+	std::mt19937 rng(7);
+	std::uniform_real_distribution<float> lump(0.75f, 1.15f);
+
+	std::vector<Vertex> vertices(points.size());
+	mesh_radius = 0.0f;
+	for(unsigned int i = 0; i < points.size(); i++) {
+		vertices[i].pos = glm::normalize(points[i]) * lump(rng);
+		vertices[i].normal = glm::vec3(0.0f);
+		vertices[i].texcoord = glm::vec2(0.0f);
+		mesh_radius = std::max(mesh_radius, glm::length(vertices[i].pos));
+	}
+
+	// area weighted face normals, summed per vertex
+	for(unsigned int i = 0; i < indices.size(); i += 3) {
+
+		Vertex &a = vertices[indices[i]], &b = vertices[indices[i + 1]], &c = vertices[indices[i + 2]];
+		glm::vec3 normal = glm::cross(b.pos - a.pos, c.pos - a.pos);
+		a.normal += normal; b.normal += normal; c.normal += normal;
+	}
+	for(auto& v : vertices) {
+		v.normal = glm::normalize(v.normal);
+	}
+
+	index_count = indices.size();
+
+	glGenVertexArrays(1, &vao);
+	glGenBuffers(1, &vbo);
+	glGenBuffers(1, &ibo);
+	glGenBuffers(1, &instance_vbo);
+
+	GLState::BindVertexArray(vao);
+
+	glBindBuffer(GL_ARRAY_BUFFER, vbo);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex) * vertices.size(), vertices.data(), GL_STATIC_DRAW);
+	glEnableVertexAttribArray(0);
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), 0);
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, normal));
+
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int) * indices.size(), indices.data(), GL_STATIC_DRAW);
+
+	// the instance buffer keeps its name when it is orphaned, so these stay valid
+	glBindBuffer(GL_ARRAY_BUFFER, instance_vbo);
+	glEnableVertexAttribArray(3);
+	glEnableVertexAttribArray(4);
+	glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, sizeof(Instance), (void*)offsetof(Instance, pos_scale));
+	glVertexAttribPointer(4, 4, GL_FLOAT, GL_FALSE, sizeof(Instance), (void*)offsetof(Instance, rotation));
+	glVertexAttribDivisor(3, 1);
+	glVertexAttribDivisor(4, 1);
+
+	GLState::BindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
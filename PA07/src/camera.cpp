@@ -15,15 +15,16 @@ void OrbitCamera::reset() {
 	yaw = 0.0f;
 	pitch = 45.0f;
 	radius = 600.0f;
-	lookingAt = glm::vec3(0, 0, 0);
+	lookingAt = glm::dvec3(0, 0, 0);
 	update();
 }
 
 void OrbitCamera::update() {
-	pos.x = cos(glm::radians(pitch)) * cos(glm::radians(yaw));
-	pos.y = sin(glm::radians(pitch));
-	pos.z = sin(glm::radians(yaw)) * cos(glm::radians(pitch));
-	pos = radius * glm::normalize(pos) + lookingAt;
+	glm::vec3 dir;
+	dir.x = cos(glm::radians(pitch)) * cos(glm::radians(yaw));
+	dir.y = sin(glm::radians(pitch));
+	dir.z = sin(glm::radians(yaw)) * cos(glm::radians(pitch));
+	pos = glm::dvec3(radius * glm::normalize(dir)) + lookingAt;
 }
 
 void OrbitCamera::move(int dx, int dy) {
@@ -49,12 +50,16 @@ glm::mat4 OrbitCamera::GetProjection(float w, float h) {
 
 glm::mat4 OrbitCamera::GetViewWithoutTranslate() {
 
-	return glm::lookAt(glm::vec3(0, 0, 0), pos, glm::vec3(0, 1, 0));
+	return glm::lookAt(glm::vec3(0, 0, 0), glm::vec3(pos), glm::vec3(0, 1, 0));
 }
 
 glm::mat4 OrbitCamera::GetView() {
 
-	return glm::lookAt(pos, lookingAt, glm::vec3(0, 1, 0));
+	return glm::lookAt(glm::vec3(0, 0, 0), glm::vec3(lookingAt - pos), glm::vec3(0, 1, 0));
+}
+
+glm::dvec3 OrbitCamera::GetPosition() {
+	return pos;
 }
 
 FreeCamera::FreeCamera() {
@@ -70,7 +75,11 @@ glm::mat4 FreeCamera::GetProjection(float w, float h) {
 }
 
 glm::mat4 FreeCamera::GetView() {
-	return glm::lookAt(pos, pos + front, up);
+	return glm::lookAt(glm::vec3(0.0f), front, up);
+}
+
+glm::dvec3 FreeCamera::GetPosition() {
+	return pos;
 }
 
 glm::mat4 FreeCamera::GetViewWithoutTranslate() {
@@ -82,7 +91,7 @@ void FreeCamera::reset() {
 	pitch = -45.0f;
 	yaw = 225.0f;
 	speed = 5.0f;
-	pos = glm::vec3(5, 5, 5);
+	pos = glm::dvec3(5, 5, 5);
 	globalUp = glm::vec3(0, 1, 0);
 	update();
 }
@@ -117,8 +126,8 @@ TrackingCamera::~TrackingCamera() {
 
 void TrackingCamera::reset() {
 	fov = 60.0f;
-	pos = glm::vec3(5, 5, 5);
-	direction = glm::normalize(-pos);
+	pos = glm::dvec3(5, 5, 5);
+	direction = glm::normalize(glm::vec3(-pos));
 }
 
 glm::mat4 TrackingCamera::GetProjection(float w, float h) {
@@ -126,7 +135,11 @@ glm::mat4 TrackingCamera::GetProjection(float w, float h) {
 }
 
 glm::mat4 TrackingCamera::GetView() {
-	return glm::lookAt(pos, pos + direction, glm::vec3(0,1,0));
+	return glm::lookAt(glm::vec3(0.0f), direction, glm::vec3(0,1,0));
+}
+
+glm::dvec3 TrackingCamera::GetPosition() {
+	return pos;
 }
 
 glm::mat4 TrackingCamera::GetViewWithoutTranslate() {
@@ -136,5 +149,5 @@ glm::mat4 TrackingCamera::GetViewWithoutTranslate() {
 void TrackingCamera::set(Planet* track) {
 
 	pos = track->getPos();
-	direction = glm::normalize(-pos);
+	direction = glm::normalize(glm::vec3(-pos));
 }
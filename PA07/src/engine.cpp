@@ -1,5 +1,7 @@
 
 #include "engine.h"
+#include "assetcache.h"
+#include "assetloader.h"
 
 Engine::Engine(string name, int width, int height) {
 
@@ -10,10 +12,14 @@ Engine::Engine(string name, int width, int height) {
 
 	mx = my = 0;
 	mouse_captured = false;
+
+	m_frames = 0;
+	m_loading = true;
 }
 
 Engine::~Engine() {
 
+	AssetLoader::Stop();
 	ImGui_ImplSdlGL3_Shutdown();
 	delete m_window;
 	delete m_graphics;
@@ -24,20 +30,32 @@ Engine::~Engine() {
 }
 
 bool Engine::Initialize(std::vector<std::string> args) {
+
+	m_startTimeMillis = GetCurrentTimeMillis();
+
+	m_benchmark.ParseArgs(args);
   	
   	// Start a window
 	m_window = new Window();
-	if(!m_window->Initialize(m_WINDOW_NAME, &w, &h)) {
+	if(m_benchmark.headless) {
+		if(!m_window->InitializeHeadless(w, h)) {
+			printf("The headless context failed to initialize.\n");
+			return false;
+		}
+	} else if(!m_window->Initialize(m_WINDOW_NAME, &w, &h)) {
 		printf("The window failed to initialize.\n");
 		return false;
 	}
 	
 	// Start the graphics
 	m_graphics = new Graphics();
-	if(!m_graphics->Initialize(w, h)) {
+	if(!m_graphics->Initialize(w, h, m_benchmark.headless)) {
 		printf("The graphics failed to initialize.\n");
 		return false;
 	}
+
+	// worker threads for reading models and textures
+	AssetLoader::Start();
 	
 	// Set the time
 	m_currentTimeMillis = GetCurrentTimeMillis();
@@ -50,6 +68,8 @@ bool Engine::Initialize(std::vector<std::string> args) {
 		return false;
 	}
 
+	printf("Startup took %lld ms\n", GetCurrentTimeMillis() - m_startTimeMillis);
+
 	// No errors
 	return true;
 }
@@ -58,8 +78,10 @@ void Engine::Run() {
 	
 	m_running = true;
 	
-	m_graphics->BeginPathRender(w, h);
-	m_system->GenPaths();
+	if(m_benchmark.headless) {
+		RunHeadless();
+		return;
+	}
 
 	while(m_running) {
 
@@ -69,30 +91,73 @@ void Engine::Run() {
 		m_DT = getDT();
 		Events();
 
-		//update and render graphics
-		ImGui::SetNextWindowSize({500,300});
-		ImGui::Begin("Menu");
+		Frame(m_DT);
+		m_window->Swap();
+	}
+}
 
-		m_system->Update(m_DT);
-		m_graphics->Update(m_DT, m_system->GetTrackedPlanet());
-		m_graphics->SetCameraDistance(m_system->GetCameraScale());
-		
-		m_graphics->Clear();
-		m_graphics->RenderSkybox(w, h);
-		
-		GLint modelLoc = m_graphics->BeginPathRender(w, h);
-		m_system->RenderPaths(modelLoc);
-		
-		m_graphics->UI();
-		m_system->UI(m_graphics->IsTracking());
+void Engine::RunHeadless() {
 
-		MatLocs matlocs = m_graphics->BeginPlanetRender(w, h);
-		m_system->Render(matlocs);
+	ImGui::GetIO().DisplaySize = ImVec2((float)w, (float)h);
 
-		ImGui::End();
+	// fixed timestep so every run simulates and renders the same frames
+	const unsigned int dT = 16;
 
-		m_graphics->EndRender();
-		m_window->Swap();
+	// and every frame has all of its assets
+	AssetLoader::Finish();
+
+	while(!m_benchmark.Done()) {
+
+		m_benchmark.BeginFrame();
+		ImGui_ImplSdlGL3_NewFrame(nullptr);
+
+		m_graphics->FollowCameraPath(m_benchmark.Progress());
+		Frame(dT);
+
+		m_benchmark.EndFrame(w, h);
+	}
+
+	m_benchmark.Report();
+}
+
+void Engine::Frame(unsigned int dT) {
+
+	// finish off whatever the loader threads have read since last frame
+	AssetLoader::Update(AssetLoader::frame_budget_ms);
+
+	//update and render graphics
+	ImGui::SetNextWindowSize({500,300});
+	ImGui::Begin("Menu");
+
+	m_system->Update(dT);
+	m_graphics->Update(dT, m_system->GetTrackedPlanet());
+	m_graphics->SetCameraDistance(m_system->GetCameraScale());
+	
+	m_graphics->Clear();
+	m_graphics->RenderSkybox(w, h);
+	
+	m_system->RenderPaths(m_graphics->BeginOrbitRender(w, h), m_graphics->GetCameraPosition());
+	GLint modelLoc = m_graphics->BeginPathRender(w, h);
+	m_system->RenderAsteroids(modelLoc, m_graphics->GetCameraPosition());
+	
+	m_graphics->UI();
+	m_system->UI(m_graphics->IsTracking());
+
+	MatLocs matlocs = m_graphics->BeginPlanetRender(w, h);
+	m_system->Render(matlocs);
+	m_system->RenderBelt(m_graphics->BeginBeltRender(w, h), m_graphics->GetCameraPosition());
+
+	ImGui::End();
+
+	m_graphics->EndRender();
+
+	if(!m_frames++) {
+		printf("Time to first frame: %lld ms\n", GetCurrentTimeMillis() - m_startTimeMillis);
+	}
+	if(m_loading && AssetLoader::Idle()) {
+		m_loading = false;
+		printf("All assets loaded after %lld ms (%u frames)\n", GetCurrentTimeMillis() - m_startTimeMillis, m_frames);
+		AssetCache::Report();
 	}
 }
 
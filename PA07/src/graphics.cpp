@@ -1,5 +1,7 @@
 
 #include "graphics.h"
+#include "benchmark.h"
+#include "glstate.h"
 #include <imgui.h>
 #include <stb_image.h>
 #include <SDL2/SDL.h>
@@ -50,7 +52,7 @@ float cubemap_points[] = {
 
 Graphics::Graphics() {
 
-	m_planet_shader = nullptr;
+	m_planet_shader = m_cubemap_shader = m_path_shader = m_rock_shader = m_orbit_shader = nullptr;
 }
 
 Graphics::~Graphics() {
@@ -70,20 +72,42 @@ Graphics::~Graphics() {
 		delete m_path_shader;
 		m_path_shader = nullptr;
 	}
+	if(m_rock_shader) {
+
+		delete m_rock_shader;
+		m_rock_shader = nullptr;
+	}
+	if(m_orbit_shader) {
+
+		delete m_orbit_shader;
+		m_orbit_shader = nullptr;
+	}
 
 	glDeleteBuffers(1, &cubemap_vbo);
-	glDeleteTextures(1, &cubemap_tex);
-	glDeleteVertexArrays(1, &cubemap_vao);
-	glDeleteVertexArrays(1, &planet_VAO);
-	glDeleteVertexArrays(1, &path_VAO);
+	GLState::DeleteTexture(cubemap_tex);
+	GLState::DeleteVertexArray(cubemap_vao);
+
+	if(offscreen_fbo) {
+		glDeleteFramebuffers(1, &offscreen_fbo);
+		glDeleteRenderbuffers(1, &offscreen_color);
+		glDeleteRenderbuffers(1, &offscreen_depth);
+	}
 }
 
-bool Graphics::Initialize(int width, int height) {
+bool Graphics::Initialize(int width, int height, bool _headless) {
   
 	glewExperimental = GL_TRUE;
+	headless = _headless;
 
 	auto status = glewInit();
 
+#ifdef GLEW_ERROR_NO_GLX_DISPLAY
+	// an EGL context has no GLX display, but the core GL entry points are still loaded
+	if(headless && status == GLEW_ERROR_NO_GLX_DISPLAY) {
+		status = GLEW_OK;
+	}
+#endif
+
 	// This is here to grab the error that comes from glew init.
 	// This error is an GL_INVALID_ENUM that has no effects on the performance
 	glGetError();
@@ -95,9 +119,9 @@ bool Graphics::Initialize(int width, int height) {
 		return false;
 	}
 
-	// For OpenGL 3
-	glGenVertexArrays(1, &planet_VAO);
-	glGenVertexArrays(1, &path_VAO);
+	if(headless && !CreateOffscreenTarget(width, height)) {
+		return false;
+	}
 
 	// Init Camera
 	camera_type = CameraType::orbit;
@@ -190,6 +214,64 @@ bool Graphics::Initialize(int width, int height) {
 			return false;
 		}
 	}
+	{
+		m_rock_shader = new Shader();
+		if(!m_rock_shader->Initialize()) {
+
+			printf("Shader Failed to Initialize\n");
+			return false;
+		}
+		
+		// Add the vertex shader
+		if(!m_rock_shader->AddShader(GL_VERTEX_SHADER, "../data/shaders/rock.v")) {
+		
+			printf("Vertex Shader failed to Initialize\n");
+			return false;
+		}
+		
+		// Add the fragment shader
+		if(!m_rock_shader->AddShader(GL_FRAGMENT_SHADER, "../data/shaders/rock.f")) {
+		
+			printf("Fragment Shader failed to Initialize\n");
+			return false;
+		}
+		
+		// Connect the program
+		if(!m_rock_shader->Finalize()) {
+
+			printf("Program to Finalize\n");
+			return false;
+		}
+	}
+	{
+		m_orbit_shader = new Shader();
+		if(!m_orbit_shader->Initialize()) {
+
+			printf("Shader Failed to Initialize\n");
+			return false;
+		}
+		
+		// Add the vertex shader
+		if(!m_orbit_shader->AddShader(GL_VERTEX_SHADER, "../data/shaders/orbit.v")) {
+		
+			printf("Vertex Shader failed to Initialize\n");
+			return false;
+		}
+		
+		// Add the fragment shader, plain white like the other paths
+		if(!m_orbit_shader->AddShader(GL_FRAGMENT_SHADER, "../data/shaders/path.f")) {
+		
+			printf("Fragment Shader failed to Initialize\n");
+			return false;
+		}
+		
+		// Connect the program
+		if(!m_orbit_shader->Finalize()) {
+
+			printf("Program to Finalize\n");
+			return false;
+		}
+	}
 
 	// load cube map texture
 	if(!CreateCubeMap("../data/textures/starscape.png")) {
@@ -197,7 +279,7 @@ bool Graphics::Initialize(int width, int height) {
 	}
 
 	//enable depth testing
-	glEnable(GL_DEPTH_TEST);
+	GLState::Enable(GL_DEPTH_TEST, true);
 	
 	return true;
 }
@@ -213,16 +295,16 @@ void Graphics::Update(unsigned int dt, Planet* tracked) {
 		float dT = dt / 1000.0f;
 
 		if (keys[SDL_SCANCODE_W]) {
-			free_camera.pos += free_camera.front * free_camera.speed * dT;
+			free_camera.pos += glm::dvec3(free_camera.front * free_camera.speed * dT);
 		}
 		if (keys[SDL_SCANCODE_S]) {
-			free_camera.pos -= free_camera.front * free_camera.speed * dT;
+			free_camera.pos -= glm::dvec3(free_camera.front * free_camera.speed * dT);
 		}
 		if (keys[SDL_SCANCODE_A]) {
-			free_camera.pos -= free_camera.right * free_camera.speed * dT;
+			free_camera.pos -= glm::dvec3(free_camera.right * free_camera.speed * dT);
 		}
 		if (keys[SDL_SCANCODE_D]) {
-			free_camera.pos += free_camera.right * free_camera.speed * dT;
+			free_camera.pos += glm::dvec3(free_camera.right * free_camera.speed * dT);
 		}
 
 		free_camera.update();
@@ -235,10 +317,10 @@ bool Graphics::CreateCubeMap(std::string file) {
 	glGenVertexArrays(1, &cubemap_vao);
 	glGenTextures(1, &cubemap_tex);
 
-	glBindVertexArray(cubemap_vao);
-	glBindBuffer(GL_ARRAY_BUFFER, cubemap_vbo);
-	glBindTexture(GL_TEXTURE_CUBE_MAP, cubemap_tex);
 	glActiveTexture(GL_TEXTURE0);
+	GLState::BindVertexArray(cubemap_vao);
+	glBindBuffer(GL_ARRAY_BUFFER, cubemap_vbo);
+	GLState::BindTexture(GL_TEXTURE_CUBE_MAP, cubemap_tex);
 
 	glBufferData(GL_ARRAY_BUFFER, 3 * 36 * sizeof(float), &cubemap_points, GL_STATIC_DRAW);
 	
@@ -267,11 +349,47 @@ bool Graphics::CreateCubeMap(std::string file) {
 	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 	glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
 
-	glBindVertexArray(0);
+	GLState::BindVertexArray(0);
 
 	return true;
 }
 
+bool Graphics::CreateOffscreenTarget(int width, int height) {
+
+	glGenFramebuffers(1, &offscreen_fbo);
+	glGenRenderbuffers(1, &offscreen_color);
+	glGenRenderbuffers(1, &offscreen_depth);
+
+	glBindRenderbuffer(GL_RENDERBUFFER, offscreen_color);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+	glBindRenderbuffer(GL_RENDERBUFFER, offscreen_depth);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, offscreen_fbo);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, offscreen_color);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, offscreen_depth);
+
+	if(glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+		std::cerr << "Offscreen framebuffer incomplete" << std::endl;
+		return false;
+	}
+
+	// everything (including reads for PNG output) goes through this framebuffer from now on
+	glViewport(0, 0, width, height);
+
+	return true;
+}
+
+void Graphics::FollowCameraPath(float t) {
+
+	// one full orbit of the system while sweeping from a high angle down towards the ecliptic
+	camera_type = CameraType::orbit;
+	orbit_camera.yaw = 360.0f * t;
+	orbit_camera.pitch = 60.0f - 50.0f * t;
+	orbit_camera.update();
+}
+
 Camera* Graphics::GetCamera() {
 	switch(camera_type) {
 	case CameraType::orbit: 	return &orbit_camera;
@@ -298,7 +416,10 @@ bool Graphics::IsTracking() {
 }
 
 void Graphics::Clear() {
-	
+
+	// a frame starts here
+	GLState::ResetCounters();
+
 	glClearColor(0.5, 0.5, 0.5, 1.0);
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 }
@@ -307,33 +428,35 @@ void Graphics::RenderSkybox(int w, int h) {
 
 	Camera* c = GetCamera();
 
-	glDepthMask(GL_FALSE);
-	glBindVertexArray(cubemap_vao);
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_CUBE_MAP, cubemap_tex);
+	GLState::DepthMask(false);
+	GLState::BindVertexArray(cubemap_vao);
+	GLState::BindTexture(GL_TEXTURE_CUBE_MAP, cubemap_tex);
 	m_cubemap_shader->Enable();
 	glUniformMatrix4fv(m_cubemap_shader->GetUniformLocation("proj"), 1, GL_FALSE, glm::value_ptr(c->GetProjection(w, h))); 
 	glUniformMatrix4fv(m_cubemap_shader->GetUniformLocation("view"), 1, GL_FALSE, glm::value_ptr(c->GetViewWithoutTranslate())); 
 	glDrawArrays(GL_TRIANGLES, 0, 36);
-	glDepthMask(GL_TRUE);
+	Benchmark::draw_calls++;
+	GLState::DepthMask(true);
 }
 
 MatLocs Graphics::BeginPlanetRender(int w, int h) {
 
 	Camera* c = GetCamera();
-	glBindVertexArray(planet_VAO);
 	m_planet_shader->Enable();
 	
 	// Send in the projection and view to the shader
 	glUniformMatrix4fv(m_planet_shader->GetUniformLocation("proj"), 1, GL_FALSE, glm::value_ptr(c->GetProjection(w, h))); 
 	glUniformMatrix4fv(m_planet_shader->GetUniformLocation("view"), 1, GL_FALSE, glm::value_ptr(c->GetView())); 
+	Scene::SetView(c->GetView(), c->GetProjection(w, h), h);
 
+	// the sun, relative to the camera like everything else
 	const float lightColor[] = {1.0f, 1.0f, 1.0f};
-	const float lightPos[] = {0.0f, 0.0f, 0.0f};
+	glm::vec3 lightPos = glm::vec3(-c->GetPosition());
 	glUniform3fv(m_planet_shader->GetUniformLocation("lightColor"), 1, lightColor);
-	glUniform3fv(m_planet_shader->GetUniformLocation("lightPos"), 1, lightPos);
+	glUniform3fv(m_planet_shader->GetUniformLocation("lightPos"), 1, glm::value_ptr(lightPos));
 
 	MatLocs m;
+	m.origin = c->GetPosition();
 	m.model = m_planet_shader->GetUniformLocation("model");
 	m.rotate = m_planet_shader->GetUniformLocation("rotate");
 	m.ambient = m_planet_shader->GetUniformLocation("ambientStrength");
@@ -351,12 +474,19 @@ void Graphics::UI() {
 	if(c == &free_camera) {
 		ImGui::SliderFloat("Speed", &free_camera.speed, 5.0f, 100.0f);
 	}
+	ImGui::Checkbox("LODs", &Scene::use_lods);
+	ImGui::SliderFloat("LOD error (px)", &Scene::lod_pixel_error, 0.25f, 16.0f);
+	ImGui::Text("Triangles: %u of %u", Scene::last_triangles, Scene::last_full_triangles);
+	ImGui::Text("GL state changes: %u (%u skipped)", GLState::last_changes, GLState::last_skipped);
+}
+
+glm::dvec3 Graphics::GetCameraPosition() {
+	return GetCamera()->GetPosition();
 }
 
 GLint Graphics::BeginPathRender(int w, int h) {
 
 	Camera* c = GetCamera();
-	glBindVertexArray(path_VAO);
 	m_path_shader->Enable();
 	
 	// Send in the projection and view to the shader
@@ -366,6 +496,37 @@ GLint Graphics::BeginPathRender(int w, int h) {
 	return m_path_shader->GetUniformLocation("model");
 }
 
+float Graphics::BeginOrbitRender(int w, int h) {
+
+	Camera* c = GetCamera();
+	m_orbit_shader->Enable();
+
+	glm::mat4 proj = c->GetProjection(w, h);
+	glUniformMatrix4fv(m_orbit_shader->GetUniformLocation("proj"), 1, GL_FALSE, glm::value_ptr(proj)); 
+	glUniformMatrix4fv(m_orbit_shader->GetUniformLocation("view"), 1, GL_FALSE, glm::value_ptr(c->GetView())); 
+
+	return proj[1][1] * h / 2.0f;
+}
+
+glm::mat4 Graphics::BeginBeltRender(int w, int h) {
+
+	Camera* c = GetCamera();
+	m_rock_shader->Enable();
+
+	glm::mat4 proj = c->GetProjection(w, h), view = c->GetView();
+	glUniformMatrix4fv(m_rock_shader->GetUniformLocation("proj"), 1, GL_FALSE, glm::value_ptr(proj)); 
+	glUniformMatrix4fv(m_rock_shader->GetUniformLocation("view"), 1, GL_FALSE, glm::value_ptr(view)); 
+
+	// lit like the planets, by the sun relative to the camera
+	const float lightColor[] = {1.0f, 1.0f, 1.0f};
+	glm::vec3 lightPos = glm::vec3(-c->GetPosition());
+	glUniform3fv(m_rock_shader->GetUniformLocation("lightColor"), 1, lightColor);
+	glUniform3fv(m_rock_shader->GetUniformLocation("lightPos"), 1, glm::value_ptr(lightPos));
+	glUniform1f(m_rock_shader->GetUniformLocation("ambientStrength"), 0.2f);
+
+	return proj * view;
+}
+
 void Graphics::EndRender() {
 
 	ImGui::Render();
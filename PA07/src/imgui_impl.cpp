@@ -7,6 +7,7 @@
 // https://github.com/ocornut/imgui
 
 #include "imgui_impl.h"
+#include "benchmark.h"
 #include <imgui.h>
 #include <SDL2/SDL.h>
 
@@ -103,6 +104,7 @@ void ImGui_ImplSdlGL3_RenderDrawLists(ImDrawData* draw_data)
                 glBindTexture(GL_TEXTURE_2D, (GLuint)(intptr_t)pcmd->TextureId);
                 glScissor((int)pcmd->ClipRect.x, (int)(fb_height - pcmd->ClipRect.w), (int)(pcmd->ClipRect.z - pcmd->ClipRect.x), (int)(pcmd->ClipRect.w - pcmd->ClipRect.y));
                 glDrawElements(GL_TRIANGLES, (GLsizei)pcmd->ElemCount, sizeof(ImDrawIdx) == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT, idx_buffer_offset);
+                Benchmark::draw_calls++;
             }
             idx_buffer_offset += pcmd->ElemCount;
         }
@@ -359,12 +361,16 @@ void ImGui_ImplSdlGL3_NewFrame(SDL_Window* window)
     ImGuiIO& io = ImGui::GetIO();
 
     // Setup display size (every frame to accommodate for window resizing)
-    int w, h;
-    int display_w, display_h;
-    SDL_GetWindowSize(window, &w, &h);
-    SDL_GL_GetDrawableSize(window, &display_w, &display_h);
-    io.DisplaySize = ImVec2((float)w, (float)h);
-    io.DisplayFramebufferScale = ImVec2(w > 0 ? ((float)display_w / w) : 0, h > 0 ? ((float)display_h / h) : 0);
+    // Headless runs pass no window and set io.DisplaySize themselves
+    if (window)
+    {
+        int w, h;
+        int display_w, display_h;
+        SDL_GetWindowSize(window, &w, &h);
+        SDL_GL_GetDrawableSize(window, &display_w, &display_h);
+        io.DisplaySize = ImVec2((float)w, (float)h);
+        io.DisplayFramebufferScale = ImVec2(w > 0 ? ((float)display_w / w) : 0, h > 0 ? ((float)display_h / h) : 0);
+    }
 
     // Setup time step
     Uint32	time = SDL_GetTicks();
@@ -376,7 +382,7 @@ void ImGui_ImplSdlGL3_NewFrame(SDL_Window* window)
     // (we already got mouse wheel, keyboard keys & characters from SDL_PollEvent())
     int mx, my;
     Uint32 mouseMask = SDL_GetMouseState(&mx, &my);
-    if (SDL_GetWindowFlags(window) & SDL_WINDOW_MOUSE_FOCUS)
+    if (window && (SDL_GetWindowFlags(window) & SDL_WINDOW_MOUSE_FOCUS))
         io.MousePos = ImVec2((float)mx, (float)my);   // Mouse position, in pixels (set to -1,-1 if no mouse / on another screen, etc.)
     else
         io.MousePos = ImVec2(-FLT_MAX, -FLT_MAX);
@@ -390,7 +396,8 @@ void ImGui_ImplSdlGL3_NewFrame(SDL_Window* window)
     g_MouseWheel = 0.0f;
 
     // Hide OS mouse cursor if ImGui is drawing it
-    SDL_ShowCursor(io.MouseDrawCursor ? 0 : 1);
+    if (window)
+        SDL_ShowCursor(io.MouseDrawCursor ? 0 : 1);
 
     // Start the frame
     ImGui::NewFrame();
@@ -2,8 +2,13 @@
 #include <iostream>
 #include <string>
 #include <vector>
+#include <cstdlib>
 
 #include "engine.h"
+#include "orbits.h"
+#include "nbody.h"
+#include "scenegraph.h"
+#include "assetloader.h"
 
 int main(int argc, char **argv) {
   
@@ -12,6 +17,28 @@ int main(int argc, char **argv) {
 	std::vector<std::string> args;
 	for(int i = 1; i < argc; i++) {
 		args.push_back(string(argv[i]));
+
+		// time the orbit solver on a generated asteroid belt and quit
+		if(args.back() == "--orbits" && i + 1 < argc) {
+			Orbits::Benchmark(atoi(argv[i+1]));
+			return 0;
+		}
+
+		// time the scene graph update on a generated hierarchy and quit
+		if(args.back() == "--scenegraph" && i + 1 < argc) {
+			AssetLoader::StartWorkers();
+			SceneGraph::Benchmark(atoi(argv[i+1]), AssetLoader::ParallelFor);
+			AssetLoader::Stop();
+			return 0;
+		}
+
+		// time the gravity simulation on a generated disk and quit
+		if(args.back() == "--nbody" && i + 1 < argc) {
+			AssetLoader::StartWorkers();
+			NBody::Benchmark(atoi(argv[i+1]));
+			AssetLoader::Stop();
+			return 0;
+		}
 	}
 
 	Engine *engine = new Engine("Solar System", 1280, 720);
@@ -0,0 +1,266 @@
+
+#include "meshsimplifier.h"
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <unordered_map>
+
+// sum of squared distances to a set of planes, weighted by triangle area
+struct Quadric {
+
+	double a2, b2, c2, d2, ab, ac, ad, bc, bd, cd;
+	double w;
+
+	Quadric() {
+		a2 = b2 = c2 = d2 = ab = ac = ad = bc = bd = cd = w = 0.0;
+	}
+
+	void AddPlane(double a, double b, double c, double d, double weight) {
+		a2 += a * a * weight; b2 += b * b * weight; c2 += c * c * weight; d2 += d * d * weight;
+		ab += a * b * weight; ac += a * c * weight; ad += a * d * weight;
+		bc += b * c * weight; bd += b * d * weight; cd += c * d * weight;
+		w += weight;
+	}
+
+	void Add(const Quadric& q) {
+		a2 += q.a2; b2 += q.b2; c2 += q.c2; d2 += q.d2;
+		ab += q.ab; ac += q.ac; ad += q.ad;
+		bc += q.bc; bd += q.bd; cd += q.cd;
+		w += q.w;
+	}
+
+	double Error(const glm::vec3& p) const {
+		double x = p.x, y = p.y, z = p.z;
+		return a2 * x * x + b2 * y * y + c2 * z * z + d2
+		     + 2.0 * (ab * x * y + ac * x * z + bc * y * z + ad * x + bd * y + cd * z);
+	}
+};
+
+struct Collapse {
+	unsigned int from, to;
+	float cost;
+};
+
+// a position shared by any number of vertices that differ in normal / texcoord
+struct PositionKey {
+	float x, y, z;
+	bool operator==(const PositionKey& o) const { return x == o.x && y == o.y && z == o.z; }
+};
+
+struct PositionHash {
+	size_t operator()(const PositionKey& k) const {
+		unsigned int h[3];
+		memcpy(h, &k, sizeof(h));
+		return (h[0] * 73856093u) ^ (h[1] * 19349663u) ^ (h[2] * 83492791u);
+	}
+};
+
+// squared distance between the non-position attributes of two vertices
+static float AttributeDistance(const Vertex& a, const Vertex& b) {
+	glm::vec3 n = a.normal - b.normal;
+	glm::vec2 t = a.texcoord - b.texcoord;
+	return glm::dot(n, n) + glm::dot(t, t);
+}
+
+float MeshSimplifier::Simplify(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices,
+                               size_t target_indices, std::vector<unsigned int>& out) {
+
+	out = indices;
+	if(out.size() <= target_indices) return 0.0f;
+
+	// weld vertices by position - collapses happen between positions, attributes follow
+	std::vector<unsigned int> position(vertices.size());
+	std::vector<unsigned int> first_wedge;
+	{
+		std::unordered_map<PositionKey, unsigned int, PositionHash> welded;
+		for(size_t v = 0; v < vertices.size(); v++) {
+			PositionKey key = {vertices[v].pos.x, vertices[v].pos.y, vertices[v].pos.z};
+			auto it = welded.find(key);
+			if(it == welded.end()) {
+				it = welded.insert(std::make_pair(key, (unsigned int)first_wedge.size())).first;
+				first_wedge.push_back(v);
+			}
+			position[v] = it->second;
+		}
+	}
+	size_t num_positions = first_wedge.size();
+
+	// every vertex at each position
+	std::vector<unsigned int> wedge_offsets(num_positions + 1, 0), wedges(vertices.size());
+	for(size_t v = 0; v < vertices.size(); v++) wedge_offsets[position[v] + 1]++;
+	for(size_t p = 0; p < num_positions; p++) wedge_offsets[p + 1] += wedge_offsets[p];
+	{
+		std::vector<unsigned int> cursor(wedge_offsets.begin(), wedge_offsets.end() - 1);
+		for(size_t v = 0; v < vertices.size(); v++) wedges[cursor[position[v]]++] = v;
+	}
+
+	// open edges only have one direction - their positions never move, so holes stay the same shape
+	std::vector<bool> locked(num_positions, false);
+	{
+		std::unordered_map<unsigned long long, unsigned int> directed;
+		for(size_t i = 0; i < out.size(); i += 3) {
+			for(int e = 0; e < 3; e++) {
+				unsigned long long a = position[out[i + e]], b = position[out[i + (e + 1) % 3]];
+				directed[a << 32 | b]++;
+			}
+		}
+		for(auto& d : directed) {
+			unsigned long long a = d.first >> 32, b = d.first & 0xffffffffu;
+			if(!directed.count(b << 32 | a)) {
+				locked[a] = locked[b] = true;
+			}
+		}
+	}
+
+	std::vector<Quadric> quadrics(num_positions);
+	for(size_t i = 0; i < out.size(); i += 3) {
+		const glm::vec3& p0 = vertices[out[i]].pos;
+		const glm::vec3& p1 = vertices[out[i + 1]].pos;
+		const glm::vec3& p2 = vertices[out[i + 2]].pos;
+
+		glm::vec3 n = glm::cross(p1 - p0, p2 - p0);
+		float area = glm::length(n);
+		if(area <= 0.0f) continue;
+		n /= area;
+
+		for(int k = 0; k < 3; k++) {
+			quadrics[position[out[i + k]]].AddPlane(n.x, n.y, n.z, -glm::dot(n, p0), area);
+		}
+	}
+
+	auto cost = [&](unsigned int from, unsigned int to) {
+		Quadric q = quadrics[from];
+		q.Add(quadrics[to]);
+		return (float)std::max(0.0, q.Error(vertices[first_wedge[to]].pos) / std::max(q.w, 1e-20));
+	};
+
+	std::vector<unsigned int> remap(num_positions);
+	std::vector<unsigned int> tri_offsets(num_positions + 1), adjacency;
+	std::vector<bool> touched(num_positions);
+	std::vector<Collapse> collapses;
+
+	float max_error = 0.0f;
+	size_t tris = out.size() / 3, target_tris = target_indices / 3;
+
+	while(tris > target_tris) {
+
+		// triangles around each position
+		std::fill(tri_offsets.begin(), tri_offsets.end(), 0);
+		for(unsigned int v : out) tri_offsets[position[v] + 1]++;
+		for(size_t p = 0; p < num_positions; p++) tri_offsets[p + 1] += tri_offsets[p];
+		adjacency.resize(out.size());
+		{
+			std::vector<unsigned int> cursor(tri_offsets.begin(), tri_offsets.end() - 1);
+			for(size_t i = 0; i < out.size(); i++) adjacency[cursor[position[out[i]]]++] = i / 3;
+		}
+
+		// every edge once, in its cheaper direction - interior edges show up as a -> b in exactly one triangle
+		collapses.clear();
+		for(size_t i = 0; i < out.size(); i += 3) {
+			for(int e = 0; e < 3; e++) {
+				unsigned int a = position[out[i + e]], b = position[out[i + (e + 1) % 3]];
+				if(a >= b || (locked[a] && locked[b])) continue;
+
+				Collapse c;
+				float ab = locked[a] ? INFINITY : cost(a, b);
+				float ba = locked[b] ? INFINITY : cost(b, a);
+				if(ab <= ba) { c.from = a; c.to = b; c.cost = ab; }
+				else         { c.from = b; c.to = a; c.cost = ba; }
+				collapses.push_back(c);
+			}
+		}
+		if(collapses.empty()) break;
+
+		std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b) { return a.cost < b.cost; });
+
+		// each collapse removes about two triangles - don't go much past what is needed
+		// at a cost well above the cheapest ones, the next pass may find cheaper ones
+		size_t goal = std::min(collapses.size() - 1, (tris - target_tris) / 2);
+		float cost_limit = collapses[goal].cost * 1.5f + 1e-12f;
+
+		for(size_t p = 0; p < num_positions; p++) remap[p] = p;
+		std::fill(touched.begin(), touched.end(), false);
+
+		size_t collapsed = 0;
+		for(const Collapse& c : collapses) {
+
+			if(c.cost > cost_limit || tris <= target_tris) break;
+			if(touched[c.from] || touched[c.to]) continue;
+
+			// triangles around from that survive must not flip, or turn far enough that a later pass could
+			const glm::vec3& to_pos = vertices[first_wedge[c.to]].pos;
+			size_t removed = 0;
+			bool flips = false;
+
+			for(unsigned int j = tri_offsets[c.from]; j < tri_offsets[c.from + 1] && !flips; j++) {
+				const unsigned int* tri = &out[adjacency[j] * 3];
+				unsigned int p[3] = {position[tri[0]], position[tri[1]], position[tri[2]]};
+
+				if(p[0] == c.to || p[1] == c.to || p[2] == c.to) {
+					removed++;
+					continue;
+				}
+
+				glm::vec3 v[3] = {vertices[tri[0]].pos, vertices[tri[1]].pos, vertices[tri[2]].pos};
+				glm::vec3 before = glm::cross(v[1] - v[0], v[2] - v[0]);
+				for(int k = 0; k < 3; k++) {
+					if(p[k] == c.from) v[k] = to_pos;
+				}
+				glm::vec3 after = glm::cross(v[1] - v[0], v[2] - v[0]);
+
+				flips = glm::dot(before, after) <= 0.25f * glm::length(before) * glm::length(after);
+			}
+			if(flips) continue;
+
+			remap[c.from] = c.to;
+			quadrics[c.to].Add(quadrics[c.from]);
+			max_error = std::max(max_error, c.cost);
+			tris -= removed;
+			collapsed++;
+
+			// the neighbourhood changed, its flip checks above are stale until the next pass
+			for(unsigned int j = tri_offsets[c.from]; j < tri_offsets[c.from + 1]; j++) {
+				const unsigned int* tri = &out[adjacency[j] * 3];
+				touched[position[tri[0]]] = touched[position[tri[1]]] = touched[position[tri[2]]] = true;
+			}
+		}
+
+		if(!collapsed) break;
+
+		// move every corner of a collapsed position to the closest matching vertex at the new one,
+		// then drop the triangles that became degenerate
+		size_t kept = 0;
+		for(size_t i = 0; i < out.size(); i += 3) {
+
+			unsigned int tri[3];
+			for(int k = 0; k < 3; k++) {
+				unsigned int v = out[i + k], p = position[v];
+				if(remap[p] != p) {
+					unsigned int to = remap[p], best = first_wedge[to];
+					float best_distance = INFINITY;
+					for(unsigned int j = wedge_offsets[to]; j < wedge_offsets[to + 1]; j++) {
+						float d = AttributeDistance(vertices[v], vertices[wedges[j]]);
+						if(d < best_distance) {
+							best_distance = d;
+							best = wedges[j];
+						}
+					}
+					v = best;
+				}
+				tri[k] = v;
+			}
+
+			if(position[tri[0]] == position[tri[1]] || position[tri[1]] == position[tri[2]] || position[tri[0]] == position[tri[2]]) {
+				continue;
+			}
+			out[kept++] = tri[0];
+			out[kept++] = tri[1];
+			out[kept++] = tri[2];
+		}
+		out.resize(kept);
+		tris = kept / 3;
+	}
+
+	return sqrtf(max_error);
+}
@@ -0,0 +1,368 @@
+
+#include "nbody.h"
+#include "assetloader.h"
+
+#include <cmath>
+#include <chrono>
+#include <random>
+#include <numeric>
+#include <algorithm>
+
+// bodies per leaf, summed directly
+static const unsigned int LEAF_SIZE = 8;
+// most bodies sharing one walk of the tree in the force pass
+static const unsigned int GROUP_SIZE = 32;
+// deeper than this, bodies on top of each other just share a leaf
+static const unsigned int MAX_DEPTH = 24;
+// groups per task in the force pass
+static const unsigned int CHUNK = 8;
+// interactions summed side by side, two SSE registers wide
+static const unsigned int LANES = 8;
+
+static double Millis(std::chrono::high_resolution_clock::time_point since) {
+	return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - since).count();
+}
+
+NBody::NBody() {
+	theta = 0.7f;
+	softening = 0.01f;
+	build_ms = force_ms = integrate_ms = 0.0;
+	forces_valid = false;
+}
+
+void NBody::Clear() {
+
+	for(auto v : {&x, &y, &z, &vx, &vy, &vz, &ax, &ay, &az, &m}) {
+		v->clear();
+	}
+	forces_valid = false;
+}
+
+unsigned int NBody::Add(glm::vec3 pos, glm::vec3 vel, float mass) {
+
+	x.push_back(pos.x); y.push_back(pos.y); z.push_back(pos.z);
+	vx.push_back(vel.x); vy.push_back(vel.y); vz.push_back(vel.z);
+	ax.push_back(0.0f); ay.push_back(0.0f); az.push_back(0.0f);
+	m.push_back(mass);
+	forces_valid = false;
+
+	return x.size() - 1;
+}
+
+unsigned int NBody::Size() const {
+	return x.size();
+}
+
+glm::vec3 NBody::Position(unsigned int i) const {
+	return glm::vec3(x[i], y[i], z[i]);
+}
+
+glm::vec3 NBody::Velocity(unsigned int i) const {
+	return glm::vec3(vx[i], vy[i], vz[i]);
+}
+
+void NBody::Step(float dt) {
+
+	unsigned int n = Size();
+	if(!n) return;
+
+	if(!forces_valid) {
+		Build();
+		Forces();
+		forces_valid = true;
+	}
+
+	float *X = x.data(), *Y = y.data(), *Z = z.data();
+	float *VX = vx.data(), *VY = vy.data(), *VZ = vz.data();
+	const float *AX = ax.data(), *AY = ay.data(), *AZ = az.data();
+	float h = dt * 0.5f;
+
+	// kick half a step and drift the whole step
+	auto start = std::chrono::high_resolution_clock::now();
+#pragma GCC ivdep
+	for(unsigned int i = 0; i < n; i++) {
+		VX[i] += AX[i] * h; VY[i] += AY[i] * h; VZ[i] += AZ[i] * h;
+		X[i] += VX[i] * dt; Y[i] += VY[i] * dt; Z[i] += VZ[i] * dt;
+	}
+	integrate_ms = Millis(start);
+
+	start = std::chrono::high_resolution_clock::now();
+	Build();
+	build_ms = Millis(start);
+
+	start = std::chrono::high_resolution_clock::now();
+	Forces();
+	force_ms = Millis(start);
+
+	// and the second half kick with the new accelerations
+	start = std::chrono::high_resolution_clock::now();
+#pragma GCC ivdep
+	for(unsigned int i = 0; i < n; i++) {
+		VX[i] += AX[i] * h; VY[i] += AY[i] * h; VZ[i] += AZ[i] * h;
+	}
+	integrate_ms += Millis(start);
+}
+
+void NBody::Build() {
+
+	unsigned int n = Size();
+
+	glm::vec3 lo(x[0], y[0], z[0]), hi = lo;
+	for(unsigned int i = 1; i < n; i++) {
+		lo = glm::min(lo, glm::vec3(x[i], y[i], z[i]));
+		hi = glm::max(hi, glm::vec3(x[i], y[i], z[i]));
+	}
+
+	// a cube around everything, a little loose so bodies on the far faces stay inside
+	glm::vec3 extent = hi - lo;
+	float half = std::max(std::max(extent.x, extent.y), std::max(extent.z, 1e-6f)) * 0.5f * 1.001f;
+
+	order.resize(n);
+	scratch.resize(n);
+	std::iota(order.begin(), order.end(), 0);
+	sx.resize(n); sy.resize(n); sz.resize(n); sm.resize(n);
+
+	nodes.clear();
+	nodes.emplace_back();
+	BuildNode(0, 0, n, (lo + hi) * 0.5f, half, 0);
+
+	// the largest cells with at most GROUP_SIZE bodies, in tree order
+	groups.clear();
+	std::vector<unsigned int> stack(1, 0);
+	while(!stack.empty()) {
+
+		unsigned int c = stack.back();
+		stack.pop_back();
+
+		const Node& cell = nodes[c];
+		if(cell.leaf || cell.end - cell.begin <= GROUP_SIZE) {
+			groups.push_back(c);
+		} else {
+			for(unsigned int k = cell.count; k > 0; k--) {
+				stack.push_back(cell.first + k - 1);
+			}
+		}
+	}
+}
+
+void NBody::BuildNode(unsigned int node, unsigned int begin, unsigned int end, glm::vec3 center, float half, unsigned int depth) {
+
+	Node cell;
+	cell.size = 2.0f * half;
+	cell.begin = begin;
+	cell.end = end;
+	cell.mass = cell.cx = cell.cy = cell.cz = 0.0f;
+
+	if(end - begin <= LEAF_SIZE || depth == MAX_DEPTH) {
+
+		// copy the bodies out in tree order so the force pass reads leaves straight through
+		for(unsigned int k = begin; k < end; k++) {
+			unsigned int i = order[k];
+			sx[k] = x[i]; sy[k] = y[i]; sz[k] = z[i]; sm[k] = m[i];
+
+			cell.mass += m[i];
+			cell.cx += m[i] * x[i]; cell.cy += m[i] * y[i]; cell.cz += m[i] * z[i];
+		}
+		cell.leaf = true;
+		cell.first = cell.count = 0;
+
+	} else {
+
+		// counting sort of this cell's bodies into its eight octants
+		unsigned int counts[8] = {0}, offsets[8];
+		for(unsigned int k = begin; k < end; k++) {
+			unsigned int i = order[k];
+			counts[(x[i] > center.x) | (y[i] > center.y) << 1 | (z[i] > center.z) << 2]++;
+		}
+
+		offsets[0] = begin;
+		for(int o = 1; o < 8; o++) {
+			offsets[o] = offsets[o - 1] + counts[o - 1];
+		}
+		for(unsigned int k = begin; k < end; k++) {
+			unsigned int i = order[k];
+			scratch[offsets[(x[i] > center.x) | (y[i] > center.y) << 1 | (z[i] > center.z) << 2]++] = i;
+		}
+		std::copy(scratch.begin() + begin, scratch.begin() + end, order.begin() + begin);
+
+		// only the occupied octants get cells, next to each other
+		cell.leaf = false;
+		cell.first = nodes.size();
+		cell.count = 0;
+		for(int o = 0; o < 8; o++) {
+			if(counts[o]) cell.count++;
+		}
+		nodes.resize(cell.first + cell.count);
+
+		unsigned int child = cell.first, start = begin;
+		for(int o = 0; o < 8; o++) {
+			if(!counts[o]) continue;
+
+			float q = half * 0.5f;
+			glm::vec3 offset(o & 1 ? q : -q, o & 2 ? q : -q, o & 4 ? q : -q);
+			BuildNode(child, start, start + counts[o], center + offset, q, depth + 1);
+
+			const Node& c = nodes[child];
+			cell.mass += c.mass;
+			cell.cx += c.mass * c.cx; cell.cy += c.mass * c.cy; cell.cz += c.mass * c.cz;
+
+			start += counts[o];
+			child++;
+		}
+	}
+
+	if(cell.mass > 0.0f) {
+		cell.cx /= cell.mass; cell.cy /= cell.mass; cell.cz /= cell.mass;
+	} else {
+		cell.cx = center.x; cell.cy = center.y; cell.cz = center.z;
+	}
+	nodes[node] = cell;
+}
+
+void NBody::Forces() {
+
+	unsigned int chunks = (groups.size() + CHUNK - 1) / CHUNK;
+
+	// groups are in tree order, so neighbouring groups walk nearly the same cells
+	AssetLoader::ParallelFor(chunks, [&](unsigned int c) {
+
+		Interactions list;
+		unsigned int end = std::min((unsigned int)groups.size(), (c + 1) * CHUNK);
+		for(unsigned int g = c * CHUNK; g < end; g++) {
+			GroupForces(nodes[groups[g]], list);
+		}
+	});
+}
+
+void NBody::GroupForces(const Node& group, Interactions& list) {
+
+	// bounds of the group's bodies - a cell far enough from all of them is one mass for every one of them
+	glm::vec3 lo(sx[group.begin], sy[group.begin], sz[group.begin]), hi = lo;
+	for(unsigned int k = group.begin + 1; k < group.end; k++) {
+		lo = glm::min(lo, glm::vec3(sx[k], sy[k], sz[k]));
+		hi = glm::max(hi, glm::vec3(sx[k], sy[k], sz[k]));
+	}
+	glm::vec3 center = (lo + hi) * 0.5f, extent = (hi - lo) * 0.5f;
+
+	list.x.clear(); list.y.clear(); list.z.clear(); list.m.clear();
+	auto add = [&](float x, float y, float z, float m) {
+		list.x.push_back(x); list.y.push_back(y); list.z.push_back(z); list.m.push_back(m);
+	};
+
+	// every cell pushes at most eight children and the tree is at most MAX_DEPTH deep
+	unsigned int stack[8 * (MAX_DEPTH + 1)];
+	unsigned int top = 0;
+	stack[top++] = 0;
+
+	float theta2 = theta * theta;
+	while(top) {
+
+		const Node& cell = nodes[stack[--top]];
+
+		// distance from the cell's centre of mass to the nearest point of the group's bounds
+		float dx = std::max(fabsf(cell.cx - center.x) - extent.x, 0.0f);
+		float dy = std::max(fabsf(cell.cy - center.y) - extent.y, 0.0f);
+		float dz = std::max(fabsf(cell.cz - center.z) - extent.z, 0.0f);
+
+		// a cell holding the group always opens - its centre of mass can sit far enough off in a corner to pass,
+			// and the group's bodies would then pull on themselves through it
+		bool holds_group = cell.begin <= group.begin && group.end <= cell.end;
+
+		if(!holds_group && cell.size * cell.size < theta2 * (dx * dx + dy * dy + dz * dz)) {
+			add(cell.cx, cell.cy, cell.cz, cell.mass);
+		} else if(cell.leaf) {
+			for(unsigned int k = cell.begin; k < cell.end; k++) {
+				add(sx[k], sy[k], sz[k], sm[k]);
+			}
+		} else {
+			for(unsigned int c = 0; c < cell.count; c++) {
+				stack[top++] = cell.first + c;
+			}
+		}
+	}
+
+	// massless padding up to a whole number of lanes
+	while(list.m.size() % LANES) add(0.0f, 0.0f, 0.0f, 0.0f);
+
+	const float *X = list.x.data(), *Y = list.y.data(), *Z = list.z.data(), *M = list.m.data();
+	unsigned int n = list.m.size();
+	float eps2 = softening * softening;
+
+	for(unsigned int k = group.begin; k < group.end; k++) {
+
+		float px = sx[k], py = sy[k], pz = sz[k];
+
+		// one running sum per lane, so the compiler can vectorize across the list without reordering any sum
+			// the body's own entry is in the list too, softening makes its pull on itself zero
+		float fx[LANES] = {0.0f}, fy[LANES] = {0.0f}, fz[LANES] = {0.0f};
+		for(unsigned int j = 0; j < n; j += LANES) {
+			for(unsigned int l = 0; l < LANES; l++) {
+				float ex = X[j + l] - px, ey = Y[j + l] - py, ez = Z[j + l] - pz;
+				float inv = 1.0f / sqrtf(ex * ex + ey * ey + ez * ez + eps2);
+				float f = M[j + l] * inv * inv * inv;
+				fx[l] += ex * f; fy[l] += ey * f; fz[l] += ez * f;
+			}
+		}
+
+		float ax_sum = 0.0f, ay_sum = 0.0f, az_sum = 0.0f;
+		for(unsigned int l = 0; l < LANES; l++) {
+			ax_sum += fx[l]; ay_sum += fy[l]; az_sum += fz[l];
+		}
+
+		unsigned int i = order[k];
+		ax[i] = ax_sum; ay[i] = ay_sum; az[i] = az_sum;
+	}
+}
+
+void NBody::Benchmark(unsigned int count, unsigned int steps) {
+
+	// a thin disk between 1 and 3 units out, every body on a circular orbit around a star of mass 1
+	std::mt19937 rng(1);
+	std::uniform_real_distribution<float> radius(1.0f, 3.0f), angle(0.0f, 6.28318531f), height(-0.02f, 0.02f);
+
+	NBody sim;
+	sim.Add(glm::vec3(0.0f), glm::vec3(0.0f), 1.0f);
+	for(unsigned int i = 0; i < count; i++) {
+
+		float r = radius(rng), t = angle(rng);
+		glm::vec3 pos(r * cosf(t), height(rng), r * sinf(t));
+		glm::vec3 vel = glm::vec3(-sinf(t), 0.0f, cosf(t)) * sqrtf(1.0f / r);
+		sim.Add(pos, vel, 1e-7f);
+	}
+
+	double build = 0.0, force = 0.0, integrate = 0.0;
+	for(unsigned int s = 0; s < steps; s++) {
+		sim.Step(0.01f);
+		build += sim.build_ms;
+		force += sim.force_ms;
+		integrate += sim.integrate_ms;
+	}
+
+	// the tree against summing every pair, for a sample of bodies
+	unsigned int n = sim.Size(), samples = std::min(n, 256u);
+	double error_sum = 0.0, error_max = 0.0;
+	for(unsigned int s = 0; s < samples; s++) {
+
+		// skipping the star, whose pull from a symmetric disk is close to nothing
+		unsigned int i = 1 + (unsigned int)((unsigned long long)s * (n - 1) / samples);
+		double dx_sum = 0.0, dy_sum = 0.0, dz_sum = 0.0, eps2 = sim.softening * sim.softening;
+		for(unsigned int j = 0; j < n; j++) {
+			double dx = sim.x[j] - sim.x[i], dy = sim.y[j] - sim.y[i], dz = sim.z[j] - sim.z[i];
+			double inv = 1.0 / sqrt(dx * dx + dy * dy + dz * dz + eps2);
+			double f = sim.m[j] * inv * inv * inv;
+			dx_sum += dx * f; dy_sum += dy * f; dz_sum += dz * f;
+		}
+
+		double ex = sim.ax[i] - dx_sum, ey = sim.ay[i] - dy_sum, ez = sim.az[i] - dz_sum;
+		double error = sqrt(ex * ex + ey * ey + ez * ez) / sqrt(dx_sum * dx_sum + dy_sum * dy_sum + dz_sum * dz_sum);
+		error_sum += error;
+		error_max = std::max(error_max, error);
+	}
+
+	printf("%u bodies, %u steps, theta %.2f, %zu cells\n", n, steps, sim.theta, sim.nodes.size());
+	printf("  tree build: %8.3f ms/step\n", build / steps);
+	printf("  forces:     %8.3f ms/step\n", force / steps);
+	printf("  integrate:  %8.3f ms/step\n", integrate / steps);
+	printf("  total:      %8.3f ms/step\n", (build + force + integrate) / steps);
+	printf("  force error against direct summation: mean %.2e, max %.2e\n", error_sum / samples, error_max);
+}
@@ -0,0 +1,93 @@
+
+#include "orbitpaths.h"
+#include "benchmark.h"
+#include "glstate.h"
+
+#include <cmath>
+#include <cstddef>
+#include <algorithm>
+
+static const float PI = 3.14159265f;
+
+// segments per orbit
+static const float MIN_SEGMENTS = 16.0f;
+static const float MAX_SEGMENTS = 1024.0f;
+
+OrbitPaths::OrbitPaths() {
+	pixel_error = 0.5f;
+	last_segments = 0;
+	vao = vbo = 0;
+}
+
+OrbitPaths::~OrbitPaths() {
+
+	if(vao) {
+		GLState::DeleteVertexArray(vao);
+		glDeleteBuffers(1, &vbo);
+	}
+}
+
+void OrbitPaths::Render(const Orbits& orbits, const glm::dvec3& origin, float proj_scale) {
+
+	instances.clear();
+	last_segments = 0;
+
+	float most = 0.0f;
+	for(unsigned int i = 0; i < orbits.Size(); i++) {
+
+		glm::mat4 model = orbits.PathTransform(i, origin);
+		glm::vec3 major(model[0]), normal(model[1]), minor(model[2]), center(model[3]);
+		float a = glm::length(major), b = glm::length(minor);
+
+		// bodies sitting on their parent, like the sun
+		if(a <= 0.0f || b <= 0.0f) continue;
+
+		// the camera in the orbit's own axes, and roughly how far it is from the nearest point of the orbit
+		float u = -glm::dot(center, major) / a, v = -glm::dot(center, minor) / b, h = -glm::dot(center, normal);
+		float across = sqrtf(u * u + v * v) - a;
+		float distance = std::max(sqrtf(across * across + h * h) - (a - b), 1e-6f);
+
+		// a chord strays r (1 - cos(pi / n)) ~ r pi^2 / 2n^2 from a curve of radius r, a^2 / b at the sharpest
+		float r = a * a / b;
+		float n = ceilf(PI * sqrtf(r * proj_scale / (2.0f * distance * pixel_error)));
+		n = std::min(std::max(n, MIN_SEGMENTS), MAX_SEGMENTS);
+
+		Instance instance;
+		instance.model = model;
+		instance.segments = n;
+		instances.push_back(instance);
+
+		most = std::max(most, n);
+		last_segments += (unsigned int)n;
+	}
+
+	if(instances.empty()) return;
+
+	if(!vao) {
+		glGenVertexArrays(1, &vao);
+		glGenBuffers(1, &vbo);
+
+		// no per vertex data, the points come from gl_VertexID
+		GLState::BindVertexArray(vao);
+		glBindBuffer(GL_ARRAY_BUFFER, vbo);
+		for(int c = 0; c < 4; c++) {
+			glEnableVertexAttribArray(1 + c);
+			glVertexAttribPointer(1 + c, 4, GL_FLOAT, GL_FALSE, sizeof(Instance), (void*)(offsetof(Instance, model) + sizeof(glm::vec4) * c));
+			glVertexAttribDivisor(1 + c, 1);
+		}
+		glEnableVertexAttribArray(5);
+		glVertexAttribPointer(5, 1, GL_FLOAT, GL_FALSE, sizeof(Instance), (void*)offsetof(Instance, segments));
+		glVertexAttribDivisor(5, 1);
+		GLState::BindVertexArray(0);
+	}
+
+	// a few dozen transforms, small enough to just replace every frame
+	glBindBuffer(GL_ARRAY_BUFFER, vbo);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(Instance) * instances.size(), instances.data(), GL_STREAM_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	// every strip runs to the longest one's length, shorter ones stop on their first point
+	GLState::BindVertexArray(vao);
+	glDrawArraysInstanced(GL_LINE_STRIP, 0, (GLsizei)most + 1, instances.size());
+	Benchmark::draw_calls++;
+}
@@ -0,0 +1,266 @@
+
+#include "orbits.h"
+
+#include <cmath>
+#include <chrono>
+#include <random>
+#include <algorithm>
+
+static const float PI = 3.14159265f;
+static const float TWO_PI = 6.28318531f;
+static const float HALF_PI = 1.57079633f;
+
+// everything below is branch-free (min / max only) so loops calling it vectorize
+
+// x moved into [-pi, pi]
+static inline float Wrap(float x) {
+	float turns = x * (1.0f / TWO_PI);
+	float k = (float)(int)(turns + copysignf(0.5f, turns));
+	return x - k * TWO_PI;
+}
+
+// ~1e-7 absolute error near zero, growing with the number of turns wrapped off
+static inline float Sin(float x) {
+
+	x = Wrap(x);
+
+	// sin(x) = sin(pi - x) = sin(-pi - x), fold into [-pi/2, pi/2]
+	x = std::max(std::min(x, PI - x), -PI - x);
+
+	float x2 = x * x;
+	return x * (1.0f + x2 * (-1.0f / 6.0f + x2 * (1.0f / 120.0f + x2 * (-1.0f / 5040.0f
+	         + x2 * (1.0f / 362880.0f + x2 * (-1.0f / 39916800.0f))))));
+}
+
+static inline float Cos(float x) {
+	return Sin(x + HALF_PI);
+}
+
+// one Newton step towards the eccentric anomaly E solving E - e sin E = M
+	// s and c are set to the sine and cosine of E before the step
+static inline float KeplerStep(float E, float e, float M, float& s, float& c) {
+	s = Sin(E);
+	c = Cos(E);
+	return E - (E - e * s - M) / (1.0f - e * c);
+}
+
+unsigned int Orbits::Add(int p) {
+
+	parent.push_back(p);
+	a.push_back(0.0f); b.push_back(0.0f); e.push_back(0.0f);
+	px.push_back(1.0f); py.push_back(0.0f); pz.push_back(0.0f);
+	qx.push_back(0.0f); qy.push_back(0.0f); qz.push_back(1.0f);
+	mean_motion.push_back(0.0f); mean_anomaly.push_back(0.0f);
+	spin_rate.push_back(0.0f); spin.push_back(0.0f);
+	x.push_back(0.0f); y.push_back(0.0f); z.push_back(0.0f);
+
+	return parent.size() - 1;
+}
+
+void Orbits::Clear() {
+
+	for(auto v : {&a, &b, &e, &px, &py, &pz, &qx, &qy, &qz, &mean_motion, &mean_anomaly, &spin_rate, &spin}) {
+		v->clear();
+	}
+	x.clear(); y.clear(); z.clear();
+	parent.clear();
+}
+
+unsigned int Orbits::Size() const {
+	return parent.size();
+}
+
+void Orbits::SetOrbit(unsigned int i, float _a, float _e, const glm::mat3& orient) {
+
+	a[i] = _a;
+	e[i] = _e;
+	b[i] = _a * sqrtf(1.0f - _e * _e);
+
+	px[i] = orient[0].x; py[i] = orient[0].y; pz[i] = orient[0].z;
+	qx[i] = orient[2].x; qy[i] = orient[2].y; qz[i] = orient[2].z;
+}
+
+void Orbits::SetMotion(unsigned int i, float _mean_motion, float _mean_anomaly, float _spin_rate, float _spin) {
+
+	mean_motion[i] = _mean_motion;
+	mean_anomaly[i] = Wrap(_mean_anomaly);
+	spin_rate[i] = _spin_rate;
+	spin[i] = Wrap(_spin);
+}
+
+void Orbits::Update(float dt) {
+
+	unsigned int n = Size();
+
+	float *M = mean_anomaly.data(), *S = spin.data();
+	double *X = x.data(), *Y = y.data(), *Z = z.data();
+	const float *n_ = mean_motion.data(), *s_ = spin_rate.data();
+	const float *A = a.data(), *B = b.data(), *ecc = e.data();
+	const float *Px = px.data(), *Py = py.data(), *Pz = pz.data();
+	const float *Qx = qx.data(), *Qy = qy.data(), *Qz = qz.data();
+
+	// the arrays never overlap - ivdep saves the compiler checking that at runtime, which
+	// it gives up on with this many arrays and falls back to scalar code
+
+	// kept in [-pi, pi] so single precision never runs out over a long run
+#pragma GCC ivdep
+	for(unsigned int i = 0; i < n; i++) {
+		M[i] = Wrap(M[i] + n_[i] * dt);
+		S[i] = Wrap(S[i] + s_[i] * dt);
+	}
+
+	// E - e sin E = M, then the position relative to the parent
+#pragma GCC ivdep
+	for(unsigned int i = 0; i < n; i++) {
+
+		// a fixed four steps from E = M + e sin M - float precision up to e ~0.7, within 1e-4 at 0.9
+			// written out, a loop here would stop the compiler vectorizing the outer one
+		float m = M[i], ei = ecc[i], s, c;
+		float E = m + ei * Sin(m);
+		E = KeplerStep(E, ei, m, s, c);
+		E = KeplerStep(E, ei, m, s, c);
+		E = KeplerStep(E, ei, m, s, c);
+
+		// the last step is tiny, carry sin / cos along it instead of working them out again
+		float d = KeplerStep(E, ei, m, s, c) - E;
+		float sin_E = s + c * d, cos_E = c - s * d;
+
+		float ox = A[i] * (cos_E - ei), oz = B[i] * sin_E;
+
+		X[i] = ox * Px[i] + oz * Qx[i];
+		Y[i] = ox * Py[i] + oz * Qy[i];
+		Z[i] = ox * Pz[i] + oz * Qz[i];
+	}
+
+	// parents come first, their world positions are already final
+	const int* p = parent.data();
+	for(unsigned int i = 0; i < n; i++) {
+		if(p[i] >= 0) {
+			X[i] += X[p[i]];
+			Y[i] += Y[p[i]];
+			Z[i] += Z[p[i]];
+		}
+	}
+}
+
+glm::dvec3 Orbits::Position(unsigned int i) const {
+	return glm::dvec3(x[i], y[i], z[i]);
+}
+
+glm::dvec3 Orbits::ParentPosition(unsigned int i) const {
+	return parent[i] >= 0 ? Position(parent[i]) : glm::dvec3(0.0);
+}
+
+float Orbits::Spin(unsigned int i) const {
+	return spin[i];
+}
+
+int Orbits::Parent(unsigned int i) const {
+	return parent[i];
+}
+
+glm::vec3 Orbits::Velocity(unsigned int i) const {
+
+	float m = mean_anomaly[i], E = m + e[i] * sinf(m);
+	for(int k = 0; k < 8; k++) {
+		E -= (E - e[i] * sinf(E) - m) / (1.0f - e[i] * cosf(E));
+	}
+
+	// d/dt of a (cos E - e) p + b sin E q
+	float rate = mean_motion[i] / (1.0f - e[i] * cosf(E));
+	float vp = -a[i] * sinf(E) * rate, vq = b[i] * cosf(E) * rate;
+	return glm::vec3(vp * px[i] + vq * qx[i], vp * py[i] + vq * qy[i], vp * pz[i] + vq * qz[i]);
+}
+
+float Orbits::GM(unsigned int i) const {
+
+	// Kepler's third law, n^2 a^3 = GM
+	return mean_motion[i] * mean_motion[i] * a[i] * a[i] * a[i];
+}
+
+void Orbits::SetPosition(unsigned int i, glm::dvec3 pos) {
+	x[i] = pos.x;
+	y[i] = pos.y;
+	z[i] = pos.z;
+}
+
+glm::mat4 Orbits::PathTransform(unsigned int i, const glm::dvec3& origin) const {
+
+	// the centre is a e back along the major axis from the focus the parent sits at
+	glm::vec3 p(px[i], py[i], pz[i]), q(qx[i], qy[i], qz[i]);
+	glm::dvec3 center = ParentPosition(i) - origin - glm::dvec3(p) * (double)(a[i] * e[i]);
+
+	glm::mat4 m(1.0f);
+	m[0] = glm::vec4(p * a[i], 0.0f);
+	m[1] = glm::vec4(glm::cross(q, p), 0.0f);
+	m[2] = glm::vec4(q * b[i], 0.0f);
+	m[3] = glm::vec4(glm::vec3(center), 1.0f);
+	return m;
+}
+
+void Orbits::Benchmark(unsigned int count, unsigned int steps) {
+
+	// an asteroid belt - semi-major axes between 2.2 and 3.3, periods from Kepler's third law
+	std::mt19937 rng(1);
+	std::uniform_real_distribution<float> axis(2.2f, 3.3f), eccentricity(0.0f, 0.3f), angle(-PI, PI), incline(-0.3f, 0.3f);
+
+	Orbits belt;
+	belt.Add(-1);
+	for(unsigned int i = 0; i < count; i++) {
+
+		unsigned int body = belt.Add(0);
+		float r = axis(rng);
+
+		glm::mat3 orient = glm::mat3(glm::rotate(glm::mat4(1.0f), angle(rng), glm::vec3(0.0f, 1.0f, 0.0f)) *
+		                             glm::rotate(glm::mat4(1.0f), incline(rng), glm::vec3(1.0f, 0.0f, 0.0f)));
+
+		belt.SetOrbit(body, r, eccentricity(rng), orient);
+		belt.SetMotion(body, 1.0f / (r * sqrtf(r)), angle(rng), 0.0f, 0.0f);
+	}
+
+	// the same thing one body at a time with libm, iterating until converged
+	auto scalar = [&](float dt) {
+
+		for(unsigned int i = 1; i <= count; i++) {
+
+			float m = fmodf(belt.mean_anomaly[i] + belt.mean_motion[i] * dt, TWO_PI), ei = belt.e[i];
+			belt.mean_anomaly[i] = m;
+
+			float E = m + ei * sinf(m);
+			for(int k = 0; k < 16; k++) {
+				float step = (E - ei * sinf(E) - m) / (1.0f - ei * cosf(E));
+				E -= step;
+				if(fabsf(step) < 1e-6f) break;
+			}
+
+			float ox = belt.a[i] * (cosf(E) - ei), oz = belt.b[i] * sinf(E);
+			belt.x[i] = ox * belt.px[i] + oz * belt.qx[i];
+			belt.y[i] = ox * belt.py[i] + oz * belt.qy[i];
+			belt.z[i] = ox * belt.pz[i] + oz * belt.qz[i];
+		}
+	};
+
+	const float dt = 0.01f;
+	std::vector<float> anomaly = belt.mean_anomaly;
+
+	auto start = std::chrono::high_resolution_clock::now();
+	for(unsigned int s = 0; s < steps; s++) scalar(dt);
+	double scalar_ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count() / steps;
+	std::vector<double> sx = belt.x, sy = belt.y, sz = belt.z;
+
+	belt.mean_anomaly = anomaly;
+
+	start = std::chrono::high_resolution_clock::now();
+	for(unsigned int s = 0; s < steps; s++) belt.Update(dt);
+	double batch_ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count() / steps;
+
+	float max_error = 0.0f;
+	for(unsigned int i = 1; i <= count; i++) {
+		max_error = std::max(max_error, (float)glm::length(glm::dvec3(belt.x[i] - sx[i], belt.y[i] - sy[i], belt.z[i] - sz[i])));
+	}
+
+	printf("%u bodies, %u steps\n", count, steps);
+	printf("  scalar libm: %8.3f ms/step, %6.1f M bodies/s\n", scalar_ms, count / scalar_ms / 1000.0);
+	printf("  batched:     %8.3f ms/step, %6.1f M bodies/s (%.1fx)\n", batch_ms, count / batch_ms / 1000.0, scalar_ms / batch_ms);
+	printf("  largest position difference: %g\n", max_error);
+}
@@ -2,16 +2,16 @@
 #include "solarsystem.h"
 #include "planet.h"
 #include "graphics.h"
+#include "benchmark.h"
+#include "glstate.h"
 #include <cmath>
 
 Planet::Planet() {
-	orbit_trace_vbo = 0;
 	diameter = distance = orbital_period = rotation_period = 0.0f;
 	inclination_orbit = inclination_equator = orbital_eccentricity = 0.0f;
 }
 
 Planet::Planet(std::string json) {
-	orbit_trace_vbo = 0;
 	diameter = distance = orbital_period = rotation_period = 0.0f;
 	inclination_orbit = inclination_equator = orbital_eccentricity = 0.0f;
 
@@ -34,9 +34,6 @@ void Planet::DeleteScene() {
 	for(auto& m : moons) {
 		m.DeleteScene();
 	}
-	if(orbit_trace_vbo) {
-		glDeleteBuffers(1, &orbit_trace_vbo);
-	}
 }
 
 bool Planet::LoadScene() {
@@ -123,7 +120,6 @@ void Planet::LoadJSONObj(const picojson::object& obj) {
 					Planet m;
 					m.rank = 3;
 					m.LoadJSONObj(j.get<picojson::object>());
-					m.LoadScene();
 					moons.push_back(m);
 				}
 			}
@@ -154,71 +150,32 @@ void Planet::LoadJSONObj(const picojson::object& obj) {
 	}
 }
 
-glm::mat4 Planet::getModel() {
-	return parentmx * orbittiltmx * translatemx * rotatemx * tiltmx * scalemx;
-}
-
-glm::vec3 Planet::getPos() {
-
-	if(name == "Sun") return glm::vec3(1.0f);
-	return pos_for_tracking;
-}
-
-void Planet::GenerateOrbitTrace(const ss_settings& settings) {
-
-	orbit_trace.clear();
-	ScaleResult s = ScaleForSettings(settings);
-
-	for(float segment = 0; segment < 360; segment += 2) {
-
-		glm::vec3 begin(s.orbit_radius*cos(glm::radians(segment)), 0.0 , s.orbit_radius*sin(glm::radians(segment)));
-		glm::vec3 end(s.orbit_radius*cos(glm::radians(segment + 1.0f)), 0.0 , s.orbit_radius*sin(glm::radians(segment + 1.0f)));
-		orbit_trace.push_back(begin);
-		orbit_trace.push_back(end);
-	}
-
-	if(!orbit_trace_vbo) {
-		glGenBuffers(1, &orbit_trace_vbo);
-	}
-
-	glBindBuffer(GL_ARRAY_BUFFER, orbit_trace_vbo);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(glm::vec3) * orbit_trace.size(), &orbit_trace[0], GL_STATIC_DRAW);
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-	for(auto& m : moons) {
-		m.GenerateOrbitTrace(settings);
-	}
-}
-
-void Planet::RenderPath(GLint shaderMdlmx) {
-
-	glm::mat4 trans = parentmx * orbittiltmx;
+glm::dvec3 Planet::getPos() {
 
-	glBindBuffer(GL_ARRAY_BUFFER, orbit_trace_vbo);
-	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), 0);
-	glUniformMatrix4fv(shaderMdlmx, 1, GL_FALSE, glm::value_ptr(trans));
-	glDrawArrays(GL_LINES, 0, 360);
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-	glDisableVertexAttribArray(0);
+	if(name == "Sun") return glm::dvec3(1.0);
 
-	for(auto& m : moons) {
-		m.RenderPath(shaderMdlmx);
-	}
+	// behind the planet looking back at its parent, a little above the orbit plane
+	glm::dvec3 pos = orbits->Position(body);
+	glm::dvec3 out = glm::normalize(pos - orbits->ParentPosition(body));
+	glm::vec3 up = glm::vec3(orbittiltmx * glm::vec4(0.0f, scaled_diameter, 0.0f, 0.0f));
+	return pos + 3.0 * scaled_diameter * out + glm::dvec3(up);
 }
 
 void Planet::Render(const MatLocs& matlocs, const ss_settings& settings) {
 
+	// model matrices come from the graph, only the normal rotations are built here
+	glm::mat4 spinmx = glm::rotate(glm::mat4(1.0f), orbits->Spin(body), glm::vec3(0.0, 1.0, 0.0));
+
 	for(auto& r : rings) {
 
 		glm::mat4 tilt = glm::rotate(glm::mat4(1.0f), glm::radians(r.tilt), glm::vec3(1.0f, 0.0f, 1.0f));
-		glm::mat4 modelmx = parentmx * orbittiltmx * translatemx * tilt * scalemx;
+		glm::mat4 modelmx = graph->World(r.node);
 
 		glUniform1f(matlocs.ambient, 0.2f);
 		glUniformMatrix4fv(matlocs.model, 1, GL_FALSE, glm::value_ptr(modelmx));
 		glUniformMatrix4fv(matlocs.rotate, 1, GL_FALSE, glm::value_ptr(orbittiltmx * tilt));
 
-		r.scene.Render();
+		r.scene.Render(modelmx);
 	}
 
 	for(auto& m : moons) {
@@ -229,10 +186,11 @@ void Planet::Render(const MatLocs& matlocs, const ss_settings& settings) {
 		glUniform1f(matlocs.ambient, 1.0f);
 	else
 		glUniform1f(matlocs.ambient, 0.2f);
-	glUniformMatrix4fv(matlocs.rotate, 1, GL_FALSE, glm::value_ptr(orbittiltmx * rotatemx * tiltmx));
-	glUniformMatrix4fv(matlocs.model, 1, GL_FALSE, glm::value_ptr(getModel()));
+	glUniformMatrix4fv(matlocs.rotate, 1, GL_FALSE, glm::value_ptr(orbittiltmx * spinmx * tiltmx));
+	glm::mat4 modelmx = graph->World(body_node);
+	glUniformMatrix4fv(matlocs.model, 1, GL_FALSE, glm::value_ptr(modelmx));
 
-	scene.Render();
+	scene.Render(modelmx);
 }
 
 Planet::ScaleResult Planet::ScaleForSettings(const ss_settings& settings) {
@@ -254,33 +212,66 @@ Planet::ScaleResult Planet::ScaleForSettings(const ss_settings& settings) {
 	return s;
 }
 
-void Planet::Update(unsigned int dT, const ss_settings& settings, glm::mat4 translation) {
+void Planet::AddToOrbits(Orbits& table, int parent) {
 
-	UpdateAngles(dT, settings);
+	orbits = &table;
+	body = table.Add(parent);
 
-	ScaleResult s = ScaleForSettings(settings);
+	// the angles advance by a radian per period, the same rate the planets have always moved at
+	table.SetMotion(body, orbital_period ? 1.0f / orbital_period : 0.0f, current_orbit_angle,
+	                rotation_period ? 1.0f / rotation_period : 0.0f, current_rotate_angle);
+
+	for(auto& m : moons) {
+		m.AddToOrbits(table, body);
+	}
+}
 
-	parentmx = translation;
-  	scalemx = glm::scale(glm::mat4(1.0f), glm::vec3(s.scaled_diameter));
-  	rotatemx = glm::rotate(glm::mat4(1.0f), current_rotate_angle, glm::vec3(0.0, 1.0, 0.0));
-  	tiltmx = glm::rotate(glm::mat4(1.0f), glm::radians(inclination_equator), glm::vec3(1.0, 0.0, 1.0));
+void Planet::AddToGraph(SceneGraph& g) {
+
+	graph = &g;
+	frame_node = g.Add();
+	body_node = g.Add(frame_node);
+	for(auto& r : rings) {
+		r.node = g.Add(frame_node);
+	}
+
+	// moons are placed from the orbit table like everything else, not under their planet
+	for(auto& m : moons) {
+		m.AddToGraph(g);
+	}
+}
 
-  	glm::vec3 pos = glm::vec3(s.orbit_radius*cos(current_orbit_angle), 0.0 , s.orbit_radius*sin(current_orbit_angle));
-	translatemx = glm::translate(glm::mat4(1.0f), pos);
+void Planet::Place(const glm::dvec3& origin) {
 
-  	orbittiltmx = glm::rotate(glm::mat4(1.0f), glm::radians(s.scaled_inclination_orbit), glm::vec3(1.0, 0.0, 1.0));
+	graph->SetTranslation(frame_node, glm::vec3(orbits->Position(body) - origin));
 
-	pos_for_tracking = pos + (3.0f * s.scaled_diameter * glm::normalize(pos)) + glm::vec3(0, s.scaled_diameter, 0);
-	pos_for_tracking = glm::vec3(orbittiltmx * glm::vec4(pos_for_tracking, 1.0f));
+	glm::quat tilt = glm::quat_cast(glm::mat3(tiltmx));
+	graph->SetRotation(body_node, glm::angleAxis(orbits->Spin(body), glm::vec3(0.0f, 1.0f, 0.0f)) * tilt);
 
 	for(auto& m : moons) {
-		m.Update(dT, settings, orbittiltmx * translatemx);
+		m.Place(origin);
 	}
 }
 
-void Planet::UpdateAngles(unsigned int dT, const ss_settings& settings) {
+void Planet::SetupOrbit(const ss_settings& settings, const glm::mat4& parent_tilt) {
+
+	ScaleResult s = ScaleForSettings(settings);
+
+	scaled_diameter = s.scaled_diameter;
+	tiltmx = glm::rotate(glm::mat4(1.0f), glm::radians(inclination_equator), glm::vec3(1.0, 0.0, 1.0));
+
+	// moons orbit in their parent's tilted plane
+	orbittiltmx = parent_tilt * glm::rotate(glm::mat4(1.0f), glm::radians(s.scaled_inclination_orbit), glm::vec3(1.0, 0.0, 1.0));
+	orbits->SetOrbit(body, s.orbit_radius, orbital_eccentricity, glm::mat3(orbittiltmx));
 
-	float multiplier      = (settings.do_time_scale ? settings.time_scale : SEC_TO_EARTH_DAYS(1.0f));
-	current_orbit_angle  += (float)dT / 1000.0f * multiplier * (orbital_period ? 1.0f / orbital_period : 0);
-	current_rotate_angle += (float)dT / 1000.0f * multiplier * (rotation_period ? 1.0f / rotation_period : 0);
+	graph->SetRotation(frame_node, glm::quat_cast(glm::mat3(orbittiltmx)));
+	graph->SetScale(body_node, glm::vec3(s.scaled_diameter));
+	for(auto& r : rings) {
+		glm::quat tilt = glm::angleAxis(glm::radians(r.tilt), glm::normalize(glm::vec3(1.0f, 0.0f, 1.0f)));
+		graph->SetLocal(r.node, glm::vec3(0.0f), tilt, glm::vec3(s.scaled_diameter));
+	}
+
+	for(auto& m : moons) {
+		m.SetupOrbit(settings, orbittiltmx);
+	}
 }
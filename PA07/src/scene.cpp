@@ -1,151 +1,230 @@
 
 #include "scene.h"
+#include "glstate.h"
+#include "cookedmodel.h"
+#include "assetcache.h"
+#include "benchmark.h"
+#include "meshsimplifier.h"
 
-#include <assimp/Importer.hpp> 		//includes the importer, which is used to read our obj file
-#include <assimp/scene.h> 			//includes the aiScene object
-#include <assimp/postprocess.h> 	//includes the postprocessing variables for the importer
-#include <assimp/color4.h> 			//includes the aiColor4 object, which is used to handle the colors from the Scene objects
 #include <stb_image.h>
 
-Scene::Scene() {
-	mesh.VBO = mesh.IBO = texture.handle = 0;
-}
+bool Scene::use_lods = true;
+float Scene::lod_pixel_error = 1.0f;
+unsigned int Scene::triangles = 0;
+unsigned int Scene::full_triangles = 0;
+unsigned int Scene::last_triangles = 0;
+unsigned int Scene::last_full_triangles = 0;
+glm::vec3 Scene::eye;
+float Scene::proj_scale = 1.0f;
+
+// triangle count of each LOD after the first, relative to the full mesh
+static const float LOD_RATIOS[] = {0.5f, 0.25f, 0.1f, 0.03f};
+
+Scene::Scene() {}
 
 Scene::~Scene() {}
 
+Scene::Mesh::Mesh() {
+	VAO = VBO = IBO = 0;
+	radius = 0.0f;
+}
+
+Scene::Mesh::~Mesh() {
+	if(VAO) GLState::DeleteVertexArray(VAO);
+	if(VBO) glDeleteBuffers(1, &VBO);
+	if(IBO) glDeleteBuffers(1, &IBO);
+}
+
+Scene::Texture::Texture() {
+	handle = 0;
+	bytes = 0;
+}
+
+Scene::Texture::~Texture() {
+	if(handle) GLState::DeleteTexture(handle);
+}
+
 void Scene::DeleteMesh() {
-	mesh.vertices.clear();
-	mesh.indices.clear();
-	if(mesh.VBO) {
-		glDeleteBuffers(1, &mesh.VBO);
-		mesh.VBO = 0;
-	}
-	if(mesh.IBO) {
-		glDeleteBuffers(1, &mesh.IBO);
-		mesh.IBO = 0;
-	}
+	mesh.reset();
 }
 
 void Scene::DeleteTexture() {
-	if(texture.handle) {
-		glDeleteTextures(1, &texture.handle);
-		texture.handle = 0;
-	}
+	texture.reset();
 }
 
 bool Scene::LoadModel(std::string file) {
 
-	std::string dir = file.substr(0, file.find_last_of("\\/") + 1);
+	mesh = AssetCache::GetMesh(file, 0);
+	return mesh != nullptr;
+}
+
+bool Scene::LoadTexture(std::string file) {
+
+	texture = AssetCache::GetTexture(file);
+	return texture != nullptr;
+}
 
-	DeleteMesh();
+bool Scene::ReadMesh(const std::string& file, int idx, Mesh& mesh) {
 
-	Assimp::Importer import;
+	CookedModel model;
+	if(!model.Load(file)) {
+		return false;
+	}
 
-	// load file
-	const aiScene* scene = import.ReadFile(file.c_str(), aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_JoinIdenticalVertices | aiProcess_FlipUVs);
-	if(!scene) {
-		std::cerr << "Error reading file " << file << ": " << import.GetErrorString() << std::endl;
+	if(idx < 0 || (unsigned int)idx >= model.meshes.size()) {
+		std::cerr << "No mesh " << idx << " in " << file << std::endl;
 		return false;
 	}
 
-	const aiVector3D zeroVec(0.0f, 0.0f, 0.0f);
+	// load requested mesh
+	const CookedModel::SubMesh& sub = model.meshes[idx];
 
-	// load first mesh
-	unsigned int mesh_idx = 0;
-	const aiMesh* aiM = scene->mMeshes[mesh_idx];
+	// cooked data is already laid out as Vertex / index arrays
+	mesh.vertices.assign(sub.vertices, sub.vertices + sub.num_vertices);
+	mesh.indices.assign(sub.indices, sub.indices + sub.num_indices);
 
-	// for each vertex in the mesh
-	for(unsigned int vert_idx = 0; vert_idx < aiM->mNumVertices; vert_idx++) {
-		const aiVector3D* pos = &aiM->mVertices[vert_idx];
-		const aiVector3D* norm = &aiM->mNormals[vert_idx];
-		const aiVector3D* texcoord = aiM->HasTextureCoords(0) ? &aiM->mTextureCoords[0][vert_idx] : &zeroVec;
+	GenerateLods(mesh);
 
-		// translate vetex data
-		Vertex vert;
-		vert.pos = glm::vec3(pos->x, pos->y, pos->z);
-		vert.normal = glm::vec3(norm->x, norm->y, norm->z);
-		vert.texcoord = glm::vec2(texcoord->x, texcoord->y);
+	return true;
+}
+
+void Scene::GenerateLods(Mesh& mesh) {
 
-		mesh.vertices.push_back(vert);
+	glm::vec3 lo = mesh.vertices.size() ? mesh.vertices[0].pos : glm::vec3(0.0f), hi = lo;
+	for(auto& v : mesh.vertices) {
+		lo = glm::min(lo, v.pos);
+		hi = glm::max(hi, v.pos);
+	}
+	mesh.center = (lo + hi) * 0.5f;
+	mesh.radius = 0.0f;
+	for(auto& v : mesh.vertices) {
+		mesh.radius = std::max(mesh.radius, glm::length(v.pos - mesh.center));
 	}
 
-	// for each face in the mesh
-	for(unsigned int face_idx = 0; face_idx < aiM->mNumFaces; face_idx++) {
-		const aiFace* face = &aiM->mFaces[face_idx];
+	Mesh::Lod full = {0, (GLsizei)mesh.indices.size(), 0.0f};
+	mesh.lods.assign(1, full);
 
-		// collect face indicies
-		for(unsigned int idx = 0; idx < 3; idx++) {
-			mesh.indices.push_back(face->mIndices[idx]);
-		}
+	size_t full_tris = mesh.indices.size() / 3;
+	if(full_tris < LOD_MIN_TRIANGLES) return;
+
+	// each LOD is simplified from the one before, so the errors add up
+	std::vector<unsigned int> prev(mesh.indices), lod;
+	float error = 0.0f;
+
+	for(float ratio : LOD_RATIOS) {
+
+		error += MeshSimplifier::Simplify(mesh.vertices, prev, (size_t)(full_tris * ratio) * 3, lod);
+
+		// stuck on borders / flips, more levels would just be copies
+		if(lod.size() > prev.size() * 9 / 10) break;
+
+		Mesh::Lod l = {(unsigned int)mesh.indices.size(), (GLsizei)lod.size(), error};
+		mesh.lods.push_back(l);
+		mesh.indices.insert(mesh.indices.end(), lod.begin(), lod.end());
+
+		prev.swap(lod);
 	}
+}
+
+void Scene::UploadMesh(Mesh& mesh) {
 
 	// send vertex / index information to GPU
+	glGenVertexArrays(1, &mesh.VAO);
 	glGenBuffers(1, &mesh.VBO);
 	glGenBuffers(1, &mesh.IBO);
 
+	// the element buffer binding and attribute pointers are captured by the VAO
+	GLState::BindVertexArray(mesh.VAO);
 	glBindBuffer(GL_ARRAY_BUFFER, mesh.VBO);
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.IBO);
 
 	glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex) * mesh.vertices.size(), &mesh.vertices[0], GL_STATIC_DRAW);
 	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int) * mesh.indices.size(), &mesh.indices[0], GL_STATIC_DRAW);
 
+	glEnableVertexAttribArray(0);
+	glEnableVertexAttribArray(1);
+	glEnableVertexAttribArray(2);
+
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), 0);
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex,normal));
+	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex,texcoord));
+
+	GLState::BindVertexArray(0);
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+}
 
-	return true;
+Scene::Image::Image() {
+	w = h = 0;
+	pixels = nullptr;
 }
 
-bool Scene::LoadTexture(std::string file) {
+Scene::Image::~Image() {
+	// free image loaded from file
+	if(pixels) stbi_image_free(pixels);
+}
 
-	DeleteTexture();
+bool Scene::ReadTexture(const std::string& file, Image& image) {
 
-	int w, h;
-	unsigned char* bitmap = stbi_load(file.c_str(), &w, &h, nullptr, 4);
-	if(!bitmap) {
+	image.pixels = stbi_load(file.c_str(), &image.w, &image.h, nullptr, 4);
+	if(!image.pixels) {
 		std::cerr << "Failed to load texture from " << file.c_str() << std::endl;
 		return false;
 	}
 
+	return true;
+}
+
+void Scene::UploadTexture(Texture& texture, const Image& image) {
+
 	// Set up OpenGL texture
 	glGenTextures(1, &texture.handle);
-	glBindTexture(GL_TEXTURE_2D, texture.handle);
+	GLState::BindTexture(GL_TEXTURE_2D, texture.handle);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, bitmap);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, image.w, image.h, 0, GL_RGBA, GL_UNSIGNED_BYTE, image.pixels);
 	glGenerateMipmap(GL_TEXTURE_2D);
-	glBindTexture(GL_TEXTURE_2D, 0);
 
-	// free image loaded from file
-	stbi_image_free(bitmap);
+	// RGBA8 base level plus a third again for the mip chain
+	texture.bytes = (size_t)image.w * image.h * 4 * 4 / 3;
+}
 
-	return true;
+void Scene::SetView(const glm::mat4& view, const glm::mat4& proj, int screen_height) {
+
+	eye = glm::vec3(glm::inverse(view)[3]);
+	proj_scale = proj[1][1] * screen_height / 2.0f;
+
+	last_triangles = triangles;
+	last_full_triangles = full_triangles;
+	triangles = full_triangles = 0;
 }
 
-void Scene::Render() {
+void Scene::Render(const glm::mat4& modelmx) {
 
-	glEnableVertexAttribArray(0);
-	glEnableVertexAttribArray(1);
-	glEnableVertexAttribArray(2);
+	if(!mesh || mesh->lods.empty()) return;
 
-	glBindBuffer(GL_ARRAY_BUFFER, mesh.VBO);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.IBO);
+	// the coarsest LOD whose error still projects to less than lod_pixel_error
+	const Mesh::Lod* lod = &mesh->lods[0];
+	if(use_lods && mesh->lods.size() > 1) {
 
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, texture.handle);
+		// errors and radius are in model units, scale them by the largest axis of modelmx
+		float scale = std::max(glm::length(glm::vec3(modelmx[0])), std::max(glm::length(glm::vec3(modelmx[1])), glm::length(glm::vec3(modelmx[2]))));
+		glm::vec3 center = glm::vec3(modelmx * glm::vec4(mesh->center, 1.0f));
+		float distance = std::max(glm::length(center - eye) - mesh->radius * scale, 1e-6f);
 
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), 0);
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex,normal));
-	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex,texcoord));
+		for(auto& l : mesh->lods) {
+			if(l.error * scale * proj_scale / distance <= lod_pixel_error) lod = &l;
+		}
+	}
 
-	glDrawElements(GL_TRIANGLES, mesh.indices.size(), GL_UNSIGNED_INT, 0);
+	GLState::BindVertexArray(mesh->VAO);
+	GLState::BindTexture(GL_TEXTURE_2D, texture ? (texture->handle ? texture->handle : AssetLoader::placeholder) : 0);
 
-	glBindTexture(GL_TEXTURE_2D, 0);
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	glDrawElements(GL_TRIANGLES, lod->count, GL_UNSIGNED_INT, (void*)(lod->first * sizeof(unsigned int)));
+	Benchmark::draw_calls++;
+	Benchmark::triangles += lod->count / 3;
 
-	glDisableVertexAttribArray(0);
-	glDisableVertexAttribArray(1);
-	glDisableVertexAttribArray(2);
+	triangles += lod->count / 3;
+	full_triangles += mesh->lods[0].count / 3;
 }
@@ -1,8 +1,13 @@
 
 #include "solarsystem.h"
 #include "graphics.h"
+#include "assetloader.h"
+#include "benchmark.h"
+#include "glstate.h"
 #include <dirent.h>
 #include <fstream>
+#include <random>
+#include <functional>
 #include <sys/stat.h>
 #include <imgui.h>
 
@@ -21,6 +26,11 @@ SolarSystem::~SolarSystem() {
 		p.DeleteScene();
 	}
 	planets.clear();
+
+	if(asteroid_vao) {
+		GLState::DeleteVertexArray(asteroid_vao);
+		glDeleteBuffers(1, &asteroid_vbo);
+	}
 }
 
 bool SolarSystem::LoadPlanets(std::string dir) {
@@ -39,25 +49,50 @@ bool SolarSystem::LoadPlanets(std::string dir) {
 		return false;
 	}
 
+	std::vector<std::string> files;
 	while((entry = readdir(directory))) {
 		std::string entryName = entry->d_name;
 
 		if(entryName != ".." && entryName != "." && isRegularFile(dirPath + entryName)) {
+			files.push_back(entryName);
+		}
+	}
+
+	closedir(directory);
 
-			std::string contents;
-			std::ifstream fin(dirPath + entryName);
-			getline(fin, contents, '\0');
+	// read and parse every definition in parallel
+	std::vector<Planet> loaded(files.size());
+	std::vector<char> ok(files.size(), 0);
 
-			Planet p;
-			if(p.LoadJSON(contents)) {
-				p.LoadScene();
-				planets.push_back(p);
+	AssetLoader::ParallelFor(files.size(), [&](unsigned int i) {
 
-				std::cout << "Loaded planet from " << dirPath << entryName << std::endl;
-			}
+		std::string contents;
+		std::ifstream fin(dirPath + files[i]);
+		getline(fin, contents, '\0');
+
+		ok[i] = loaded[i].LoadJSON(contents);
+	});
+
+	// models and textures load in the background, the planets appear as they arrive
+	for(unsigned int i = 0; i < files.size(); i++) {
+		if(ok[i]) {
+			loaded[i].LoadScene();
+			planets.push_back(loaded[i]);
+
+			std::cout << "Loaded planet from " << dirPath << files[i] << std::endl;
 		}
 	}
 
+	// planets and moons move as one flat table from here on
+	orbits.Clear();
+	graph.Clear();
+	for(auto& p : planets) {
+		p.AddToOrbits(orbits);
+		p.AddToGraph(graph);
+	}
+	SetupOrbits();
+	SetupBelt();
+
 	return true;
 }
 
@@ -71,8 +106,121 @@ float SolarSystem::GetCameraScale() {
 
 void SolarSystem::Update(unsigned int dT) {
 
+	float multiplier = (settings.do_time_scale ? settings.time_scale : SEC_TO_EARTH_DAYS(1.0f));
+	float days = (float)dT / 1000.0f * multiplier;
+
+	// spins still come from the orbit table
+	orbits.Update(days);
+	belt.Update(days);
+
+	if(!settings.do_gravity || !nbody.Size()) return;
+
+	last_steps = std::min((int)ceilf(days / settings.max_step), settings.max_steps);
+	float step = std::min(days / std::max(last_steps, 1u), settings.max_step);
+
+	last_build_ms = last_force_ms = last_integrate_ms = 0.0;
+	for(unsigned int s = 0; s < last_steps; s++) {
+		nbody.Step(step);
+		last_build_ms += nbody.build_ms;
+		last_force_ms += nbody.force_ms;
+		last_integrate_ms += nbody.integrate_ms;
+	}
+
+	for(unsigned int i = 0; i < orbits.Size(); i++) {
+		orbits.SetPosition(i, glm::dvec3(nbody.Position(i)));
+	}
+}
+
+void SolarSystem::StartGravity() {
+
+	unsigned int n = orbits.Size();
+
+	// the mass at the centre of each family of orbits (indexed by parent + 1) is the
+		// geometric mean of what each orbit says it should be - with compressed distances
+		// the planets don't agree, and their periods change once gravity takes over
+	std::vector<double> log_gm(n + 1, 0.0);
+	std::vector<unsigned int> orbiting(n + 1, 0);
+	for(unsigned int i = 0; i < n; i++) {
+		if(orbits.GM(i) > 0.0f) {
+			log_gm[orbits.Parent(i) + 1] += log(orbits.GM(i));
+			orbiting[orbits.Parent(i) + 1]++;
+		}
+	}
+
+	std::vector<float> central(n + 1, 0.0f);
+	for(unsigned int i = 0; i <= n; i++) {
+		if(orbiting[i]) central[i] = exp(log_gm[i] / orbiting[i]);
+	}
+	float sun_gm = central[0];
+
+	// everything else weighs what a ball of its diameter would at earth's density (earth / sun = 3e-6)
+	std::vector<float> mass(n, 0.0f);
+	std::function<void(const Planet&)> weigh = [&](const Planet& p) {
+
+		mass[p.body] = sun_gm * 3e-6f * p.diameter * p.diameter * p.diameter;
+		if(central[p.body + 1] > 0.0f) mass[p.body] = central[p.body + 1];
+
+		for(auto& m : p.moons) weigh(m);
+	};
+	for(auto& p : planets) weigh(p);
+
+	// the top level orbits are around the origin, the sun is whatever sits still there
+	bool sun_found = false;
+	for(unsigned int i = 0; i < n; i++) {
+		if(orbits.Parent(i) < 0 && orbits.GM(i) == 0.0f && glm::length(orbits.Position(i)) == 0.0) {
+			mass[i] = sun_gm;
+			sun_found = true;
+			break;
+		}
+	}
+
+	// same orbit shapes, speeds scaled to the masses they now move around
+	nbody.Clear();
+	std::vector<glm::vec3> velocity(n, glm::vec3(0.0f));
+	for(unsigned int i = 0; i < n; i++) {
+
+		int p = orbits.Parent(i);
+		if(p >= 0) velocity[i] = velocity[p];
+		if(orbits.GM(i) > 0.0f) velocity[i] += orbits.Velocity(i) * sqrtf(central[p + 1] / orbits.GM(i));
+
+		nbody.Add(glm::vec3(orbits.Position(i)), velocity[i], mass[i]);
+	}
+	if(!sun_found && sun_gm > 0.0f) {
+		nbody.Add(glm::vec3(0.0f), glm::vec3(0.0f), sun_gm);
+	}
+
+	// the belt between mars and jupiter, on circular orbits around the sun
+	first_asteroid = nbody.Size();
+
+	float inner = 0.0f, outer = 0.0f;
 	for(auto& p : planets) {
-		p.Update(dT, settings);
+		if(p.name == "Mars") inner = (float)glm::length(orbits.Position(p.body)) * 1.1f;
+		if(p.name == "Jupiter") outer = (float)glm::length(orbits.Position(p.body)) * 0.8f;
+	}
+
+	if(inner > 0.0f && outer > inner && sun_gm > 0.0f) {
+
+		std::mt19937 rng(1);
+		std::uniform_real_distribution<float> radius(inner, outer), angle(0.0f, 6.28318531f), height(-0.02f, 0.02f);
+
+		for(int a = 0; a < settings.asteroids; a++) {
+
+			float r = radius(rng), t = angle(rng);
+			glm::vec3 pos(r * cosf(t), r * height(rng), r * sinf(t));
+			glm::vec3 vel = glm::vec3(-sinf(t), 0.0f, cosf(t)) * sqrtf(sun_gm / r);
+			nbody.Add(pos, vel, sun_gm * 1e-12f);
+		}
+	}
+
+	if(!asteroid_vao) {
+		glGenVertexArrays(1, &asteroid_vao);
+		glGenBuffers(1, &asteroid_vbo);
+
+		GLState::BindVertexArray(asteroid_vao);
+		glBindBuffer(GL_ARRAY_BUFFER, asteroid_vbo);
+		glEnableVertexAttribArray(0);
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), 0);
+		GLState::BindVertexArray(0);
 	}
 }
 
@@ -80,29 +228,75 @@ Planet* SolarSystem::GetTrackedPlanet() {
 	return &planets[settings.track_planet_idx];
 }
 
-void SolarSystem::RenderPaths(GLint shader_MdlMx) {
+void SolarSystem::RenderPaths(float proj_scale, const glm::dvec3& origin) {
 
 	if(settings.do_orbit_path) {
-		for(auto& p : planets) {
-			p.RenderPath(shader_MdlMx);
+		paths.Render(orbits, origin, proj_scale);
+	}
+}
+
+void SolarSystem::RenderAsteroids(GLint shader_MdlMx, const glm::dvec3& origin) {
+
+	// asteroids are single pixels, drawn with the path shader
+	unsigned int count = nbody.Size() - first_asteroid;
+	if(settings.do_gravity && count) {
+
+		std::vector<glm::vec3> points(count);
+		for(unsigned int i = 0; i < count; i++) {
+			points[i] = glm::vec3(glm::dvec3(nbody.Position(first_asteroid + i)) - origin);
 		}
+
+		glBindBuffer(GL_ARRAY_BUFFER, asteroid_vbo);
+		glBufferData(GL_ARRAY_BUFFER, sizeof(glm::vec3) * count, points.data(), GL_STREAM_DRAW);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+		GLState::BindVertexArray(asteroid_vao);
+		glUniformMatrix4fv(shader_MdlMx, 1, GL_FALSE, glm::value_ptr(glm::mat4(1.0f)));
+		glDrawArrays(GL_POINTS, 0, count);
+		Benchmark::draw_calls++;
 	}
 }
 
-void SolarSystem::GenPaths() {
+void SolarSystem::SetupOrbits() {
 
 	for(auto& p : planets) {
-		p.GenerateOrbitTrace(settings);
+		p.SetupOrbit(settings);
 	}
+	// positions on the new orbits, without moving anything along them
+	orbits.Update(0.0f);
+}
+
+void SolarSystem::SetupBelt() {
+
+	Planet *mars = nullptr, *jupiter = nullptr;
+	for(auto& p : planets) {
+		if(p.name == "Mars") mars = &p;
+		if(p.name == "Jupiter") jupiter = &p;
+	}
+	if(!mars || !jupiter) return;
+
+	// the middle half of the gap, moving at the speeds mars' orbit implies
+	float inner = mars->ScaleForSettings(settings).orbit_radius, outer = jupiter->ScaleForSettings(settings).orbit_radius;
+	float gap = outer - inner;
+	belt.Generate(settings.belt_rocks, inner + 0.25f * gap, outer - 0.25f * gap, orbits.GM(mars->body));
 }
 
 void SolarSystem::Render(const MatLocs& matlocs) {
 
+	for(auto& p : planets) {
+		p.Place(matlocs.origin);
+	}
+	graph.Update(AssetLoader::ParallelFor);
+
 	for(auto& p : planets) {
 		p.Render(matlocs, settings);
 	}
 }
 
+void SolarSystem::RenderBelt(const glm::mat4& view_proj, const glm::dvec3& origin) {
+	belt.Render(view_proj, origin);
+}
+
 void SolarSystem::UI(bool track) {
 	if(track) {
 		std::vector<const char*> names;
@@ -114,18 +308,49 @@ void SolarSystem::UI(bool track) {
 	}
 
 	ImGui::Checkbox("Draw Orbit Paths", &settings.do_orbit_path);
+	if(settings.do_orbit_path) {
+		ImGui::SliderFloat("Path error (px)", &paths.pixel_error, 0.1f, 4.0f);
+		ImGui::Text("%u orbit path segments", paths.last_segments);
+	}
 
 	ImGui::Separator();
 	ImGui::Text("Simulation");
 	ImGui::SliderFloat("Time Scale", &settings.time_scale, 0.0f, 2500.0f);
 	ImGui::Checkbox("Use Time Scale", &settings.do_time_scale);
 	
-	bool traces_changed = false;
-	traces_changed = traces_changed || ImGui::SliderFloat("Distance Scale", &settings.distance_scale, 0.001f, 0.05f);
-	traces_changed = traces_changed || ImGui::SliderFloat("Diameter Scale", &settings.diameter_scale, 1.0f, 100.0f);
-	traces_changed = traces_changed || ImGui::Checkbox("Use Distance Scales", &settings.do_distance_scale);
+	bool scales_changed = false;
+	scales_changed = scales_changed || ImGui::SliderFloat("Distance Scale", &settings.distance_scale, 0.001f, 0.05f);
+	scales_changed = scales_changed || ImGui::SliderFloat("Diameter Scale", &settings.diameter_scale, 1.0f, 100.0f);
+	scales_changed = scales_changed || ImGui::Checkbox("Use Distance Scales", &settings.do_distance_scale);
+
+	if(scales_changed) {
+		SetupOrbits();
+		SetupBelt();
+	}
+
+	ImGui::Separator();
+	ImGui::Text("Asteroid Belt");
+	if(ImGui::SliderInt("Rocks", &settings.belt_rocks, 0, 1000000)) {
+		SetupBelt();
+	}
+	ImGui::Checkbox("Frustum Culling", &belt.culling);
+	ImGui::Text("%u of %u rocks drawn, %.2f ms moving / culling", belt.last_visible, belt.Size(), belt.last_cull_ms);
+
+	ImGui::Separator();
+	ImGui::Text("Gravity");
+	bool restart = ImGui::Checkbox("Simulate Gravity", &settings.do_gravity);
+	restart = ImGui::SliderInt("Asteroids", &settings.asteroids, 0, 100000) || restart;
+	ImGui::SliderFloat("Opening Angle", &nbody.theta, 0.2f, 1.5f);
+	ImGui::SliderFloat("Max Step (days)", &settings.max_step, 0.005f, 0.5f);
+	ImGui::SliderInt("Max Steps / Frame", &settings.max_steps, 1, 32);
+
+	// settings changes start again from the fixed orbits
+	if(settings.do_gravity && (restart || scales_changed)) {
+		StartGravity();
+	}
 
-	if(traces_changed) {
-		GenPaths();
+	if(settings.do_gravity) {
+		ImGui::Text("%u bodies, %u steps", nbody.Size(), last_steps);
+		ImGui::Text("Tree %.2f ms, forces %.2f ms, integrate %.2f ms", last_build_ms, last_force_ms, last_integrate_ms);
 	}
 }
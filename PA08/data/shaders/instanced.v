@@ -0,0 +1,24 @@
+
+#version 330
+
+layout (location = 0) in vec3 v_pos;
+layout (location = 1) in vec3 v_norm;
+layout (location = 2) in vec2 v_texcood;
+
+// per-instance model matrix
+layout (location = 3) in mat4 i_model;
+
+smooth out vec2 f_texcoord;
+smooth out vec3 f_norm;
+smooth out vec3 f_pos;
+
+uniform mat4 view, proj;
+
+void main() {
+	vec4 pos = i_model * vec4(v_pos, 1.0);
+	gl_Position = proj * view * pos;
+	f_texcoord = v_texcood;
+	// the inverse transpose, since the floor is scaled unevenly and would tilt its normals otherwise
+	f_norm = normalize(transpose(inverse(mat3(i_model))) * v_norm);
+	f_pos = vec3(pos);
+}
@@ -0,0 +1,45 @@
+#ifndef BVHCACHE_H
+#define BVHCACHE_H
+
+#include <btBulletDynamicsCommon.h>
+#include <string>
+#include <map>
+
+#include "graphics_headers.h"
+
+// Static triangle mesh colliders, built straight on top of a render mesh's vertex
+// and index arrays through a btTriangleIndexVertexArray instead of copying every
+// triangle into a btTriangleMesh. Building the quantized BVH over the triangles is
+// the slow part, so it's serialized to a cache file the first time and read back
+// in place on every launch after that, as long as the triangles haven't changed.
+class BvhCache {
+public:
+	// collision shape over the triangles in vertices / indices, which have to outlive it
+		// uses the BVH in cache_file if it was built from the same triangles, otherwise builds one and writes it there
+		// nullptr if there are no triangles
+	static btBvhTriangleMeshShape* Load(const std::string& cache_file, const Vertex* vertices, unsigned int num_vertices,
+	                                    const unsigned int* indices, unsigned int num_indices);
+	// delete a shape made by Load, with its vertex array and BVH
+	static void Free(btCollisionShape* shape);
+
+	// print how many BVHs were read and built, how long that took, and the memory saved on triangles
+	static void Report();
+
+private:
+	struct Entry {
+		btTriangleIndexVertexArray* array;
+		// the BVH read from the cache lives in here, nullptr when the shape built and owns its own
+		void* buffer;
+	};
+	static std::map<btCollisionShape*, Entry> entries;
+
+	static bool Read(const std::string& cache_file, unsigned long long hash, unsigned int num_vertices, unsigned int num_indices, void*& buffer, unsigned int& size);
+	static bool Write(const std::string& cache_file, unsigned long long hash, unsigned int num_vertices, unsigned int num_indices, btOptimizedBvh* bvh);
+
+	static unsigned int loaded, built;
+	static double load_ms, build_ms;
+	// BVH memory, and what copying the triangles into btTriangleMeshes would have taken
+	static size_t bvh_bytes, shared_bytes;
+};
+
+#endif // BVHCACHE_H
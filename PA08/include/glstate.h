@@ -0,0 +1,39 @@
+#ifndef GLSTATE_H
+#define GLSTATE_H
+
+#include "graphics_headers.h"
+
+// Shadows the pieces of GL state the renderer changes per draw so redundant
+// binds and toggles never reach the driver. Everything that binds a program,
+// VAO, texture, or flips blend/depth state should go through here, otherwise
+// the cache goes stale - call Invalidate() after any code that bypasses it.
+class GLState {
+public:
+	static void UseProgram(GLuint program);
+	static void BindVertexArray(GLuint vao);
+	// binds on texture unit 0, which is the only unit the shaders sample from
+	static void BindTexture(GLenum target, GLuint texture);
+
+	// GL_BLEND, GL_DEPTH_TEST or GL_CULL_FACE
+	static void Enable(GLenum cap, bool enable);
+	static void DepthMask(bool write);
+	static void BlendFunc(GLenum src, GLenum dst);
+
+	// delete through the tracker so a recycled object name is never mistaken for a live binding
+	static void DeleteProgram(GLuint program);
+	static void DeleteVertexArray(GLuint vao);
+	static void DeleteTexture(GLuint texture);
+
+	// forget everything cached, the next request of each kind always reaches GL
+	static void Invalidate();
+
+	// start counting a new frame, keeping the previous frame's totals
+	static void ResetCounters();
+
+	// state changes issued / skipped so far this frame
+	static unsigned int changes, skipped;
+	// totals from the last complete frame
+	static unsigned int last_changes, last_skipped;
+};
+
+#endif // GLSTATE_H
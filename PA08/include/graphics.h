@@ -26,6 +26,8 @@ public:
 	void Update(unsigned int dt);
 	// setup rendering context for planets
 	UniformLocs BeginObjectRender(int w, int h);
+	// the same for drawing with Scene::RenderInstanced, model matrices come from the instances
+	UniformLocs BeginInstancedRender(int w, int h);
 	// render skybox
 	void RenderSkybox(int w, int h);
 	// clear window
@@ -53,9 +55,12 @@ private:
 	OrbitCamera 	orbit_camera;
 	FreeCamera  	free_camera;
 
+	// set up shader's camera and light uniforms
+	UniformLocs BeginRender(Shader* shader, int w, int h);
+
 	// Object rendering
-	GLuint object_VAO;
 	Shader *m_object_shader;
+	Shader *m_instanced_shader;
 };
 
 void debug_proc(GLenum glsource, GLenum gltype, GLuint id, GLenum severity, GLsizei length, const GLchar* glmessage, const void* up);
@@ -9,7 +9,8 @@ class Scene {
 public:
 	struct Mesh {
 
-		GLuint VBO, IBO;
+		// VAO holds the buffer bindings and attribute layout, configured once at load
+		GLuint VAO, VBO, IBO;
 
 		std::vector<Vertex> 		vertices;
 		std::vector<unsigned int> 	indices; 
@@ -22,6 +23,9 @@ public:
 
 	Scene();
 	~Scene();
+	// moved, never copied - a mesh collider points into the vertices and indices
+	Scene(Scene&&) = default;
+	Scene& operator=(Scene&&) = default;
 
 	// load model mesh from file - loads only first mesh
 	bool LoadModel(std::string file);
@@ -31,6 +35,8 @@ public:
 	// render the scene (model + texture)
 		// setup the model matrix BEFOREHAND
 	void Render();
+	// draw count copies at once, each with a model matrix read from buffer (locations 3 - 6)
+	void RenderInstanced(GLuint buffer, GLsizei count);
 	// free mesh asset
 	void DeleteMesh();
 	// free texture asset
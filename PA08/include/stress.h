@@ -0,0 +1,106 @@
+#ifndef STRESS_H
+#define STRESS_H
+
+#include <btBulletDynamicsCommon.h>
+#include <vector>
+#include <random>
+
+#include "graphics.h"
+#include "scene.h"
+
+// The standard load for profiling PA8: count bodies in one of a few patterns on a
+// walled floor, in place of the table. Every body of a kind shares one collision
+// shape and one mesh, and each kind is drawn with one instanced draw call, so
+// the numbers are about how physics and rendering scale with the body count
+// rather than about per object overhead.
+class Stress {
+public:
+	enum Pattern {
+		PYRAMIDS,
+		RAIN,
+		NUM_PATTERNS
+	};
+	static const char* pattern_names[NUM_PATTERNS];
+
+	// pattern from its name, false if there isn't one called name
+	static bool ParsePattern(const std::string& name, Pattern& pattern);
+
+	Stress();
+	~Stress();
+
+	// load the shared meshes, false if they can't be - leave it out for a run without a window
+	bool LoadMeshes();
+
+	// take out any bodies from before and add count in pattern to world
+		// pyramids are all there at once, rain keeps falling through the next few seconds of Update
+	void Spawn(btDiscreteDynamicsWorld* world, Pattern pattern, unsigned int count);
+	// the same pattern and count again, from the start
+	void Respawn(btDiscreteDynamicsWorld* world) { Spawn(world, pattern, count); }
+	// take every body and the floor out of world
+	void Clear(btDiscreteDynamicsWorld* world);
+
+	// drop the next of the rain, before the step
+	void Update(btDiscreteDynamicsWorld* world, unsigned int dT);
+	// write every body's transform into its kind's mapped instance buffer, split across the thread pool
+		// into instances instead when there are no meshes, and so no buffers
+	void Sync();
+	// one instanced draw per kind of what the last Sync wrote, with the shader from Graphics::BeginInstancedRender
+	void Render(UniformLocs uniforms);
+
+	// pattern, count and respawn controls
+	void UI(btDiscreteDynamicsWorld* world);
+
+	// half the width of the floor, for fitting the camera to it
+	float Extent() const { return half; }
+
+	// draw calls in the last Render
+	unsigned int draws = 0;
+
+private:
+	enum Kind {
+		BOX,
+		SPHERE,
+		NUM_KINDS
+	};
+
+	void AddFloor(btDiscreteDynamicsWorld* world);
+	void AddBody(btDiscreteDynamicsWorld* world, Kind kind, const btVector3& pos, const btVector3& velocity);
+
+	// shared by every body of a kind, and the floor
+	btCollisionShape* shapes[NUM_KINDS];
+	btCollisionShape* floor_shape = nullptr;
+	std::vector<btCollisionShape*> walls;
+	std::vector<btRigidBody*> statics;
+
+	struct Bodies {
+
+		std::vector<btRigidBody*> bodies;
+		std::vector<btDefaultMotionState*> states;
+		// model matrix of each, for a run without meshes - otherwise Sync writes them straight into buffer
+		std::vector<glm::mat4> instances;
+
+		Scene s;
+		GLuint buffer = 0;
+		size_t capacity = 0;
+		// instances the last Sync wrote, the floor included
+		unsigned int drawn = 0;
+	};
+	Bodies kinds[NUM_KINDS];
+	// the floor slab, drawn as one more box
+	glm::mat4 floor_model;
+
+	Pattern pattern = PYRAMIDS;
+	unsigned int count = 0;
+	float half = 0.0f;
+
+	// rain still to come, and how many fall per second
+	unsigned int pending = 0;
+	float rain_rate = 0.0f, rain_carry = 0.0f;
+	// the same rain every run
+	std::minstd_rand random;
+
+	// what the UI's controls hold until respawned
+	int ui_pattern = PYRAMIDS, ui_count = 0;
+};
+
+#endif // STRESS_H
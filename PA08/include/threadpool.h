@@ -0,0 +1,43 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <deque>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <functional>
+#include <condition_variable>
+
+// A fixed set of worker threads for splitting loops across cores - the physics
+// step's task scheduler and the transform sync both run on it. The calling
+// thread always takes part, so a pool of n threads has n - 1 workers.
+class ThreadPool {
+public:
+	// start threads - 1 workers, 0 for one per core
+	static void Start(unsigned int threads = 0);
+	// join the workers, anything queued is dropped
+	static void Stop();
+
+	// run fn(0) .. fn(count - 1) on up to Threads() threads, returns once all are done
+		// safe to call from inside fn, the caller just works through the rest itself
+	static void ParallelFor(unsigned int count, std::function<void(unsigned int)> fn);
+
+	// threads ParallelFor spreads over, the caller included
+	static unsigned int Threads();
+	// use only the first threads of the pool, to see how things scale
+	static void SetThreads(unsigned int threads);
+	// workers started + the caller
+	static unsigned int MaxThreads();
+
+private:
+	static void Worker();
+
+	static std::vector<std::thread> workers;
+	static std::deque<std::function<void()>> queued;
+	static std::mutex lock;
+	static std::condition_variable work_cv;
+	static bool stopping;
+	static unsigned int active;
+};
+
+#endif // THREADPOOL_H
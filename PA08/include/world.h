@@ -8,9 +8,16 @@
 #include <glm/glm.hpp>
 #include <glm/ext.hpp>
 #include <vector>
-#include <picojson.h>
 #include "graphics.h"
 #include "scene.h"
+#include "scenefile.h"
+#include "stress.h"
+
+#ifdef BULLET_MT
+#include <BulletDynamics/Dynamics/btDiscreteDynamicsWorldMt.h>
+#include <BulletDynamics/ConstraintSolver/btSequentialImpulseConstraintSolverMt.h>
+#include <BulletCollision/CollisionDispatch/btCollisionDispatcherMt.h>
+#endif
 
 enum class Shape {
 	none,
@@ -25,7 +32,6 @@ class Object {
 	// shape info
 	Shape shape = Shape::none;
 	btCollisionShape* btShape = nullptr;
-	btTriangleMesh* btMesh = nullptr;
 
 	// initial values
 	glm::vec3 box, position, velocity;
@@ -41,10 +47,11 @@ class Object {
 	// rendering
 	std::string name, model, texture;
 	Scene s;
-	glm::mat4 modelmx, rotmx;
 
-	bool LoadJSON(std::string json);
-	bool LoadJSONObj(const picojson::object& obj);
+	// false if the type isn't one there's a shape for
+	bool LoadFields(const SceneFile::Fields& fields);
+	// reads scene files with every key an object can have
+	static SceneFile& Reader();
 
 	bool Setup();
 	void Shutdown();
@@ -53,34 +60,76 @@ class Object {
 	friend class World;
 };
 
+// time spent in each part of the last physics step, in ms
+struct StepPhases {
+	// updating bounding boxes and finding the pairs that overlap
+	double broadphase = 0.0;
+	// contact points for each overlapping pair
+	double narrowphase = 0.0;
+	double solver = 0.0;
+	// moving the bodies, before and after the solve
+	double integrate = 0.0;
+};
+
 class World {
 public:
 	World();
 	~World();
 
+	// set up the bullet world, threaded across the thread pool when built with BULLET_MT
 	bool Initialize();
 	void Update(unsigned int dT);
 	void Render(UniformLocs uniforms);
 
-	bool LoadObjects(std::string directory);
-	bool LoadObject(std::string path);
-	void AddObject(const Object& o);
+	// load every object in a scene file, see SceneFile
+	bool LoadScene(std::string path);
+	// moves o in, its collider may point into its scene
+	void AddObject(Object&& o);
+
+	// count bodies in pattern on a floor of their own, with gravity straight down, see Stress
+		// meshes false for a run with no window to draw them in
+	bool StartStress(Stress::Pattern pattern, unsigned int count, bool meshes = true);
+	// draw the stress bodies, with the uniforms from Graphics::BeginInstancedRender
+	void RenderInstanced(UniformLocs uniforms);
+	// half the width of the stress floor, 0 without one
+	float StressExtent() const;
 
 	void Reset();
 	void NextSelected();
 
 	void UI();
 
+	// drop count bodies on a floor and time stepping them and syncing their transforms
+	// with 1, 2, 4 and 8 threads, then print them - needs the thread pool started
+		// a pile of spheres and cubes, or a Stress pattern
+	static void Benchmark(unsigned int count, unsigned int steps = 300, int pattern = -1);
+
 private:
+	// copy every body's transform into models / rotations, split across the thread pool
+	static void SyncTransforms(const std::vector<btDefaultMotionState*>& states, std::vector<glm::mat4>& models, std::vector<glm::mat4>& rotations);
 
 	btDiscreteDynamicsWorld* btWorld = nullptr;
 
 	btBroadphaseInterface* broadphase = nullptr;
 	btDefaultCollisionConfiguration* collisionConfiguration = nullptr;
 	btCollisionDispatcher* dispatcher = nullptr;
-	btSequentialImpulseConstraintSolver* solver = nullptr;
+	btConstraintSolver* solver = nullptr;
+#ifdef BULLET_MT
+	btConstraintSolverPoolMt* solverPool = nullptr;
+#endif
 
 	std::vector<Object> objects;
+	// stress bodies, nullptr until StartStress
+	Stress* stress = nullptr;
+
+	// by object, filled in by Update for rendering
+	std::vector<btDefaultMotionState*> states;
+	std::vector<glm::mat4> models, rotations;
+	// step_ms and phases are from the last frame that took a physics step
+	double step_ms = 0.0, sync_ms = 0.0;
+	StepPhases phases;
+	// what the world times the current step into
+	StepPhases stepping;
 	int selected = -1, ui_selected = 0;
 };
 
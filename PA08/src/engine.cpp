@@ -1,5 +1,10 @@
 
 #include "engine.h"
+#include "threadpool.h"
+#include "bvhcache.h"
+
+#include <cstdlib>
+#include <algorithm>
 
 Engine::Engine(string name, int width, int height) {
 
@@ -25,6 +30,8 @@ Engine::~Engine() {
 	m_window = nullptr;
 	m_graphics = nullptr;
 	m_world = nullptr;
+
+	ThreadPool::Stop();
 }
 
 bool Engine::Initialize(std::vector<std::string> args) {
@@ -43,15 +50,46 @@ bool Engine::Initialize(std::vector<std::string> args) {
 		return false;
 	}
 	
+	// one thread per core unless --threads says otherwise
+	unsigned int threads = 0;
+	// --stress N bodies in place of the table, in the --pattern given
+	int stress = -1;
+	Stress::Pattern pattern = Stress::PYRAMIDS;
+	for(unsigned int i = 0; i + 1 < args.size(); i++) {
+		if(args[i] == "--threads") {
+			threads = std::max(1, atoi(args[i + 1].c_str()));
+		}
+		if(args[i] == "--stress") {
+			stress = std::max(0, atoi(args[i + 1].c_str()));
+		}
+		if(args[i] == "--pattern" && !Stress::ParsePattern(args[i + 1], pattern)) {
+			std::cerr << "Unknown pattern " << args[i + 1] << ", using " << Stress::pattern_names[pattern] << std::endl;
+		}
+	}
+	ThreadPool::Start(threads);
+
 	// Start the physics world
 	m_world = new World();
 	if(!m_world->Initialize()) {
 		std::cerr << "The physics world failed to initialize." << std::endl;
 		return false;
 	}
-	if(!m_world->LoadObjects("../data/objects")) {
-		std::cerr << "Failed to load physics objects." << std::endl;
-		return false;
+	if(stress >= 0) {
+
+		if(!m_world->StartStress(pattern, stress)) {
+			std::cerr << "Failed to start the stress test." << std::endl;
+			return false;
+		}
+		// far enough back to see the whole floor
+		m_graphics->SetCameraDistance(std::min(80.0f, std::max(20.0f, m_world->StressExtent() * 2.5f)));
+
+	} else {
+
+		if(!m_world->LoadScene("../data/scene.json")) {
+			std::cerr << "Failed to load physics objects." << std::endl;
+			return false;
+		}
+		BvhCache::Report();
 	}
 
 	// Set the time
@@ -85,6 +123,9 @@ void Engine::Run() {
 		
 		UniformLocs uniforms = m_graphics->BeginObjectRender(w, h);
 		m_world->Render(uniforms);
+		if(m_world->StressExtent() > 0.0f) {
+			m_world->RenderInstanced(m_graphics->BeginInstancedRender(w, h));
+		}
 
 		m_graphics->UI();
 		ImGui::Separator();
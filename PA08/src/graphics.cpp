@@ -1,5 +1,6 @@
 
 #include "graphics.h"
+#include "glstate.h"
 #include <imgui.h>
 #include <stb_image.h>
 #include <SDL2/SDL.h>
@@ -51,6 +52,7 @@ float cubemap_points[] = {
 Graphics::Graphics() {
 
 	m_object_shader = nullptr;
+	m_instanced_shader = nullptr;
 }
 
 Graphics::~Graphics() {
@@ -60,6 +62,11 @@ Graphics::~Graphics() {
 		delete m_object_shader;
 		m_object_shader = nullptr;
 	}
+	if(m_instanced_shader) {
+
+		delete m_instanced_shader;
+		m_instanced_shader = nullptr;
+	}
 	if(m_cubemap_shader) {
 
 		delete m_cubemap_shader;
@@ -67,9 +74,8 @@ Graphics::~Graphics() {
 	}
 
 	glDeleteBuffers(1, &cubemap_vbo);
-	glDeleteTextures(1, &cubemap_tex);
-	glDeleteVertexArrays(1, &cubemap_vao);
-	glDeleteVertexArrays(1, &object_VAO);
+	GLState::DeleteTexture(cubemap_tex);
+	GLState::DeleteVertexArray(cubemap_vao);
 }
 
 bool Graphics::Initialize(int width, int height) {
@@ -98,9 +104,6 @@ bool Graphics::Initialize(int width, int height) {
 		return false;
 	}
 
-	// For OpenGL 3
-	glGenVertexArrays(1, &object_VAO);
-
 	// Init Camera
 	camera_type = CameraType::orbit;
 
@@ -134,6 +137,35 @@ bool Graphics::Initialize(int width, int height) {
 			return false;
 		}
 	}
+	{
+		m_instanced_shader = new Shader();
+		if(!m_instanced_shader->Initialize()) {
+
+			std::cerr << "Shader Failed to Initialize" << std::endl;
+			return false;
+		}
+		
+		// Add the vertex shader
+		if(!m_instanced_shader->AddShader(GL_VERTEX_SHADER, "../data/shaders/instanced.v")) {
+		
+			std::cerr << "Vertex Shader failed to Initialize" << std::endl;
+			return false;
+		}
+		
+		// same lighting as everything else
+		if(!m_instanced_shader->AddShader(GL_FRAGMENT_SHADER, "../data/shaders/shader.f")) {
+		
+			std::cerr << "Fragment Shader failed to Initialize" << std::endl;
+			return false;
+		}
+		
+		// Connect the program
+		if(!m_instanced_shader->Finalize()) {
+
+			std::cerr << "Program to Finalize" << std::endl;
+			return false;
+		}
+	}
 	{
 		m_cubemap_shader = new Shader();
 		if(!m_cubemap_shader->Initialize()) {
@@ -170,7 +202,7 @@ bool Graphics::Initialize(int width, int height) {
 	}
 
 	//enable depth testing
-	glEnable(GL_DEPTH_TEST);
+	GLState::Enable(GL_DEPTH_TEST, true);
 	
 	return true;
 }
@@ -207,10 +239,10 @@ bool Graphics::CreateCubeMap(std::string file) {
 	glGenVertexArrays(1, &cubemap_vao);
 	glGenTextures(1, &cubemap_tex);
 
-	glBindVertexArray(cubemap_vao);
-	glBindBuffer(GL_ARRAY_BUFFER, cubemap_vbo);
-	glBindTexture(GL_TEXTURE_CUBE_MAP, cubemap_tex);
 	glActiveTexture(GL_TEXTURE0);
+	GLState::BindVertexArray(cubemap_vao);
+	glBindBuffer(GL_ARRAY_BUFFER, cubemap_vbo);
+	GLState::BindTexture(GL_TEXTURE_CUBE_MAP, cubemap_tex);
 
 	glBufferData(GL_ARRAY_BUFFER, 3 * 36 * sizeof(float), &cubemap_points, GL_STATIC_DRAW);
 	
@@ -239,7 +271,7 @@ bool Graphics::CreateCubeMap(std::string file) {
 	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 	glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
 
-	glBindVertexArray(0);
+	GLState::BindVertexArray(0);
 
 	return true;
 }
@@ -265,7 +297,10 @@ void Graphics::SetCameraDistance(float d) {
 }
 
 void Graphics::Clear() {
-	
+
+	// a frame starts here
+	GLState::ResetCounters();
+
 	glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 }
@@ -274,35 +309,47 @@ void Graphics::RenderSkybox(int w, int h) {
 
 	Camera* c = GetCamera();
 
-	glDepthMask(GL_FALSE);
-	glBindVertexArray(cubemap_vao);
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_CUBE_MAP, cubemap_tex);
+	GLState::DepthMask(false);
+	GLState::BindVertexArray(cubemap_vao);
+	GLState::BindTexture(GL_TEXTURE_CUBE_MAP, cubemap_tex);
 	m_cubemap_shader->Enable();
 	glUniformMatrix4fv(m_cubemap_shader->GetUniformLocation("proj"), 1, GL_FALSE, glm::value_ptr(c->GetProjection(w, h))); 
 	glUniformMatrix4fv(m_cubemap_shader->GetUniformLocation("view"), 1, GL_FALSE, glm::value_ptr(c->GetViewWithoutTranslate())); 
 	glDrawArrays(GL_TRIANGLES, 0, 36);
-	glDepthMask(GL_TRUE);
+	GLState::DepthMask(true);
 }
 
 UniformLocs Graphics::BeginObjectRender(int w, int h) {
 
+	return BeginRender(m_object_shader, w, h);
+}
+
+UniformLocs Graphics::BeginInstancedRender(int w, int h) {
+
+	return BeginRender(m_instanced_shader, w, h);
+}
+
+UniformLocs Graphics::BeginRender(Shader* shader, int w, int h) {
+
 	Camera* c = GetCamera();
-	glBindVertexArray(object_VAO);
-	m_object_shader->Enable();
+	shader->Enable();
 	
 	// Send in the projection and view to the shader
-	glUniformMatrix4fv(m_object_shader->GetUniformLocation("proj"), 1, GL_FALSE, glm::value_ptr(c->GetProjection(w, h))); 
-	glUniformMatrix4fv(m_object_shader->GetUniformLocation("view"), 1, GL_FALSE, glm::value_ptr(c->GetView())); 
+	glUniformMatrix4fv(shader->GetUniformLocation("proj"), 1, GL_FALSE, glm::value_ptr(c->GetProjection(w, h))); 
+	glUniformMatrix4fv(shader->GetUniformLocation("view"), 1, GL_FALSE, glm::value_ptr(c->GetView())); 
 
 	const float lightColor[] = {1.0f, 1.0f, 1.0f};
-	glUniform3fv(m_object_shader->GetUniformLocation("lightColor"), 1, lightColor);
-	glUniform3fv(m_object_shader->GetUniformLocation("lightPos"), 1, glm::value_ptr(c->pos));
+	glUniform3fv(shader->GetUniformLocation("lightColor"), 1, lightColor);
+	glUniform3fv(shader->GetUniformLocation("lightPos"), 1, glm::value_ptr(c->pos));
 
+	// the instanced shader reads its model matrices from the instances instead
 	UniformLocs m;
-	m.model = m_object_shader->GetUniformLocation("model");
-	m.rotate = m_object_shader->GetUniformLocation("rotate");
-	m.ambient = m_object_shader->GetUniformLocation("ambientStrength");
+	m.model = m.rotate = -1;
+	if(shader == m_object_shader) {
+		m.model = shader->GetUniformLocation("model");
+		m.rotate = shader->GetUniformLocation("rotate");
+	}
+	m.ambient = shader->GetUniformLocation("ambientStrength");
 	return m;
 }
 
@@ -315,13 +362,14 @@ void Graphics::UI() {
 	ImGui::Combo("Camera Type", (int*)&camera_type, names, 2);
 
 	if(c == &orbit_camera) {
-		if(ImGui::SliderFloat("Radius", &orbit_camera.radius, 10.0f, 30.0f)) {
+		if(ImGui::SliderFloat("Radius", &orbit_camera.radius, 10.0f, 80.0f)) {
 			orbit_camera.update();
 		}
 	}
 	if(c == &free_camera) {
 		ImGui::SliderFloat("Speed", &free_camera.speed, 5.0f, 100.0f);
 	}
+	ImGui::Text("GL state changes: %u (%u skipped)", GLState::last_changes, GLState::last_skipped);
 }
 
 void Graphics::EndRender() {
@@ -2,8 +2,10 @@
 #include <iostream>
 #include <string>
 #include <vector>
+#include <cstdlib>
 
 #include "engine.h"
+#include "threadpool.h"
 
 int main(int argc, char **argv) {
   
@@ -14,6 +16,26 @@ int main(int argc, char **argv) {
 		args.push_back(string(argv[i]));
 	}
 
+	for(unsigned int i = 0; i + 1 < args.size(); i++) {
+
+		// time the physics step and transform sync on a generated pile of bodies, or a --pattern, and quit
+		if(args[i] == "--physics") {
+
+			int pattern = -1;
+			for(unsigned int j = 0; j + 1 < args.size(); j++) {
+				Stress::Pattern p;
+				if(args[j] == "--pattern" && Stress::ParsePattern(args[j + 1], p)) {
+					pattern = p;
+				}
+			}
+
+			ThreadPool::Start(8);
+			World::Benchmark(atoi(args[i + 1].c_str()), 300, pattern);
+			ThreadPool::Stop();
+			return 0;
+		}
+	}
+
 	Engine *engine = new Engine("PA8", 1280, 720);
 
 	if(!engine->Initialize(args)) {
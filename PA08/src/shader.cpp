@@ -1,4 +1,5 @@
 #include "shader.h"
+#include "glstate.h"
 #include <fstream>
 
 Shader::Shader() {
@@ -15,7 +16,7 @@ Shader::~Shader() {
 
 	if (m_shaderProg != 0) {
 
-		glDeleteProgram(m_shaderProg);
+		GLState::DeleteProgram(m_shaderProg);
 		m_shaderProg = 0;
 	}
 }
@@ -124,7 +125,7 @@ bool Shader::Finalize()
 
 void Shader::Enable() {
 	
-	glUseProgram(m_shaderProg);
+	GLState::UseProgram(m_shaderProg);
 }
 
 
@@ -0,0 +1,307 @@
+#include "stress.h"
+#include "threadpool.h"
+
+#include <imgui.h>
+#include <algorithm>
+#include <cmath>
+
+const char* Stress::pattern_names[NUM_PATTERNS] = {"pyramids", "rain"};
+
+// boxes and spheres are a quarter the size of cube.obj and sphere.obj
+static const float BODY_HALF = 0.25f;
+// pyramids of boxes 10 wide at the bottom, with a hair of space between boxes so none start out overlapping
+static const int PYRAMID_BASE = 10;
+static const float PYRAMID_SPACING = 7.0f;
+static const float STACK_STEP = 2.0f * BODY_HALF + 0.002f;
+// rain starts this high, and all of it has fallen after this long
+static const float RAIN_HEIGHT = 15.0f, RAIN_SECONDS = 4.0f;
+// bodies per task when the sync is split across threads
+static const unsigned int SYNC_CHUNK = 512;
+
+bool Stress::ParsePattern(const std::string& name, Pattern& pattern) {
+
+	for(int p = 0; p < NUM_PATTERNS; p++) {
+		if(name == pattern_names[p]) {
+			pattern = (Pattern)p;
+			return true;
+		}
+	}
+	return false;
+}
+
+Stress::Stress() : random(1) {
+
+	shapes[BOX] = new btBoxShape(btVector3(BODY_HALF, BODY_HALF, BODY_HALF));
+	shapes[SPHERE] = new btSphereShape(BODY_HALF);
+}
+
+Stress::~Stress() {
+
+	for(int k = 0; k < NUM_KINDS; k++) {
+
+		// the bodies have to be out of the world already, see Clear
+		for(btRigidBody* body : kinds[k].bodies) delete body;
+		for(btDefaultMotionState* state : kinds[k].states) delete state;
+
+		delete shapes[k];
+		kinds[k].s.DeleteMesh();
+		kinds[k].s.DeleteTexture();
+		if(kinds[k].buffer) glDeleteBuffers(1, &kinds[k].buffer);
+	}
+
+	for(btRigidBody* body : statics) {
+		delete body->getMotionState();
+		delete body;
+	}
+	for(btCollisionShape* wall : walls) delete wall;
+	if(floor_shape) delete floor_shape;
+}
+
+bool Stress::LoadMeshes() {
+
+	if(!kinds[BOX].s.LoadModel("../data/models/cube.obj") || !kinds[BOX].s.LoadTexture("../data/textures/cube.png")) {
+		return false;
+	}
+	if(!kinds[SPHERE].s.LoadModel("../data/models/sphere.obj") || !kinds[SPHERE].s.LoadTexture("../data/textures/sphere.png")) {
+		return false;
+	}
+	return true;
+}
+
+void Stress::Spawn(btDiscreteDynamicsWorld* world, Pattern pattern, unsigned int count) {
+
+	Clear(world);
+
+	this->pattern = pattern;
+	this->count = count;
+	ui_pattern = pattern;
+	ui_count = count;
+	random.seed(1);
+
+	if(pattern == PYRAMIDS) {
+
+		unsigned int per_pyramid = 0;
+		for(int l = 0; l < PYRAMID_BASE; l++) {
+			per_pyramid += (PYRAMID_BASE - l) * (PYRAMID_BASE - l);
+		}
+
+		// a square of pyramids, the last one only built as high as count goes
+		unsigned int pyramids = (count + per_pyramid - 1) / per_pyramid;
+		int side = std::max(1, (int)ceil(sqrt(pyramids)));
+		half = side * PYRAMID_SPACING / 2.0f;
+		AddFloor(world);
+
+		unsigned int added = 0;
+		for(unsigned int p = 0; p < pyramids; p++) {
+
+			float px = (p % side - (side - 1) / 2.0f) * PYRAMID_SPACING;
+			float pz = (p / side - (side - 1) / 2.0f) * PYRAMID_SPACING;
+
+			for(int l = 0; l < PYRAMID_BASE && added < count; l++) {
+
+				int n = PYRAMID_BASE - l;
+				for(int i = 0; i < n * n && added < count; i++, added++) {
+
+					float x = px + (i % n - (n - 1) / 2.0f) * STACK_STEP;
+					float z = pz + (i / n - (n - 1) / 2.0f) * STACK_STEP;
+					AddBody(world, BOX, btVector3(x, BODY_HALF + l * STACK_STEP, z), btVector3(0, 0, 0));
+				}
+			}
+		}
+
+	} else {
+
+		// wide enough that the spheres end up a couple of layers deep
+		half = std::min(20.0f, std::max(4.0f, sqrtf(count) * 0.2f));
+		AddFloor(world);
+
+		pending = count;
+		rain_rate = count / RAIN_SECONDS;
+		rain_carry = 0.0f;
+	}
+}
+
+void Stress::Clear(btDiscreteDynamicsWorld* world) {
+
+	for(int k = 0; k < NUM_KINDS; k++) {
+
+		Bodies& b = kinds[k];
+		for(unsigned int i = 0; i < b.bodies.size(); i++) {
+			world->removeRigidBody(b.bodies[i]);
+			delete b.bodies[i];
+			delete b.states[i];
+		}
+		b.bodies.clear();
+		b.states.clear();
+		b.instances.clear();
+		b.drawn = 0;
+	}
+
+	for(btRigidBody* body : statics) {
+		world->removeRigidBody(body);
+		delete body->getMotionState();
+		delete body;
+	}
+	statics.clear();
+
+	for(btCollisionShape* wall : walls) delete wall;
+	walls.clear();
+	if(floor_shape) delete floor_shape;
+	floor_shape = nullptr;
+
+	count = 0;
+	pending = 0;
+}
+
+void Stress::AddFloor(btDiscreteDynamicsWorld* world) {
+
+	// a slab to stand on, top at y = 0, walled in on four sides so nothing rolls away
+	floor_shape = new btBoxShape(btVector3(half, 0.5f, half));
+	walls = {
+		new btStaticPlaneShape(btVector3(1, 0, 0), -half),
+		new btStaticPlaneShape(btVector3(-1, 0, 0), -half),
+		new btStaticPlaneShape(btVector3(0, 0, 1), -half),
+		new btStaticPlaneShape(btVector3(0, 0, -1), -half)
+	};
+
+	auto add = [&](btCollisionShape* shape, const btVector3& pos) {
+
+		btDefaultMotionState* state = new btDefaultMotionState(btTransform(btQuaternion(0, 0, 0, 1), pos));
+		btRigidBody* body = new btRigidBody(btRigidBody::btRigidBodyConstructionInfo(0, state, shape, btVector3(0, 0, 0)));
+		world->addRigidBody(body);
+		statics.push_back(body);
+	};
+
+	add(floor_shape, btVector3(0, -0.5f, 0));
+	for(btCollisionShape* wall : walls) {
+		add(wall, btVector3(0, 0, 0));
+	}
+
+	floor_model = glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, -0.5f, 0.0f)), glm::vec3(half, 0.5f, half));
+}
+
+void Stress::AddBody(btDiscreteDynamicsWorld* world, Kind kind, const btVector3& pos, const btVector3& velocity) {
+
+	const btScalar mass = 1;
+	btVector3 inertia(0, 0, 0);
+	shapes[kind]->calculateLocalInertia(mass, inertia);
+
+	btDefaultMotionState* state = new btDefaultMotionState(btTransform(btQuaternion(0, 0, 0, 1), pos));
+	btRigidBody* body = new btRigidBody(btRigidBody::btRigidBodyConstructionInfo(mass, state, shapes[kind], inertia));
+	// kept awake like everything else in PA8, so the load doesn't drop off once they settle
+	body->setActivationState(DISABLE_DEACTIVATION);
+	body->setLinearVelocity(velocity);
+
+	world->addRigidBody(body);
+	kinds[kind].bodies.push_back(body);
+	kinds[kind].states.push_back(state);
+}
+
+void Stress::Update(btDiscreteDynamicsWorld* world, unsigned int dT) {
+
+	if(!pending) return;
+
+	rain_carry += rain_rate * dT / 1000.0f;
+	unsigned int drops = std::min(pending, (unsigned int)rain_carry);
+	rain_carry -= drops;
+	pending -= drops;
+
+	std::uniform_real_distribution<float> spread(-half + BODY_HALF, half - BODY_HALF);
+	std::uniform_real_distribution<float> height(0.0f, 2.0f);
+	for(unsigned int i = 0; i < drops; i++) {
+
+		float x = spread(random), z = spread(random);
+		AddBody(world, SPHERE, btVector3(x, RAIN_HEIGHT + height(random), z), btVector3(0, -5, 0));
+	}
+}
+
+void Stress::Sync() {
+
+	for(int k = 0; k < NUM_KINDS; k++) {
+
+		Bodies& b = kinds[k];
+		unsigned int count = b.states.size();
+		// the floor goes in as one more box
+		bool floor = k == BOX && floor_shape;
+		unsigned int total = count + (floor ? 1 : 0);
+
+		// without a window there's no buffer to map, the run without meshes syncs into instances instead
+		glm::mat4* out = nullptr;
+		bool buffered = b.s.getMesh().VAO && total;
+		if(buffered) {
+
+			if(!b.buffer) glGenBuffers(1, &b.buffer);
+			glBindBuffer(GL_ARRAY_BUFFER, b.buffer);
+
+			size_t bytes = total * sizeof(glm::mat4);
+			if(bytes > b.capacity) {
+				b.capacity = std::max(bytes, b.capacity * 2);
+				glBufferData(GL_ARRAY_BUFFER, b.capacity, nullptr, GL_STREAM_DRAW);
+			}
+			// invalidating orphans the old storage, so the driver doesn't wait on last frame's draw reading it
+			out = (glm::mat4*)glMapBufferRange(GL_ARRAY_BUFFER, 0, bytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+		}
+		bool mapped = out != nullptr;
+		if(!mapped) {
+			b.instances.resize(total);
+			out = b.instances.data();
+		}
+
+		ThreadPool::ParallelFor((count + SYNC_CHUNK - 1) / SYNC_CHUNK, [&](unsigned int t) {
+
+			unsigned int end = std::min(count, (t + 1) * SYNC_CHUNK);
+			for(unsigned int i = t * SYNC_CHUNK; i < end; i++) {
+
+				btTransform transform;
+				btScalar mat[16];
+
+				b.states[i]->getWorldTransform(transform);
+				transform.getOpenGLMatrix(mat);
+				out[i] = glm::scale(glm::make_mat4(mat), glm::vec3(BODY_HALF));
+			}
+		});
+		if(floor) out[count] = floor_model;
+
+		b.drawn = total;
+		if(mapped) {
+			// the contents are lost if the buffer got trashed while mapped, skip a frame rather than draw junk
+			if(glUnmapBuffer(GL_ARRAY_BUFFER) != GL_TRUE) b.drawn = 0;
+		} else if(buffered) {
+			// the map failed, and the buffer it invalidated still has to hold this frame
+			glBufferSubData(GL_ARRAY_BUFFER, 0, total * sizeof(glm::mat4), b.instances.data());
+		}
+		if(buffered) glBindBuffer(GL_ARRAY_BUFFER, 0);
+	}
+}
+
+void Stress::Render(UniformLocs uniforms) {
+
+	glUniform1f(uniforms.ambient, 0.25f);
+
+	draws = 0;
+	for(int k = 0; k < NUM_KINDS; k++) {
+
+		Bodies& b = kinds[k];
+		if(!b.s.getMesh().VAO || !b.buffer || !b.drawn) continue;
+
+		b.s.RenderInstanced(b.buffer, b.drawn);
+		draws++;
+	}
+}
+
+void Stress::UI(btDiscreteDynamicsWorld* world) {
+
+	ImGui::Text("Stress");
+	ImGui::Combo("Pattern", &ui_pattern, pattern_names, NUM_PATTERNS);
+	ImGui::InputInt("Count", &ui_count, 500, 5000);
+	ui_count = std::max(0, ui_count);
+
+	if(pending) {
+		ImGui::Text("%u of %u still to fall", pending, count);
+	}
+	ImGui::Text("Instanced draws: %u", draws);
+
+	if(ImGui::Button("Respawn")) {
+		Spawn(world, (Pattern)ui_pattern, ui_count);
+	}
+}
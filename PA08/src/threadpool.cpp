@@ -0,0 +1,111 @@
+
+#include "threadpool.h"
+
+#include <atomic>
+#include <memory>
+#include <algorithm>
+
+std::vector<std::thread> ThreadPool::workers;
+std::deque<std::function<void()>> ThreadPool::queued;
+std::mutex ThreadPool::lock;
+std::condition_variable ThreadPool::work_cv;
+bool ThreadPool::stopping = false;
+unsigned int ThreadPool::active = 1;
+
+void ThreadPool::Start(unsigned int threads) {
+
+	if(!threads) threads = std::max(1u, std::thread::hardware_concurrency());
+
+	stopping = false;
+	for(unsigned int i = 0; i + 1 < threads; i++) {
+		workers.push_back(std::thread(Worker));
+	}
+	active = threads;
+}
+
+void ThreadPool::Stop() {
+
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		stopping = true;
+	}
+	work_cv.notify_all();
+
+	for(auto& t : workers) {
+		t.join();
+	}
+	workers.clear();
+	queued.clear();
+	active = 1;
+}
+
+unsigned int ThreadPool::Threads() {
+	return active;
+}
+
+void ThreadPool::SetThreads(unsigned int threads) {
+	active = std::min(std::max(threads, 1u), MaxThreads());
+}
+
+unsigned int ThreadPool::MaxThreads() {
+	return workers.size() + 1;
+}
+
+void ThreadPool::ParallelFor(unsigned int count, std::function<void(unsigned int)> fn) {
+
+	if(count <= 1 || active <= 1) {
+		for(unsigned int i = 0; i < count; i++) fn(i);
+		return;
+	}
+
+	struct Range {
+		std::atomic<unsigned int> next;
+		unsigned int done = 0;
+		std::mutex lock;
+		std::condition_variable cv;
+	};
+	std::shared_ptr<Range> range = std::make_shared<Range>();
+	range->next = 0;
+
+	// helpers that only get to run after the calling thread took every index find nothing left
+	auto run = [range, count, fn]() {
+		unsigned int i;
+		while((i = range->next++) < count) {
+			fn(i);
+
+			std::lock_guard<std::mutex> guard(range->lock);
+			if(++range->done == count) range->cv.notify_all();
+		}
+	};
+
+	unsigned int helpers = std::min(active - 1, count - 1);
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		for(unsigned int i = 0; i < helpers; i++) {
+			queued.push_back(run);
+		}
+	}
+	work_cv.notify_all();
+	run();
+
+	std::unique_lock<std::mutex> guard(range->lock);
+	range->cv.wait(guard, [&] { return range->done == count; });
+}
+
+void ThreadPool::Worker() {
+
+	for(;;) {
+
+		std::function<void()> task;
+		{
+			std::unique_lock<std::mutex> guard(lock);
+			work_cv.wait(guard, [] { return stopping || !queued.empty(); });
+			if(stopping) return;
+
+			task = queued.front();
+			queued.pop_front();
+		}
+
+		task();
+	}
+}
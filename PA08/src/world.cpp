@@ -1,50 +1,137 @@
 
 #include "world.h"
+#include "threadpool.h"
+#include "bvhcache.h"
 
-#include <dirent.h>
-#include <fstream>
-#include <sys/stat.h>
 #include <imgui.h>
 #include <SDL2/SDL.h>
+#include <chrono>
+#include <cmath>
+#include <algorithm>
 
-bool isRegularFile(std::string path) {
+// bodies per task when the transform sync is split across threads
+static const unsigned int SYNC_CHUNK = 512;
 
-    struct stat path_stat;
-    stat(path.c_str(), &path_stat);
-    return !!S_ISREG(path_stat.st_mode);
-}
+#ifdef BULLET_MT
+// Bullet's parallel loops, run on the thread pool
+class PoolScheduler : public btITaskScheduler {
+public:
+	PoolScheduler() : btITaskScheduler("ThreadPool") {}
 
-bool Object::LoadJSON(std::string json) {
+	virtual int getMaxNumThreads() const { return ThreadPool::MaxThreads(); }
+	virtual int getNumThreads() const { return ThreadPool::Threads(); }
+	virtual void setNumThreads(int threads) { ThreadPool::SetThreads(threads); }
 
-	picojson::value v;
-	std::string err = picojson::parse(v, json);
+	virtual void parallelFor(int begin, int end, int grain, const btIParallelForBody& body) {
 
-	if (!err.empty()) {
-  		std::cerr << err << std::endl;
-  		return false;
+		grain = std::max(grain, 1);
+		ThreadPool::ParallelFor((end - begin + grain - 1) / grain, [&](unsigned int t) {
+			body.forLoop(begin + t * grain, std::min(end, begin + (int)(t + 1) * grain));
+		});
 	}
 
-	if (!v.is<picojson::object>()) {
-		std::cerr << "JSON is not an object" << std::endl;
-		return false;
+	virtual btScalar parallelSum(int begin, int end, int grain, const btIParallelSumBody& body) {
+
+		grain = std::max(grain, 1);
+		std::vector<btScalar> sums((end - begin + grain - 1) / grain);
+		ThreadPool::ParallelFor(sums.size(), [&](unsigned int t) {
+			sums[t] = body.sumLoop(begin + t * grain, std::min(end, begin + (int)(t + 1) * grain));
+		});
+
+		btScalar sum = 0;
+		for(btScalar s : sums) sum += s;
+		return sum;
 	}
+};
 
-	const auto& obj = v.get<picojson::object>();
-	return LoadJSONObj(obj);
-}
+static PoolScheduler scheduler;
+#endif
 
-#define stringfield(name) if(i.first == #name && i.second.is<std::string>()) name = i.second.get<std::string>();
-#define floatfield(name) if(i.first == #name && i.second.is<double>()) name = i.second.get<double>();
-#define vecfield(name) if(i.first == #name && i.second.is<picojson::array>()) { const auto& array = i.second.get<picojson::array>(); for(int i = 0; i < 3; i++) if(array[i].is<double>()) name[i] = array[i].get<double>();}
-#define boolfield(name) if(i.first == #name && i.second.is<bool>()) name = i.second.get<bool>();
+// a dynamics world that times each phase of its steps into phases, added up until they're zeroed
+template<class Base>
+class TimedWorld : public Base {
+public:
+	template<class... Args>
+	TimedWorld(StepPhases& phases, Args... args) : Base(args...), phases(phases) {}
+
+	// btCollisionWorld's, with the broadphase and the narrowphase timed apart
+	virtual void performDiscreteCollisionDetection() {
+
+		auto start = std::chrono::high_resolution_clock::now();
+		this->updateAabbs();
+		this->computeOverlappingPairs();
+		auto paired = std::chrono::high_resolution_clock::now();
+
+		if(this->m_dispatcher1) {
+			this->m_dispatcher1->dispatchAllCollisionPairs(this->m_broadphasePairCache->getOverlappingPairCache(), this->getDispatchInfo(), this->m_dispatcher1);
+		}
+		auto dispatched = std::chrono::high_resolution_clock::now();
+
+		phases.broadphase += std::chrono::duration<double, std::milli>(paired - start).count();
+		phases.narrowphase += std::chrono::duration<double, std::milli>(dispatched - paired).count();
+	}
+
+protected:
+	virtual void solveConstraints(btContactSolverInfo& info) {
+
+		auto start = std::chrono::high_resolution_clock::now();
+		Base::solveConstraints(info);
+		phases.solver += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	}
+
+	virtual void predictUnconstraintMotion(btScalar timeStep) {
+
+		auto start = std::chrono::high_resolution_clock::now();
+		Base::predictUnconstraintMotion(timeStep);
+		phases.integrate += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	}
 
-bool Object::LoadJSONObj(const picojson::object& obj) {
+	virtual void integrateTransforms(btScalar timeStep) {
+
+		auto start = std::chrono::high_resolution_clock::now();
+		Base::integrateTransforms(timeStep);
+		phases.integrate += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	}
+
+private:
+	StepPhases& phases;
+};
+
+// every field an object can have, looked up once per field through the scene file's perfect hash
+enum ObjectKey {
+	KEY_TYPE,
+	KEY_NAME,
+	KEY_MODEL,
+	KEY_TEXTURE,
+	KEY_MASS,
+	KEY_POSITION,
+	KEY_VELOCITY,
+	KEY_SHAPE,
+
+	KEY_COUNT
+};
+
+static const char* key_names[KEY_COUNT] = {
+	"type", "name", "model", "texture", "mass", "position", "velocity", "shape"
+};
+
+#define stringfield(key, name) case key: if(f.kind == SceneFile::STRING) name = f.string; break;
+#define floatfield(key, name) case key: if(f.kind == SceneFile::NUMBER) name = f.numbers[0]; break;
+#define vecfield(key, name) case key: if(f.kind == SceneFile::NUMBERS && f.count >= 3) for(int n = 0; n < 3; n++) name[n] = f.numbers[n]; break;
+
+SceneFile& Object::Reader() {
+
+	static SceneFile reader(key_names, KEY_COUNT);
+	return reader;
+}
+
+bool Object::LoadFields(const SceneFile::Fields& fields) {
 
 	shape = Shape::none;
-	for(auto& i : obj) {
+	for(auto& f : fields) {
 
-		if(i.first == "type" && i.second.is<std::string>()) {
-			std::string type = i.second.get<std::string>();
+		if(f.key == KEY_TYPE && f.kind == SceneFile::STRING) {
+			const std::string& type = f.string;
 			if(type == "plane") {
 				shape = Shape::plane;
 			} else if(type == "sphere") {
@@ -58,51 +145,34 @@ bool Object::LoadJSONObj(const picojson::object& obj) {
 			} else {
 				return false;
 			}
-			break;
 		}
 	}
-	for(auto& i : obj) {
+	for(auto& f : fields) {
+		switch(f.key) {
 
-		stringfield(name);
-		stringfield(model);
-		stringfield(texture);
+			stringfield(KEY_NAME, name)
+			stringfield(KEY_MODEL, model)
+			stringfield(KEY_TEXTURE, texture)
 
-		floatfield(mass);
+			floatfield(KEY_MASS, mass)
 
-		vecfield(position);
-		vecfield(velocity);
+			vecfield(KEY_POSITION, position)
+			vecfield(KEY_VELOCITY, velocity)
 
-		if(i.first == "shape" && shape == Shape::plane && i.second.is<picojson::array>()) {
-			const auto& array = i.second.get<picojson::array>();
-			for(int i = 0; i < 4; i++) {
-				if(array[i].is<double>()) {
-					plane[i] = array[i].get<double>();
-				}
+		case KEY_SHAPE:
+			if(shape == Shape::plane && f.kind == SceneFile::NUMBERS && f.count >= 4) {
+				for(int n = 0; n < 4; n++) plane[n] = f.numbers[n];
 			}
-		}
-		if(i.first == "shape" && shape == Shape::sphere && i.second.is<double>()) {
-			sphere = i.second.get<double>();
-		}
-		if(i.first == "shape" && shape == Shape::box && i.second.is<picojson::array>()) {
-
-			const auto& array = i.second.get<picojson::array>();
-			for(int i = 0; i < 3; i++) {
-				if(array[i].is<double>()) {
-					box[i] = array[i].get<double>();
-				}
+			if(shape == Shape::sphere && f.kind == SceneFile::NUMBER) {
+				sphere = f.numbers[0];
 			}
-		}
-
-	    if(i.first == "shape" && shape == Shape::cylinder && i.second.is<picojson::array>()) {
-
-				const auto& array = i.second.get<picojson::array>();
-				for(int i = 0; i < 3; i++) {
-					if(array[i].is<double>()) {
-						box[i] = array[i].get<double>();
-					}
-				}
+			// cylinders keep their half extents in box too
+			if((shape == Shape::box || shape == Shape::cylinder) && f.kind == SceneFile::NUMBERS && f.count >= 3) {
+				for(int n = 0; n < 3; n++) box[n] = f.numbers[n];
 			}
+			break;
 		}
+	}
 
 	return true;
 }
@@ -122,9 +192,6 @@ bool Object::Setup() {
 	case Shape::cylinder: {
 		btShape = new btCylinderShape(btVector3(box.x, box.y, box.z));
 	} break;
-	case Shape::mesh: {
-		btMesh = new btTriangleMesh();
-	} break;
 	default: break;
 	}
 
@@ -135,19 +202,11 @@ bool Object::Setup() {
 		return false;
 	}
 
+	// straight on top of the render mesh's arrays, with the BVH read from next to the model when it can be
 	if(shape == Shape::mesh) {
 		Scene::Mesh& mesh = s.getMesh();
-
-		for(unsigned int i = 0; i < mesh.indices.size(); i += 3) {
-
-			glm::vec3 pos1 = mesh.vertices[mesh.indices[i]].pos;
-			glm::vec3 pos2 = mesh.vertices[mesh.indices[i+1]].pos;
-			glm::vec3 pos3 = mesh.vertices[mesh.indices[i+2]].pos;
-
-			btMesh->addTriangle(btVector3(pos1.x,pos1.y,pos1.z),btVector3(pos2.x,pos2.y,pos2.z),btVector3(pos3.x,pos3.y,pos3.z));
-		}
-
-		btShape = new btBvhTriangleMeshShape(btMesh, true);
+		btShape = BvhCache::Load(model + ".bvh", mesh.vertices.data(), mesh.vertices.size(), mesh.indices.data(), mesh.indices.size());
+		if(!btShape) return false;
 	}
 
 	btMotionState = new btDefaultMotionState(btTransform(btQuaternion(0,0,0,1), btVector3(position.x, position.y, position.z)));
@@ -184,10 +243,12 @@ void Object::Shutdown() {
 
 	if(btBody) delete btBody;
 	if(btMotionState) delete btMotionState;
-	if(btShape) delete btShape;
-	if(btMesh) delete btMesh;
+	if(shape == Shape::mesh) {
+		BvhCache::Free(btShape);
+	} else if(btShape) {
+		delete btShape;
+	}
 	btShape = nullptr;
-	btMesh = nullptr;
 	btMotionState = nullptr;
 	btBody = nullptr;
 
@@ -201,12 +262,22 @@ World::World() {
 
 World::~World() {
 
+	if(stress && btWorld) {
+		stress->Clear(btWorld);
+	}
+	if(stress) delete stress;
+	stress = nullptr;
+
 	for(Object& o : objects) {
 		btWorld->removeRigidBody(o.btBody);
 	}
 
 	if(btWorld) delete btWorld;
 	if(solver) delete solver;
+#ifdef BULLET_MT
+	if(solverPool) delete solverPool;
+	solverPool = nullptr;
+#endif
 	if(dispatcher) delete dispatcher;
 	if(collisionConfiguration) delete collisionConfiguration;
 	if(broadphase) delete broadphase;
@@ -224,6 +295,10 @@ World::~World() {
 
 void World::Reset() {
 
+	if(stress) {
+		stress->Respawn(btWorld);
+	}
+
 	for(Object& o : objects) {
 		o.Reset();
 	}
@@ -233,13 +308,25 @@ bool World::Initialize() {
 
 	broadphase = new btDbvtBroadphase();
 	collisionConfiguration = new btDefaultCollisionConfiguration();
+
+#ifdef BULLET_MT
+	// narrowphase, islands and solver all split over the pool, one solver per thread
+	btSetTaskScheduler(&scheduler);
+	dispatcher = new btCollisionDispatcherMt(collisionConfiguration);
+	solverPool = new btConstraintSolverPoolMt(ThreadPool::MaxThreads());
+	solver = new btSequentialImpulseConstraintSolverMt();
+#else
 	dispatcher = new btCollisionDispatcher(collisionConfiguration);
+	solver = new btSequentialImpulseConstraintSolver();
+#endif
 
 	btGImpactCollisionAlgorithm::registerAlgorithm(dispatcher);
 
-	solver = new btSequentialImpulseConstraintSolver();
-
-	btWorld = new btDiscreteDynamicsWorld(dispatcher, broadphase, solver, collisionConfiguration);
+#ifdef BULLET_MT
+	btWorld = new TimedWorld<btDiscreteDynamicsWorldMt>(stepping, dispatcher, broadphase, solverPool, solver, collisionConfiguration);
+#else
+	btWorld = new TimedWorld<btDiscreteDynamicsWorld>(stepping, dispatcher, broadphase, solver, collisionConfiguration);
+#endif
 	btWorld->setGravity(btVector3(5, -5, 0));
 
 	return true;
@@ -247,7 +334,18 @@ bool World::Initialize() {
 
 void World::Update(unsigned int dT) {
 
-	btWorld->stepSimulation(dT / 1000.0f);
+	if(stress) {
+		stress->Update(btWorld, dT);
+	}
+
+	stepping = StepPhases();
+	auto start = std::chrono::high_resolution_clock::now();
+	int steps = btWorld->stepSimulation(dT / 1000.0f);
+	// a frame shorter than the fixed step only interpolates, so keep showing the last one that stepped
+	if(steps > 0) {
+		step_ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+		phases = stepping;
+	}
 
 	static const unsigned char* keys = SDL_GetKeyboardState(NULL);
 
@@ -280,32 +378,51 @@ void World::Update(unsigned int dT) {
 		}
 	}
 
-	for(Object& o : objects) {
-		btTransform transform;
-		btScalar mat[16];
+	start = std::chrono::high_resolution_clock::now();
+	SyncTransforms(states, models, rotations);
+	if(stress) {
+		stress->Sync();
+	}
+	sync_ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
 
-		o.btMotionState->getWorldTransform(transform);
-		transform.getOpenGLMatrix(mat);
-		o.modelmx = glm::make_mat4(mat);
+void World::SyncTransforms(const std::vector<btDefaultMotionState*>& states, std::vector<glm::mat4>& models, std::vector<glm::mat4>& rotations) {
 
-		btQuaternion q = transform.getRotation();
-		glm::quat quat(q.w(),q.x(),q.y(),q.z());
-		o.rotmx = glm::mat4(quat);
-	}
+	unsigned int count = states.size();
+	models.resize(count);
+	rotations.resize(count);
+
+	ThreadPool::ParallelFor((count + SYNC_CHUNK - 1) / SYNC_CHUNK, [&](unsigned int t) {
+
+		unsigned int end = std::min(count, (t + 1) * SYNC_CHUNK);
+		for(unsigned int i = t * SYNC_CHUNK; i < end; i++) {
+
+			btTransform transform;
+			btScalar mat[16];
+
+			states[i]->getWorldTransform(transform);
+			transform.getOpenGLMatrix(mat);
+			models[i] = glm::make_mat4(mat);
+
+			// bullet transforms are rigid, the rotation is the model matrix without its translation
+			rotations[i] = models[i];
+			rotations[i][3] = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+		}
+	});
 }
 
 void World::Render(UniformLocs uniforms) {
 
-	for(Object& o : objects) {
+	for(unsigned int i = 0; i < objects.size(); i++) {
 
-		if(selected != -1 && &o == &objects[selected])
+		if((int)i == selected)
 			glUniform1f(uniforms.ambient, 0.75f);
 		else
 			glUniform1f(uniforms.ambient, 0.25f);
-		glUniformMatrix4fv(uniforms.model, 1, GL_FALSE, glm::value_ptr(o.modelmx));
-		glUniformMatrix4fv(uniforms.rotate, 1, GL_FALSE, glm::value_ptr(o.rotmx));
+		glUniformMatrix4fv(uniforms.model, 1, GL_FALSE, glm::value_ptr(models[i]));
+		glUniformMatrix4fv(uniforms.rotate, 1, GL_FALSE, glm::value_ptr(rotations[i]));
 
-		o.s.Render();
+		objects[i].s.Render();
 	}
 }
 
@@ -327,6 +444,26 @@ void World::UI() {
 	ImGui::Text("Physics");
 	ImGui::Combo("Selected", &ui_selected, available.data(), available.size());
 
+	int threads = ThreadPool::Threads();
+	if(ImGui::SliderInt("Threads", &threads, 1, ThreadPool::MaxThreads())) {
+		ThreadPool::SetThreads(threads);
+	}
+	ImGui::Text("Step: %.2f ms, sync: %.3f ms", step_ms, sync_ms);
+	ImGui::Text("  broadphase %.2f, narrowphase %.2f, solver %.2f, integrate %.2f ms", phases.broadphase, phases.narrowphase, phases.solver, phases.integrate);
+
+	// what the last step had to work through
+	int manifolds = dispatcher->getNumManifolds(), contacts = 0;
+	for(int m = 0; m < manifolds; m++) {
+		contacts += dispatcher->getManifoldByIndexInternal(m)->getNumContacts();
+	}
+	ImGui::Text("Bodies: %d, broadphase pairs: %d", btWorld->getNumCollisionObjects(), broadphase->getOverlappingPairCache()->getNumOverlappingPairs());
+	ImGui::Text("Contacts: %d in %d manifolds", contacts, manifolds);
+
+	if(stress) {
+		ImGui::Separator();
+		stress->UI(btWorld);
+	}
+
 	if(!ui_selected) selected = -1;
 
 	for(unsigned int i = 0; i < objects.size(); i++) {
@@ -338,6 +475,8 @@ void World::UI() {
 
 void World::NextSelected() {
 
+	if(objects.empty()) return;
+
 	for(int i = (selected + 1) % objects.size(); i != selected; ++i %= objects.size()) {
 		if(objects[i].mass > 0) {
 			selected = i;
@@ -346,62 +485,184 @@ void World::NextSelected() {
 	}
 }
 
-bool World::LoadObjects(std::string dir) {
+bool World::LoadScene(std::string path) {
 
-	DIR *directory;
-	dirent *entry;
-	std::string dirPath = dir;
+	unsigned int index = 0;
+	bool ok = Object::Reader().Load(path, [&](const SceneFile::Fields& fields) {
 
-	if (dirPath.back() != '/' && dirPath.back() != '\\') {
-		dirPath.append("/");
-	}
+		Object o;
+		if(!o.LoadFields(fields) || !o.Setup()) {
+			std::cerr << "Failed to load object " << index << " from " << path << std::endl;
+		} else {
+			AddObject(std::move(o));
+		}
+		index++;
+		return true;
+	});
 
-	directory = opendir(dirPath.c_str());
-	if (!directory) {
-		std::cerr << "Failed to open directory at " << dirPath << std::endl;
+	if(!ok) {
+		std::cerr << "Failed to load scene " << path << std::endl;
 		return false;
 	}
 
-	while((entry = readdir(directory))) {
-		std::string entryName = entry->d_name;
+	const SceneFile& reader = Object::Reader();
+	printf("Scene %s: %u objects %s in %.2f ms\n", path.c_str(), reader.objects, reader.from_cache ? "read compiled" : "parsed", reader.load_ms);
 
-		if(entryName != ".." && entryName != "." && isRegularFile(dirPath + entryName)) {
+	return true;
+}
 
-			std::cout << "Loading object "<< entryName << std::endl;
-			if(!LoadObject(dirPath + entryName)) {
-				std::cerr << "Failed to load object from file " << entryName << std::endl;
-			}
+void World::AddObject(Object&& o) {
+
+	btWorld->addRigidBody(o.btBody);
+	states.push_back(o.btMotionState);
+	objects.push_back(std::move(o));
+
+	models.push_back(glm::mat4(1.0f));
+	rotations.push_back(glm::mat4(1.0f));
+}
+
+bool World::StartStress(Stress::Pattern pattern, unsigned int count, bool meshes) {
+
+	if(!stress) {
+		stress = new Stress();
+		if(meshes && !stress->LoadMeshes()) {
+			std::cerr << "Failed to load the stress meshes" << std::endl;
+			return false;
 		}
 	}
 
-	closedir(directory);
+	// the floor's flat, unlike the table
+	btWorld->setGravity(btVector3(0, -10, 0));
+	stress->Spawn(btWorld, pattern, count);
 
+	printf("Stress: %u bodies, %s\n", count, Stress::pattern_names[pattern]);
 	return true;
 }
 
-bool World::LoadObject(std::string path) {
+void World::RenderInstanced(UniformLocs uniforms) {
 
-	Object o;
-
-	std::string contents;
-	std::ifstream fin(path);
-	getline(fin, contents, '\0');
-
-	if(!o.LoadJSON(contents)) {
-    printf("Failed to Load JSON\n");
-		return false;
+	if(stress) {
+		stress->Render(uniforms);
 	}
+}
 
-	if(!o.Setup()) {
-		return false;
-	}
+float World::StressExtent() const {
 
-	AddObject(o);
-	return true;
+	return stress ? stress->Extent() : 0.0f;
 }
 
-void World::AddObject(const Object& o) {
+void World::Benchmark(unsigned int count, unsigned int steps, int pattern) {
 
-	btWorld->addRigidBody(o.btBody);
-	objects.push_back(o);
+	if(!count) return;
+
+#ifdef BULLET_MT
+	printf("%u bodies, %u steps, %s\n", count, steps, pattern < 0 ? "pile" : Stress::pattern_names[pattern]);
+#else
+	printf("%u bodies, %u steps, %s - built without BULLET_MT, only the sync is threaded\n", count, steps, pattern < 0 ? "pile" : Stress::pattern_names[pattern]);
+#endif
+
+	// without a pattern, a box of spheres and cubes, eight layers deep, dropped onto the floor
+	const float spacing = 1.1f;
+	int side = std::max(1, (int)ceil(sqrt(count / 8.0)));
+	float half = side * spacing / 2.0f + 0.5f;
+
+	const unsigned int thread_counts[] = {1, 2, 4, 8};
+	for(unsigned int threads : thread_counts) {
+
+		if(threads > ThreadPool::MaxThreads()) break;
+		ThreadPool::SetThreads(threads);
+
+		World world;
+		world.Initialize();
+		world.btWorld->setGravity(btVector3(0, -10, 0));
+
+		std::vector<btCollisionShape*> shapes;
+		std::vector<btRigidBody*> bodies;
+		std::vector<btDefaultMotionState*> states;
+
+		if(pattern >= 0) {
+			world.StartStress((Stress::Pattern)pattern, count, false);
+		} else {
+
+			shapes = {
+				new btStaticPlaneShape(btVector3(0, 1, 0), 0),
+				new btStaticPlaneShape(btVector3(1, 0, 0), -half),
+				new btStaticPlaneShape(btVector3(-1, 0, 0), -half),
+				new btStaticPlaneShape(btVector3(0, 0, 1), -half),
+				new btStaticPlaneShape(btVector3(0, 0, -1), -half),
+				new btSphereShape(0.5f),
+				new btBoxShape(btVector3(0.45f, 0.45f, 0.45f))
+			};
+
+			auto add = [&](btCollisionShape* shape, btScalar mass, const btVector3& pos) {
+
+				btVector3 inertia(0, 0, 0);
+				shape->calculateLocalInertia(mass, inertia);
+
+				btDefaultMotionState* state = new btDefaultMotionState(btTransform(btQuaternion(0, 0, 0, 1), pos));
+				btRigidBody* body = new btRigidBody(btRigidBody::btRigidBodyConstructionInfo(mass, state, shape, inertia));
+				if(mass > 0) {
+					body->setActivationState(DISABLE_DEACTIVATION);
+				}
+
+				world.btWorld->addRigidBody(body);
+				bodies.push_back(body);
+				states.push_back(state);
+			};
+
+			for(int w = 0; w < 5; w++) {
+				add(shapes[w], 0, btVector3(0, 0, 0));
+			}
+			for(unsigned int n = 0; n < count; n++) {
+
+				int x = n % side, z = n / side % side, y = n / (side * side);
+				// every other layer shifted so nothing stacks perfectly
+				float shift = (y % 2) * spacing * 0.3f;
+				add(shapes[5 + n % 2], 1, btVector3((x - side / 2.0f) * spacing + shift, 1.0f + y * spacing, (z - side / 2.0f) * spacing + shift));
+			}
+		}
+
+		std::vector<glm::mat4> models, rotations;
+		double step_ms = 0.0, sync_ms = 0.0;
+		StepPhases total;
+		for(unsigned int s = 0; s < steps; s++) {
+
+			if(world.stress) {
+				world.stress->Update(world.btWorld, 1000 / 60);
+			}
+
+			world.stepping = StepPhases();
+			auto start = std::chrono::high_resolution_clock::now();
+			world.btWorld->stepSimulation(1.0f / 60.0f, 1, 1.0f / 60.0f);
+			auto stepped = std::chrono::high_resolution_clock::now();
+			SyncTransforms(states, models, rotations);
+			if(world.stress) {
+				world.stress->Sync();
+			}
+			auto synced = std::chrono::high_resolution_clock::now();
+
+			step_ms += std::chrono::duration<double, std::milli>(stepped - start).count();
+			sync_ms += std::chrono::duration<double, std::milli>(synced - stepped).count();
+
+			total.broadphase += world.stepping.broadphase;
+			total.narrowphase += world.stepping.narrowphase;
+			total.solver += world.stepping.solver;
+			total.integrate += world.stepping.integrate;
+		}
+
+		printf("  %u thread%s: step %8.3f ms, sync %7.3f ms - broadphase %.3f, narrowphase %.3f, solver %.3f, integrate %.3f ms\n",
+		       threads, threads > 1 ? "s" : " ", step_ms / steps, sync_ms / steps,
+		       total.broadphase / steps, total.narrowphase / steps, total.solver / steps, total.integrate / steps);
+
+		for(unsigned int b = 0; b < bodies.size(); b++) {
+			world.btWorld->removeRigidBody(bodies[b]);
+			delete bodies[b];
+			delete states[b];
+		}
+		for(btCollisionShape* shape : shapes) {
+			delete shape;
+		}
+	}
+
+	ThreadPool::SetThreads(ThreadPool::MaxThreads());
 }
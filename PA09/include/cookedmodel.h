@@ -0,0 +1,54 @@
+#ifndef COOKEDMODEL_H
+#define COOKEDMODEL_H
+
+#include <vector>
+#include <string>
+#include "graphics_headers.h"
+
+// Preprocessed copy of a model file, written next to it as <file>.cooked
+	// header, then every mesh's interleaved vertices and indices, each blob aligned so
+	// the mapped file can be handed straight to glBufferData without going through Assimp
+class CookedModel {
+public:
+	struct SubMesh {
+
+		// point into the mapped file - valid for as long as the CookedModel is
+		const Vertex* 		vertices;
+		const unsigned int* indices;
+
+		unsigned int num_vertices;
+		unsigned int num_indices;
+		unsigned int material;
+	};
+
+	CookedModel();
+	~CookedModel();
+
+	// map the cooked copy of file, importing and cooking it first if it is missing or stale
+	bool Load(const std::string& file);
+	// import file with Assimp and (re)write its cooked copy
+	bool Cook(const std::string& file);
+
+	std::vector<SubMesh> 		meshes;
+	// diffuse texture path of each material, relative to the model, empty if it has none
+	std::vector<std::string> 	materials;
+
+	// whether the last Load was served from the cooked copy, and how long it took
+	bool from_cache;
+	double load_ms;
+
+	// Assimp post-processing every model in this project is imported with
+	static const unsigned int import_flags;
+
+private:
+	bool Map(const std::string& path);
+	bool Parse(const char* data, size_t size);
+	void Unmap();
+
+	// mmap'd cooked file, or the freshly cooked bytes if they couldn't be written out
+	void* mapped;
+	size_t mapped_size;
+	std::vector<char> buffer;
+};
+
+#endif // COOKEDMODEL_H
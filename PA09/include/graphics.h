@@ -65,7 +65,6 @@ private:
 	glm::vec3 default_ambient = glm::vec3(0.05f);
 
 	// Object rendering
-	GLuint object_VAO;
 	Shader *m_v_light_shader, *m_f_light_shader;
 };
 
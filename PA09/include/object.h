@@ -8,23 +8,27 @@
 #include <glm/glm.hpp>
 #include <glm/ext.hpp>
 #include <vector>
-#include <picojson.h>
 #include "scene.h"
+#include "scenefile.h"
 
 class Object {
 protected:
 
 	std::string name;
+	// index in the world's components, set when it is added
+	unsigned int entity = 0;
 
-	static Object* LoadJSON(std::string json);
+	static Object* Create(const SceneFile::Fields& fields);
+	static SceneFile& Reader();
 
 	virtual ~Object();
 
-	virtual void LoadJSONObj(const picojson::object& obj);
+	virtual void LoadFields(const SceneFile::Fields& fields);
 	virtual void Reset() = 0;
 	virtual bool Setup() = 0;
 
 	friend class World;
+	friend class Components;
 };
 
 class Collider : public virtual Object {
@@ -41,7 +45,7 @@ protected:
 
 	double restitution = 0.0;
 
-	virtual void LoadJSONObj(const picojson::object& obj);
+	virtual void LoadFields(const SceneFile::Fields& fields);
 	virtual bool Setup();
 	virtual void Reset();
 
@@ -59,7 +63,7 @@ protected:
 	Scene s;
 	glm::mat4 modelmx, rotmx;
 
-	virtual void LoadJSONObj(const picojson::object& obj);
+	virtual void LoadFields(const SceneFile::Fields& fields);
 	virtual bool Setup();
 
 	friend class World;
@@ -76,7 +80,7 @@ protected:
 	glm::vec3 spotlight_dir;
 	float spotlight_cutoff = 180.0f, spotlight_exp = 1.0f;
 
-	virtual void LoadJSONObj(const picojson::object& obj);
+	virtual void LoadFields(const SceneFile::Fields& fields);
 	virtual bool Setup();
 	virtual void Reset();
 
@@ -89,7 +93,7 @@ protected:
 
 	glm::vec4 plane;
 
-	virtual void LoadJSONObj(const picojson::object& obj);
+	virtual void LoadFields(const SceneFile::Fields& fields);
 	virtual bool Setup();
 
 	friend class World;
@@ -101,7 +105,7 @@ protected:
 
 	float sphere = 0.0f;
 
-	virtual void LoadJSONObj(const picojson::object& obj);
+	virtual void LoadFields(const SceneFile::Fields& fields);
 	virtual bool Setup();
 
 	friend class World;
@@ -113,7 +117,7 @@ protected:
 
 	glm::vec3 cylinder;
 
-	virtual void LoadJSONObj(const picojson::object& obj);
+	virtual void LoadFields(const SceneFile::Fields& fields);
 	virtual bool Setup();
 
 	friend class World;
@@ -125,7 +129,7 @@ protected:
 
 	glm::vec3 box;
 
-	virtual void LoadJSONObj(const picojson::object& obj);
+	virtual void LoadFields(const SceneFile::Fields& fields);
 	virtual bool Setup();
 
 	friend class World;
@@ -135,9 +139,7 @@ class Mesh : public Collider, public Renderable {
 protected:
 	virtual ~Mesh();
 
-	btTriangleMesh* btMesh = nullptr;
-
-	virtual void LoadJSONObj(const picojson::object& obj);
+	virtual void LoadFields(const SceneFile::Fields& fields);
 	virtual bool Setup();
 
 	friend class World;
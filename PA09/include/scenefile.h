@@ -0,0 +1,95 @@
+#ifndef SCENEFILE_H
+#define SCENEFILE_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <functional>
+
+// Every object in a scene, in one file. The text form is JSON:
+//
+//   {
+//     "templates": { "<name>": { <fields> }, ... },
+//     "objects": [ { <fields> }, ... ]
+//   }
+//
+// An object or template with "template": "<name>" starts out with that template's
+// fields, and its own go after them, so they win. An object with
+// "instances": [[x, y, z], ...] stands for a copy of it at each of those positions.
+// Objects are handed out one at a time as they're parsed, straight from the text,
+// with field names already turned into key numbers through a perfect hash - only
+// the templates are kept. The first load also writes everything out again, templates
+// applied, as <file>.bin, which later loads read instead for as long as the text
+// and the key list stay the same.
+class SceneFile {
+public:
+	enum Kind {
+		NUMBER,
+		STRING,
+		BOOL,
+		NUMBERS,
+		STRINGS
+	};
+
+	// one field of an object, key is its index in the key list
+	struct Field {
+		int key;
+		int kind;
+		// values in numbers for NUMBER, BOOL (0 / 1) and NUMBERS, in strings for STRINGS
+		unsigned int count;
+		float numbers[4];
+		std::string string;
+		std::vector<std::string> strings;
+	};
+	typedef std::vector<Field> Fields;
+
+	// gets each object's fields in the order they apply in, false stops the load
+	typedef std::function<bool(const Fields& fields)> Callback;
+
+	// keys are every field name an object can have, must outlive this - anything else is skipped with a warning
+	SceneFile(const char* const* keys, unsigned int num_keys);
+
+	// stream every object in path to callback, from path.bin if it's up to date, otherwise from the text - writing path.bin
+	bool Load(const std::string& path, const Callback& callback);
+	// the same, always from text, and writing the binary form to binary_path unless it's empty
+	bool LoadText(const std::string& text, const Callback& callback, const std::string& binary_path = "");
+
+	// fields of a lone object, e.g. {"type": "sphere", "shape": 0.4}, for objects made in code
+		// templates from the last Load can be used in it
+	bool ParseObject(const std::string& text, Fields& fields);
+
+	// key index of name, -1 if it isn't one
+	int Key(const char* name, size_t length) const;
+	// fields of a template from the last Load, nullptr if there isn't one called name
+	const Fields* Template(const std::string& name) const;
+
+	// what the last Load did
+	unsigned int objects = 0;
+	bool from_cache = false;
+	double load_ms = 0.0;
+
+private:
+	const char* const* keys;
+	unsigned int num_keys;
+	std::vector<size_t> key_lengths;
+
+	// perfect hash over the keys - each one hashes to its own slot with this seed
+	std::vector<int> slots;
+	unsigned int seed = 0;
+	// the binary form is only good for this exact key list
+	unsigned long long keys_hash = 0;
+	// instances replace this key's value
+	int position_key = -1;
+
+	std::map<std::string, Fields> templates;
+
+	struct Parser;
+	bool ParseFields(Parser& p, Fields& fields, std::vector<float>* instances, const char* what);
+
+	// 1 if it was read, -1 if it's missing or out of date, 0 if it went wrong after objects were handed out
+	int ReadBinary(const std::string& path, unsigned long long text_hash, const Callback& callback);
+	static void WriteFields(std::string& out, const Fields& fields);
+	static bool ReadFields(const char*& data, const char* end, Fields& fields, unsigned int num_keys);
+};
+
+#endif // SCENEFILE_H
@@ -5,6 +5,7 @@
 #include "graphics.h"
 #include "scene.h"
 #include "object.h"
+#include "components.h"
 
 class World {
 public:
@@ -15,8 +16,8 @@ public:
 	void Update(unsigned int dT);
 	void Render(ShaderInfo info);
 
-	bool LoadObjects(std::string directory);
-	bool LoadObject(std::string path);
+	bool LoadScene(std::string path);
+	bool AddObject(Object* o);
 
 	void Reset();
 	void NextSelected();
@@ -32,8 +33,11 @@ private:
 	btCollisionDispatcher* dispatcher = nullptr;
 	btSequentialImpulseConstraintSolver* solver = nullptr;
 
-	std::vector<Object*> objects;
-	Light * spotlight;
+	// every object, with its colliders, renderables and lights in arrays of their own
+	Components components;
+	Light * spotlight = nullptr;
+	// the spotlight follows it
+	Renderable* sphere = nullptr;
 	int selected = -1, ui_selected = 0;
 };
 
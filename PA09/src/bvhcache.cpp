@@ -0,0 +1,215 @@
+
+#include "bvhcache.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+
+// bump whenever the layout below changes
+static const uint32_t BVH_VERSION = 1;
+static const char BVH_MAGIC[4] = {'Q', 'B', 'V', 'H'};
+
+// serialized BVHs hold raw node arrays, so they're only good for the same Bullet on the same kind of machine
+struct BvhHeader {
+	char magic[4];
+	uint32_t version;
+	uint32_t bullet_version;
+	uint32_t pointer_size;
+	uint32_t scalar_size;
+
+	// triangles it was built from
+	uint32_t num_vertices;
+	uint32_t num_indices;
+	uint32_t bvh_size;
+	uint64_t geometry_hash;
+};
+
+// followed by bvh_size bytes of btQuantizedBvh::serializeInPlace output
+
+static_assert(sizeof(BvhHeader) == 40, "bvh header must not depend on the compiler's padding");
+
+std::map<btCollisionShape*, BvhCache::Entry> BvhCache::entries;
+unsigned int BvhCache::loaded = 0;
+unsigned int BvhCache::built = 0;
+double BvhCache::load_ms = 0.0;
+double BvhCache::build_ms = 0.0;
+size_t BvhCache::bvh_bytes = 0;
+size_t BvhCache::shared_bytes = 0;
+
+// FNV-1a over the positions and indices, everything the BVH depends on
+static uint64_t HashGeometry(const Vertex* vertices, unsigned int num_vertices, const unsigned int* indices, unsigned int num_indices) {
+
+	uint64_t hash = 14695981039346656037ull;
+
+	auto add = [&](const void* data, size_t len) {
+		const unsigned char* bytes = (const unsigned char*)data;
+		for(size_t i = 0; i < len; i++) {
+			hash = (hash ^ bytes[i]) * 1099511628211ull;
+		}
+	};
+
+	for(unsigned int i = 0; i < num_vertices; i++) {
+		add(&vertices[i].pos, sizeof(vertices[i].pos));
+	}
+	add(indices, num_indices * sizeof(unsigned int));
+
+	return hash;
+}
+
+btBvhTriangleMeshShape* BvhCache::Load(const std::string& cache_file, const Vertex* vertices, unsigned int num_vertices,
+                                       const unsigned int* indices, unsigned int num_indices) {
+
+	if(!num_indices) {
+		std::cerr << "No triangles to collide with for " << cache_file << std::endl;
+		return nullptr;
+	}
+
+	auto start = std::chrono::high_resolution_clock::now();
+
+	// bullet reads the positions out of the interleaved render vertices, stepping over the rest of each one
+	btIndexedMesh part;
+	part.m_numTriangles = num_indices / 3;
+	part.m_triangleIndexBase = (const unsigned char*)indices;
+	part.m_triangleIndexStride = 3 * sizeof(unsigned int);
+	part.m_numVertices = num_vertices;
+	part.m_vertexBase = (const unsigned char*)&vertices[0].pos;
+	part.m_vertexStride = sizeof(Vertex);
+	part.m_indexType = PHY_INTEGER;
+	part.m_vertexType = PHY_FLOAT;
+
+	Entry entry;
+	entry.array = new btTriangleIndexVertexArray();
+	entry.array->addIndexedMesh(part, PHY_INTEGER);
+	entry.buffer = nullptr;
+
+	uint64_t hash = HashGeometry(vertices, num_vertices, indices, num_indices);
+
+	btBvhTriangleMeshShape* shape = nullptr;
+	unsigned int size = 0;
+
+	if(Read(cache_file, hash, num_vertices, num_indices, entry.buffer, size)) {
+
+		// the nodes are used right where they were read, the buffer has to stay around as long as the shape
+		btOptimizedBvh* bvh = (btOptimizedBvh*)btOptimizedBvh::deSerializeInPlace(entry.buffer, size, false);
+		if(bvh) {
+			shape = new btBvhTriangleMeshShape(entry.array, true, false);
+			shape->setOptimizedBvh(bvh);
+		} else {
+			std::cerr << "Ignoring unreadable BVH cache " << cache_file << std::endl;
+			btAlignedFree(entry.buffer);
+			entry.buffer = nullptr;
+		}
+	}
+
+	double ms;
+	if(shape) {
+
+		ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+		load_ms += ms;
+		loaded++;
+
+	} else {
+
+		shape = new btBvhTriangleMeshShape(entry.array, true);
+		size = shape->getOptimizedBvh()->calculateSerializeBufferSize();
+
+		ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+		build_ms += ms;
+		built++;
+
+		if(!Write(cache_file, hash, num_vertices, num_indices, shape->getOptimizedBvh())) {
+			std::cerr << "Failed to write BVH cache " << cache_file << std::endl;
+		}
+	}
+
+	bvh_bytes += size;
+	shared_bytes += num_indices * (sizeof(btVector3) + sizeof(unsigned int));
+	entries[shape] = entry;
+
+	printf("Collision mesh %s: %u triangles, BVH %s in %.2f ms\n", cache_file.c_str(), num_indices / 3, entry.buffer ? "read from cache" : "built", ms);
+
+	return shape;
+}
+
+void BvhCache::Free(btCollisionShape* shape) {
+
+	auto i = entries.find(shape);
+	if(i == entries.end()) return;
+
+	// the shape only deletes a BVH it built itself
+	delete shape;
+	delete i->second.array;
+	if(i->second.buffer) btAlignedFree(i->second.buffer);
+
+	entries.erase(i);
+}
+
+bool BvhCache::Read(const std::string& cache_file, unsigned long long hash, unsigned int num_vertices, unsigned int num_indices, void*& buffer, unsigned int& size) {
+
+	std::ifstream fin(cache_file, std::ios::binary);
+	if(!fin.good()) return false;
+
+	BvhHeader header;
+	if(!fin.read((char*)&header, sizeof(header))) return false;
+
+	if(memcmp(header.magic, BVH_MAGIC, 4) || header.version != BVH_VERSION || header.bullet_version != BT_BULLET_VERSION ||
+	   header.pointer_size != sizeof(void*) || header.scalar_size != sizeof(btScalar)) {
+		std::cerr << "Ignoring outdated BVH cache " << cache_file << std::endl;
+		return false;
+	}
+	if(header.num_vertices != num_vertices || header.num_indices != num_indices || header.geometry_hash != hash) {
+		// the model changed since, not worth a message
+		return false;
+	}
+
+	// bullet wants its nodes 16 byte aligned
+	buffer = btAlignedAlloc(header.bvh_size, 16);
+	if(!fin.read((char*)buffer, header.bvh_size)) {
+		std::cerr << "Ignoring truncated BVH cache " << cache_file << std::endl;
+		btAlignedFree(buffer);
+		buffer = nullptr;
+		return false;
+	}
+
+	size = header.bvh_size;
+	return true;
+}
+
+bool BvhCache::Write(const std::string& cache_file, unsigned long long hash, unsigned int num_vertices, unsigned int num_indices, btOptimizedBvh* bvh) {
+
+	BvhHeader header;
+	memcpy(header.magic, BVH_MAGIC, 4);
+	header.version = BVH_VERSION;
+	header.bullet_version = BT_BULLET_VERSION;
+	header.pointer_size = sizeof(void*);
+	header.scalar_size = sizeof(btScalar);
+	header.num_vertices = num_vertices;
+	header.num_indices = num_indices;
+	header.bvh_size = bvh->calculateSerializeBufferSize();
+	header.geometry_hash = hash;
+
+	// serializing rewrites pointers in the output, so it goes to a copy, not the bvh in use
+	void* buffer = btAlignedAlloc(header.bvh_size, 16);
+	bool ok = bvh->serializeInPlace(buffer, header.bvh_size, false);
+
+	if(ok) {
+		std::ofstream fout(cache_file, std::ios::binary);
+		fout.write((const char*)&header, sizeof(header));
+		fout.write((const char*)buffer, header.bvh_size);
+		ok = fout.good();
+	}
+
+	btAlignedFree(buffer);
+	return ok;
+}
+
+void BvhCache::Report() {
+
+	if(!loaded && !built) return;
+
+	printf("Collision meshes: %u BVHs read from cache in %.1f ms, %u built in %.1f ms\n", loaded, load_ms, built, build_ms);
+	printf("  %.2f MB of BVH nodes, %.2f MB of triangles shared with the render meshes instead of copied\n", bvh_bytes / 1048576.0, shared_bytes / 1048576.0);
+}
@@ -1,5 +1,6 @@
 
 #include "engine.h"
+#include "bvhcache.h"
 
 Engine::Engine(string name, int width, int height) {
 
@@ -49,10 +50,11 @@ bool Engine::Initialize(std::vector<std::string> args) {
 		std::cerr << "The physics world failed to initialize." << std::endl;
 		return false;
 	}
-	if(!m_world->LoadObjects("../data/objects")) {
+	if(!m_world->LoadScene("../data/scene.json")) {
 		std::cerr << "Failed to load physics objects." << std::endl;
 		return false;
 	}
+	BvhCache::Report();
 
 	// Set the time
 	m_currentTimeMillis = GetCurrentTimeMillis();
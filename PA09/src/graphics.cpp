@@ -1,5 +1,6 @@
 
 #include "graphics.h"
+#include "glstate.h"
 #include <imgui.h>
 #include <stb_image.h>
 #include <SDL2/SDL.h>
@@ -74,9 +75,8 @@ Graphics::~Graphics() {
 	}
 
 	glDeleteBuffers(1, &cubemap_vbo);
-	glDeleteTextures(1, &cubemap_tex);
-	glDeleteVertexArrays(1, &cubemap_vao);
-	glDeleteVertexArrays(1, &object_VAO);
+	GLState::DeleteTexture(cubemap_tex);
+	GLState::DeleteVertexArray(cubemap_vao);
 }
 
 bool Graphics::ReloadShaders() {
@@ -202,9 +202,6 @@ bool Graphics::Initialize(int width, int height) {
 		return false;
 	}
 
-	// For OpenGL 3
-	glGenVertexArrays(1, &object_VAO);
-
 	// Init Camera
 	camera_type = CameraType::orbit;
 
@@ -219,7 +216,7 @@ bool Graphics::Initialize(int width, int height) {
 	}
 
 	//enable depth testing
-	glEnable(GL_DEPTH_TEST);
+	GLState::Enable(GL_DEPTH_TEST, true);
 	
 	return true;
 }
@@ -256,10 +253,10 @@ bool Graphics::CreateCubeMap(std::string file) {
 	glGenVertexArrays(1, &cubemap_vao);
 	glGenTextures(1, &cubemap_tex);
 
-	glBindVertexArray(cubemap_vao);
-	glBindBuffer(GL_ARRAY_BUFFER, cubemap_vbo);
-	glBindTexture(GL_TEXTURE_CUBE_MAP, cubemap_tex);
 	glActiveTexture(GL_TEXTURE0);
+	GLState::BindVertexArray(cubemap_vao);
+	glBindBuffer(GL_ARRAY_BUFFER, cubemap_vbo);
+	GLState::BindTexture(GL_TEXTURE_CUBE_MAP, cubemap_tex);
 
 	glBufferData(GL_ARRAY_BUFFER, 3 * 36 * sizeof(float), &cubemap_points, GL_STATIC_DRAW);
 	
@@ -288,7 +285,7 @@ bool Graphics::CreateCubeMap(std::string file) {
 	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 	glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
 
-	glBindVertexArray(0);
+	GLState::BindVertexArray(0);
 
 	return true;
 }
@@ -314,7 +311,10 @@ void Graphics::SetCameraDistance(float d) {
 }
 
 void Graphics::Clear() {
-	
+
+	// a frame starts here
+	GLState::ResetCounters();
+
 	glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 }
@@ -323,15 +323,14 @@ void Graphics::RenderSkybox(int w, int h) {
 
 	Camera* c = GetCamera();
 
-	glDepthMask(GL_FALSE);
-	glBindVertexArray(cubemap_vao);
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_CUBE_MAP, cubemap_tex);
+	GLState::DepthMask(false);
+	GLState::BindVertexArray(cubemap_vao);
+	GLState::BindTexture(GL_TEXTURE_CUBE_MAP, cubemap_tex);
 	m_cubemap_shader->Enable();
 	glUniformMatrix4fv(m_cubemap_shader->GetUniformLocation("proj"), 1, GL_FALSE, glm::value_ptr(c->GetProjection(w, h))); 
 	glUniformMatrix4fv(m_cubemap_shader->GetUniformLocation("view"), 1, GL_FALSE, glm::value_ptr(c->GetViewWithoutTranslate())); 
 	glDrawArrays(GL_TRIANGLES, 0, 36);
-	glDepthMask(GL_TRUE);
+	GLState::DepthMask(true);
 }
 
 ShaderInfo Graphics::BeginObjectRender(int w, int h) {
@@ -340,8 +339,6 @@ ShaderInfo Graphics::BeginObjectRender(int w, int h) {
 
 	ShaderInfo m;
 	m.default_ambient = default_ambient;
-	
-	glBindVertexArray(object_VAO);
 
 	if(light_type == LightingType::vertex) {
 		m_v_light_shader->Enable();
@@ -390,6 +387,9 @@ void Graphics::UI() {
 		ImGui::SliderFloat("B", &default_ambient.z, 0.0f, 1.0f);
 		ImGui::Unindent();
 	}
+
+	ImGui::Separator();
+	ImGui::Text("GL state changes: %u (%u skipped)", GLState::last_changes, GLState::last_skipped);
 }
 
 void Graphics::EndRender() {
@@ -1,33 +1,60 @@
-
 #include "object.h"
+#include "bvhcache.h"
+
+// every field an object can have, looked up once per field through the scene file's perfect hash
+enum ObjectKey {
+	KEY_TYPE,
+	KEY_NAME,
+	KEY_SHAPE,
+
+	KEY_MASS,
+	KEY_POSITION,
+	KEY_VELOCITY,
+	KEY_RESTITUTION,
+
+	KEY_MODEL,
+	KEY_TEXTURE,
+	KEY_SPECULAR,
+	KEY_DIFFUSE,
+	KEY_AMBIENT,
+	KEY_SHINE,
+
+	KEY_DIFFUSE_COLOR,
+	KEY_SPECULAR_COLOR,
+	KEY_CONSTANT_ATTEN,
+	KEY_LINEAR_ATTEN,
+	KEY_QUAD_ATTEN,
+	KEY_SPOTLIGHT_DIR,
+	KEY_SPOTLIGHT_CUTOFF,
+	KEY_SPOTLIGHT_EXP,
+
+	KEY_COUNT
+};
+
+static const char* key_names[KEY_COUNT] = {
+	"type", "name", "shape",
+	"mass", "position", "velocity", "restitution",
+	"model", "texture", "specular", "diffuse", "ambient", "shine",
+	"diffuse_color", "specular_color", "constant_atten", "linear_atten", "quad_atten", "spotlight_dir", "spotlight_cutoff", "spotlight_exp"
+};
+
+#define stringfield(key, name) case key: if(f.kind == SceneFile::STRING) name = f.string; break;
+#define floatfield(key, name) case key: if(f.kind == SceneFile::NUMBER) name = f.numbers[0]; break;
+#define vec3field(key, name) case key: if(f.kind == SceneFile::NUMBERS && f.count >= 3) for(int n = 0; n < 3; n++) name[n] = f.numbers[n]; break;
+#define vec4field(key, name) case key: if(f.kind == SceneFile::NUMBERS && f.count >= 4) for(int n = 0; n < 4; n++) name[n] = f.numbers[n]; break;
+
+SceneFile& Object::Reader() {
+
+	static SceneFile reader(key_names, KEY_COUNT);
+	return reader;
+}
 
-#define stringfield(name) if(i.first == #name && i.second.is<std::string>()) name = i.second.get<std::string>();
-#define floatfield(name) if(i.first == #name && i.second.is<double>()) name = i.second.get<double>();
-#define vec3field(name) if(i.first == #name && i.second.is<picojson::array>()) { const auto& array = i.second.get<picojson::array>(); for(int i = 0; i < 3; i++) if(array[i].is<double>()) name[i] = array[i].get<double>();}
-#define vec4field(name) if(i.first == #name && i.second.is<picojson::array>()) { const auto& array = i.second.get<picojson::array>(); for(int i = 0; i < 4; i++) if(array[i].is<double>()) name[i] = array[i].get<double>();}
-#define boolfield(name) if(i.first == #name && i.second.is<bool>()) name = i.second.get<bool>();
-
-Object* Object::LoadJSON(std::string json) {
-
-	picojson::value v;
-	std::string err = picojson::parse(v, json);
-
-	if (!err.empty()) {
-  		std::cerr << err << std::endl;
-  		return nullptr;
-	}
-
-	if (!v.is<picojson::object>()) {
-		std::cerr << "JSON is not an object" << std::endl;
-		return nullptr;
-	}
-
-	const auto& obj = v.get<picojson::object>();
+Object* Object::Create(const SceneFile::Fields& fields) {
 
 	Object* ret = nullptr;
-	for(auto& i : obj) {
-		if(i.first == "type" && i.second.is<std::string>()) {
-			std::string type = i.second.get<std::string>();
+	for(auto& f : fields) {
+		if(f.key == KEY_TYPE && f.kind == SceneFile::STRING) {
+			const std::string& type = f.string;
 			if(type == "plane") {
 				ret = new Plane;
 			} else if(type == "sphere") {
@@ -45,141 +72,129 @@ Object* Object::LoadJSON(std::string json) {
 	}
 	if(!ret) return ret;
 
-	ret->LoadJSONObj(obj);
-	ret->Setup();
+	ret->LoadFields(fields);
 	return ret;
 }
 
-void Object::LoadJSONObj(const picojson::object& obj) {
+void Object::LoadFields(const SceneFile::Fields& fields) {
 
-	for(auto& i : obj) {
+	for(auto& f : fields) {
+		switch(f.key) {
 
-		stringfield(name);
+			stringfield(KEY_NAME, name)
+		}
 	}
 }
 
-void Collider::LoadJSONObj(const picojson::object& obj) {
+void Collider::LoadFields(const SceneFile::Fields& fields) {
 
-	Object::LoadJSONObj(obj);
+	Object::LoadFields(fields);
 
-	for(auto& i : obj) {
+	for(auto& f : fields) {
+		switch(f.key) {
 
-		floatfield(mass);
-		
-		vec3field(position);
-		vec3field(velocity);
-		floatfield(restitution);
+			floatfield(KEY_MASS, mass)
+
+			vec3field(KEY_POSITION, position)
+			vec3field(KEY_VELOCITY, velocity)
+			floatfield(KEY_RESTITUTION, restitution)
+		}
 	}
 }
 
-void Renderable::LoadJSONObj(const picojson::object& obj) {
+void Renderable::LoadFields(const SceneFile::Fields& fields) {
 
-	Object::LoadJSONObj(obj);
+	Object::LoadFields(fields);
 
-	for(auto& i : obj) {
+	for(auto& f : fields) {
+		switch(f.key) {
 
-		stringfield(model);
-		stringfield(texture);
+			stringfield(KEY_MODEL, model)
+			stringfield(KEY_TEXTURE, texture)
 
-		vec3field(specular);
-		vec3field(diffuse);
-		vec3field(ambient);
+			vec3field(KEY_SPECULAR, specular)
+			vec3field(KEY_DIFFUSE, diffuse)
+			vec3field(KEY_AMBIENT, ambient)
 
-		floatfield(shine);
+			floatfield(KEY_SHINE, shine)
+		}
 	}
 }
 
-void Light::LoadJSONObj(const picojson::object& obj) {
+void Light::LoadFields(const SceneFile::Fields& fields) {
+
+	Object::LoadFields(fields);
 
-	Object::LoadJSONObj(obj);
+	for(auto& f : fields) {
+		switch(f.key) {
 
-	for(auto& i : obj) {
+			vec4field(KEY_POSITION, position)
+			vec3field(KEY_DIFFUSE_COLOR, diffuse_color)
+			vec3field(KEY_SPECULAR_COLOR, specular_color)
 
-		vec4field(position);
-		vec3field(diffuse_color);
-		vec3field(specular_color);
-		
-		floatfield(constant_atten);
-		floatfield(linear_atten);
-		floatfield(quad_atten);
+			floatfield(KEY_CONSTANT_ATTEN, constant_atten)
+			floatfield(KEY_LINEAR_ATTEN, linear_atten)
+			floatfield(KEY_QUAD_ATTEN, quad_atten)
 
-		vec3field(spotlight_dir);
-		floatfield(spotlight_cutoff);
-		floatfield(spotlight_exp);
+			vec3field(KEY_SPOTLIGHT_DIR, spotlight_dir)
+			floatfield(KEY_SPOTLIGHT_CUTOFF, spotlight_cutoff)
+			floatfield(KEY_SPOTLIGHT_EXP, spotlight_exp)
+		}
 	}
 }
 
-void Plane::LoadJSONObj(const picojson::object& obj) {
+void Plane::LoadFields(const SceneFile::Fields& fields) {
 
-	Collider::LoadJSONObj(obj);
-	Renderable::LoadJSONObj(obj);
+	Collider::LoadFields(fields);
+	Renderable::LoadFields(fields);
 
-	for(auto& i : obj) {
-		if(i.first == "shape" && i.second.is<picojson::array>()) {
-
-			const auto& array = i.second.get<picojson::array>();
-			for(int i = 0; i < 4; i++) {
-				if(array[i].is<double>()) {
-					plane[i] = array[i].get<double>();
-				}
-			}
+	for(auto& f : fields) {
+		switch(f.key) {
+			vec4field(KEY_SHAPE, plane)
 		}
 	}
 }
 
-void Sphere::LoadJSONObj(const picojson::object& obj) {
+void Sphere::LoadFields(const SceneFile::Fields& fields) {
 
-	Collider::LoadJSONObj(obj);
-	Renderable::LoadJSONObj(obj);
+	Collider::LoadFields(fields);
+	Renderable::LoadFields(fields);
 
-	for(auto& i : obj) {
-		if(i.first == "shape" && i.second.is<double>()) {
-
-			sphere = i.second.get<double>();
+	for(auto& f : fields) {
+		switch(f.key) {
+			floatfield(KEY_SHAPE, sphere)
 		}
 	}
 }
 
-void Cylinder::LoadJSONObj(const picojson::object& obj) {
-
-	Collider::LoadJSONObj(obj);
-	Renderable::LoadJSONObj(obj);
+void Cylinder::LoadFields(const SceneFile::Fields& fields) {
 
-	for(auto& i : obj) {
-		if(i.first == "shape" && i.second.is<picojson::array>()) {
+	Collider::LoadFields(fields);
+	Renderable::LoadFields(fields);
 
-			const auto& array = i.second.get<picojson::array>();
-			for(int i = 0; i < 3; i++) {
-				if(array[i].is<double>()) {
-					cylinder[i] = array[i].get<double>();
-				}
-			}
+	for(auto& f : fields) {
+		switch(f.key) {
+			vec3field(KEY_SHAPE, cylinder)
 		}
 	}
 }
 
-void Box::LoadJSONObj(const picojson::object& obj) {
-
-	Collider::LoadJSONObj(obj);
-	Renderable::LoadJSONObj(obj);
+void Box::LoadFields(const SceneFile::Fields& fields) {
 
-	for(auto& i : obj) {
-		if(i.first == "shape" && i.second.is<picojson::array>()) {
+	Collider::LoadFields(fields);
+	Renderable::LoadFields(fields);
 
-			const auto& array = i.second.get<picojson::array>();
-			for(int i = 0; i < 3; i++) {
-				if(array[i].is<double>()) {
-					box[i] = array[i].get<double>();
-				}
-			}
+	for(auto& f : fields) {
+		switch(f.key) {
+			vec3field(KEY_SHAPE, box)
 		}
 	}
 }
 
-void Mesh::LoadJSONObj(const picojson::object& obj) {
+void Mesh::LoadFields(const SceneFile::Fields& fields) {
 
-	Collider::LoadJSONObj(obj);
-	Renderable::LoadJSONObj(obj);
+	Collider::LoadFields(fields);
+	Renderable::LoadFields(fields);
 }
 
 bool Collider::Setup() {
@@ -259,20 +274,10 @@ bool Mesh::Setup() {
 
 	if(!Renderable::Setup()) return false;
 
-	btMesh = new btTriangleMesh();
-
+	// the collider points straight into the render mesh's arrays, which live as long as this object
 	Scene::Mesh& mesh = s.getMesh();
-
-	for(unsigned int i = 0; i < mesh.indices.size(); i += 3) {
-
-		glm::vec3 pos1 = mesh.vertices[mesh.indices[i]].pos;
-		glm::vec3 pos2 = mesh.vertices[mesh.indices[i+1]].pos;
-		glm::vec3 pos3 = mesh.vertices[mesh.indices[i+2]].pos;
-
-		btMesh->addTriangle(btVector3(pos1.x,pos1.y,pos1.z),btVector3(pos2.x,pos2.y,pos2.z),btVector3(pos3.x,pos3.y,pos3.z));
-	}
-
-	btShape = new btBvhTriangleMeshShape(btMesh, true);
+	btShape = BvhCache::Load(model + ".bvh", mesh.vertices.data(), mesh.vertices.size(), mesh.indices.data(), mesh.indices.size());
+	if(!btShape) return false;
 
 	if(!Collider::Setup()) return false;
 
@@ -321,8 +326,8 @@ Box::~Box() {
 
 Mesh::~Mesh() {
 
-	if(btMesh) delete btMesh;
-	btMesh = nullptr;
+	BvhCache::Free(btShape);
+	btShape = nullptr;
 }
 
 void Collider::Reset() {
@@ -1,29 +1,17 @@
 
 #include "world.h"
 
-#include <dirent.h>
-#include <fstream>
-#include <sys/stat.h>
 #include <imgui.h>
 #include <SDL2/SDL.h>
 
-bool isRegularFile(std::string path) {
-
-	struct stat path_stat;
-	stat(path.c_str(), &path_stat);
-	return !!S_ISREG(path_stat.st_mode);
-}
-
 World::World() {
 
 }
 
 World::~World() {
 
-	for(Object* o : objects) {
-		if(Collider* c = dynamic_cast<Collider*>(o)) {
-			btWorld->removeRigidBody(c->btBody);
-		}
+	for(Collider* c : components.colliders) {
+		btWorld->removeRigidBody(c->btBody);
 	}
 
 	if(btWorld) delete btWorld;
@@ -38,14 +26,14 @@ World::~World() {
 	solver = nullptr;
 	btWorld = nullptr;
 
-	for(Object* o : objects) {
+	for(Object* o : components.objects) {
 		delete o;
 	}
 }
 
 void World::Reset() {
 
-	for(Object* o : objects) {
+	for(Object* o : components.objects) {
 		o->Reset();
 	}
 }
@@ -74,7 +62,7 @@ void World::Update(unsigned int dT) {
 
 	if(selected > -1) {
 
-		Collider* selectedObject = dynamic_cast<Collider*>(objects[selected]);
+		Collider* selectedObject = components.colliders[components.collider[selected]];
 
 		btTransform transform;
 		selectedObject->btMotionState->getWorldTransform(transform);
@@ -102,29 +90,27 @@ void World::Update(unsigned int dT) {
 
 	}
 
-	for(Object* o : objects) {
+	for(unsigned int i = 0; i < components.bodies.size(); i++) {
 
-		Collider* c = dynamic_cast<Collider*>(o);
-		Renderable* r = dynamic_cast<Renderable*>(o);
-		if(c && r) {
+		Collider* c = components.bodies[i];
+		Renderable* r = components.meshes[i];
 
-			btTransform transform;
-			btScalar mat[16];
+		btTransform transform;
+		btScalar mat[16];
 
-			c->btMotionState->getWorldTransform(transform);
-			transform.getOpenGLMatrix(mat);
-			r->modelmx = glm::make_mat4(mat);
+		c->btMotionState->getWorldTransform(transform);
+		transform.getOpenGLMatrix(mat);
+		r->modelmx = glm::make_mat4(mat);
 
-			btQuaternion q = transform.getRotation();
-			glm::quat quat(q.w(),q.x(),q.y(),q.z());
-			r->rotmx = glm::mat4(quat);
+		btQuaternion q = transform.getRotation();
+		glm::quat quat(q.w(),q.x(),q.y(),q.z());
+		r->rotmx = glm::mat4(quat);
+	}
 
-			if(o->name == "Sphere") {
-				glm::vec3 position = glm::vec3(r->modelmx[3]);
-				position.y = spotlight->position.y;
-				spotlight->position = glm::vec4(position, 1);
-			}
-		}
+	if(sphere && spotlight) {
+		glm::vec3 position = glm::vec3(sphere->modelmx[3]);
+		position.y = spotlight->position.y;
+		spotlight->position = glm::vec4(position, 1);
 	}
 }
 
@@ -147,48 +133,47 @@ void World::Render(ShaderInfo info) {
 	obj_shine_loc = info.shader->GetUniformLocation("object.shine");
 
 	int num_lights = 0;
-	for(Object* o : objects) {
+	for(Light* p : components.lights) {
 		if(num_lights >= 16) break;
 
-		if(Light* p = dynamic_cast<Light*>(o)) {
-
-			std::string light = "lights[" + std::to_string(num_lights) + "].";
+		std::string light = "lights[" + std::to_string(num_lights) + "].";
 
-			glUniform4fv(info.shader->GetUniformLocation((light + "pos").c_str()), 1, glm::value_ptr(p->position));
-			glUniform3fv(info.shader->GetUniformLocation((light + "diffuse_color").c_str()), 1, glm::value_ptr(p->diffuse_color));
-			glUniform3fv(info.shader->GetUniformLocation((light + "specular_color").c_str()), 1, glm::value_ptr(p->specular_color));
-			glUniform1f(info.shader->GetUniformLocation((light + "constant_attenuation").c_str()), p->constant_atten);
-			glUniform1f(info.shader->GetUniformLocation((light + "linear_attenuation").c_str()), p->linear_atten);
-			glUniform1f(info.shader->GetUniformLocation((light + "quadratic_attenuation").c_str()), p->quad_atten);
-			glUniform3fv(info.shader->GetUniformLocation((light + "spotlight_direction").c_str()), 1, glm::value_ptr(p->spotlight_dir));
-			glUniform1f(info.shader->GetUniformLocation((light + "spotlight_cutoff").c_str()), p->spotlight_cutoff);
-			glUniform1f(info.shader->GetUniformLocation((light + "spotlight_exponent").c_str()), p->spotlight_exp);
+		glUniform4fv(info.shader->GetUniformLocation((light + "pos").c_str()), 1, glm::value_ptr(p->position));
+		glUniform3fv(info.shader->GetUniformLocation((light + "diffuse_color").c_str()), 1, glm::value_ptr(p->diffuse_color));
+		glUniform3fv(info.shader->GetUniformLocation((light + "specular_color").c_str()), 1, glm::value_ptr(p->specular_color));
+		glUniform1f(info.shader->GetUniformLocation((light + "constant_attenuation").c_str()), p->constant_atten);
+		glUniform1f(info.shader->GetUniformLocation((light + "linear_attenuation").c_str()), p->linear_atten);
+		glUniform1f(info.shader->GetUniformLocation((light + "quadratic_attenuation").c_str()), p->quad_atten);
+		glUniform3fv(info.shader->GetUniformLocation((light + "spotlight_direction").c_str()), 1, glm::value_ptr(p->spotlight_dir));
+		glUniform1f(info.shader->GetUniformLocation((light + "spotlight_cutoff").c_str()), p->spotlight_cutoff);
+		glUniform1f(info.shader->GetUniformLocation((light + "spotlight_exponent").c_str()), p->spotlight_exp);
 
-			num_lights++;
-		}
+		num_lights++;
 	}
 	glUniform1i(num_lights_loc, num_lights);
 
-	for(Object* o : objects) {
+	Renderable* selected_r = nullptr;
+	if(selected != -1 && components.renderable[selected] >= 0) {
+		selected_r = components.renderables[components.renderable[selected]];
+	}
 
-		if(Renderable* r = dynamic_cast<Renderable*>(o)) {
+	for(Renderable* r : components.renderables) {
 
-			static float selected_ambient[] = {0.3f, 0.3f, 0.3f};
+		static float selected_ambient[] = {0.3f, 0.3f, 0.3f};
 
-			if(selected != -1 && o == objects[selected]) {
-				glUniform3fv(ambient_color_loc, 1, selected_ambient);
-			} else {
-				glUniform3fv(ambient_color_loc, 1, glm::value_ptr(info.default_ambient));
-			}
+		if(r == selected_r) {
+			glUniform3fv(ambient_color_loc, 1, selected_ambient);
+		} else {
+			glUniform3fv(ambient_color_loc, 1, glm::value_ptr(info.default_ambient));
+		}
 
-			glUniform3fv(obj_ambient_loc, 1, glm::value_ptr(r->ambient));
-			glUniform3fv(obj_diffuse_loc, 1, glm::value_ptr(r->diffuse));
-			glUniform3fv(obj_specular_loc, 1, glm::value_ptr(r->specular));
-			glUniform1f(obj_shine_loc, r->shine);
-			glUniformMatrix4fv(model_loc, 1, GL_FALSE, glm::value_ptr(r->modelmx));
+		glUniform3fv(obj_ambient_loc, 1, glm::value_ptr(r->ambient));
+		glUniform3fv(obj_diffuse_loc, 1, glm::value_ptr(r->diffuse));
+		glUniform3fv(obj_specular_loc, 1, glm::value_ptr(r->specular));
+		glUniform1f(obj_shine_loc, r->shine);
+		glUniformMatrix4fv(model_loc, 1, GL_FALSE, glm::value_ptr(r->modelmx));
 
-			r->s.Render();
-		}
+		r->s.Render();
 	}
 }
 
@@ -197,29 +182,30 @@ void World::UI() {
 	int ui_idx = 1;
 	std::vector<const char*> available({"None"});
 
-	for(unsigned int i = 0; i < objects.size(); i++) {
+	for(unsigned int i = 0; i < components.Size(); i++) {
 		if((int)i == selected) {
 			ui_selected = ui_idx;
 		}
-		if(Collider* c = dynamic_cast<Collider*>(objects[i])) {
-			if(c->mass > 0) {
+		if(components.collider[i] >= 0) {
+			if(components.colliders[components.collider[i]]->mass > 0) {
 				ui_idx++;
-				available.push_back(objects[i]->name.c_str());
+				available.push_back(components.objects[i]->name.c_str());
 			}
 		}
 	}
 
 	if(ImGui::CollapsingHeader("Object Properties")) {
-		int idx = 0;
 		ImGui::Indent();
-		for(Object* o : objects) {
+		for(unsigned int idx = 0; idx < components.Size(); idx++) {
+			Object* o = components.objects[idx];
+			int ri = components.renderable[idx], li = components.light[idx];
 			ImGui::PushID(idx);
-			idx++;
 
 			if(ImGui::CollapsingHeader(o->name.c_str())) {
 				ImGui::Indent();
 
-				if(Renderable* r = dynamic_cast<Renderable*>(o)) {
+				if(ri >= 0) {
+					Renderable* r = components.renderables[ri];
 
 					ImGui::Text("Model: %s", r->model.c_str());
 					ImGui::Text("Texture: %s", r->texture.c_str());
@@ -253,7 +239,8 @@ void World::UI() {
 					ImGui::SliderFloat("Shine", &r->shine, 0.1f, 20.0f);
 				}
 
-				if(Light* l = dynamic_cast<Light*>(o)) {
+				if(li >= 0) {
+					Light* l = components.lights[li];
 					if(ImGui::CollapsingHeader("Position")) {
 						ImGui::PushID(0);
 						ImGui::Indent();
@@ -321,8 +308,8 @@ void World::UI() {
 
 	if(!ui_selected) selected = -1;
 
-	for(unsigned int i = 0; i < objects.size(); i++) {
-		if(objects[i]->name == available[ui_selected]) {
+	for(unsigned int i = 0; i < components.Size(); i++) {
+		if(components.objects[i]->name == available[ui_selected]) {
 			selected = i;
 		}
 	}
@@ -330,9 +317,9 @@ void World::UI() {
 
 void World::NextSelected() {
 
-	for(int i = (selected + 1) % objects.size(); i != selected; ++i %= objects.size()) {
-		if(Collider* c = dynamic_cast<Collider*>(objects[i])) {
-			if(c->mass > 0) {
+	for(int i = (selected + 1) % components.Size(); i != selected; ++i %= components.Size()) {
+		if(components.collider[i] >= 0) {
+			if(components.colliders[components.collider[i]]->mass > 0) {
 				selected = i;
 				break;
 			}
@@ -340,70 +327,49 @@ void World::NextSelected() {
 	}
 }
 
-bool World::LoadObjects(std::string dir) {
+bool World::LoadScene(std::string path) {
 
-	DIR *directory;
-	dirent *entry;
-	std::string dirPath = dir;
+	unsigned int index = 0;
+	bool ok = Object::Reader().Load(path, [&](const SceneFile::Fields& fields) {
 
-	if (dirPath.back() != '/' && dirPath.back() != '\\') {
-		dirPath.append("/");
-	}
+		Object* o = Object::Create(fields);
+		if(!o || !AddObject(o)) {
+			std::cerr << "Failed to load object " << index << " from " << path << std::endl;
+			delete o;
+		}
+		index++;
+		return true;
+	});
 
-	directory = opendir(dirPath.c_str());
-	if (!directory) {
-		std::cerr << "Failed to open directory at " << dirPath << std::endl;
+	if(!ok) {
+		std::cerr << "Failed to load scene " << path << std::endl;
 		return false;
 	}
 
-	while((entry = readdir(directory))) {
-		std::string entryName = entry->d_name;
-
-		if(entryName != ".." && entryName != "." && isRegularFile(dirPath + entryName)) {
-
-			std::cout << "Loading object "<< entryName << std::endl;
-			if(!LoadObject(dirPath + entryName)) {
-				std::cerr << "Failed to load object from file " << entryName << std::endl;
-			}
-		}
-	}
-
-	closedir(directory);
+	const SceneFile& reader = Object::Reader();
+	printf("Scene %s: %u objects %s in %.2f ms\n", path.c_str(), reader.objects, reader.from_cache ? "read compiled" : "parsed", reader.load_ms);
 
 	return true;
 }
 
-bool World::LoadObject(std::string path) {
-
-	std::string contents;
-	std::ifstream fin(path);
-	getline(fin, contents, '\0');
+bool World::AddObject(Object* o) {
 
-	Object* o = Object::LoadJSON(contents);
-	if(!o) {
-		printf("Failed to load object from JSON\n");
+	if(!o->Setup()) {
 		return false;
 	}
 
-	if(!o->Setup()) {
-		return false;
+	unsigned int id = components.Add(o);
+	int ci = components.collider[id], ri = components.renderable[id], li = components.light[id];
+
+	if(ci >= 0) {
+		btWorld->addRigidBody(components.colliders[ci]->btBody);
 	}
 
-	if(Collider* c = dynamic_cast<Collider*>(o)) {
-		btWorld->addRigidBody(c->btBody);
+	if(o->name == "Spot Light" && li >= 0) {
+		spotlight = components.lights[li];
 	}
-	objects.push_back(o);
-
-<<<<<<< HEAD
-  if(o->name == "Spot Light") {
-    Light * l = dynamic_cast<Light*>(o);
-    spotlight = l;
-  }
-=======
-	if(o->name == "Spot Light") {
-		Light * l = dynamic_cast<Light*>(o);
-		spotlight = l;
+	if(o->name == "Sphere" && ri >= 0) {
+		sphere = components.renderables[ri];
 	}
->>>>>>> 235e2e86dbe6c169f55070955ad7dafbd12b2716
 	return true;
 }
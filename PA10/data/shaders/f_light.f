@@ -19,15 +19,12 @@ struct light {
 uniform light lights[MAX_LIGHTS];
 uniform int num_lights;
 
-struct material {
-	vec3 ambient, diffuse, specular;
-	float shine;
-};
-uniform material object;
+flat in vec3 f_ambient, f_diffuse, f_specular;
+flat in float f_shine;
 
 uniform vec3 ambient_color;
 uniform sampler2D tex;
-uniform mat4 model, view, proj;
+uniform mat4 view, proj;
 
 void main() {
 
@@ -36,7 +33,7 @@ void main() {
 	vec3 light_dir;
 	float attenuation;
 
-	vec3 ambient = ambient_color * object.ambient;
+	vec3 ambient = ambient_color * f_ambient;
 	vec3 diffuse = vec3(0), specular = vec3(0);
 
 	for(int i = 0; i < num_lights; i++) {
@@ -69,11 +66,11 @@ void main() {
 			}
 		}
 
-		diffuse += attenuation * object.diffuse * lights[i].diffuse_color * max(0.0, dot(norm_dir, light_dir));
+		diffuse += attenuation * f_diffuse * lights[i].diffuse_color * max(0.0, dot(norm_dir, light_dir));
 		if(dot(norm_dir, light_dir) > 0.0) {								// is the face on the right side to face the light?
 
-			float highlight = pow(max(0.0, dot(reflect(-light_dir, norm_dir), view_dir)), object.shine);
-			specular += attenuation * lights[i].specular_color * object.specular * highlight;
+			float highlight = pow(max(0.0, dot(reflect(-light_dir, norm_dir), view_dir)), f_shine);
+			specular += attenuation * lights[i].specular_color * f_specular * highlight;
 		}
 	}
 
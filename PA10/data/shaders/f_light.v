@@ -5,17 +5,32 @@ layout (location = 0) in vec3 v_pos;
 layout (location = 1) in vec3 v_norm;
 layout (location = 2) in vec2 v_texcood;
 
+// per-instance model matrix and material
+layout (location = 3) in mat4 i_model;
+layout (location = 7) in vec3 i_ambient;
+layout (location = 8) in vec3 i_diffuse;
+layout (location = 9) in vec3 i_specular;
+layout (location = 10) in float i_shine;
+
 smooth out vec2 f_texcoord;
 smooth out vec3 f_norm;
 smooth out vec4 f_pos;
 
-uniform mat4 model, view, proj;
+// material, the same across the whole instance
+flat out vec3 f_ambient, f_diffuse, f_specular;
+flat out float f_shine;
+
+uniform mat4 view, proj;
 
 void main() {
 
 	f_texcoord = v_texcood;
-	f_norm = normalize(inverse(transpose(mat3(model))) * v_norm);
-	f_pos = model * vec4(v_pos, 1.0);
+	f_norm = normalize(inverse(transpose(mat3(i_model))) * v_norm);
+	f_pos = i_model * vec4(v_pos, 1.0);
+	f_ambient = i_ambient;
+	f_diffuse = i_diffuse;
+	f_specular = i_specular;
+	f_shine = i_shine;
 
-	gl_Position = proj * view * model * vec4(v_pos, 1.0);
+	gl_Position = proj * view * f_pos;
 }
@@ -5,6 +5,13 @@ layout (location = 0) in vec3 v_pos;
 layout (location = 1) in vec3 v_norm;
 layout (location = 2) in vec2 v_texcood;
 
+// per-instance model matrix and material
+layout (location = 3) in mat4 i_model;
+layout (location = 7) in vec3 i_ambient;
+layout (location = 8) in vec3 i_diffuse;
+layout (location = 9) in vec3 i_specular;
+layout (location = 10) in float i_shine;
+
 smooth out vec4 f_lighting;
 smooth out vec2 f_texcoord;
 
@@ -20,28 +27,22 @@ struct light {
 uniform light lights[MAX_LIGHTS];
 uniform int num_lights;
 
-struct material {
-	vec3 ambient, diffuse, specular;
-	float shine;
-};
-uniform material object;
-
 uniform vec3 ambient_color;
 uniform sampler2D tex;
-uniform mat4 model, view, proj;
+uniform mat4 view, proj;
 
 void main() {
 
-	vec4 pos = model * vec4(v_pos, 1.0);
+	vec4 pos = i_model * vec4(v_pos, 1.0);
 	gl_Position = proj * view * pos;
 	f_texcoord = v_texcood;
 
-	vec3 norm_dir = normalize(inverse(transpose(mat3(model))) * v_norm);
+	vec3 norm_dir = normalize(inverse(transpose(mat3(i_model))) * v_norm);
 	vec3 view_dir = normalize(vec3(inverse(view) * vec4(0,0,0,1) - pos)); // get direction to camera (0,0,0)
 	vec3 light_dir;
 	float attenuation;
 
-	vec3 ambient = ambient_color * object.ambient;
+	vec3 ambient = ambient_color * i_ambient;
 	vec3 diffuse = vec3(0), specular = vec3(0);
 
 	for(int i = 0; i < num_lights; i++) {
@@ -74,11 +75,11 @@ void main() {
 			}
 		}
 
-		diffuse += attenuation * object.diffuse * lights[i].diffuse_color * max(0.0, dot(norm_dir, light_dir));
+		diffuse += attenuation * i_diffuse * lights[i].diffuse_color * max(0.0, dot(norm_dir, light_dir));
 		if(dot(norm_dir, light_dir) >= 0.0) {								// is the face on the right side to face the light?
 
-			float highlight = pow(max(0.0, dot(reflect(-light_dir, norm_dir), view_dir)), object.shine);
-			specular += attenuation * lights[i].specular_color * object.specular * highlight;
+			float highlight = pow(max(0.0, dot(reflect(-light_dir, norm_dir), view_dir)), i_shine);
+			specular += attenuation * lights[i].specular_color * i_specular * highlight;
 		}
 	}
 
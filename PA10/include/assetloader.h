@@ -0,0 +1,68 @@
+#ifndef ASSETLOADER_H
+#define ASSETLOADER_H
+
+#include <deque>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <functional>
+#include <condition_variable>
+
+#include "graphics_headers.h"
+
+// Background asset loading. File reads, model imports and image decodes run on a
+// pool of worker threads; the GL half of each load is handed back to the render
+// thread and drained a few milliseconds per frame, so the first frame doesn't
+// wait on the disk and the scene fills in as assets arrive.
+class AssetLoader {
+public:
+	struct Task {
+
+		enum State { QUEUED, READING, READ, DONE };
+
+		// worker thread, then render thread
+		std::function<void()> read, upload;
+		State state;
+	};
+
+	// start the worker pool and create the placeholder texture - needs the GL context
+	static void Start();
+	// drop everything that hasn't finished and join the workers - before the GL context goes away
+	static void Stop();
+
+	// run read on a worker, then upload on the render thread from Update or Wait
+	static std::shared_ptr<Task> Load(std::function<void()> read, std::function<void()> upload);
+	// run fn(0) .. fn(count - 1) on the workers and the calling thread, returns once all are done
+	static void ParallelFor(unsigned int count, std::function<void(unsigned int)> fn);
+
+	// run finished loads' uploads until budget_ms is used, always at least one
+	static void Update(double budget_ms);
+	// block until task has been read and uploaded
+	static void Wait(const std::shared_ptr<Task>& task);
+	// block until everything loaded so far has been read and uploaded
+	static void Finish();
+	// nothing waiting to be read or uploaded
+	static bool Idle();
+
+	// 1x1 grey texture drawn in place of textures that are still loading
+	static GLuint placeholder;
+	// GL upload time allowed per frame
+	static double frame_budget_ms;
+
+private:
+	static void Worker();
+	static void Upload(const std::shared_ptr<Task>& task);
+
+	static std::vector<std::thread> workers;
+	static std::deque<std::shared_ptr<Task>> queued, ready;
+	// ParallelFor's helpers, taken ahead of queued and not counted in outstanding
+	static std::deque<std::function<void()>> jobs;
+	static std::mutex lock;
+	// workers wait on jobs and queued, everyone else on ready / finished reads
+	static std::condition_variable work_cv, ready_cv;
+	static unsigned int outstanding;
+	static bool stopping;
+};
+
+#endif // ASSETLOADER_H
@@ -0,0 +1,89 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <vector>
+#include <string>
+#include <chrono>
+
+#include "graphics_headers.h"
+
+// Frame-throughput benchmark for headless runs
+class Benchmark {
+public:
+	Benchmark();
+	~Benchmark();
+
+	// read --headless, --frames, --png-dir, --png-every, --instances, --balls, --objects,
+	// --simulate, --tick-rate, --replay and --record from the command-line arguments
+	void ParseArgs(const std::vector<std::string>& args);
+
+	// start timing a frame
+	void BeginFrame();
+	// wait for the GPU, record the frame, and optionally dump it as a PNG
+	void EndFrame(int w, int h);
+	// print average/p99 frame time, draw calls and GL state changes
+	void Report();
+
+	// record the physics tick that just ran, for simulation runs
+	void EndTick();
+	// print ticks per second over wall_ms, per tick step, solver and contact averages, substep and CCD totals, and bodies slept
+	void ReportTicks(double wall_ms);
+
+	// position along the scripted camera path, [0, 1)
+	float Progress();
+	// whether the requested number of frames has been rendered
+	bool Done();
+
+	bool headless = false;
+	int frames = 600;
+	int png_every = 0;
+	std::string png_dir;
+	// extra copies of the ball to draw, for stress testing the renderer
+	int instances = 0;
+	// extra balls to simulate, for stress testing the physics and contact handling
+	int balls = 0;
+	// extra static objects to load, for timing the per object work with lots of them
+	int objects = 0;
+	// seconds of physics to run as fast as possible without rendering, 0 to render as usual
+	int simulate = 0;
+	// physics ticks per second, 0 to keep the world's default
+	unsigned int tick_rate = 0;
+	// recording to play the inputs from, and where to write one of this run
+	std::string replay_path, record_path;
+
+	// incremented by every glDraw* call made while rendering a frame
+	static unsigned int draw_calls;
+	// set by the world each frame - time in stepSimulation and handling its contact events
+	static double physics_ms, contacts_ms;
+	// the constraint solver's share of physics_ms
+	static double solver_ms;
+	// and in the loops over every object, syncing bodies and queueing instances
+	static double objects_ms;
+	static unsigned int contact_events;
+	// contact points in every manifold after the step
+	static unsigned int contact_points;
+	// substeps the tick was split into, moves CCD cut short, and balls that ended up outside the table anyway
+	static unsigned int substeps, ccd_hits, escapes;
+	// moving bodies simulated and resting after the step
+	static unsigned int awake, asleep;
+
+private:
+	// write an RGBA framebuffer to disk, flipped to top-down row order
+	bool WritePNG(std::string path, int w, int h, const std::vector<unsigned char>& rgba);
+
+	int frame = 0;
+	std::chrono::high_resolution_clock::time_point frame_start;
+
+	std::vector<double> frame_times;
+	std::vector<unsigned int> frame_draw_calls;
+	std::vector<unsigned int> frame_state_changes;
+	std::vector<double> frame_physics_ms, frame_contacts_ms, frame_objects_ms;
+	std::vector<unsigned int> frame_contact_events;
+
+	std::vector<double> tick_physics_ms, tick_solver_ms, tick_contacts_ms;
+	std::vector<unsigned int> tick_contact_points, tick_contact_events;
+	std::vector<unsigned int> tick_substeps, tick_ccd_hits, tick_escapes;
+	std::vector<unsigned int> tick_awake, tick_asleep;
+};
+
+#endif // BENCHMARK_H
@@ -0,0 +1,35 @@
+#ifndef COMPONENTS_H
+#define COMPONENTS_H
+
+#include <vector>
+#include "object.h"
+
+// Every object's facets in arrays of their own. An object is cast once when it
+// is added, so the per frame loops walk only the colliders, renderables or
+// lights they need instead of casting every object to find out what it is.
+// An object's entity id is its index in objects, and every facet array is in
+// entity order.
+class Components {
+public:
+	// store o and sort out its facets, returns its entity id
+	unsigned int Add(Object* o);
+	// forget every object, without deleting them
+	void Clear();
+	unsigned int Size() const;
+
+	std::vector<Object*> objects;
+
+	std::vector<Collider*> colliders;
+	std::vector<Renderable*> renderables;
+	std::vector<Light*> lights;
+
+	// objects that are both, the ones whose transform comes from bullet
+		// bodies[i] and meshes[i] are the same object
+	std::vector<Collider*> bodies;
+	std::vector<Renderable*> meshes;
+
+	// entity id to index in each facet array, -1 for objects without it
+	std::vector<int> collider, renderable, light;
+};
+
+#endif // COMPONENTS_H
@@ -0,0 +1,46 @@
+#ifndef CONTACTS_H
+#define CONTACTS_H
+
+#include <btBulletDynamicsCommon.h>
+
+class Object;
+
+// two objects starting or stopping touching, reported to a
+struct ContactEvent {
+	bool begin;
+	Object *a, *b;
+};
+
+// Turns Bullet's contact started / ended callbacks into events in a ring buffer,
+// read by the game logic after each step instead of scanning every manifold.
+// Only pairs where one object's contacts mask has the other's tag are queued, once
+// for each side that asked. Every manifold from every substep of a frame lands in
+// the same buffer, so begin and end can both show up for one pair in one frame.
+class Contacts {
+public:
+	// hook the callbacks and the tag based pair filter into world, and empty the buffer
+		// the callbacks are global, so only one world can be installed at a time
+	static void Install(btDynamicsWorld* world);
+	static void Uninstall(btDynamicsWorld* world);
+
+	// oldest event first, false once the buffer is empty
+	static bool Pop(ContactEvent& event);
+	static void Clear();
+
+	// events queued since the last Clear / thrown away because the buffer was full
+	static unsigned int queued, dropped;
+
+private:
+	static void Push(bool begin, Object* a, Object* b);
+	// queue manifold's pair for whichever side listens for the other
+	static void Report(bool begin, btPersistentManifold* manifold);
+	static void Started(btPersistentManifold* const& manifold);
+	static void Ended(btPersistentManifold* const& manifold);
+
+	// power of two, so positions just wrap with a mask
+	static const unsigned int CAPACITY = 4096;
+	static ContactEvent events[CAPACITY];
+	static unsigned int head, tail;
+};
+
+#endif // CONTACTS_H
@@ -12,6 +12,8 @@
 #include "world.h"
 #include "text.h"
 #include "sound.h"
+#include "benchmark.h"
+#include "replay.h"
 
 class Engine {
 
@@ -22,7 +24,12 @@ public:
 	// setup all systems, args are the command-line arguments
 	bool Initialize(std::vector<std::string> args);
 	// run the game loop
-	void Run();
+		// false if a replay played back differently from how it was recorded
+	bool Run();
+	// render a scripted, fixed-timestep run offscreen and report frame timings
+	void RunHeadless();
+	// step the physics only, as fast as it goes, and report tick timings and a state hash a second
+	void RunSimulation();
 	// process SDL events
 	void Events();
 	
@@ -32,6 +39,9 @@ public:
   
 private:
 
+	// simulate and render a single frame over dT
+	void Frame(unsigned int dT);
+
 	// process SDL keyboard events
 	void KeyboardEvts();
 	// process SDL mouse events
@@ -53,6 +63,9 @@ private:
 
 	// Physics 
 	World* m_world;
+	// inputs being recorded or played back, if there's a --record / --replay
+	Replay m_replay;
+	bool m_replaying;
 
 	// Sound
 	Sound* m_sound;
@@ -62,8 +75,13 @@ private:
 	Text *m_text;
 	
 	// Timing
+	Benchmark m_benchmark;
 	unsigned int m_DT;
 	long long m_currentTimeMillis;
+	long long m_startTimeMillis;
+	// frames rendered, and whether assets are still streaming in
+	unsigned int m_frames;
+	bool m_loading;
 	bool m_running;
 };
 
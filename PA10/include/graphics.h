@@ -24,8 +24,8 @@ public:
 	Graphics();
 	~Graphics();
 
-	// setup openGL
-	bool Initialize(int width, int height);
+	// setup openGL - headless renders into an offscreen framebuffer instead of the window
+	bool Initialize(int width, int height, bool headless = false);
 	
 	// update camera simulation
 	void Update(unsigned int dt);
@@ -52,6 +52,8 @@ public:
 	glm::mat4 GetProj();
 	// set the window width & height
 	void UpdateWH(int w, int h);
+	// place the camera along the scripted benchmark path, t in [0, 1)
+	void FollowCameraPath(float t);
 
 private:
 	// get a pointer to the current camera (orbit_camrea, free_camera, or tracking_camera)
@@ -59,6 +61,11 @@ private:
 
 	int w, h;
 
+	// offscreen render target for headless mode
+	bool CreateOffscreenTarget();
+	bool headless = false;
+	GLuint offscreen_fbo = 0, offscreen_color = 0, offscreen_depth = 0;
+
 	// cubemap
 	bool CreateCubeMap(std::string file);
 	GLuint cubemap_tex, cubemap_vbo, cubemap_vao;
@@ -74,7 +81,6 @@ private:
 	glm::vec3 default_ambient = glm::vec3(0.1f);
 
 	// Object rendering
-	GLuint object_VAO;
 	Shader *m_v_light_shader, *m_f_light_shader;
 };
 
@@ -0,0 +1,44 @@
+#ifndef INSTANCER_H
+#define INSTANCER_H
+
+#include <vector>
+#include "scene.h"
+
+// Collects everything drawn with the object shaders over a frame and draws each
+// mesh / texture pair once with glDrawElementsInstanced, its model matrices and
+// materials streamed through one shared instance buffer. The shader is the same
+// for every object in a pass, so it is not part of the key.
+class Instancer {
+public:
+	// queue one copy of scene's model + texture, drawn at the next Flush
+		// scenes whose mesh hasn't loaded yet are skipped
+	static void Add(Scene& scene, const Scene::Instance& instance);
+	// upload everything queued and draw it, then start over
+		// with batching off every instance gets a draw of its own, for comparison
+	static void Flush();
+
+	static bool batching;
+
+	// draws and instances in the last Flush
+	static unsigned int last_draws, last_instances;
+
+private:
+	struct Batch {
+
+		Scene::Mesh* mesh;
+		Scene::Texture* texture;
+		// the first scene queued with this pair, drawn on behalf of all of them
+		Scene* scene;
+		std::vector<Scene::Instance> instances;
+	};
+
+	// only the first used entries are live, the rest keep their capacity for the next frame
+	static std::vector<Batch> batches;
+	static unsigned int used;
+
+	// instance buffer, grown to fit the largest frame so far
+	static GLuint buffer;
+	static size_t capacity;
+};
+
+#endif // INSTANCER_H
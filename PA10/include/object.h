@@ -8,27 +8,51 @@
 #include <glm/glm.hpp>
 #include <glm/ext.hpp>
 #include <vector>
-#include <picojson.h>
 #include "scene.h"
+#include "scenefile.h"
+
+// what an object is to the game logic - each is one bit of a contacts / collides mask
+enum ObjectTag {
+	TAG_NONE,
+	TAG_BALL,
+	TAG_SURFACE,
+	TAG_WALL,
+	TAG_FLIPPER,
+	TAG_BUMPER,
+	TAG_POP_BUMPER,
+	TAG_RESET
+};
 
 class Object {
 protected:
 
 	std::string name;
 
-	// set up parameters from a json string
+	int tag = TAG_NONE;
+	// tags this object gets contact events for, none by default
+	int contacts = 0;
+	// index in the world's components, set when it is added
+	unsigned int entity = 0;
+
+	// set up parameters from a json string, one object's fields - templates from the last scene loaded can be used
 	static Object* LoadJSON(std::string json);
+	// the object of fields' type, set up from them - nullptr if it has no type that exists
+	static Object* Create(const SceneFile::Fields& fields);
+	// reads scene files with every key an object can have
+	static SceneFile& Reader();
 
 	virtual ~Object();
 
-	// load paramters from a json object
-	virtual void LoadJSONObj(const picojson::object& obj);
+	// load paramters from a scene file object
+	virtual void LoadFields(const SceneFile::Fields& fields);
 	// reset to default parameters
 	virtual void Reset() = 0;
 	// do any neccesary set up - e.g. bullet shapes
 	virtual bool Setup() = 0;
 
 	friend class World;
+	friend class Contacts;
+	friend class Components;
 	friend void CheckCollisions(btDynamicsWorld *btWorld, btScalar timeStep);
 };
 
@@ -45,9 +69,17 @@ protected:
 	glm::vec3 position, velocity;
 
 	float restitution = 0.0;
-
-	// load paramters from a json object
-	virtual void LoadJSONObj(const picojson::object& obj);
+	// tags this object's body collides with, everything by default
+	int collides = ~0;
+	// continuous collision - swept sphere radius, and how far it has to move in a step before it's swept, 0 for off
+	float ccd_radius = 0.0f, ccd_threshold = 0.0f;
+	// falls asleep once slower than these for a couple of seconds, a negative sleep_linear keeps it awake
+	float sleep_linear = 0.8f, sleep_angular = 1.0f;
+	// moved by the game setting its transform rather than by forces, like the flippers
+	bool kinematic = false;
+
+	// load paramters from a scene file object
+	virtual void LoadFields(const SceneFile::Fields& fields);
 	// set up bullet shape, motion, and body
 	virtual bool Setup();
 	// reset position & velocity
@@ -70,8 +102,8 @@ protected:
 	Scene s;
 	glm::mat4 modelmx, rotmx;
 
-	// load paramters from a json object
-	virtual void LoadJSONObj(const picojson::object& obj);
+	// load paramters from a scene file object
+	virtual void LoadFields(const SceneFile::Fields& fields);
 	// set up scene, model, texture for rendering
 	virtual bool Setup();
 
@@ -89,8 +121,8 @@ protected:
 	glm::vec3 spotlight_dir;
 	float spotlight_cutoff = 180.0f, spotlight_exp = 1.0f;
 
-	// load paramters from a json object
-	virtual void LoadJSONObj(const picojson::object& obj);
+	// load paramters from a scene file object
+	virtual void LoadFields(const SceneFile::Fields& fields);
 	// useless
 	virtual bool Setup();
 	// reset to default parameters
@@ -105,8 +137,8 @@ protected:
 
 	glm::vec4 plane;
 
-	// load paramters from a json object
-	virtual void LoadJSONObj(const picojson::object& obj);
+	// load paramters from a scene file object
+	virtual void LoadFields(const SceneFile::Fields& fields);
 	virtual bool Setup();
 
 	friend class World;
@@ -118,8 +150,8 @@ protected:
 
 	float sphere = 0.0f;
 
-	// load paramters from a json object
-	virtual void LoadJSONObj(const picojson::object& obj);
+	// load paramters from a scene file object
+	virtual void LoadFields(const SceneFile::Fields& fields);
 	// set up collider/renderable info
 	virtual bool Setup();
 
@@ -132,8 +164,8 @@ protected:
 
 	glm::vec3 cylinder;
 
-	// load paramters from a json object
-	virtual void LoadJSONObj(const picojson::object& obj);
+	// load paramters from a scene file object
+	virtual void LoadFields(const SceneFile::Fields& fields);
 	// set up collider/renderable info
 	virtual bool Setup();
 
@@ -146,8 +178,8 @@ protected:
 
 	glm::vec3 box;
 
-	// load paramters from a json object
-	virtual void LoadJSONObj(const picojson::object& obj);
+	// load paramters from a scene file object
+	virtual void LoadFields(const SceneFile::Fields& fields);
 	// set up collider/renderable info
 	virtual bool Setup();
 
@@ -158,10 +190,8 @@ class Mesh : public Collider, public Renderable {
 protected:
 	virtual ~Mesh();
 
-	btTriangleMesh* btMesh = nullptr;
-
-	// load paramters from a json object
-	virtual void LoadJSONObj(const picojson::object& obj);
+	// load paramters from a scene file object
+	virtual void LoadFields(const SceneFile::Fields& fields);
 	// set up collider/renderable info
 	virtual bool Setup();
 
@@ -0,0 +1,59 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <string>
+#include <vector>
+
+// the game's inputs, everything a recording has to play back
+enum ReplayInput {
+	INPUT_LEFT,
+	INPUT_RIGHT,
+	INPUT_LAUNCH,
+	INPUT_POWER_UP,
+	INPUT_POWER_DOWN
+};
+
+// A recorded game: every input with the physics tick it was applied before, and a
+// hash of the world's state once a second. Playing one back feeds the same inputs
+// in on the same ticks, and comparing hashes shows where the simulation stopped
+// doing exactly what it did when it was recorded.
+class Replay {
+public:
+	struct Event {
+		unsigned int tick;
+		int input;
+		bool down;
+	};
+
+	// read a recording written by Save, a "rate" line then one "input" or "hash" line each
+	bool Load(std::string path);
+	bool Save(std::string path);
+
+	// start playing from the first tick again / throw everything recorded away
+	void Rewind();
+	void Clear();
+
+	void Record(unsigned int tick, int input, bool down);
+	// next input due on tick, false once there are none left for it
+		// ticks have to be asked for in order
+	bool Next(unsigned int tick, Event& event);
+
+	// recording - store hash for tick, playing - compare it with the stored one
+		// false the first time they don't match
+	bool Hash(unsigned int tick, unsigned int hash);
+
+	bool recording = false;
+	// physics ticks per second it was recorded at, the ticks in it mean nothing at any other rate
+	unsigned int rate = 120;
+	// the tick a played back run first hashed differently, 0 if it never did
+	unsigned int diverged = 0;
+	// hashes compared so far while playing
+	unsigned int checked = 0;
+
+private:
+	std::vector<Event> events;
+	std::vector<std::pair<unsigned int, unsigned int>> hashes;
+	unsigned int next_event = 0, next_hash = 0;
+};
+
+#endif // REPLAY_H
@@ -3,45 +3,96 @@
 #define MESH_H
 
 #include <vector>
+#include <memory>
 #include "graphics_headers.h"
+#include "assetloader.h"
 
 class Scene {
 public:
 	struct Mesh {
 
-		GLuint VBO, IBO;
+		Mesh();
+		~Mesh();
+
+		// VAO holds the buffer bindings and attribute layout, configured once at load
+		GLuint VAO, VBO, IBO;
 
 		std::vector<Vertex> 		vertices;
 		std::vector<unsigned int> 	indices; 
+
+		// background load filling this mesh in
+		std::shared_ptr<AssetLoader::Task> pending;
 	};
 
 	struct Texture {
 
+		Texture();
+		~Texture();
+
 		GLuint handle;
+		// GPU memory including the mip chain
+		size_t bytes;
+	};
+
+	// per-instance attributes read by the object shaders (locations 3 - 10)
+	struct Instance {
+
+		glm::mat4 model;
+		glm::vec3 ambient, diffuse, specular;
+		float shine;
 	};
 
 	Scene();
 	~Scene();
 
 	// load model mesh from file - loads only first mesh
+		// shared with every other scene that loaded the same file and index
+		// loads in the background, nothing is drawn until it arrives
 	bool LoadModel(std::string file, int idx);
 	// load texture from file to be associated with mesh
+		// shared with every other scene that loaded the same file
+		// loads in the background, a grey placeholder is drawn until it arrives
 	bool LoadTexture(std::string file);
+	// block until the mesh has arrived, false if it failed to load
+	bool WaitForMesh();
+	// whether LoadModel / LoadTexture have been given something that exists
+	bool HasMesh() const { return mesh != nullptr; }
+	bool HasTexture() const { return texture != nullptr; }
 
-	// render the scene (model + texture)
-		// setup the model matrix BEFOREHAND
-	void Render();
-	// free mesh asset
+	// render count copies of the scene (model + texture)
+		// their Instance data is read from buffer starting at offset
+	void RenderInstances(GLuint buffer, size_t offset, GLsizei count);
+	// release this scene's reference to its mesh
 	void DeleteMesh();
-	// free texture asset
+	// release this scene's reference to its texture
 	void DeleteTexture();
 	// get reference to mesh representation
 	Mesh& getMesh();
 
 private:
+	friend class AssetCache;
+	friend class Instancer;
+
+	// decoded RGBA8 pixels waiting to be uploaded
+	struct Image {
+
+		Image();
+		~Image();
+
+		int w, h;
+		unsigned char* pixels;
+	};
+
+	// only called by AssetCache on a miss
+		// read from disk into the CPU-side arrays / pixels, safe on any thread
+	static bool ReadMesh(const std::string& file, int idx, Mesh& mesh);
+	static bool ReadTexture(const std::string& file, Image& image);
+		// create the GL objects, render thread only
+	static void UploadMesh(Mesh& mesh);
+	static void UploadTexture(Texture& texture, const Image& image);
 
-	Mesh mesh;
-	Texture texture;
+	std::shared_ptr<Mesh> mesh;
+	std::shared_ptr<Texture> texture;
 };
 
 #endif // MESH_H
@@ -0,0 +1,44 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <btBulletDynamicsCommon.h>
+#include <vector>
+
+// Everything that changes while the table is being played, copied out of the
+// world by World::Save and back in by World::Restore. Static bodies never move,
+// so only the others are stored, in the order they were added. The arrays keep
+// their size between saves, so saving into the same snapshot again is a straight
+// copy with nothing allocated.
+struct Snapshot {
+
+	struct Body {
+		btScalar basis[9], origin[3];
+		btScalar linear[3], angular[3];
+		btScalar deactivation;
+		int activation;
+	};
+
+	std::vector<Body> bodies;
+	// each constraint's impulse from the last step, the solver warm starts from it
+		// the hinges work out their angle and limits from the bodies each step, there's nothing else to keep
+	std::vector<btScalar> constraints;
+
+	// entity and cooldown of every lit up bumper
+	std::vector<std::pair<unsigned int, int>> boosted;
+	// entity of each ball and the last thing it hit
+	std::vector<std::pair<unsigned int, unsigned int>> last_hit;
+
+	int score = 0, lives = 0, power = 0;
+	bool playing = false, reset = false, gameover = false;
+	bool left_held = false, right_held = false;
+	float left_angle = 0.0f, right_angle = 0.0f;
+	unsigned int tick = 0;
+
+	// memory the snapshot uses
+	size_t Bytes() const {
+		return sizeof(Snapshot) + bodies.capacity() * sizeof(Body) + constraints.capacity() * sizeof(btScalar)
+		     + boosted.capacity() * sizeof(boosted[0]) + last_hit.capacity() * sizeof(last_hit[0]);
+	}
+};
+
+#endif // SNAPSHOT_H
@@ -7,58 +7,149 @@
 #include "object.h"
 #include "text.h"
 #include "sound.h"
+#include "components.h"
+#include "replay.h"
+#include "snapshot.h"
+#include <map>
 #include <SDL2/SDL.h>
 
+class TimedSolver;
+
 class World {
 public:
+	// physics ticks per second, every tick is the same length so a run can be replayed exactly
+		// set before creating a world, --tick-rate
+	static unsigned int tick_rate;
+	// most substeps a fast moving body can split a tick into
+	static const unsigned int MAX_SUBSTEPS = 8;
+
 	World();
 	~World();
 
 	// set up bullet world
 	bool Initialize(Sound* sound);
-	// simulate over dT
+	// simulate over dT, as however many ticks fit in it
 	void Update(unsigned int dT);
+	// apply the inputs due and simulate a single tick
+		// in as many substeps as keep the fastest body from moving further than the smallest CCD radius in one
+	void Step();
+	// hash of every body's transform and velocity, the score and the lives
+	unsigned int StateHash();
 	// render objects
 	void Render(ShaderInfo info);
 
-	// load objects from directory
-	bool LoadObjects(std::string directory);
-	// load single object
-	bool LoadObject(std::string path);
+	// load every object in a scene file, see SceneFile
+		// models and textures arrive in the background
+	bool LoadScene(std::string path);
+	// set up a parsed object and add it to the world
+	bool AddObject(Object* o);
 
 	// reset all objects
 	void Reset();
+
+	// copy the state of every moving body, the constraints and the game into snapshot
+	void Save(Snapshot& snapshot);
+	// put it all back, false if the snapshot came from a world with different bodies
+		// contact points aren't kept, so contacts are found again from scratch on the next step
+	bool Restore(const Snapshot& snapshot);
+	// go back to the last whole second, and a second further each time after that
+	void Rewind();
+	// time Save and Restore on a world of count spheres and print the results, needs no window
+	static void SnapshotBenchmark(unsigned int count, unsigned int repeats = 100);
+	// time ticks of count spheres resting on a floor, once with them kept awake and once left to sleep
+	static void SleepBenchmark(unsigned int count, unsigned int ticks = 600);
+	// time loading a scene of count objects from text and from its compiled form, against a picojson parse of the same
+	static void SceneBenchmark(unsigned int count);
 	// process keyboard events
 	void KeyboardEvts(SDL_Event e);
+	// press or release one of the game's inputs, before the next tick
+	void Input(int input, bool down);
+	// record every input and a hash a second into replay, or play them back from it
+		// the world only holds on to replay, nullptr to stop
+	void SetReplay(Replay* replay);
 
 	// display UI options
 	void UI(Text* t);
 
+	// draw count extra copies of the ball alongside the table, to measure the renderer
+	void Stress(unsigned int count);
+	// add count more simulated balls over the playfield, to measure physics and contact handling
+		// they roll down the table and start over from where they were dropped when they drain
+	void Multiball(unsigned int count);
+	// add count static objects under the table, to measure the per object work with lots of them loaded
+	void Clutter(unsigned int count);
+
 private:
 
 	// game logic info
 	int score = 0, lives = 3, power = 0;
 	bool playing = false, reset = true, gameover = false;
+	// flipper buttons held down, and how far each flipper has turned
+	bool left_held = false, right_held = false;
+	float left_angle = 0.0f, right_angle = 0.0f;
+
+	// ticks simulated, and the time left over from the last Update that didn't make a whole one
+	unsigned int tick = 0;
+	double tick_time = 0.0;
+	Replay* replay = nullptr;
 
 	// bullet info
 	btDiscreteDynamicsWorld* btWorld = nullptr;
 	btBroadphaseInterface* broadphase = nullptr;
 	btDefaultCollisionConfiguration* collisionConfiguration = nullptr;
 	btCollisionDispatcher* dispatcher = nullptr;
-	btSequentialImpulseConstraintSolver* solver = nullptr;
+	TimedSolver* solver = nullptr;
 
-	// object store
-	std::vector<Object*> objects;
+	// every object, with its colliders, renderables and lights in arrays of their own
+	Components components;
+	// colliders that aren't static, the ones a snapshot has to store
+	std::vector<Collider*> moving;
+	// smallest swept sphere of any moving body, how far one substep may move things - 0 with no CCD bodies
+	float max_travel = 0.0f;
+	// around the table's surfaces and walls, a ball outside it went through something
+	btVector3 table_min, table_max;
+	bool has_table = false;
+
+	// a snapshot every second for Rewind, oldest overwritten first
+	static const unsigned int HISTORY = 5;
+	Snapshot history[HISTORY];
+	unsigned int history_head = 0, history_size = 0;
 	
 	// specific game objects
 	Collider *leftFlipper = nullptr, *rightFlipper = nullptr;
 	Renderable* ball_r = nullptr;
 	Collider*   ball_c = nullptr;
 	Light* spotlight = nullptr;
-	btHingeConstraint *leftHinge = nullptr, *rightHinge = nullptr;
+
+	// render-only instances added by Stress
+	Renderable* stress_source = nullptr;
+	std::vector<Scene::Instance> stress;
+
+	// lit up by a hit, until their cooldown runs out
+	std::vector<Renderable*> boosted;
+	// the last thing each ball hit that wasn't a surface, bumpers only score when it changes
+	std::map<Object*, Object*> last_hit;
+
+	// stats from the last Update, shown in the menu
+	double physics_ms = 0.0, contacts_ms = 0.0, objects_ms = 0.0, solver_ms = 0.0;
+	unsigned int contact_events = 0, contacts_dropped = 0, contact_points = 0, ticks = 0;
+	// substeps run, moves CCD cut short, and balls found outside the table, over the last Update
+	unsigned int substeps = 0, ccd_hits = 0, escapes = 0;
+	// moving bodies simulated and resting after the last tick
+	unsigned int awake = 0, asleep = 0;
 
 	// process collisions for game logic
 	void CheckCollisions(unsigned int dT);
+	// turn the flippers up or back down over dt, depending on whether they're held
+	void MoveFlippers(float dt);
+	// move a kinematic flipper angle towards target at speed, and put its body there
+	void SwingFlipper(Collider* flipper, float& angle, float target, float speed, float dt);
+	// wake anything touching body, it's about to be pushed
+	void Wake(btRigidBody* body);
+	// a floor and count spheres on it, for the benchmarks
+	static bool AddSpheres(World& world, unsigned int count, const std::string& sphere);
+	// what an input does to the game, whether it came from the keyboard or a replay
+	void Press(int input, bool down);
 	Sound* m_sound = nullptr;
 };
 
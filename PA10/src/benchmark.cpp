@@ -0,0 +1,300 @@
+
+#include "benchmark.h"
+#include "glstate.h"
+
+#include <algorithm>
+#include <fstream>
+#include <cstdio>
+#include <cstdlib>
+
+unsigned int Benchmark::draw_calls = 0;
+double Benchmark::physics_ms = 0.0;
+double Benchmark::contacts_ms = 0.0;
+double Benchmark::solver_ms = 0.0;
+double Benchmark::objects_ms = 0.0;
+unsigned int Benchmark::contact_events = 0;
+unsigned int Benchmark::contact_points = 0;
+unsigned int Benchmark::substeps = 0;
+unsigned int Benchmark::ccd_hits = 0;
+unsigned int Benchmark::escapes = 0;
+unsigned int Benchmark::awake = 0;
+unsigned int Benchmark::asleep = 0;
+
+Benchmark::Benchmark() {}
+
+Benchmark::~Benchmark() {}
+
+void Benchmark::ParseArgs(const std::vector<std::string>& args) {
+
+	for(unsigned int i = 0; i < args.size(); i++) {
+
+		if(args[i] == "--headless") {
+			headless = true;
+		} else if(args[i] == "--frames" && i + 1 < args.size()) {
+			frames = std::max(1, atoi(args[++i].c_str()));
+		} else if(args[i] == "--png-dir" && i + 1 < args.size()) {
+			png_dir = args[++i];
+			if(png_dir.back() != '/' && png_dir.back() != '\\') {
+				png_dir.append("/");
+			}
+			if(!png_every) png_every = 1;
+		} else if(args[i] == "--png-every" && i + 1 < args.size()) {
+			png_every = std::max(1, atoi(args[++i].c_str()));
+		} else if(args[i] == "--instances" && i + 1 < args.size()) {
+			instances = std::max(0, atoi(args[++i].c_str()));
+		} else if(args[i] == "--balls" && i + 1 < args.size()) {
+			balls = std::max(0, atoi(args[++i].c_str()));
+		} else if(args[i] == "--objects" && i + 1 < args.size()) {
+			objects = std::max(0, atoi(args[++i].c_str()));
+		} else if(args[i] == "--simulate" && i + 1 < args.size()) {
+			// still needs the offscreen context, the mesh colliders come from models loaded through the renderer
+			simulate = std::max(1, atoi(args[++i].c_str()));
+			headless = true;
+		} else if(args[i] == "--tick-rate" && i + 1 < args.size()) {
+			tick_rate = std::max(1, atoi(args[++i].c_str()));
+		} else if(args[i] == "--replay" && i + 1 < args.size()) {
+			replay_path = args[++i];
+		} else if(args[i] == "--record" && i + 1 < args.size()) {
+			record_path = args[++i];
+		}
+	}
+
+	frame_times.reserve(frames);
+	frame_draw_calls.reserve(frames);
+	frame_state_changes.reserve(frames);
+	frame_physics_ms.reserve(frames);
+	frame_contacts_ms.reserve(frames);
+	frame_objects_ms.reserve(frames);
+	frame_contact_events.reserve(frames);
+}
+
+float Benchmark::Progress() {
+
+	return (float)frame / (float)frames;
+}
+
+bool Benchmark::Done() {
+
+	return frame >= frames;
+}
+
+void Benchmark::BeginFrame() {
+
+	draw_calls = 0;
+	frame_start = std::chrono::high_resolution_clock::now();
+}
+
+void Benchmark::EndFrame(int w, int h) {
+
+	// make sure the frame has actually been rendered before stopping the clock
+	glFinish();
+
+	auto frame_end = std::chrono::high_resolution_clock::now();
+	frame_times.push_back(std::chrono::duration<double, std::milli>(frame_end - frame_start).count());
+	frame_draw_calls.push_back(draw_calls);
+	frame_state_changes.push_back(GLState::changes);
+	frame_physics_ms.push_back(physics_ms);
+	frame_contacts_ms.push_back(contacts_ms);
+	frame_objects_ms.push_back(objects_ms);
+	frame_contact_events.push_back(contact_events);
+
+	if(png_dir.size() && png_every && frame % png_every == 0) {
+
+		std::vector<unsigned char> rgba(w * h * 4);
+		glPixelStorei(GL_PACK_ALIGNMENT, 1);
+		glReadPixels(0, 0, w, h, GL_RGBA, GL_UNSIGNED_BYTE, rgba.data());
+
+		char name[32];
+		snprintf(name, sizeof(name), "frame_%05d.png", frame);
+		if(!WritePNG(png_dir + name, w, h, rgba)) {
+			std::cerr << "Failed to write frame to " << png_dir << name << std::endl;
+		}
+	}
+
+	frame++;
+}
+
+void Benchmark::Report() {
+
+	if(frame_times.empty()) return;
+
+	std::vector<double> sorted = frame_times;
+	std::sort(sorted.begin(), sorted.end());
+
+	double total = 0.0, total_draws = 0.0, total_changes = 0.0;
+	for(double t : frame_times) total += t;
+	for(unsigned int d : frame_draw_calls) total_draws += d;
+	for(unsigned int c : frame_state_changes) total_changes += c;
+
+	double total_physics = 0.0, total_contacts = 0.0, total_events = 0.0, total_objects = 0.0;
+	for(double t : frame_physics_ms) total_physics += t;
+	for(double t : frame_contacts_ms) total_contacts += t;
+	for(unsigned int e : frame_contact_events) total_events += e;
+	for(double t : frame_objects_ms) total_objects += t;
+
+	unsigned int p99_idx = std::min((unsigned int)sorted.size() - 1, (unsigned int)(sorted.size() * 0.99));
+
+	std::cout << "Benchmark: " << frame_times.size() << " frames" << std::endl;
+	std::cout << "  avg frame time: " << total / frame_times.size() << " ms" << std::endl;
+	std::cout << "  p99 frame time: " << sorted[p99_idx] << " ms" << std::endl;
+	std::cout << "  min/max:        " << sorted.front() << " / " << sorted.back() << " ms" << std::endl;
+	std::cout << "  avg draw calls: " << total_draws / frame_draw_calls.size() << std::endl;
+	std::cout << "  avg GL state changes: " << total_changes / frame_state_changes.size() << std::endl;
+	std::cout << "  avg physics step: " << total_physics / frame_physics_ms.size() << " ms" << std::endl;
+	std::cout << "  avg contact handling: " << total_contacts / frame_contacts_ms.size() << " ms, " << total_events / frame_contact_events.size() << " events" << std::endl;
+	std::cout << "  avg object loops: " << total_objects / frame_objects_ms.size() << " ms" << std::endl;
+}
+
+void Benchmark::EndTick() {
+
+	tick_physics_ms.push_back(physics_ms);
+	tick_solver_ms.push_back(solver_ms);
+	tick_contacts_ms.push_back(contacts_ms);
+	tick_contact_points.push_back(contact_points);
+	tick_contact_events.push_back(contact_events);
+	tick_substeps.push_back(substeps);
+	tick_ccd_hits.push_back(ccd_hits);
+	tick_escapes.push_back(escapes);
+	tick_awake.push_back(awake);
+	tick_asleep.push_back(asleep);
+}
+
+void Benchmark::ReportTicks(double wall_ms) {
+
+	if(tick_physics_ms.empty()) return;
+
+	std::vector<double> sorted = tick_physics_ms;
+	std::sort(sorted.begin(), sorted.end());
+
+	double total_physics = 0.0, total_solver = 0.0, total_contacts = 0.0, total_points = 0.0, total_events = 0.0;
+	for(double t : tick_physics_ms) total_physics += t;
+	for(double t : tick_solver_ms) total_solver += t;
+	for(double t : tick_contacts_ms) total_contacts += t;
+	for(unsigned int p : tick_contact_points) total_points += p;
+	for(unsigned int e : tick_contact_events) total_events += e;
+
+	unsigned int total_substeps = 0, most_substeps = 0, total_hits = 0, total_escapes = 0;
+	for(unsigned int s : tick_substeps) {
+		total_substeps += s;
+		most_substeps = std::max(most_substeps, s);
+	}
+	for(unsigned int h : tick_ccd_hits) total_hits += h;
+	for(unsigned int e : tick_escapes) total_escapes += e;
+
+	double total_awake = 0.0, total_asleep = 0.0;
+	for(unsigned int a : tick_awake) total_awake += a;
+	for(unsigned int a : tick_asleep) total_asleep += a;
+
+	unsigned int ticks = tick_physics_ms.size();
+	unsigned int p99_idx = std::min(ticks - 1, (unsigned int)(ticks * 0.99));
+
+	std::cout << "Simulation: " << ticks << " ticks in " << wall_ms << " ms" << std::endl;
+	std::cout << "  steps/s: " << ticks * 1000.0 / wall_ms << std::endl;
+	std::cout << "  avg step: " << total_physics / ticks << " ms, p99 " << sorted[p99_idx] << " ms" << std::endl;
+	std::cout << "  avg solver: " << total_solver / ticks << " ms" << std::endl;
+	std::cout << "  avg contact handling: " << total_contacts / ticks << " ms, " << total_events / ticks << " events" << std::endl;
+	std::cout << "  avg contact points/step: " << total_points / ticks << std::endl;
+	std::cout << "  avg substeps/tick: " << (double)total_substeps / ticks << ", most " << most_substeps << std::endl;
+	std::cout << "  CCD hits: " << total_hits << ", escaped the table: " << total_escapes << std::endl;
+	std::cout << "  avg bodies awake: " << total_awake / ticks << ", asleep: " << total_asleep / ticks << std::endl;
+}
+
+static unsigned int crc32(unsigned int crc, const unsigned char* data, size_t len) {
+
+	static unsigned int table[256];
+	static bool init = false;
+
+	if(!init) {
+		for(unsigned int n = 0; n < 256; n++) {
+			unsigned int c = n;
+			for(int k = 0; k < 8; k++) {
+				c = c & 1 ? 0xedb88320u ^ (c >> 1) : c >> 1;
+			}
+			table[n] = c;
+		}
+		init = true;
+	}
+
+	crc = ~crc;
+	for(size_t i = 0; i < len; i++) {
+		crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+	}
+	return ~crc;
+}
+
+static void put32(std::vector<unsigned char>& out, unsigned int v) {
+
+	out.push_back(v >> 24);
+	out.push_back(v >> 16);
+	out.push_back(v >> 8);
+	out.push_back(v);
+}
+
+static void chunk(std::ofstream& fout, const char* type, const std::vector<unsigned char>& data) {
+
+	std::vector<unsigned char> buf;
+	put32(buf, data.size());
+	buf.insert(buf.end(), type, type + 4);
+	buf.insert(buf.end(), data.begin(), data.end());
+	put32(buf, crc32(0, buf.data() + 4, buf.size() - 4));
+
+	fout.write((const char*)buf.data(), buf.size());
+}
+
+// uncompressed (stored) deflate stream - golden images only need to be exact, not small
+bool Benchmark::WritePNG(std::string path, int w, int h, const std::vector<unsigned char>& rgba) {
+
+	std::ofstream fout(path, std::ios::binary);
+	if(!fout.good()) return false;
+
+	static const unsigned char signature[] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+	fout.write((const char*)signature, sizeof(signature));
+
+	std::vector<unsigned char> ihdr;
+	put32(ihdr, w);
+	put32(ihdr, h);
+	ihdr.push_back(8);	// bit depth
+	ihdr.push_back(6);	// RGBA
+	ihdr.push_back(0);
+	ihdr.push_back(0);
+	ihdr.push_back(0);
+	chunk(fout, "IHDR", ihdr);
+
+	// filter byte + flipped scanlines
+	size_t stride = w * 4;
+	std::vector<unsigned char> raw;
+	raw.reserve((stride + 1) * h);
+	for(int y = h - 1; y >= 0; y--) {
+		raw.push_back(0);
+		raw.insert(raw.end(), rgba.begin() + y * stride, rgba.begin() + (y + 1) * stride);
+	}
+
+	std::vector<unsigned char> idat = {0x78, 0x01};
+	unsigned int a = 1, b = 0;
+	for(size_t pos = 0; pos < raw.size() || pos == 0; ) {
+
+		size_t len = std::min(raw.size() - pos, (size_t)65535);
+		bool last = pos + len >= raw.size();
+
+		idat.push_back(last ? 1 : 0);
+		idat.push_back(len & 0xff);
+		idat.push_back(len >> 8);
+		idat.push_back(~len & 0xff);
+		idat.push_back((~len >> 8) & 0xff);
+		idat.insert(idat.end(), raw.begin() + pos, raw.begin() + pos + len);
+
+		for(size_t i = pos; i < pos + len; i++) {
+			a = (a + raw[i]) % 65521;
+			b = (b + a) % 65521;
+		}
+
+		pos += len;
+		if(last) break;
+	}
+	put32(idat, (b << 16) | a);
+	chunk(fout, "IDAT", idat);
+
+	chunk(fout, "IEND", std::vector<unsigned char>());
+
+	return fout.good();
+}
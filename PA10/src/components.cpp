@@ -0,0 +1,45 @@
+
+#include "components.h"
+
+unsigned int Components::Add(Object* o) {
+
+	unsigned int id = objects.size();
+	o->entity = id;
+	objects.push_back(o);
+
+	Collider* c = dynamic_cast<Collider*>(o);
+	Renderable* r = dynamic_cast<Renderable*>(o);
+	Light* l = dynamic_cast<Light*>(o);
+
+	collider.push_back(c ? (int)colliders.size() : -1);
+	renderable.push_back(r ? (int)renderables.size() : -1);
+	light.push_back(l ? (int)lights.size() : -1);
+
+	if(c) colliders.push_back(c);
+	if(r) renderables.push_back(r);
+	if(l) lights.push_back(l);
+
+	if(c && r) {
+		bodies.push_back(c);
+		meshes.push_back(r);
+	}
+
+	return id;
+}
+
+void Components::Clear() {
+
+	objects.clear();
+	colliders.clear();
+	renderables.clear();
+	lights.clear();
+	bodies.clear();
+	meshes.clear();
+	collider.clear();
+	renderable.clear();
+	light.clear();
+}
+
+unsigned int Components::Size() const {
+	return objects.size();
+}
@@ -0,0 +1,94 @@
+
+#include "contacts.h"
+#include "object.h"
+
+unsigned int Contacts::queued = 0;
+unsigned int Contacts::dropped = 0;
+
+ContactEvent Contacts::events[Contacts::CAPACITY];
+unsigned int Contacts::head = 0;
+unsigned int Contacts::tail = 0;
+
+// collision groups are 1 << tag and masks come from each object's collides list,
+// checked the same way bullet's default filter does - but that filter also keeps
+// static bodies from ever meeting each other, which tag bits alone can't say
+struct TagFilter : public btOverlapFilterCallback {
+
+	virtual bool needBroadphaseCollision(btBroadphaseProxy* a, btBroadphaseProxy* b) const {
+
+		if(!(a->m_collisionFilterGroup & b->m_collisionFilterMask) || !(b->m_collisionFilterGroup & a->m_collisionFilterMask)) {
+			return false;
+		}
+
+		btCollisionObject* ca = (btCollisionObject*)a->m_clientObject;
+		btCollisionObject* cb = (btCollisionObject*)b->m_clientObject;
+		return !(ca && cb && ca->isStaticObject() && cb->isStaticObject());
+	}
+};
+
+static TagFilter filter;
+
+void Contacts::Install(btDynamicsWorld* world) {
+
+	world->getPairCache()->setOverlapFilterCallback(&filter);
+	gContactStartedCallback = Started;
+	gContactEndedCallback = Ended;
+	Clear();
+}
+
+void Contacts::Uninstall(btDynamicsWorld* world) {
+
+	world->getPairCache()->setOverlapFilterCallback(nullptr);
+	gContactStartedCallback = nullptr;
+	gContactEndedCallback = nullptr;
+	Clear();
+}
+
+bool Contacts::Pop(ContactEvent& event) {
+
+	if(head == tail) return false;
+
+	event = events[tail & (CAPACITY - 1)];
+	tail++;
+	return true;
+}
+
+void Contacts::Clear() {
+
+	head = tail = 0;
+	queued = dropped = 0;
+}
+
+void Contacts::Push(bool begin, Object* a, Object* b) {
+
+	// keep what is already queued, the reader gets to it in order
+	if(head - tail >= CAPACITY) {
+		dropped++;
+		return;
+	}
+
+	ContactEvent& event = events[head & (CAPACITY - 1)];
+	event.begin = begin;
+	event.a = a;
+	event.b = b;
+	head++;
+	queued++;
+}
+
+void Contacts::Report(bool begin, btPersistentManifold* manifold) {
+
+	Object* a = (Object*)manifold->getBody0()->getUserPointer();
+	Object* b = (Object*)manifold->getBody1()->getUserPointer();
+	if(!a || !b) return;
+
+	if(a->contacts & (1 << b->tag)) Push(begin, a, b);
+	if(b->contacts & (1 << a->tag)) Push(begin, b, a);
+}
+
+void Contacts::Started(btPersistentManifold* const& manifold) {
+	Report(true, manifold);
+}
+
+void Contacts::Ended(btPersistentManifold* const& manifold) {
+	Report(false, manifold);
+}
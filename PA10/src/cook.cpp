@@ -0,0 +1,38 @@
+
+#include "cookedmodel.h"
+
+#include <chrono>
+
+// Offline model cooker - writes <model>.cooked next to each model given on the
+// command line so even the first launch skips Assimp
+int main(int argc, char **argv) {
+
+	if(argc < 2) {
+		std::cerr << "Usage: " << argv[0] << " <model> [<model> ...]" << std::endl;
+		return 1;
+	}
+
+	int failed = 0;
+	for(int i = 1; i < argc; i++) {
+
+		auto start = std::chrono::high_resolution_clock::now();
+
+		CookedModel model;
+		if(!model.Cook(argv[i])) {
+			failed++;
+			continue;
+		}
+
+		double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+		unsigned int verts = 0, tris = 0;
+		for(auto& m : model.meshes) {
+			verts += m.num_vertices;
+			tris += m.num_indices / 3;
+		}
+
+		std::cout << argv[i] << ": " << model.meshes.size() << " meshes, " << verts << " vertices, " << tris << " triangles, cooked in " << ms << " ms" << std::endl;
+	}
+
+	return failed ? 1 : 0;
+}
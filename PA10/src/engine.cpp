@@ -1,5 +1,8 @@
 
 #include "engine.h"
+#include "assetcache.h"
+#include "assetloader.h"
+#include "bvhcache.h"
 
 Engine::Engine(string name, int width, int height) {
 
@@ -16,10 +19,15 @@ Engine::Engine(string name, int width, int height) {
 	m_world = nullptr;
 	m_text = nullptr;
 	m_sound = nullptr;
+
+	m_frames = 0;
+	m_loading = true;
+	m_replaying = false;
 }
 
 Engine::~Engine() {
 
+	AssetLoader::Stop();
 	ImGui_ImplSdlGL3_Shutdown();
 	if(m_window) delete m_window;
 	if(m_graphics) delete m_graphics;
@@ -34,20 +42,52 @@ Engine::~Engine() {
 }
 
 bool Engine::Initialize(std::vector<std::string> args) {
+
+	m_startTimeMillis = GetCurrentTimeMillis();
+
+	m_benchmark.ParseArgs(args);
+
+	if(m_benchmark.replay_path.size() && m_benchmark.record_path.size()) {
+		std::cerr << "Only one of --replay and --record at a time." << std::endl;
+		return false;
+	}
+	if(m_benchmark.replay_path.size() && !m_replay.Load(m_benchmark.replay_path)) {
+		return false;
+	}
+	m_replay.recording = m_benchmark.record_path.size() > 0;
+	m_replaying = m_benchmark.replay_path.size() || m_replay.recording;
+
+	// a replay only plays back the same at the rate it was recorded at
+	if(m_benchmark.replay_path.size()) {
+		if(m_benchmark.tick_rate && m_benchmark.tick_rate != m_replay.rate) {
+			std::cerr << "Ignoring --tick-rate, the replay was recorded at " << m_replay.rate << " Hz." << std::endl;
+		}
+		World::tick_rate = m_replay.rate;
+	} else if(m_benchmark.tick_rate) {
+		World::tick_rate = m_benchmark.tick_rate;
+	}
   	
   	// Start a window
 	m_window = new Window();
-	if(!m_window->Initialize(m_WINDOW_NAME, &w, &h)) {
+	if(m_benchmark.headless) {
+		if(!m_window->InitializeHeadless(w, h)) {
+			std::cerr << "The headless context failed to initialize." << std::endl;
+			return false;
+		}
+	} else if(!m_window->Initialize(m_WINDOW_NAME, &w, &h)) {
 		std::cerr << "The window failed to initialize." << std::endl;
 		return false;
 	}
 	
 	// Start the graphics
 	m_graphics = new Graphics();
-	if(!m_graphics->Initialize(w, h)) {
+	if(!m_graphics->Initialize(w, h, m_benchmark.headless)) {
 		std::cerr << "The graphics failed to initialize." << std::endl;
 		return false;
 	}
+
+	// worker threads for reading models and textures
+	AssetLoader::Start();
 	
 	// Set up text rendering
 	m_text = new Text();
@@ -69,52 +109,143 @@ bool Engine::Initialize(std::vector<std::string> args) {
 		std::cerr << "The physics world failed to initialize." << std::endl;
 		return false;
 	}
-	if(!m_world->LoadObjects("../data/objects")) {
+	if(!m_world->LoadScene("../data/scene.json")) {
 		std::cerr << "Failed to load physics objects." << std::endl;
 		return false;
 	}
+	m_world->Stress(m_benchmark.instances);
+	m_world->Multiball(m_benchmark.balls);
+	m_world->Clutter(m_benchmark.objects);
+	if(m_replaying) m_world->SetReplay(&m_replay);
+	BvhCache::Report();
 
 	// Set the time
 	m_currentTimeMillis = GetCurrentTimeMillis();
 	
 	ImGui_ImplSdlGL3_Init(m_window->GetWindow());
 
+	std::cout << "Startup took " << m_currentTimeMillis - m_startTimeMillis << " ms" << std::endl;
+
 	// No errors
 	return true;
 }
 
-void Engine::Run() {
-	
-	m_running = true;
+bool Engine::Run() {
 
-	while(m_running) {
+	if(m_benchmark.simulate) {
+		RunSimulation();
+	} else if(m_benchmark.headless) {
+		RunHeadless();
+	} else {
 
-		ImGui_ImplSdlGL3_NewFrame(m_window->GetWindow());
+		m_running = true;
 
-		// Update the DT
-		m_DT = getDT();
-		Events();
+		while(m_running) {
 
-		ImGui::Begin("Menu", nullptr, ImGuiWindowFlags_AlwaysAutoResize);
+			ImGui_ImplSdlGL3_NewFrame(m_window->GetWindow());
 
-		m_graphics->Update(m_DT);
-		m_world->Update(m_DT);
+			// Update the DT
+			m_DT = getDT();
+			Events();
 
-		m_graphics->Clear();
-		m_graphics->RenderSkybox();
-		
-		ShaderInfo info = m_graphics->BeginObjectRender();
-		m_world->Render(info);
+			Frame(m_DT);
+			m_window->Swap();
+		}
+	}
+
+	if(m_replay.recording) {
+		m_replay.Save(m_benchmark.record_path);
+	} else if(m_replaying) {
+		if(m_replay.diverged) {
+			std::cout << "Replay diverged at tick " << m_replay.diverged << std::endl;
+			return false;
+		}
+		std::cout << "Replay matched " << m_replay.checked << " hashes" << std::endl;
+	}
+
+	return true;
+}
+
+void Engine::RunHeadless() {
+
+	ImGui::GetIO().DisplaySize = ImVec2((float)w, (float)h);
+
+	// fixed timestep so every run simulates and renders the same frames
+	const unsigned int dT = 16;
 
-		m_graphics->UI();
+	// and every frame has all of its assets
+	AssetLoader::Finish();
 
-		m_text->Begin();
-		m_world->UI(m_text);
+	while(!m_benchmark.Done()) {
 
-		m_text->End(m_graphics);
-		ImGui::End();
-		m_graphics->EndRender();
-		m_window->Swap();
+		m_benchmark.BeginFrame();
+		ImGui_ImplSdlGL3_NewFrame(nullptr);
+
+		m_graphics->FollowCameraPath(m_benchmark.Progress());
+		Frame(dT);
+
+		m_benchmark.EndFrame(w, h);
+	}
+
+	m_benchmark.Report();
+}
+
+void Engine::RunSimulation() {
+
+	// the mesh colliders already have their triangles, this is just so nothing is left uploading
+	AssetLoader::Finish();
+
+	unsigned int ticks = m_benchmark.simulate * World::tick_rate;
+	std::cout << "Simulating " << m_benchmark.simulate << " s, " << ticks << " ticks at " << World::tick_rate << " Hz" << std::endl;
+
+	auto start = std::chrono::high_resolution_clock::now();
+
+	for(unsigned int t = 1; t <= ticks; t++) {
+
+		m_world->Step();
+		m_benchmark.EndTick();
+
+		if(t % World::tick_rate == 0) {
+			printf("  %4u s  hash %08x\n", t / World::tick_rate, m_world->StateHash());
+		}
+	}
+
+	double wall_ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	m_benchmark.ReportTicks(wall_ms);
+}
+
+void Engine::Frame(unsigned int dT) {
+
+	// finish off whatever the loader threads have read since last frame
+	AssetLoader::Update(AssetLoader::frame_budget_ms);
+
+	ImGui::Begin("Menu", nullptr, ImGuiWindowFlags_AlwaysAutoResize);
+
+	m_graphics->Update(dT);
+	m_world->Update(dT);
+
+	m_graphics->Clear();
+	m_graphics->RenderSkybox();
+	
+	ShaderInfo info = m_graphics->BeginObjectRender();
+	m_world->Render(info);
+
+	m_graphics->UI();
+
+	m_text->Begin();
+	m_world->UI(m_text);
+
+	m_text->End(m_graphics);
+	ImGui::End();
+	m_graphics->EndRender();
+
+	if(!m_frames++) {
+		std::cout << "Time to first frame: " << GetCurrentTimeMillis() - m_startTimeMillis << " ms" << std::endl;
+	}
+	if(m_loading && AssetLoader::Idle()) {
+		m_loading = false;
+		std::cout << "All assets loaded after " << GetCurrentTimeMillis() - m_startTimeMillis << " ms (" << m_frames << " frames)" << std::endl;
+		AssetCache::Report();
 	}
 }
 
@@ -176,9 +307,13 @@ void Engine::KeyboardEvts() {
 			if(!m_world->Initialize(m_sound)) {
 				std::cerr << "The physics world failed to initialize." << std::endl;
 			}
-			if(!m_world->LoadObjects("../data/objects")) {
+			if(!m_world->LoadScene("../data/scene.json")) {
 				std::cerr << "Failed to load physics objects." << std::endl;
 			}
+			m_world->Stress(m_benchmark.instances);
+			m_world->Multiball(m_benchmark.balls);
+			m_world->Clutter(m_benchmark.objects);
+			if(m_replaying) m_world->SetReplay(&m_replay);
 		}
 	}
 
@@ -1,5 +1,8 @@
 
 #include "graphics.h"
+#include "benchmark.h"
+#include "glstate.h"
+#include "instancer.h"
 #include <imgui.h>
 #include <stb_image.h>
 #include <SDL2/SDL.h>
@@ -74,9 +77,14 @@ Graphics::~Graphics() {
 	}
 
 	glDeleteBuffers(1, &cubemap_vbo);
-	glDeleteTextures(1, &cubemap_tex);
-	glDeleteVertexArrays(1, &cubemap_vao);
-	glDeleteVertexArrays(1, &object_VAO);
+	GLState::DeleteTexture(cubemap_tex);
+	GLState::DeleteVertexArray(cubemap_vao);
+
+	if(offscreen_fbo) {
+		glDeleteFramebuffers(1, &offscreen_fbo);
+		glDeleteRenderbuffers(1, &offscreen_color);
+		glDeleteRenderbuffers(1, &offscreen_depth);
+	}
 }
 
 bool Graphics::ReloadShaders() {
@@ -176,13 +184,21 @@ bool Graphics::ReloadShaders() {
 	return true;
 }
 
-bool Graphics::Initialize(int width, int height) {
+bool Graphics::Initialize(int width, int height, bool _headless) {
   
 	glewExperimental = GL_TRUE;
 
 	w = width; h = height;
+	headless = _headless;
 	auto status = glewInit();
 
+#ifdef GLEW_ERROR_NO_GLX_DISPLAY
+	// an EGL context has no GLX display, but the core GL entry points are still loaded
+	if(headless && status == GLEW_ERROR_NO_GLX_DISPLAY) {
+		status = GLEW_OK;
+	}
+#endif
+
 	// This is here to grab the error that comes from glew init.
 	// This error is an GL_INVALID_ENUM that has no effects on the performance
 	glGetError();
@@ -203,8 +219,9 @@ bool Graphics::Initialize(int width, int height) {
 		return false;
 	}
 
-	// For OpenGL 3
-	glGenVertexArrays(1, &object_VAO);
+	if(headless && !CreateOffscreenTarget()) {
+		return false;
+	}
 
 	// Init Camera
 	camera_type = CameraType::orbit;
@@ -222,7 +239,7 @@ bool Graphics::Initialize(int width, int height) {
 	orbit_camera.lock = true;
 
 	//enable depth testing
-	glEnable(GL_DEPTH_TEST);
+	GLState::Enable(GL_DEPTH_TEST, true);
 	
 	return true;
 }
@@ -259,10 +276,10 @@ bool Graphics::CreateCubeMap(std::string file) {
 	glGenVertexArrays(1, &cubemap_vao);
 	glGenTextures(1, &cubemap_tex);
 
-	glBindVertexArray(cubemap_vao);
-	glBindBuffer(GL_ARRAY_BUFFER, cubemap_vbo);
-	glBindTexture(GL_TEXTURE_CUBE_MAP, cubemap_tex);
 	glActiveTexture(GL_TEXTURE0);
+	GLState::BindVertexArray(cubemap_vao);
+	glBindBuffer(GL_ARRAY_BUFFER, cubemap_vbo);
+	GLState::BindTexture(GL_TEXTURE_CUBE_MAP, cubemap_tex);
 
 	glBufferData(GL_ARRAY_BUFFER, 3 * 36 * sizeof(float), &cubemap_points, GL_STATIC_DRAW);
 	
@@ -291,11 +308,48 @@ bool Graphics::CreateCubeMap(std::string file) {
 	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 	glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
 
-	glBindVertexArray(0);
+	GLState::BindVertexArray(0);
+
+	return true;
+}
+
+bool Graphics::CreateOffscreenTarget() {
+
+	glGenFramebuffers(1, &offscreen_fbo);
+	glGenRenderbuffers(1, &offscreen_color);
+	glGenRenderbuffers(1, &offscreen_depth);
+
+	glBindRenderbuffer(GL_RENDERBUFFER, offscreen_color);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, w, h);
+	glBindRenderbuffer(GL_RENDERBUFFER, offscreen_depth);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, w, h);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, offscreen_fbo);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, offscreen_color);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, offscreen_depth);
+
+	if(glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+		std::cerr << "Offscreen framebuffer incomplete" << std::endl;
+		return false;
+	}
+
+	// everything (including reads for PNG output) goes through this framebuffer from now on
+	glViewport(0, 0, w, h);
+	glScissor(0, 0, w, h);
 
 	return true;
 }
 
+void Graphics::FollowCameraPath(float t) {
+
+	// one full orbit around the table while bobbing between a low and a high angle
+	orbit_camera.yaw = 360.0f * t;
+	orbit_camera.pitch = 45.0f + 25.0f * sin(glm::radians(720.0f * t));
+	orbit_camera.update();
+	camera_type = CameraType::orbit;
+}
+
 Camera* Graphics::GetCamera() {
 	switch(camera_type) {
 	case CameraType::orbit: 	return &orbit_camera;
@@ -317,7 +371,10 @@ void Graphics::SetCameraDistance(float d) {
 }
 
 void Graphics::Clear() {
-	
+
+	// a frame starts here
+	GLState::ResetCounters();
+
 	glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 }
@@ -343,31 +400,29 @@ void Graphics::RenderSkybox() {
 
 	Camera* c = GetCamera();
 
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-	glDepthMask(GL_FALSE);
-	glBindVertexArray(cubemap_vao);
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_CUBE_MAP, cubemap_tex);
+	GLState::BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	GLState::DepthMask(false);
+	GLState::BindVertexArray(cubemap_vao);
+	GLState::BindTexture(GL_TEXTURE_CUBE_MAP, cubemap_tex);
 	m_cubemap_shader->Enable();
 	glUniformMatrix4fv(m_cubemap_shader->GetUniformLocation("proj"), 1, GL_FALSE, glm::value_ptr(c->GetProjection(w, h))); 
 	glUniformMatrix4fv(m_cubemap_shader->GetUniformLocation("view"), 1, GL_FALSE, glm::value_ptr(c->GetViewWithoutTranslate())); 
 	glDrawArrays(GL_TRIANGLES, 0, 36);
-	glDepthMask(GL_TRUE);
+	Benchmark::draw_calls++;
+	GLState::DepthMask(true);
 }
 
 ShaderInfo Graphics::BeginObjectRender() {
 
 	Camera* c = GetCamera();
 
-	glEnable(GL_BLEND);
-	glEnable(GL_DEPTH_TEST);
-	glDepthMask(GL_TRUE);
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	GLState::Enable(GL_BLEND, true);
+	GLState::Enable(GL_DEPTH_TEST, true);
+	GLState::DepthMask(true);
+	GLState::BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
 	ShaderInfo m;
 	m.default_ambient = default_ambient;
-	
-	glBindVertexArray(object_VAO);
 
 	if(light_type == LightingType::vertex) {
 		m_v_light_shader->Enable();
@@ -417,6 +472,11 @@ void Graphics::UI() {
 		ImGui::SliderFloat("B", &default_ambient.z, 0.0f, 1.0f);
 		ImGui::Unindent();
 	}
+
+	ImGui::Separator();
+	ImGui::Checkbox("Instancing", &Instancer::batching);
+	ImGui::Text("Object draws: %u for %u instances", Instancer::last_draws, Instancer::last_instances);
+	ImGui::Text("GL state changes: %u (%u skipped)", GLState::last_changes, GLState::last_skipped);
 }
 
 void Graphics::EndRender() {
@@ -0,0 +1,90 @@
+#include "instancer.h"
+
+#include <algorithm>
+
+bool Instancer::batching = true;
+unsigned int Instancer::last_draws = 0;
+unsigned int Instancer::last_instances = 0;
+
+std::vector<Instancer::Batch> Instancer::batches;
+unsigned int Instancer::used = 0;
+
+GLuint Instancer::buffer = 0;
+size_t Instancer::capacity = 0;
+
+void Instancer::Add(Scene& scene, const Scene::Instance& instance) {
+
+	if(!scene.mesh || scene.mesh->indices.empty()) return;
+
+	Scene::Mesh* mesh = scene.mesh.get();
+	Scene::Texture* texture = scene.texture.get();
+
+	// runs of the same object are common, check the last batch before searching
+	static unsigned int last = 0;
+	if(last >= used || batches[last].mesh != mesh || batches[last].texture != texture) {
+
+		for(last = 0; last < used; last++) {
+			if(batches[last].mesh == mesh && batches[last].texture == texture) break;
+		}
+
+		if(last == used) {
+			if(used == batches.size()) batches.emplace_back();
+
+			Batch& b = batches[used++];
+			b.mesh = mesh;
+			b.texture = texture;
+			b.scene = &scene;
+			b.instances.clear();
+		}
+	}
+
+	batches[last].instances.push_back(instance);
+}
+
+void Instancer::Flush() {
+
+	size_t total = 0;
+	for(unsigned int i = 0; i < used; i++) {
+		total += batches[i].instances.size();
+	}
+
+	last_draws = 0;
+	last_instances = total;
+	if(!total) {
+		used = 0;
+		return;
+	}
+
+	if(!buffer) glGenBuffers(1, &buffer);
+	glBindBuffer(GL_ARRAY_BUFFER, buffer);
+
+	// orphan the old storage so the driver doesn't wait on last frame's draws reading it
+	size_t bytes = total * sizeof(Scene::Instance);
+	if(bytes > capacity) {
+		capacity = std::max(bytes, capacity * 2);
+	}
+	glBufferData(GL_ARRAY_BUFFER, capacity, nullptr, GL_STREAM_DRAW);
+
+	size_t offset = 0;
+	for(unsigned int i = 0; i < used; i++) {
+
+		Batch& b = batches[i];
+		size_t size = b.instances.size() * sizeof(Scene::Instance);
+		glBufferSubData(GL_ARRAY_BUFFER, offset, size, b.instances.data());
+
+		if(batching) {
+			b.scene->RenderInstances(buffer, offset, b.instances.size());
+			last_draws++;
+		} else {
+			for(size_t j = 0; j < b.instances.size(); j++) {
+				b.scene->RenderInstances(buffer, offset + j * sizeof(Scene::Instance), 1);
+			}
+			last_draws += b.instances.size();
+		}
+
+		offset += size;
+		b.instances.clear();
+	}
+
+	used = 0;
+}
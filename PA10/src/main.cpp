@@ -15,6 +15,23 @@ int main(int argc, char **argv) {
 	std::vector<std::string> args;
 	for(int i = 1; i < argc; i++) {
 		args.push_back(string(argv[i]));
+
+		// time saving and restoring the physics state of 1k and 10k bodies and quit
+		if(args.back() == "--snapshots") {
+			World::SnapshotBenchmark(1000);
+			World::SnapshotBenchmark(10000);
+			return 0;
+		}
+		// time stepping 1k resting bodies kept awake and left to sleep, and quit
+		if(args.back() == "--sleeping") {
+			World::SleepBenchmark(1000);
+			return 0;
+		}
+		// time loading a 10k object scene and quit
+		if(args.back() == "--scene-benchmark") {
+			World::SceneBenchmark(10000);
+			return 0;
+		}
 	}
 
 	Engine *engine = new Engine("PINBALL", 1280, 720);
@@ -27,10 +44,10 @@ int main(int argc, char **argv) {
 		return 1;
 	}
 
-	engine->Run();
+	bool ok = engine->Run();
 
 	delete engine;
 	engine = NULL;
 	
-	return 0;
+	return ok ? 0 : 1;
 }
@@ -1,34 +1,96 @@
-
 #include "object.h"
+#include "bvhcache.h"
+
+// every field an object can have, looked up once per field through the scene file's perfect hash
+enum ObjectKey {
+	KEY_TYPE,
+	KEY_NAME,
+	KEY_TAG,
+	KEY_CONTACTS,
+	KEY_SHAPE,
+
+	KEY_MASS,
+	KEY_POSITION,
+	KEY_VELOCITY,
+	KEY_RESTITUTION,
+	KEY_CCD_RADIUS,
+	KEY_CCD_THRESHOLD,
+	KEY_SLEEP_LINEAR,
+	KEY_SLEEP_ANGULAR,
+	KEY_KINEMATIC,
+	KEY_COLLIDES,
+
+	KEY_MODEL,
+	KEY_TEXTURE,
+	KEY_SPECULAR,
+	KEY_DIFFUSE,
+	KEY_AMBIENT,
+	KEY_SHINE,
+	KEY_SCALE,
+	KEY_MODEL_IDX,
+
+	KEY_DIFFUSE_COLOR,
+	KEY_SPECULAR_COLOR,
+	KEY_CONSTANT_ATTEN,
+	KEY_LINEAR_ATTEN,
+	KEY_QUAD_ATTEN,
+	KEY_SPOTLIGHT_DIR,
+	KEY_SPOTLIGHT_CUTOFF,
+	KEY_SPOTLIGHT_EXP,
+
+	KEY_COUNT
+};
+
+static const char* key_names[KEY_COUNT] = {
+	"type", "name", "tag", "contacts", "shape",
+	"mass", "position", "velocity", "restitution", "ccd_radius", "ccd_threshold", "sleep_linear", "sleep_angular", "kinematic", "collides",
+	"model", "texture", "specular", "diffuse", "ambient", "shine", "scale", "model_idx",
+	"diffuse_color", "specular_color", "constant_atten", "linear_atten", "quad_atten", "spotlight_dir", "spotlight_cutoff", "spotlight_exp"
+};
+
+#define stringfield(key, name) case key: if(f.kind == SceneFile::STRING) name = f.string; break;
+#define floatfield(key, name) case key: if(f.kind == SceneFile::NUMBER) name = f.numbers[0]; break;
+#define intfield(key, name) floatfield(key, name)
+#define vec3field(key, name) case key: if(f.kind == SceneFile::NUMBERS && f.count >= 3) for(int n = 0; n < 3; n++) name[n] = f.numbers[n]; break;
+#define vec4field(key, name) case key: if(f.kind == SceneFile::NUMBERS && f.count >= 4) for(int n = 0; n < 4; n++) name[n] = f.numbers[n]; break;
+#define boolfield(key, name) case key: if(f.kind == SceneFile::BOOL) name = f.numbers[0] != 0.0f; break;
+#define tagfield(key, name) case key: if(f.kind == SceneFile::STRING) name = ParseTag(f.string); break;
+#define tagsfield(key, name) case key: if(f.kind == SceneFile::STRINGS) { name = 0; for(const auto& t : f.strings) name |= 1 << ParseTag(t); } break;
+
+static int ParseTag(const std::string& tag) {
+
+	static const char* names[] = {"none", "ball", "surface", "wall", "flipper", "bumper", "pop_bumper", "reset"};
+
+	for(int t = 0; t < (int)(sizeof(names) / sizeof(names[0])); t++) {
+		if(tag == names[t]) return t;
+	}
 
-#define stringfield(name) if(i.first == #name && i.second.is<std::string>()) name = i.second.get<std::string>();
-#define floatfield(name) if(i.first == #name && i.second.is<double>()) name = i.second.get<double>();
-#define intfield(name) floatfield(name)
-#define vec3field(name) if(i.first == #name && i.second.is<picojson::array>()) { const auto& array = i.second.get<picojson::array>(); for(int i = 0; i < 3; i++) if(array[i].is<double>()) name[i] = array[i].get<double>();}
-#define vec4field(name) if(i.first == #name && i.second.is<picojson::array>()) { const auto& array = i.second.get<picojson::array>(); for(int i = 0; i < 4; i++) if(array[i].is<double>()) name[i] = array[i].get<double>();}
-#define boolfield(name) if(i.first == #name && i.second.is<bool>()) name = i.second.get<bool>();
+	std::cerr << "Unknown object tag " << tag << std::endl;
+	return TAG_NONE;
+}
 
-Object* Object::LoadJSON(std::string json) {
+SceneFile& Object::Reader() {
 
-	picojson::value v;
-	std::string err = picojson::parse(v, json);
+	static SceneFile reader(key_names, KEY_COUNT);
+	return reader;
+}
 
-	if (!err.empty()) {
-  		std::cerr << err << std::endl;
-  		return nullptr;
-	}
+Object* Object::LoadJSON(std::string json) {
 
-	if (!v.is<picojson::object>()) {
-		std::cerr << "JSON is not an object" << std::endl;
+	SceneFile::Fields fields;
+	if(!Reader().ParseObject(json, fields)) {
 		return nullptr;
 	}
 
-	const auto& obj = v.get<picojson::object>();
+	return Create(fields);
+}
+
+Object* Object::Create(const SceneFile::Fields& fields) {
 
 	Object* ret = nullptr;
-	for(auto& i : obj) {
-		if(i.first == "type" && i.second.is<std::string>()) {
-			std::string type = i.second.get<std::string>();
+	for(auto& f : fields) {
+		if(f.key == KEY_TYPE && f.kind == SceneFile::STRING) {
+			const std::string& type = f.string;
 			if(type == "plane") {
 				ret = new Plane;
 			} else if(type == "sphere") {
@@ -46,148 +108,149 @@ Object* Object::LoadJSON(std::string json) {
 	}
 	if(!ret) return ret;
 
-	ret->LoadJSONObj(obj);
-	ret->Setup();
+	ret->LoadFields(fields);
 	return ret;
 }
 
-void Object::LoadJSONObj(const picojson::object& obj) {
+void Object::LoadFields(const SceneFile::Fields& fields) {
 
-	for(auto& i : obj) {
+	for(auto& f : fields) {
+		switch(f.key) {
 
-		stringfield(name);
+			stringfield(KEY_NAME, name)
+
+			tagfield(KEY_TAG, tag)
+			tagsfield(KEY_CONTACTS, contacts)
+		}
 	}
 }
 
-void Collider::LoadJSONObj(const picojson::object& obj) {
+void Collider::LoadFields(const SceneFile::Fields& fields) {
+
+	Object::LoadFields(fields);
 
-	Object::LoadJSONObj(obj);
+	for(auto& f : fields) {
+		switch(f.key) {
 
-	for(auto& i : obj) {
+			floatfield(KEY_MASS, mass)
 
-		floatfield(mass);
-		
-		vec3field(position);
-		vec3field(velocity);
-		floatfield(restitution);
+			vec3field(KEY_POSITION, position)
+			vec3field(KEY_VELOCITY, velocity)
+			floatfield(KEY_RESTITUTION, restitution)
+			floatfield(KEY_CCD_RADIUS, ccd_radius)
+			floatfield(KEY_CCD_THRESHOLD, ccd_threshold)
+			floatfield(KEY_SLEEP_LINEAR, sleep_linear)
+			floatfield(KEY_SLEEP_ANGULAR, sleep_angular)
+			boolfield(KEY_KINEMATIC, kinematic)
+
+			tagsfield(KEY_COLLIDES, collides)
+		}
 	}
 }
 
-void Renderable::LoadJSONObj(const picojson::object& obj) {
+void Renderable::LoadFields(const SceneFile::Fields& fields) {
 
-	Object::LoadJSONObj(obj);
+	Object::LoadFields(fields);
 
-	for(auto& i : obj) {
+	for(auto& f : fields) {
+		switch(f.key) {
 
-		stringfield(model);
-		stringfield(texture);
+			stringfield(KEY_MODEL, model)
+			stringfield(KEY_TEXTURE, texture)
 
-		vec3field(specular);
-		vec3field(diffuse);
-		vec3field(ambient);
+			vec3field(KEY_SPECULAR, specular)
+			vec3field(KEY_DIFFUSE, diffuse)
+			vec3field(KEY_AMBIENT, ambient)
 
-		floatfield(shine);
-		floatfield(scale);
+			floatfield(KEY_SHINE, shine)
+			floatfield(KEY_SCALE, scale)
 
-		intfield(model_idx);
+			intfield(KEY_MODEL_IDX, model_idx)
+		}
 	}
 }
 
-void Light::LoadJSONObj(const picojson::object& obj) {
+void Light::LoadFields(const SceneFile::Fields& fields) {
+
+	Object::LoadFields(fields);
 
-	Object::LoadJSONObj(obj);
+	for(auto& f : fields) {
+		switch(f.key) {
 
-	for(auto& i : obj) {
+			vec4field(KEY_POSITION, position)
+			vec3field(KEY_DIFFUSE_COLOR, diffuse_color)
+			vec3field(KEY_SPECULAR_COLOR, specular_color)
 
-		vec4field(position);
-		vec3field(diffuse_color);
-		vec3field(specular_color);
-		
-		floatfield(constant_atten);
-		floatfield(linear_atten);
-		floatfield(quad_atten);
+			floatfield(KEY_CONSTANT_ATTEN, constant_atten)
+			floatfield(KEY_LINEAR_ATTEN, linear_atten)
+			floatfield(KEY_QUAD_ATTEN, quad_atten)
 
-		vec3field(spotlight_dir);
-		floatfield(spotlight_cutoff);
-		floatfield(spotlight_exp);
+			vec3field(KEY_SPOTLIGHT_DIR, spotlight_dir)
+			floatfield(KEY_SPOTLIGHT_CUTOFF, spotlight_cutoff)
+			floatfield(KEY_SPOTLIGHT_EXP, spotlight_exp)
+		}
 	}
 }
 
-void Plane::LoadJSONObj(const picojson::object& obj) {
-
-	Collider::LoadJSONObj(obj);
-	Renderable::LoadJSONObj(obj);
+void Plane::LoadFields(const SceneFile::Fields& fields) {
 
-	for(auto& i : obj) {
-		if(i.first == "shape" && i.second.is<picojson::array>()) {
+	Collider::LoadFields(fields);
+	Renderable::LoadFields(fields);
 
-			const auto& array = i.second.get<picojson::array>();
-			for(int i = 0; i < 4; i++) {
-				if(array[i].is<double>()) {
-					plane[i] = array[i].get<double>();
-				}
-			}
+	for(auto& f : fields) {
+		switch(f.key) {
+			vec4field(KEY_SHAPE, plane)
 		}
 	}
 }
 
-void Sphere::LoadJSONObj(const picojson::object& obj) {
-
-	Collider::LoadJSONObj(obj);
-	Renderable::LoadJSONObj(obj);
+void Sphere::LoadFields(const SceneFile::Fields& fields) {
 
-	for(auto& i : obj) {
-		if(i.first == "shape" && i.second.is<double>()) {
+	Collider::LoadFields(fields);
+	Renderable::LoadFields(fields);
 
-			sphere = i.second.get<double>();
+	for(auto& f : fields) {
+		switch(f.key) {
+			floatfield(KEY_SHAPE, sphere)
 		}
 	}
 }
 
-void Cylinder::LoadJSONObj(const picojson::object& obj) {
-
-	Collider::LoadJSONObj(obj);
-	Renderable::LoadJSONObj(obj);
+void Cylinder::LoadFields(const SceneFile::Fields& fields) {
 
-	for(auto& i : obj) {
-		if(i.first == "shape" && i.second.is<picojson::array>()) {
+	Collider::LoadFields(fields);
+	Renderable::LoadFields(fields);
 
-			const auto& array = i.second.get<picojson::array>();
-			for(int i = 0; i < 3; i++) {
-				if(array[i].is<double>()) {
-					cylinder[i] = array[i].get<double>();
-				}
-			}
+	for(auto& f : fields) {
+		switch(f.key) {
+			vec3field(KEY_SHAPE, cylinder)
 		}
 	}
 }
 
-void Box::LoadJSONObj(const picojson::object& obj) {
-
-	Collider::LoadJSONObj(obj);
-	Renderable::LoadJSONObj(obj);
+void Box::LoadFields(const SceneFile::Fields& fields) {
 
-	for(auto& i : obj) {
-		if(i.first == "shape" && i.second.is<picojson::array>()) {
+	Collider::LoadFields(fields);
+	Renderable::LoadFields(fields);
 
-			const auto& array = i.second.get<picojson::array>();
-			for(int i = 0; i < 3; i++) {
-				if(array[i].is<double>()) {
-					box[i] = array[i].get<double>();
-				}
-			}
+	for(auto& f : fields) {
+		switch(f.key) {
+			vec3field(KEY_SHAPE, box)
 		}
 	}
 }
 
-void Mesh::LoadJSONObj(const picojson::object& obj) {
+void Mesh::LoadFields(const SceneFile::Fields& fields) {
 
-	Collider::LoadJSONObj(obj);
-	Renderable::LoadJSONObj(obj);
+	Collider::LoadFields(fields);
+	Renderable::LoadFields(fields);
 }
 
 bool Collider::Setup() {
 
+	// has to be massless, bullet only moves it where it's told
+	if(kinematic) mass = 0;
+
 	btMotionState = new btDefaultMotionState(btTransform(btQuaternion(0,0,0,1), btVector3(position.x, position.y, position.z)));
 
 	btInertia = btVector3(0,0,0);
@@ -196,14 +259,28 @@ bool Collider::Setup() {
 	btRigidBody::btRigidBodyConstructionInfo btBodyCTI(mass, btMotionState, btShape, btInertia);
 	btBody = new btRigidBody(btBodyCTI);
 
-	// if(mass > 0) {
+	if(kinematic) {
+		// bullet works out the velocity it hits things with from how far its transform moved each step
+		btBody->setCollisionFlags((btBody->getCollisionFlags() & ~btCollisionObject::CF_STATIC_OBJECT) | btCollisionObject::CF_KINEMATIC_OBJECT);
+	}
+
+	// kinematic bodies only pick up a new transform while they're awake, anything else can rest once it's stopped
+	if(kinematic || sleep_linear < 0.0f) {
 		btBody->setActivationState(DISABLE_DEACTIVATION);
-	// }
+	} else {
+		btBody->setSleepingThresholds(sleep_linear, sleep_angular);
+	}
 
 	btBody->setLinearVelocity(btVector3(velocity.x, velocity.y, velocity.z));
 	btBody->setRestitution(restitution);
 	btBody->setUserPointer((Object*)this);
 
+	// a small fast body can skip right over a thin wall in one step, sweeping it along its path catches that
+	if(ccd_radius > 0.0f) {
+		btBody->setCcdSweptSphereRadius(ccd_radius);
+		btBody->setCcdMotionThreshold(ccd_threshold);
+	}
+
 	return true;
 }
 
@@ -211,10 +288,11 @@ bool Renderable::Setup() {
 
 	if(!model.length() && !texture.length()) return true;
 
-	if(!s.LoadModel(model, model_idx)) {
+	// World::LoadScene may have started these already, don't count them twice in the cache
+	if(!s.HasMesh() && !s.LoadModel(model, model_idx)) {
 		return false;
 	}
-	if(!s.LoadTexture(texture)) {
+	if(!s.HasTexture() && !s.LoadTexture(texture)) {
 		return false;
 	}
 
@@ -266,20 +344,14 @@ bool Mesh::Setup() {
 
 	if(!Renderable::Setup()) return false;
 
-	btMesh = new btTriangleMesh();
+	// the collider needs the triangles now, not whenever the loader gets to them
+	if(!s.WaitForMesh()) return false;
 
+	// and keeps pointing into them, the scene holds on to the mesh for as long as this object is around
 	Scene::Mesh& mesh = s.getMesh();
-
-	for(unsigned int i = 0; i < mesh.indices.size(); i += 3) {
-
-		glm::vec3 pos1 = mesh.vertices[mesh.indices[i]].pos;
-		glm::vec3 pos2 = mesh.vertices[mesh.indices[i+1]].pos;
-		glm::vec3 pos3 = mesh.vertices[mesh.indices[i+2]].pos;
-
-		btMesh->addTriangle(btVector3(pos1.x,pos1.y,pos1.z),btVector3(pos2.x,pos2.y,pos2.z),btVector3(pos3.x,pos3.y,pos3.z));
-	}
-
-	btShape = new btBvhTriangleMeshShape(btMesh, true);
+	btShape = BvhCache::Load(model + "." + std::to_string(model_idx) + ".bvh", mesh.vertices.data(), mesh.vertices.size(),
+	                         mesh.indices.data(), mesh.indices.size());
+	if(!btShape) return false;
 
 	if(!Collider::Setup()) return false;
 
@@ -328,8 +400,8 @@ Box::~Box() {
 
 Mesh::~Mesh() {
 
-	if(btMesh) delete btMesh;
-	btMesh = nullptr;
+	BvhCache::Free(btShape);
+	btShape = nullptr;
 }
 
 void Collider::Reset() {
@@ -343,6 +415,8 @@ void Collider::Reset() {
 	btBody->setAngularVelocity(btVector3(0,0,0));
 
 	btBody->updateInertiaTensor();
+	// it may have been asleep wherever it was
+	btBody->activate(true);
 }
 
 void Light::Reset() {
@@ -0,0 +1,158 @@
+
+#include "replay.h"
+
+#include <fstream>
+#include <iostream>
+#include <cstdio>
+
+static const char* input_names[] = {"left", "right", "launch", "power_up", "power_down"};
+static const int INPUT_COUNT = sizeof(input_names) / sizeof(input_names[0]);
+
+bool Replay::Load(std::string path) {
+
+	std::ifstream fin(path);
+	if(!fin.good()) {
+		std::cerr << "Failed to open replay " << path << std::endl;
+		return false;
+	}
+
+	Clear();
+	rate = 120;
+
+	std::string kind;
+	while(fin >> kind) {
+
+		if(kind == "rate") {
+
+			// older recordings don't have one, they were all made at 120
+			fin >> rate;
+
+		} else if(kind == "input") {
+
+			Event e;
+			std::string name;
+			fin >> e.tick >> name >> e.down;
+
+			e.input = -1;
+			for(int i = 0; i < INPUT_COUNT; i++) {
+				if(name == input_names[i]) e.input = i;
+			}
+			if(e.input < 0) {
+				std::cerr << "Unknown input " << name << " in replay " << path << std::endl;
+				return false;
+			}
+			events.push_back(e);
+
+		} else if(kind == "hash") {
+
+			unsigned int tick, hash;
+			fin >> tick >> std::hex >> hash >> std::dec;
+			hashes.push_back({tick, hash});
+
+		} else {
+
+			std::cerr << "Unexpected " << kind << " in replay " << path << std::endl;
+			return false;
+		}
+
+		if(fin.fail()) {
+			std::cerr << "Malformed replay " << path << std::endl;
+			return false;
+		}
+	}
+
+	if(!rate) {
+		std::cerr << "Bad tick rate in replay " << path << std::endl;
+		return false;
+	}
+
+	std::cout << "Replay " << path << ": " << events.size() << " inputs, " << hashes.size() << " hashes at " << rate << " Hz" << std::endl;
+	return true;
+}
+
+bool Replay::Save(std::string path) {
+
+	std::ofstream fout(path);
+	if(!fout.good()) {
+		std::cerr << "Failed to write replay " << path << std::endl;
+		return false;
+	}
+
+	fout << "rate " << rate << "\n";
+
+	// both are in tick order already, merge them so the file reads in order too
+	unsigned int e = 0, h = 0;
+	while(e < events.size() || h < hashes.size()) {
+
+		if(e < events.size() && (h >= hashes.size() || events[e].tick <= hashes[h].first)) {
+			fout << "input " << events[e].tick << " " << input_names[events[e].input] << " " << events[e].down << "\n";
+			e++;
+		} else {
+			char hex[16];
+			snprintf(hex, sizeof(hex), "%08x", hashes[h].second);
+			fout << "hash " << hashes[h].first << " " << hex << "\n";
+			h++;
+		}
+	}
+
+	std::cout << "Saved replay " << path << ": " << events.size() << " inputs, " << hashes.size() << " hashes" << std::endl;
+	return fout.good();
+}
+
+void Replay::Rewind() {
+
+	next_event = next_hash = 0;
+	diverged = checked = 0;
+}
+
+void Replay::Clear() {
+
+	events.clear();
+	hashes.clear();
+	Rewind();
+}
+
+void Replay::Record(unsigned int tick, int input, bool down) {
+
+	events.push_back({tick, input, down});
+}
+
+bool Replay::Next(unsigned int tick, Event& event) {
+
+	// anything left over from a tick that was skipped isn't going to happen now
+	while(next_event < events.size() && events[next_event].tick < tick) {
+		next_event++;
+	}
+
+	if(next_event < events.size() && events[next_event].tick == tick) {
+		event = events[next_event++];
+		return true;
+	}
+	return false;
+}
+
+bool Replay::Hash(unsigned int tick, unsigned int hash) {
+
+	if(recording) {
+		hashes.push_back({tick, hash});
+		return true;
+	}
+
+	while(next_hash < hashes.size() && hashes[next_hash].first < tick) {
+		next_hash++;
+	}
+	if(next_hash >= hashes.size() || hashes[next_hash].first != tick) {
+		return true;
+	}
+
+	checked++;
+	if(hashes[next_hash].second == hash || diverged) {
+		return true;
+	}
+
+	diverged = tick;
+	char hex[32];
+	snprintf(hex, sizeof(hex), "%08x, recorded %08x", hash, hashes[next_hash].second);
+	std::cerr << "Replay diverged at tick " << tick << ": hash " << hex << std::endl;
+	return false;
+}
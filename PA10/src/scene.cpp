@@ -1,158 +1,177 @@
 
 #include "scene.h"
+#include "glstate.h"
+#include "cookedmodel.h"
+#include "assetcache.h"
+#include "benchmark.h"
 
-#include <assimp/Importer.hpp> 		//includes the importer, which is used to read our obj file
-#include <assimp/scene.h> 			//includes the aiScene object
-#include <assimp/postprocess.h> 	//includes the postprocessing variables for the importer
-#include <assimp/color4.h> 			//includes the aiColor4 object, which is used to handle the colors from the Scene objects
 #include <stb_image.h>
 
-Scene::Scene() {
-	mesh.VBO = mesh.IBO = texture.handle = 0;
-}
+Scene::Scene() {}
 
 Scene::~Scene() {}
 
+Scene::Mesh::Mesh() {
+	VAO = VBO = IBO = 0;
+}
+
+Scene::Mesh::~Mesh() {
+	if(VAO) GLState::DeleteVertexArray(VAO);
+	if(VBO) glDeleteBuffers(1, &VBO);
+	if(IBO) glDeleteBuffers(1, &IBO);
+}
+
+Scene::Texture::Texture() {
+	handle = 0;
+	bytes = 0;
+}
+
+Scene::Texture::~Texture() {
+	if(handle) GLState::DeleteTexture(handle);
+}
+
 void Scene::DeleteMesh() {
-	mesh.vertices.clear();
-	mesh.indices.clear();
-	if(mesh.VBO) {
-		glDeleteBuffers(1, &mesh.VBO);
-		mesh.VBO = 0;
-	}
-	if(mesh.IBO) {
-		glDeleteBuffers(1, &mesh.IBO);
-		mesh.IBO = 0;
-	}
+	mesh.reset();
 }
 
 void Scene::DeleteTexture() {
-	if(texture.handle) {
-		glDeleteTextures(1, &texture.handle);
-		texture.handle = 0;
-	}
+	texture.reset();
 }
 
 Scene::Mesh& Scene::getMesh() {
 
-	return mesh;
+	return *mesh;
 }
 
 bool Scene::LoadModel(std::string file, int idx) {
 
-	std::string dir = file.substr(0, file.find_last_of("\\/") + 1);
-
-	DeleteMesh();
+	mesh = AssetCache::GetMesh(file, idx);
+	return mesh != nullptr;
+}
 
-	Assimp::Importer import;
+bool Scene::LoadTexture(std::string file) {
 
-	// load file
-	const aiScene* scene = import.ReadFile(file.c_str(), aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_JoinIdenticalVertices | aiProcess_FlipUVs);
-	if(!scene) {
-		std::cerr << "Error reading file " << file << ": " << import.GetErrorString() << std::endl;
-		return false;
-	}
+	texture = AssetCache::GetTexture(file);
+	return texture != nullptr;
+}
 
-	const aiVector3D zeroVec(0.0f, 0.0f, 0.0f);
+bool Scene::WaitForMesh() {
 
-	// load first mesh
-	unsigned int mesh_idx = idx;
-	const aiMesh* aiM = scene->mMeshes[mesh_idx];
+	if(!mesh) return false;
+	if(mesh->pending) AssetLoader::Wait(mesh->pending);
+	return !mesh->indices.empty();
+}
 
-	// for each vertex in the mesh
-	for(unsigned int vert_idx = 0; vert_idx < aiM->mNumVertices; vert_idx++) {
-		const aiVector3D* pos = &aiM->mVertices[vert_idx];
-		const aiVector3D* norm = &aiM->mNormals[vert_idx];
-		const aiVector3D* texcoord = aiM->HasTextureCoords(0) ? &aiM->mTextureCoords[0][vert_idx] : &zeroVec;
+bool Scene::ReadMesh(const std::string& file, int idx, Mesh& mesh) {
 
-		// translate vetex data
-		Vertex vert;
-		vert.pos = glm::vec3(pos->x, pos->y, pos->z);
-		vert.normal = glm::vec3(norm->x, norm->y, norm->z);
-		vert.texcoord = glm::vec2(texcoord->x, texcoord->y);
+	CookedModel model;
+	if(!model.Load(file)) {
+		return false;
+	}
 
-		mesh.vertices.push_back(vert);
+	if(idx < 0 || (unsigned int)idx >= model.meshes.size()) {
+		std::cerr << "No mesh " << idx << " in " << file << std::endl;
+		return false;
 	}
 
-	// for each face in the mesh
-	for(unsigned int face_idx = 0; face_idx < aiM->mNumFaces; face_idx++) {
-		const aiFace* face = &aiM->mFaces[face_idx];
+	// load requested mesh
+	const CookedModel::SubMesh& sub = model.meshes[idx];
 
-		// collect face indicies
-		for(unsigned int idx = 0; idx < 3; idx++) {
-			mesh.indices.push_back(face->mIndices[idx]);
-		}
-	}
+	// cooked data is already laid out as Vertex / index arrays
+	mesh.vertices.assign(sub.vertices, sub.vertices + sub.num_vertices);
+	mesh.indices.assign(sub.indices, sub.indices + sub.num_indices);
+
+	return true;
+}
+
+void Scene::UploadMesh(Mesh& mesh) {
 
 	// send vertex / index information to GPU
+	glGenVertexArrays(1, &mesh.VAO);
 	glGenBuffers(1, &mesh.VBO);
 	glGenBuffers(1, &mesh.IBO);
 
+	// the element buffer binding and attribute pointers are captured by the VAO
+	GLState::BindVertexArray(mesh.VAO);
 	glBindBuffer(GL_ARRAY_BUFFER, mesh.VBO);
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.IBO);
 
 	glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex) * mesh.vertices.size(), &mesh.vertices[0], GL_STATIC_DRAW);
 	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int) * mesh.indices.size(), &mesh.indices[0], GL_STATIC_DRAW);
 
+	glEnableVertexAttribArray(0);
+	glEnableVertexAttribArray(1);
+	glEnableVertexAttribArray(2);
+
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), 0);
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex,normal));
+	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex,texcoord));
+
+	// instance attributes advance once per instance, RenderInstances points them at a buffer
+	for(GLuint a = 3; a <= 10; a++) {
+		glEnableVertexAttribArray(a);
+		glVertexAttribDivisor(a, 1);
+	}
+
+	GLState::BindVertexArray(0);
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+}
 
-	return true;
+Scene::Image::Image() {
+	w = h = 0;
+	pixels = nullptr;
 }
 
-bool Scene::LoadTexture(std::string file) {
+Scene::Image::~Image() {
+	// free image loaded from file
+	if(pixels) stbi_image_free(pixels);
+}
 
-	DeleteTexture();
+bool Scene::ReadTexture(const std::string& file, Image& image) {
 
-	int w, h;
-	unsigned char* bitmap = stbi_load(file.c_str(), &w, &h, nullptr, 4);
-	if(!bitmap) {
+	image.pixels = stbi_load(file.c_str(), &image.w, &image.h, nullptr, 4);
+	if(!image.pixels) {
 		std::cerr << "Failed to load texture from " << file.c_str() << std::endl;
 		return false;
 	}
 
+	return true;
+}
+
+void Scene::UploadTexture(Texture& texture, const Image& image) {
+
 	// Set up OpenGL texture
 	glGenTextures(1, &texture.handle);
-	glBindTexture(GL_TEXTURE_2D, texture.handle);
+	GLState::BindTexture(GL_TEXTURE_2D, texture.handle);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, bitmap);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, image.w, image.h, 0, GL_RGBA, GL_UNSIGNED_BYTE, image.pixels);
 	glGenerateMipmap(GL_TEXTURE_2D);
-	glBindTexture(GL_TEXTURE_2D, 0);
 
-	// free image loaded from file
-	stbi_image_free(bitmap);
-
-	return true;
+	// RGBA8 base level plus a third again for the mip chain
+	texture.bytes = (size_t)image.w * image.h * 4 * 4 / 3;
 }
 
-void Scene::Render() {
+void Scene::RenderInstances(GLuint buffer, size_t offset, GLsizei count) {
 
-	if(!mesh.vertices.size() || !mesh.indices.size()) return;
-
-	glEnableVertexAttribArray(0);
-	glEnableVertexAttribArray(1);
-	glEnableVertexAttribArray(2);
+	if(!mesh || !mesh->indices.size() || !count) return;
 
-	glBindBuffer(GL_ARRAY_BUFFER, mesh.VBO);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.IBO);
+	GLState::BindVertexArray(mesh->VAO);
+	GLState::BindTexture(GL_TEXTURE_2D, texture ? (texture->handle ? texture->handle : AssetLoader::placeholder) : 0);
 
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, texture.handle);
+	glBindBuffer(GL_ARRAY_BUFFER, buffer);
 
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), 0);
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex,normal));
-	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex,texcoord));
-
-	glDrawElements(GL_TRIANGLES, mesh.indices.size(), GL_UNSIGNED_INT, 0);
-
-	glBindTexture(GL_TEXTURE_2D, 0);
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	// a mat4 attribute takes four locations, one column each
+	for(GLuint c = 0; c < 4; c++) {
+		glVertexAttribPointer(3 + c, 4, GL_FLOAT, GL_FALSE, sizeof(Instance), (void*)(offset + offsetof(Instance, model) + sizeof(glm::vec4) * c));
+	}
+	glVertexAttribPointer(7, 3, GL_FLOAT, GL_FALSE, sizeof(Instance), (void*)(offset + offsetof(Instance, ambient)));
+	glVertexAttribPointer(8, 3, GL_FLOAT, GL_FALSE, sizeof(Instance), (void*)(offset + offsetof(Instance, diffuse)));
+	glVertexAttribPointer(9, 3, GL_FLOAT, GL_FALSE, sizeof(Instance), (void*)(offset + offsetof(Instance, specular)));
+	glVertexAttribPointer(10, 1, GL_FLOAT, GL_FALSE, sizeof(Instance), (void*)(offset + offsetof(Instance, shine)));
 
-	glDisableVertexAttribArray(0);
-	glDisableVertexAttribArray(1);
-	glDisableVertexAttribArray(2);
+	glDrawElementsInstanced(GL_TRIANGLES, mesh->indices.size(), GL_UNSIGNED_INT, 0, count);
+	Benchmark::draw_calls++;
 }
@@ -0,0 +1,659 @@
+
+#include "scenefile.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <set>
+
+// bump whenever the binary layout changes
+static const uint32_t SCENE_VERSION = 1;
+static const char SCENE_MAGIC[4] = {'Q', 'S', 'C', 'N'};
+
+struct SceneHeader {
+	char magic[4];
+	uint32_t version;
+	// the key list and the text it was compiled from
+	uint64_t keys_hash;
+	uint64_t text_hash;
+
+	uint32_t num_templates;
+	// before instancing
+	uint32_t num_objects;
+	// bytes of records after the header
+	uint32_t size;
+	uint32_t unused;
+};
+
+// followed by the templates, each a name and its fields, then the objects, each
+// its fields and a list of instance positions - see WriteFields for a field
+
+static_assert(sizeof(SceneHeader) == 40, "scene header must not depend on the compiler's padding");
+
+static uint64_t Hash64(const char* data, size_t len, uint64_t hash = 14695981039346656037ull) {
+
+	for(size_t i = 0; i < len; i++) {
+		hash = (hash ^ (unsigned char)data[i]) * 1099511628211ull;
+	}
+	return hash;
+}
+
+static uint32_t HashKey(const char* name, size_t len, uint32_t seed) {
+
+	uint32_t hash = 2166136261u ^ (seed * 0x9e3779b9u);
+	for(size_t i = 0; i < len; i++) {
+		hash = (hash ^ (unsigned char)name[i]) * 16777619u;
+	}
+	return hash ^ (hash >> 15);
+}
+
+SceneFile::SceneFile(const char* const* keys, unsigned int num_keys) : keys(keys), num_keys(num_keys) {
+
+	keys_hash = Hash64(nullptr, 0);
+	for(unsigned int k = 0; k < num_keys; k++) {
+		key_lengths.push_back(strlen(keys[k]));
+		keys_hash = Hash64(keys[k], key_lengths[k] + 1, keys_hash);
+	}
+
+	// try seeds until every key lands in a slot of its own, with a bigger table if none do
+	unsigned int size = 8;
+	while(size < 2 * num_keys) size *= 2;
+
+	for(;;) {
+		for(seed = 1; seed < 1000; seed++) {
+
+			slots.assign(size, -1);
+			unsigned int k = 0;
+			for(; k < num_keys; k++) {
+				int& slot = slots[HashKey(keys[k], key_lengths[k], seed) & (size - 1)];
+				if(slot >= 0) break;
+				slot = k;
+			}
+			if(k == num_keys) break;
+		}
+		if(seed < 1000) break;
+		size *= 2;
+	}
+
+	position_key = Key("position", 8);
+}
+
+int SceneFile::Key(const char* name, size_t length) const {
+
+	int k = slots[HashKey(name, length, seed) & (slots.size() - 1)];
+	if(k < 0 || key_lengths[k] != length || memcmp(keys[k], name, length)) return -1;
+	return k;
+}
+
+const SceneFile::Fields* SceneFile::Template(const std::string& name) const {
+
+	auto i = templates.find(name);
+	return i == templates.end() ? nullptr : &i->second;
+}
+
+// Reads JSON a token at a time, straight out of the text - there's never a tree of it
+struct SceneFile::Parser {
+
+	const char* begin;
+	const char* p;
+	const char* end;
+	std::string name;
+	bool failed = false;
+	// unknown keys, only warned about once each
+	std::set<std::string> unknown;
+	std::string scratch;
+
+	Parser(const std::string& text, const std::string& name) : begin(text.c_str()), p(begin), end(begin + text.size()), name(name) {}
+
+	bool Error(const std::string& what) {
+
+		if(!failed) {
+			unsigned int line = 1;
+			for(const char* c = begin; c < p; c++) {
+				if(*c == '\n') line++;
+			}
+			std::cerr << name << ":" << line << ": " << what << std::endl;
+			failed = true;
+		}
+		return false;
+	}
+
+	void Skip() {
+		while(p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')) p++;
+	}
+
+	// consume c if it's next
+	bool Peek(char c) {
+		Skip();
+		if(p < end && *p == c) {
+			p++;
+			return true;
+		}
+		return false;
+	}
+
+	bool Expect(char c) {
+		if(Peek(c)) return true;
+		return Error(std::string("expected '") + c + "'");
+	}
+
+	// after a member, true if another one follows, false at close or on an error
+	bool Next(char close) {
+		if(Peek(',')) return true;
+		if(!Peek(close)) Error(std::string("expected ',' or '") + close + "'");
+		return false;
+	}
+
+	bool String(std::string& out) {
+
+		Skip();
+		if(p >= end || *p != '"') return Error("expected a string");
+		p++;
+
+		out.clear();
+		const char* start = p;
+		while(p < end && *p != '"') {
+
+			if(*p != '\\') {
+				p++;
+				continue;
+			}
+
+			out.append(start, p);
+			if(++p >= end) break;
+
+			switch(*p) {
+				case 'n': out += '\n'; break;
+				case 't': out += '\t'; break;
+				case 'r': out += '\r'; break;
+				case 'b': out += '\b'; break;
+				case 'f': out += '\f'; break;
+				case 'u': {
+					if(end - p < 5) return Error("bad \\u escape");
+					unsigned int code = strtoul(std::string(p + 1, 4).c_str(), nullptr, 16);
+					if(code < 0x80) {
+						out += (char)code;
+					} else if(code < 0x800) {
+						out += (char)(0xc0 | code >> 6);
+						out += (char)(0x80 | (code & 0x3f));
+					} else {
+						out += (char)(0xe0 | code >> 12);
+						out += (char)(0x80 | (code >> 6 & 0x3f));
+						out += (char)(0x80 | (code & 0x3f));
+					}
+					p += 4;
+					break;
+				}
+				default: out += *p; break;
+			}
+			start = ++p;
+		}
+
+		if(p >= end) return Error("unterminated string");
+		out.append(start, p++);
+		return true;
+	}
+
+	// a key, pointing into the text unless it has escapes in it
+	bool Key(const char*& key, size_t& length) {
+
+		Skip();
+		if(p >= end || *p != '"') return Error("expected a key");
+
+		const char* start = p + 1;
+		const char* close = start;
+		while(close < end && *close != '"' && *close != '\\') close++;
+
+		if(close < end && *close == '"') {
+			key = start;
+			length = close - start;
+			p = close + 1;
+		} else {
+			if(!String(scratch)) return false;
+			key = scratch.c_str();
+			length = scratch.size();
+		}
+		return Expect(':');
+	}
+
+	bool Number(float& out) {
+
+		Skip();
+		char* after = nullptr;
+		out = (float)strtod(p, &after);
+		if(after == p || after > end) return Error("expected a number");
+		p = after;
+		return true;
+	}
+
+	bool Literal(const char* word) {
+
+		size_t len = strlen(word);
+		if((size_t)(end - p) < len || memcmp(p, word, len)) return Error("unexpected character");
+		p += len;
+		return true;
+	}
+
+	// a value, false with kind -1 for null
+	bool Value(Field& f) {
+
+		Skip();
+		if(p >= end) return Error("expected a value");
+
+		f.count = 0;
+		switch(*p) {
+
+			case '"':
+				f.kind = STRING;
+				f.count = 1;
+				return String(f.string);
+
+			case 't':
+			case 'f':
+				f.kind = BOOL;
+				f.count = 1;
+				f.numbers[0] = *p == 't';
+				return Literal(*p == 't' ? "true" : "false");
+
+			case 'n':
+				f.kind = -1;
+				Literal("null");
+				return false;
+
+			case '[':
+				p++;
+				Skip();
+				if(p < end && *p == '"') {
+					f.kind = STRINGS;
+					f.strings.clear();
+					do {
+						f.strings.emplace_back();
+						if(!String(f.strings.back())) return false;
+					} while(Next(']'));
+					f.count = f.strings.size();
+				} else {
+					f.kind = NUMBERS;
+					if(Peek(']')) return true;
+					do {
+						if(f.count == 4) return Error("more than 4 numbers in an array");
+						if(!Number(f.numbers[f.count++])) return false;
+					} while(Next(']'));
+				}
+				return !failed;
+
+			default:
+				f.kind = NUMBER;
+				f.count = 1;
+				return Number(f.numbers[0]);
+		}
+	}
+
+	// anything at all, for keys nobody reads
+	bool SkipValue() {
+
+		Skip();
+		if(p >= end) return Error("expected a value");
+
+		if(*p == '"') return String(scratch);
+		if(*p == 't') return Literal("true");
+		if(*p == 'f') return Literal("false");
+		if(*p == 'n') return Literal("null");
+
+		if(*p == '[' || *p == '{') {
+			char close = *p == '[' ? ']' : '}';
+			p++;
+			if(Peek(close)) return true;
+			do {
+				if(close == '}') {
+					if(!String(scratch) || !Expect(':')) return false;
+				}
+				if(!SkipValue()) return false;
+			} while(Next(close));
+			return !failed;
+		}
+
+		float unused;
+		return Number(unused);
+	}
+};
+
+bool SceneFile::ParseFields(Parser& p, Fields& fields, std::vector<float>* instances, const char* what) {
+
+	fields.clear();
+	if(instances) instances->clear();
+
+	if(!p.Expect('{')) return false;
+	if(p.Peek('}')) return true;
+
+	do {
+		const char* name;
+		size_t length;
+		if(!p.Key(name, length)) return false;
+
+		int k = Key(name, length);
+		if(k >= 0) {
+
+			fields.emplace_back();
+			fields.back().key = k;
+			if(!p.Value(fields.back())) {
+				if(p.failed) return false;
+				fields.pop_back();
+			}
+
+		} else if(length == 8 && !memcmp(name, "template", 8)) {
+
+			std::string t;
+			if(!p.String(t)) return false;
+			auto i = templates.find(t);
+			if(i == templates.end()) return p.Error("unknown template " + t + ", templates have to come before the objects using them");
+			fields.insert(fields.begin(), i->second.begin(), i->second.end());
+
+		} else if(length == 9 && !memcmp(name, "instances", 9) && instances) {
+
+			if(position_key < 0) return p.Error("instances need a position key");
+			if(!p.Expect('[')) return false;
+			if(p.Peek(']')) continue;
+			do {
+				float x, y, z;
+				if(!p.Expect('[') || !p.Number(x) || !p.Expect(',') || !p.Number(y) || !p.Expect(',') || !p.Number(z) || !p.Expect(']')) {
+					return p.Error("instances are [x, y, z] positions");
+				}
+				instances->push_back(x);
+				instances->push_back(y);
+				instances->push_back(z);
+			} while(p.Next(']'));
+			if(p.failed) return false;
+
+		} else {
+
+			std::string key(name, length);
+			if(p.unknown.insert(key).second) {
+				std::cerr << p.name << ": ignoring unknown key " << key << " in " << what << std::endl;
+			}
+			if(!p.SkipValue()) return false;
+		}
+	} while(p.Next('}'));
+
+	return !p.failed;
+}
+
+bool SceneFile::ParseObject(const std::string& text, Fields& fields) {
+
+	Parser p(text, "object");
+	if(!ParseFields(p, fields, nullptr, "an object")) return false;
+
+	p.Skip();
+	if(p.p != p.end) return p.Error("unexpected text after the object");
+	return true;
+}
+
+bool SceneFile::LoadText(const std::string& text, const Callback& callback, const std::string& binary_path) {
+
+	Parser p(text, binary_path.size() ? binary_path.substr(0, binary_path.size() - 4) : "scene");
+	templates.clear();
+	objects = 0;
+
+	bool write = binary_path.size() > 0;
+	std::string out_templates, out_objects;
+	uint32_t num_templates = 0, num_records = 0;
+
+	Fields fields;
+	std::vector<float> instances;
+
+	if(!p.Expect('{')) return false;
+	if(p.Peek('}')) return true;
+
+	do {
+		const char* name;
+		size_t length;
+		if(!p.Key(name, length)) return false;
+		std::string section(name, length);
+
+		if(section == "templates") {
+
+			if(!p.Expect('{')) return false;
+			if(p.Peek('}')) continue;
+			do {
+				std::string t;
+				if(!p.String(t) || !p.Expect(':')) return false;
+				if(!ParseFields(p, fields, nullptr, "a template")) return false;
+				templates[t] = fields;
+
+				if(write) {
+					uint16_t len = t.size();
+					out_templates.append((const char*)&len, sizeof(len));
+					out_templates.append(t);
+					WriteFields(out_templates, fields);
+					num_templates++;
+				}
+			} while(p.Next('}'));
+
+		} else if(section == "objects") {
+
+			if(!p.Expect('[')) return false;
+			if(p.Peek(']')) continue;
+			do {
+				if(!ParseFields(p, fields, &instances, "an object")) return false;
+
+				if(write) {
+					WriteFields(out_objects, fields);
+					uint32_t count = instances.size() / 3;
+					out_objects.append((const char*)&count, sizeof(count));
+					out_objects.append((const char*)instances.data(), instances.size() * sizeof(float));
+					num_records++;
+				}
+
+				if(instances.empty()) {
+					objects++;
+					if(!callback(fields)) return false;
+					continue;
+				}
+
+				// the same fields for each, with a last word on where it goes
+				fields.emplace_back();
+				Field& position = fields.back();
+				position.key = position_key;
+				position.kind = NUMBERS;
+				position.count = 3;
+				for(size_t i = 0; i < instances.size(); i += 3) {
+					memcpy(position.numbers, &instances[i], 3 * sizeof(float));
+					objects++;
+					if(!callback(fields)) return false;
+				}
+			} while(p.Next(']'));
+
+		} else {
+
+			std::cerr << p.name << ": ignoring unknown section " << section << std::endl;
+			if(!p.SkipValue()) return false;
+		}
+	} while(p.Next('}'));
+
+	if(p.failed) return false;
+
+	if(write) {
+
+		SceneHeader header;
+		memcpy(header.magic, SCENE_MAGIC, 4);
+		header.version = SCENE_VERSION;
+		header.keys_hash = keys_hash;
+		header.text_hash = Hash64(text.data(), text.size());
+		header.num_templates = num_templates;
+		header.num_objects = num_records;
+		header.size = out_templates.size() + out_objects.size();
+		header.unused = 0;
+
+		std::ofstream fout(binary_path, std::ios::binary);
+		fout.write((const char*)&header, sizeof(header));
+		fout << out_templates << out_objects;
+		if(!fout.good()) {
+			std::cerr << "Failed to write compiled scene " << binary_path << std::endl;
+		}
+	}
+
+	return true;
+}
+
+bool SceneFile::Load(const std::string& path, const Callback& callback) {
+
+	auto start = std::chrono::high_resolution_clock::now();
+
+	std::string text;
+	std::ifstream fin(path, std::ios::binary);
+	if(!fin.good()) {
+		std::cerr << "Failed to open scene " << path << std::endl;
+		return false;
+	}
+	getline(fin, text, '\0');
+
+	int cached = ReadBinary(path + ".bin", Hash64(text.data(), text.size()), callback);
+	from_cache = cached > 0;
+
+	bool ok = cached == 0 ? false : from_cache || LoadText(text, callback, path + ".bin");
+
+	load_ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	return ok;
+}
+
+// key, kind, count, then count floats, or length prefixed strings for STRING / STRINGS
+void SceneFile::WriteFields(std::string& out, const Fields& fields) {
+
+	uint16_t count = fields.size();
+	out.append((const char*)&count, sizeof(count));
+
+	for(const Field& f : fields) {
+
+		uint16_t key = f.key;
+		uint8_t kind = f.kind, n = f.count;
+		out.append((const char*)&key, sizeof(key));
+		out.append((const char*)&kind, sizeof(kind));
+		out.append((const char*)&n, sizeof(n));
+
+		if(f.kind == STRING || f.kind == STRINGS) {
+			for(unsigned int i = 0; i < f.count; i++) {
+				const std::string& s = f.kind == STRING ? f.string : f.strings[i];
+				uint32_t len = s.size();
+				out.append((const char*)&len, sizeof(len));
+				out.append(s);
+			}
+		} else {
+			out.append((const char*)f.numbers, f.count * sizeof(float));
+		}
+	}
+}
+
+bool SceneFile::ReadFields(const char*& data, const char* end, Fields& fields, unsigned int num_keys) {
+
+	auto read = [&](void* to, size_t len) {
+		if((size_t)(end - data) < len) return false;
+		memcpy(to, data, len);
+		data += len;
+		return true;
+	};
+
+	uint16_t count;
+	if(!read(&count, sizeof(count))) return false;
+	fields.resize(count);
+
+	for(Field& f : fields) {
+
+		uint16_t key;
+		uint8_t kind, n;
+		if(!read(&key, sizeof(key)) || !read(&kind, sizeof(kind)) || !read(&n, sizeof(n))) return false;
+		if(key >= num_keys || kind > STRINGS) return false;
+		f.key = key;
+		f.kind = kind;
+		f.count = n;
+
+		if(kind == STRING || kind == STRINGS) {
+			if(kind == STRINGS) f.strings.resize(n);
+			for(unsigned int i = 0; i < n; i++) {
+				uint32_t len;
+				if(!read(&len, sizeof(len)) || (size_t)(end - data) < len) return false;
+				(kind == STRING ? f.string : f.strings[i]).assign(data, len);
+				data += len;
+			}
+		} else {
+			if(n > 4 || !read(f.numbers, n * sizeof(float))) return false;
+		}
+	}
+	return true;
+}
+
+int SceneFile::ReadBinary(const std::string& path, unsigned long long text_hash, const Callback& callback) {
+
+	std::ifstream fin(path, std::ios::binary);
+	if(!fin.good()) return -1;
+
+	SceneHeader header;
+	if(!fin.read((char*)&header, sizeof(header))) return -1;
+	if(memcmp(header.magic, SCENE_MAGIC, 4) || header.version != SCENE_VERSION || header.keys_hash != keys_hash || header.text_hash != text_hash) {
+		// edited since, or compiled by a different build
+		return -1;
+	}
+
+	std::string records(header.size, '\0');
+	if(!fin.read(&records[0], header.size)) {
+		std::cerr << "Ignoring truncated compiled scene " << path << std::endl;
+		return -1;
+	}
+
+	const char* data = records.data();
+	const char* end = data + records.size();
+	templates.clear();
+	objects = 0;
+
+	// nothing has been handed out yet, so a bad template can still go back to the text
+	for(uint32_t t = 0; t < header.num_templates; t++) {
+
+		uint16_t len;
+		if((size_t)(end - data) < sizeof(len)) return -1;
+		memcpy(&len, data, sizeof(len));
+		data += sizeof(len);
+		if((size_t)(end - data) < len) return -1;
+		std::string name(data, len);
+		data += len;
+
+		if(!ReadFields(data, end, templates[name], num_keys)) return -1;
+	}
+
+	Fields fields;
+	for(uint32_t o = 0; o < header.num_objects; o++) {
+
+		uint32_t count;
+		if(!ReadFields(data, end, fields, num_keys) || (size_t)(end - data) < sizeof(count)) {
+			std::cerr << "Compiled scene " << path << " is corrupt" << std::endl;
+			return 0;
+		}
+		memcpy(&count, data, sizeof(count));
+		data += sizeof(count);
+
+		if(!count) {
+			objects++;
+			if(!callback(fields)) return 0;
+			continue;
+		}
+
+		if((size_t)(end - data) < count * 3 * sizeof(float)) {
+			std::cerr << "Compiled scene " << path << " is corrupt" << std::endl;
+			return 0;
+		}
+
+		fields.emplace_back();
+		Field& position = fields.back();
+		position.key = position_key;
+		position.kind = NUMBERS;
+		position.count = 3;
+		for(uint32_t i = 0; i < count; i++) {
+			memcpy(position.numbers, data, 3 * sizeof(float));
+			data += 3 * sizeof(float);
+			objects++;
+			if(!callback(fields)) return 0;
+		}
+	}
+
+	return 1;
+}
@@ -1,4 +1,6 @@
 #include "text.h"
+#include "benchmark.h"
+#include "glstate.h"
 
 #define STB_TRUETYPE_IMPLEMENTATION
 #include <stb_truetype.h>
@@ -23,8 +25,8 @@ Text::~Text() {
 
 	glDeleteBuffers(1, &VBO);
 	glDeleteBuffers(1, &IBO);
-	glDeleteVertexArrays(1, &VAO);
-	glDeleteTextures(1, &texture);
+	GLState::DeleteVertexArray(VAO);
+	GLState::DeleteTexture(texture);
 }
 
 bool Text::Initialize(int width, int height, std::string font_path) {
@@ -130,7 +132,7 @@ bool Text::Initialize(int width, int height, std::string font_path) {
 		}
 
 		// load rasterized texture
-		glBindTexture(GL_TEXTURE_2D, texture);
+		GLState::BindTexture(GL_TEXTURE_2D, texture);
 		
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
@@ -143,9 +145,7 @@ bool Text::Initialize(int width, int height, std::string font_path) {
 		
 		glGenerateMipmap(GL_TEXTURE_2D);
 
-		glBindTexture(GL_TEXTURE_2D, 0);
-
-		glBindVertexArray(VAO);
+		GLState::BindVertexArray(VAO);
 		glBindBuffer(GL_ARRAY_BUFFER, VBO);
 		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, IBO);
 
@@ -154,7 +154,7 @@ bool Text::Initialize(int width, int height, std::string font_path) {
 		
 		glEnableVertexAttribArray(0);
 		glEnableVertexAttribArray(1);
-		glBindVertexArray(0);
+		GLState::BindVertexArray(0);
 
 		delete[] baked_bitmap;
 		delete[] chars;
@@ -181,8 +181,8 @@ void Text::End(Graphics* g) {
 		return;
 	}
 
-	glBindVertexArray(VAO);
-	glBindTexture(GL_TEXTURE_2D, texture);
+	GLState::BindVertexArray(VAO);
+	GLState::BindTexture(GL_TEXTURE_2D, texture);
 
 	glBindBuffer(GL_ARRAY_BUFFER, VBO);
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, IBO);
@@ -190,12 +190,11 @@ void Text::End(Graphics* g) {
 	glBufferData(GL_ARRAY_BUFFER, sizeof(vertex) * Verticies.size(), &Verticies[0], GL_DYNAMIC_DRAW);
 	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int) * Indicies.size(), &Indicies[0], GL_DYNAMIC_DRAW);
 
-	glEnable(GL_BLEND);
-	glEnable(GL_DEPTH_TEST);
-	glBlendFunc(GL_DST_ALPHA, GL_DST_ALPHA);
+	GLState::Enable(GL_BLEND, true);
+	GLState::Enable(GL_DEPTH_TEST, true);
+	GLState::BlendFunc(GL_DST_ALPHA, GL_DST_ALPHA);
 	glDrawElements(GL_TRIANGLES, Indicies.size(), GL_UNSIGNED_INT, 0);
-
-	glBindVertexArray(0);
+	Benchmark::draw_calls++;
 }
 
 float Text::AddText(std::string text, glm::vec3 pos, glm::vec3 axis, float fp) {
@@ -1,15 +1,34 @@
 #include <window.h>
 
+#define EGL_NO_X11
+#define MESA_EGL_NO_X11_HEADERS
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
 Window::Window() {
 
 	gWindow = NULL;
+	headless = false;
+	eglDisplay = EGL_NO_DISPLAY;
+	eglContext = EGL_NO_CONTEXT;
 }
 
 Window::~Window() {
 
-	SDL_StopTextInput();
-	SDL_DestroyWindow(gWindow);
-	gWindow = NULL;
+	if(headless) {
+
+		eglMakeCurrent(eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+		if(eglContext != EGL_NO_CONTEXT) eglDestroyContext(eglDisplay, eglContext);
+		if(eglDisplay != EGL_NO_DISPLAY) eglTerminate(eglDisplay);
+		eglContext = EGL_NO_CONTEXT;
+		eglDisplay = EGL_NO_DISPLAY;
+
+	} else {
+
+		SDL_StopTextInput();
+		SDL_DestroyWindow(gWindow);
+		gWindow = NULL;
+	}
 	SDL_Quit();
 }
 
@@ -68,7 +87,84 @@ bool Window::Initialize(const string &name, int* width, int* height) {
 	return true;
 }
 
+bool Window::InitializeHeadless(int width, int height) {
+
+	headless = true;
+
+	// SDL is still used for timing and input state, but must not open a display or audio device
+	SDL_setenv("SDL_AUDIODRIVER", "dummy", 1);
+	if(SDL_Init(SDL_INIT_TIMER | SDL_INIT_EVENTS | SDL_INIT_AUDIO) < 0) {
+
+		printf("SDL failed to initialize: %s\n", SDL_GetError());
+		return false;
+	}
+
+	// prefer the surfaceless platform (works with llvmpipe and no GPU), fall back to the default display
+	EGLDisplay display = EGL_NO_DISPLAY;
+	PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+	if(getPlatformDisplay) {
+		display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+	}
+	if(display == EGL_NO_DISPLAY) {
+		display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+	}
+
+	EGLint major, minor;
+	if(display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor)) {
+
+		printf("EGL display failed to initialize: 0x%x\n", eglGetError());
+		return false;
+	}
+	eglDisplay = display;
+
+	if(!eglBindAPI(EGL_OPENGL_API)) {
+
+		printf("EGL does not support desktop OpenGL: 0x%x\n", eglGetError());
+		return false;
+	}
+
+	const EGLint config_attribs[] = {
+		EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+		EGL_NONE
+	};
+
+	EGLConfig config = EGL_NO_CONFIG_KHR;
+	EGLint num_configs = 0;
+	eglChooseConfig(display, config_attribs, &config, 1, &num_configs);
+	if(!num_configs) {
+		config = EGL_NO_CONFIG_KHR;
+	}
+
+	// same 3.3 core context as the windowed path
+	const EGLint context_attribs[] = {
+		EGL_CONTEXT_MAJOR_VERSION, 3,
+		EGL_CONTEXT_MINOR_VERSION, 3,
+		EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+		EGL_NONE
+	};
+
+	EGLContext context = eglCreateContext(display, config, EGL_NO_CONTEXT, context_attribs);
+	if(context == EGL_NO_CONTEXT) {
+
+		printf("EGL context not created: 0x%x\n", eglGetError());
+		return false;
+	}
+	eglContext = context;
+
+	// no surface at all - Graphics renders into its own framebuffer object
+	if(!eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context)) {
+
+		printf("EGL context could not be made current: 0x%x\n", eglGetError());
+		return false;
+	}
+
+	printf("Headless EGL %d.%d context, %dx%d offscreen\n", major, minor, width, height);
+
+	return true;
+}
+
 void Window::Swap() {
 
+	if(headless) return;
 	SDL_GL_SwapWindow(gWindow);
 }
@@ -1,13 +1,60 @@
 
 #include "world.h"
+#include "assetloader.h"
+#include "instancer.h"
+#include "contacts.h"
+#include "benchmark.h"
 
-#include <dirent.h>
 #include <fstream>
 #include <sys/stat.h>
 #include <imgui.h>
+#include <picojson.h>
 #include <SDL2/SDL.h>
 #include <map>
+#include <cmath>
 #include <sstream>
+#include <chrono>
+#include <algorithm>
+#include <cstdio>
+
+// times the constraint solve inside each step, the rest of it is collision detection and integration
+class TimedSolver : public btSequentialImpulseConstraintSolver {
+public:
+	double ms = 0.0;
+
+	btScalar solveGroup(btCollisionObject** bodies, int numBodies, btPersistentManifold** manifolds, int numManifolds,
+	                    btTypedConstraint** constraints, int numConstraints, const btContactSolverInfo& info,
+	                    btIDebugDraw* debugDrawer, btDispatcher* dispatcher) {
+
+		auto start = std::chrono::high_resolution_clock::now();
+		btScalar residual = btSequentialImpulseConstraintSolver::solveGroup(bodies, numBodies, manifolds, numManifolds,
+		                                                                    constraints, numConstraints, info, debugDrawer, dispatcher);
+		ms += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+		return residual;
+	}
+};
+
+// FNV-1a, over the exact bits so any difference at all shows up
+static unsigned int hashBytes(unsigned int hash, const void* data, size_t len) {
+
+	const unsigned char* bytes = (const unsigned char*)data;
+	for(size_t i = 0; i < len; i++) {
+		hash = (hash ^ bytes[i]) * 16777619u;
+	}
+	return hash;
+}
+
+static unsigned int hashVector(unsigned int hash, const btVector3& v) {
+
+	// not the whole btVector3, its padding is never written
+	btScalar xyz[3] = {v.x(), v.y(), v.z()};
+	return hashBytes(hash, xyz, sizeof(xyz));
+}
+
+unsigned int World::tick_rate = 120;
+
+// how far the flippers turn when held, in radians, and how fast they go up and come back down
+static const float FLIPPER_SWING = 0.8f, FLIPPER_UP = 15.0f, FLIPPER_DOWN = 3.0f;
 
 bool isRegularFile(std::string path) {
 
@@ -17,76 +64,65 @@ bool isRegularFile(std::string path) {
 }
 
 void World::CheckCollisions(unsigned int dT) {
-	
-	std::map<btCollisionObject*, std::pair<Object*,Object*>> collisions;
-
-	int manifolds = dispatcher->getNumManifolds();
-	for (int i = 0; i < manifolds; i++) {
-		btPersistentManifold* contact = dispatcher->getManifoldByIndexInternal(i);
-		btCollisionObject* a = (btCollisionObject*)contact->getBody0();
-		btCollisionObject* b = (btCollisionObject*)contact->getBody1();
-
-		int contacts = contact->getNumContacts();
-		for (int j = 0; j < contacts; j++) {
-			btManifoldPoint& pt = contact->getContactPoint(j);
-			
-			if (pt.getDistance() < 0.8f) {
-
-				if (collisions.find(a) == collisions.end()) {
-					collisions[a] = {(Object*)a->getUserPointer(), (Object*)b->getUserPointer()};
-				}
-				if (collisions.find(b) == collisions.end()) {
-					collisions[b] = {(Object*)a->getUserPointer(), (Object*)b->getUserPointer()};
-				}
-			}
-		}
-	}
 
-	for(Object* o : objects) {
-		if(Renderable* r = dynamic_cast<Renderable*>(o)) {
-			if(r->boost_cooldown > 0) r->boost_cooldown -= dT;
-			if(r->boost_cooldown <= 0) r->diffuse_boost = glm::vec3(0.0f);
+	for(unsigned int i = 0; i < boosted.size(); ) {
+		Renderable* r = boosted[i];
+		r->boost_cooldown -= dT;
+		if(r->boost_cooldown > 0) {
+			i++;
+			continue;
 		}
+		r->diffuse_boost = glm::vec3(0.0f);
+		boosted[i] = boosted.back();
+		boosted.pop_back();
 	}
 
-	static Object* last = nullptr;
+	// only balls listen for contacts, so a is always a ball
+	ContactEvent e;
+	while(Contacts::Pop(e)) {
+
+		if(!e.begin) continue;
+
+		Object *a = e.a, *b = e.b;
+		Object*& last = last_hit[a];
 
-	for(auto collision : collisions) {
-		Object *a = collision.second.first, *b = collision.second.second;
+		if(b->tag == TAG_POP_BUMPER) {
 
-		if(a->name == "Ball" && b->name == "CylinderBumpers") {
-			
 			if(last != b) {
 				score += 2;
-				last = b;
 				std::cout << "Score: " << score << std::endl;
 				m_sound->Play("bounce");
 			}
 
-			if(Renderable* r = dynamic_cast<Renderable*>(b)) {
+			int ri = components.renderable[b->entity];
+			if(ri >= 0) {
+				Renderable* r = components.renderables[ri];
+				if(r->boost_cooldown <= 0) boosted.push_back(r);
 				r->diffuse_boost = glm::vec3(0.4f);
 				r->boost_cooldown = 250;
 			}
-			break;
 		}
 
-		if(a->name == "Ball" && b->name == "Reset" && last != b) {
-			ball_c->Reset();
-			lives--;
-			reset = true;
-			last = b;
-			if(lives > 0)
-				m_sound->Play("hit_reset");
-			break;
+		if(b->tag == TAG_RESET) {
+
+			// extra balls just go back to where they started
+			int ci = components.collider[a->entity];
+			Collider* c = ci >= 0 ? components.colliders[ci] : nullptr;
+			if(c) c->Reset();
+
+			if(c == ball_c) {
+				lives--;
+				reset = true;
+				if(lives > 0)
+					m_sound->Play("hit_reset");
+			}
 		}
 
-		if(a->name == "Ball" && b->name == "Bumpers") {
+		if(b->tag == TAG_BUMPER) {
 			m_sound->Play("hit_bumper");
 		}
 
-		if(a->name == "Ball" && b->name != "Board" && b->name != "Ramp 2") {
-			last = b;
-		}
+		last = b;
 	}
 }
 
@@ -95,14 +131,13 @@ World::World() {
 
 World::~World() {
 
-	for(Object* o : objects) {
-		if(Collider* c = dynamic_cast<Collider*>(o)) {
-			btWorld->removeRigidBody(c->btBody);
-		}
+	// removing bodies ends their contacts, nobody is left to read about it
+	if(btWorld) Contacts::Uninstall(btWorld);
+
+	for(Collider* c : components.colliders) {
+		btWorld->removeRigidBody(c->btBody);
 	}
 
-	if(leftHinge) delete leftHinge;
-	if(rightHinge) delete rightHinge;
 	if(btWorld) delete btWorld;
 	if(solver) delete solver;
 	if(dispatcher) delete dispatcher;
@@ -114,17 +149,15 @@ World::~World() {
 	dispatcher = nullptr;
 	solver = nullptr;
 	btWorld = nullptr;
-	leftHinge = nullptr;
-	rightHinge = nullptr;
 
-	for(Object* o : objects) {
+	for(Object* o : components.objects) {
 		delete o;
 	}
 }
 
 void World::Reset() {
 
-	for(Object* o : objects) {
+	for(Object* o : components.objects) {
 		o->Reset();
 	}
 }
@@ -139,104 +172,143 @@ bool World::Initialize(Sound* sound) {
 
 	btGImpactCollisionAlgorithm::registerAlgorithm(dispatcher);
 
-	solver = new btSequentialImpulseConstraintSolver();
+	solver = new TimedSolver();
 
 	btWorld = new btDiscreteDynamicsWorld(dispatcher, broadphase, solver, collisionConfiguration);
 	btWorld->setGravity(btVector3(10, -10, 0));
 
+	Contacts::Install(btWorld);
+
 	return true;
 }
 
 void World::Update(unsigned int dT) {
 
-	btWorld->stepSimulation(dT / 1000.0f, 300, 1.0/120.0);
-	CheckCollisions(dT);
+	physics_ms = contacts_ms = solver_ms = 0.0;
+	contact_events = contacts_dropped = contact_points = ticks = 0;
+	substeps = ccd_hits = escapes = 0;
 
-	static const unsigned char* keys = SDL_GetKeyboardState(NULL);
+	// run as many whole ticks as dT covers, the rest carries over to the next frame
+		// a stall longer than a quarter second is let go, rather than spent catching up on
+	tick_time = std::min(tick_time + dT / 1000.0, 0.25);
+	while(tick_time >= 1.0 / tick_rate) {
+		tick_time -= 1.0 / tick_rate;
+		Step();
+	}
 
-	if (keys[SDL_SCANCODE_LEFT]) {
-		btTransform transform;
-		leftFlipper->btMotionState->getWorldTransform(transform);
-		btScalar yaw, pitch, roll;
+	Benchmark::physics_ms = physics_ms;
+	Benchmark::contacts_ms = contacts_ms;
+	Benchmark::solver_ms = solver_ms;
+	Benchmark::contact_events = contact_events;
+	Benchmark::contact_points = contact_points;
+	Benchmark::substeps = substeps;
+	Benchmark::ccd_hits = ccd_hits;
+	Benchmark::escapes = escapes;
+	Benchmark::awake = awake;
+	Benchmark::asleep = asleep;
 
-		btMatrix3x3 mat = btMatrix3x3(transform.getRotation());
-		mat.getEulerYPR(yaw, pitch, roll);
+	auto synced = std::chrono::high_resolution_clock::now();
 
-		if(2 * pitch + M_PI <= 4.7) {
-			leftFlipper->btBody->setAngularVelocity(btVector3(0, 15, 0));
-			m_sound->Play("activate_flipper");
-		} else {
-			leftFlipper->btBody->setAngularVelocity(btVector3(0, 0, 0));
-		}
-	} else {
-		btTransform transform;
-		leftFlipper->btMotionState->getWorldTransform(transform);
+	for(unsigned int i = 0; i < components.bodies.size(); i++) {
+
+		Collider* c = components.bodies[i];
+		Renderable* r = components.meshes[i];
 
-		btScalar yaw, pitch, roll;
+		btTransform transform;
+		btScalar mat[16];
 
-		btMatrix3x3 mat = btMatrix3x3(transform.getRotation());
-		mat.getEulerYPR(yaw, pitch, roll);
+		c->btMotionState->getWorldTransform(transform);
+		transform.getOpenGLMatrix(mat);
+		r->modelmx = glm::make_mat4(mat);
 
-		if(2 * pitch + M_PI >= 3.2) {
-			leftFlipper->btBody->setAngularVelocity(btVector3(0, -3, 0));
-		} else {
-			leftFlipper->btBody->setAngularVelocity(btVector3(0, 0, 0));
-		}
+		btQuaternion q = transform.getRotation();
+		glm::quat quat(q.w(),q.x(),q.y(),q.z());
+		r->rotmx = glm::mat4(quat);
 	}
 
-	if (keys[SDL_SCANCODE_RIGHT]) {
-		btTransform transform;
-		rightFlipper->btMotionState->getWorldTransform(transform);
-		btScalar yaw, pitch, roll;
+	objects_ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - synced).count();
 
-		btMatrix3x3 mat = btMatrix3x3(transform.getRotation());
-		mat.getEulerYPR(yaw, pitch, roll);
+	glm::vec3 position = glm::vec3(ball_r->modelmx[3]);
+	position = glm::vec3(position.x, position.y + 5, position.z);
+	spotlight->position = glm::vec4(position, 1);
+}
 
-		if(2 * pitch + M_PI >= 1.5) {
-			rightFlipper->btBody->setAngularVelocity(btVector3(0, -15, 0));
-			m_sound->Play("activate_flipper");
-		} else {
-			rightFlipper->btBody->setAngularVelocity(btVector3(0, 0, 0));
+void World::Step() {
+
+	if(replay && !replay->recording) {
+		Replay::Event e;
+		while(replay->Next(tick, e)) {
+			Press(e.input, e.down);
 		}
-	} else {
-		btTransform transform;
-		rightFlipper->btMotionState->getWorldTransform(transform);
+	}
 
-		btScalar yaw, pitch, roll;
+	// split the tick up so nothing moves further than max_travel in one go, CCD covers anything thinner
+		// only depends on the state, so a replay splits its ticks up the same way
+	unsigned int steps = 1;
+	if(max_travel > 0.0f) {
+		btScalar fastest = 0;
+		for(Collider* c : moving) {
+			fastest = std::max(fastest, c->btBody->getLinearVelocity().length2());
+		}
+		steps = (unsigned int)std::ceil(std::sqrt(fastest) / tick_rate / max_travel);
+		steps = std::min(std::max(steps, 1u), MAX_SUBSTEPS);
+	}
+
+	// fixed steps, no interpolation - the motion states hold exactly what was simulated
+	auto start = std::chrono::high_resolution_clock::now();
+	solver->ms = 0.0;
 
-		btMatrix3x3 mat = btMatrix3x3(transform.getRotation());
-		mat.getEulerYPR(yaw, pitch, roll);
+	unsigned int hits = 0;
+	for(unsigned int i = 0; i < steps; i++) {
 
-		if(2 * pitch + M_PI <= 3) {
-			rightFlipper->btBody->setAngularVelocity(btVector3(0, 3, 0));
-		} else {
-			rightFlipper->btBody->setAngularVelocity(btVector3(0, 0, 0));
+		// the flippers move a little every substep, so they hit with the velocity they turn at
+		MoveFlippers(1.0f / tick_rate / steps);
+		btWorld->stepSimulation(1.0 / tick_rate / steps, 0);
+
+		// a body whose move CCD had to stop short of would have gone through something without it
+		for(Collider* c : moving) {
+			if(c->ccd_radius > 0.0f && c->btBody->getHitFraction() < 1.0f) hits++;
 		}
 	}
 
+	auto stepped = std::chrono::high_resolution_clock::now();
 
-	for(Object* o : objects) {
+	// anything that got through anyway ends up outside the table, put it back where it started
+	unsigned int escaped = 0;
+	if(has_table) {
+		for(Collider* c : moving) {
 
-		Collider* c = dynamic_cast<Collider*>(o);
-		Renderable* r = dynamic_cast<Renderable*>(o);
-		if(c && r) {
+			if(c->tag != TAG_BALL) continue;
 
-			btTransform transform;
-			btScalar mat[16];
+			// a unit of slack, so a ball rolling along an edge isn't counted
+			btVector3 p = c->btBody->getWorldTransform().getOrigin();
+			btVector3 clamped = p;
+			clamped.setMax(table_min - btVector3(1, 1, 1));
+			clamped.setMin(table_max + btVector3(1, 1, 1));
+			if(clamped == p) continue;
 
-			c->btMotionState->getWorldTransform(transform);
-			transform.getOpenGLMatrix(mat);
-			r->modelmx = glm::make_mat4(mat);
-
-			btQuaternion q = transform.getRotation();
-			glm::quat quat(q.w(),q.x(),q.y(),q.z());
-			r->rotmx = glm::mat4(quat);
+			std::cerr << "Tick " << tick << ": " << c->name << " escaped the table" << std::endl;
+			c->Reset();
+			if(c == ball_c) reset = true;
+			escaped++;
 		}
 	}
 
-	glm::vec3 position = glm::vec3(ball_r->modelmx[3]);
-	position = glm::vec3(position.x, position.y + 5, position.z);
-	spotlight->position = glm::vec4(position, 1);
+	awake = asleep = 0;
+	for(Collider* c : moving) {
+		if(c->btBody->isActive()) awake++;
+		else asleep++;
+	}
+
+	unsigned int points = 0;
+	for(int i = 0; i < dispatcher->getNumManifolds(); i++) {
+		points += dispatcher->getManifoldByIndexInternal(i)->getNumContacts();
+	}
+
+	unsigned int events = Contacts::queued;
+	contacts_dropped += Contacts::dropped;
+	CheckCollisions(1000 / tick_rate);
+	Contacts::Clear();
 
 	if(lives == 0) {
 		playing = false;
@@ -245,6 +317,422 @@ void World::Update(unsigned int dT) {
 		gameover = true;
 		m_sound->Play("game_over");
 	}
+
+	tick++;
+	if(replay && tick % tick_rate == 0) {
+		replay->Hash(tick, StateHash());
+	}
+
+	// rewinding would undo inputs a replay has already been given
+	if(!replay && tick % tick_rate == 0) {
+		Save(history[history_head]);
+		history_head = (history_head + 1) % HISTORY;
+		history_size = std::min(history_size + 1, HISTORY);
+	}
+
+	// this tick's numbers for the simulation benchmark, Update adds them up for the frame
+	Benchmark::physics_ms = std::chrono::duration<double, std::milli>(stepped - start).count();
+	Benchmark::contacts_ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - stepped).count();
+	Benchmark::solver_ms = solver->ms;
+	Benchmark::contact_events = events;
+	Benchmark::contact_points = points;
+	Benchmark::substeps = steps;
+	Benchmark::ccd_hits = hits;
+	Benchmark::escapes = escaped;
+	Benchmark::awake = awake;
+	Benchmark::asleep = asleep;
+
+	substeps += steps;
+	ccd_hits += hits;
+	escapes += escaped;
+	physics_ms += Benchmark::physics_ms;
+	contacts_ms += Benchmark::contacts_ms;
+	solver_ms += solver->ms;
+	contact_events += events;
+	contact_points += points;
+	ticks++;
+}
+
+unsigned int World::StateHash() {
+
+	unsigned int hash = 2166136261u;
+
+	for(Collider* c : components.colliders) {
+
+		const btTransform& transform = c->btBody->getWorldTransform();
+		hash = hashVector(hash, transform.getOrigin());
+		for(int row = 0; row < 3; row++) {
+			hash = hashVector(hash, transform.getBasis()[row]);
+		}
+		hash = hashVector(hash, c->btBody->getLinearVelocity());
+		hash = hashVector(hash, c->btBody->getAngularVelocity());
+	}
+
+	int game[] = {score, lives, power, playing, reset};
+	return hashBytes(hash, game, sizeof(game));
+}
+
+void World::Save(Snapshot& snapshot) {
+
+	snapshot.bodies.resize(moving.size());
+
+	for(unsigned int i = 0; i < moving.size(); i++) {
+
+		const btRigidBody* body = moving[i]->btBody;
+		const btTransform& transform = body->getWorldTransform();
+		Snapshot::Body& b = snapshot.bodies[i];
+
+		for(int row = 0; row < 3; row++) {
+			const btVector3& r = transform.getBasis()[row];
+			b.basis[row * 3] = r.x();
+			b.basis[row * 3 + 1] = r.y();
+			b.basis[row * 3 + 2] = r.z();
+		}
+
+		const btVector3& origin = transform.getOrigin();
+		const btVector3& linear = body->getLinearVelocity();
+		const btVector3& angular = body->getAngularVelocity();
+		b.origin[0] = origin.x(); b.origin[1] = origin.y(); b.origin[2] = origin.z();
+		b.linear[0] = linear.x(); b.linear[1] = linear.y(); b.linear[2] = linear.z();
+		b.angular[0] = angular.x(); b.angular[1] = angular.y(); b.angular[2] = angular.z();
+
+		b.activation = body->getActivationState();
+		b.deactivation = body->getDeactivationTime();
+	}
+
+	snapshot.constraints.resize(btWorld->getNumConstraints());
+	for(int i = 0; i < btWorld->getNumConstraints(); i++) {
+		snapshot.constraints[i] = btWorld->getConstraint(i)->internalGetAppliedImpulse();
+	}
+
+	snapshot.boosted.clear();
+	for(Renderable* r : boosted) {
+		snapshot.boosted.push_back({r->entity, r->boost_cooldown});
+	}
+	snapshot.last_hit.clear();
+	for(auto& hit : last_hit) {
+		if(hit.second) snapshot.last_hit.push_back({hit.first->entity, hit.second->entity});
+	}
+
+	snapshot.score = score;
+	snapshot.lives = lives;
+	snapshot.power = power;
+	snapshot.playing = playing;
+	snapshot.reset = reset;
+	snapshot.gameover = gameover;
+	snapshot.left_held = left_held;
+	snapshot.right_held = right_held;
+	snapshot.left_angle = left_angle;
+	snapshot.right_angle = right_angle;
+	snapshot.tick = tick;
+}
+
+bool World::Restore(const Snapshot& snapshot) {
+
+	if(snapshot.bodies.size() != moving.size() || snapshot.constraints.size() != (size_t)btWorld->getNumConstraints()) {
+		std::cerr << "Snapshot of " << snapshot.bodies.size() << " bodies doesn't fit a world of " << moving.size() << std::endl;
+		return false;
+	}
+
+	for(unsigned int i = 0; i < moving.size(); i++) {
+
+		Collider* c = moving[i];
+		btRigidBody* body = c->btBody;
+		const Snapshot::Body& b = snapshot.bodies[i];
+
+		btTransform transform(btMatrix3x3(b.basis[0], b.basis[1], b.basis[2],
+		                                  b.basis[3], b.basis[4], b.basis[5],
+		                                  b.basis[6], b.basis[7], b.basis[8]),
+		                      btVector3(b.origin[0], b.origin[1], b.origin[2]));
+		btVector3 linear(b.linear[0], b.linear[1], b.linear[2]);
+		btVector3 angular(b.angular[0], b.angular[1], b.angular[2]);
+
+		body->setWorldTransform(transform);
+		body->setInterpolationWorldTransform(transform);
+		c->btMotionState->setWorldTransform(transform);
+
+		body->setLinearVelocity(linear);
+		body->setAngularVelocity(angular);
+		body->setInterpolationLinearVelocity(linear);
+		body->setInterpolationAngularVelocity(angular);
+		body->clearForces();
+
+		body->forceActivationState(b.activation);
+		body->setDeactivationTime(b.deactivation);
+	}
+
+	for(int i = 0; i < btWorld->getNumConstraints(); i++) {
+		btWorld->getConstraint(i)->internalSetAppliedImpulse(snapshot.constraints[i]);
+	}
+
+	// the cached points describe wherever the bodies were a moment ago
+		// clearing them ends their contacts, nothing should hear about that
+	for(int i = 0; i < dispatcher->getNumManifolds(); i++) {
+		dispatcher->getManifoldByIndexInternal(i)->clearManifold();
+	}
+	Contacts::Clear();
+	solver->reset();
+
+	for(Renderable* r : boosted) {
+		r->boost_cooldown = 0;
+		r->diffuse_boost = glm::vec3(0.0f);
+	}
+	boosted.clear();
+	for(auto& b : snapshot.boosted) {
+		Renderable* r = components.renderables[components.renderable[b.first]];
+		r->boost_cooldown = b.second;
+		r->diffuse_boost = glm::vec3(0.4f);
+		boosted.push_back(r);
+	}
+	last_hit.clear();
+	for(auto& hit : snapshot.last_hit) {
+		last_hit[components.objects[hit.first]] = components.objects[hit.second];
+	}
+
+	score = snapshot.score;
+	lives = snapshot.lives;
+	power = snapshot.power;
+	playing = snapshot.playing;
+	reset = snapshot.reset;
+	gameover = snapshot.gameover;
+	left_held = snapshot.left_held;
+	right_held = snapshot.right_held;
+	left_angle = snapshot.left_angle;
+	right_angle = snapshot.right_angle;
+	tick = snapshot.tick;
+
+	return true;
+}
+
+void World::Rewind() {
+
+	if(replay || !history_size) return;
+
+	history_head = (history_head + HISTORY - 1) % HISTORY;
+	history_size--;
+	if(Restore(history[history_head])) {
+		std::cout << "Rewound to tick " << tick << std::endl;
+	}
+}
+
+bool World::AddSpheres(World& world, unsigned int count, const std::string& sphere) {
+
+	// a floor, and count spheres dropped on it in layers of 100 x 100 - no models, so no GL either
+	std::string floor = "{\"type\": \"plane\", \"name\": \"Floor\", \"shape\": [0, 1, 0, 0], \"tag\": \"surface\"}";
+
+	Object* o = Object::LoadJSON(floor);
+	if(!o || !world.AddObject(o)) {
+		delete o;
+		return false;
+	}
+
+	const unsigned int side = 100;
+	for(unsigned int n = 0; n < count; n++) {
+
+		o = Object::LoadJSON(sphere);
+		Collider* c = dynamic_cast<Collider*>(o);
+		if(!c) {
+			delete o;
+			return false;
+		}
+		c->position = glm::vec3((n % side) * 1.0f, 0.5f + n / (side * side), (n / side % side) * 1.0f);
+		if(!world.AddObject(o)) {
+			delete o;
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void World::SnapshotBenchmark(unsigned int count, unsigned int repeats) {
+
+	if(!count) return;
+
+	World world;
+	world.Initialize(nullptr);
+
+	if(!AddSpheres(world, count, "{\"type\": \"sphere\", \"name\": \"Sphere\", \"shape\": 0.4, \"mass\": 1, \"tag\": \"ball\"}")) {
+		return;
+	}
+
+	// let them land, so there are contacts to throw away on every restore
+	for(unsigned int i = 0; i < tick_rate; i++) {
+		world.btWorld->stepSimulation(1.0 / tick_rate, 0);
+	}
+
+	// sized once here, the timed saves only copy
+	Snapshot snapshot;
+	world.Save(snapshot);
+
+	double save_ms = 0.0, restore_ms = 0.0;
+	bool matched = true, repeated = true;
+
+	for(unsigned int i = 0; i < repeats; i++) {
+
+		// move everything on so restoring has something to undo
+		world.btWorld->stepSimulation(1.0 / tick_rate, 0);
+
+		auto start = std::chrono::high_resolution_clock::now();
+		world.Save(snapshot);
+		auto saved = std::chrono::high_resolution_clock::now();
+
+		world.btWorld->stepSimulation(1.0 / tick_rate, 0);
+		unsigned int original = world.StateHash();
+
+		auto stepped = std::chrono::high_resolution_clock::now();
+		world.Restore(snapshot);
+		auto restored = std::chrono::high_resolution_clock::now();
+
+		save_ms += std::chrono::duration<double, std::milli>(saved - start).count();
+		restore_ms += std::chrono::duration<double, std::milli>(restored - stepped).count();
+
+		// the same step again from the restored state, twice - it starts without the cached contacts the original had
+		world.btWorld->stepSimulation(1.0 / tick_rate, 0);
+		unsigned int first = world.StateHash();
+		world.Restore(snapshot);
+		world.btWorld->stepSimulation(1.0 / tick_rate, 0);
+
+		matched = matched && first == original;
+		repeated = repeated && world.StateHash() == first;
+	}
+
+	printf("%u bodies, %.1f KB snapshot: save %.4f ms, restore %.4f ms\n", count, snapshot.Bytes() / 1024.0, save_ms / repeats, restore_ms / repeats);
+	printf("  stepping after a restore %s the original step, and %s every time\n", matched ? "matched" : "differed from", repeated ? "came out the same" : "came out differently");
+}
+
+void World::SleepBenchmark(unsigned int count, unsigned int ticks) {
+
+	if(!count || !ticks) return;
+
+	for(int sleeping = 0; sleeping < 2; sleeping++) {
+
+		World world;
+		world.Initialize(nullptr);
+
+		std::string sphere = "{\"type\": \"sphere\", \"name\": \"Sphere\", \"shape\": 0.4, \"mass\": 1, \"tag\": \"ball\"";
+		sphere += sleeping ? "}" : ", \"sleep_linear\": -1}";
+		if(!AddSpheres(world, count, sphere)) {
+			return;
+		}
+
+		// land and stay still past bullet's two seconds, so the ones that can are asleep by now
+		for(unsigned int i = 0; i < 3 * tick_rate; i++) {
+			world.btWorld->stepSimulation(1.0 / tick_rate, 0);
+		}
+
+		auto start = std::chrono::high_resolution_clock::now();
+		for(unsigned int i = 0; i < ticks; i++) {
+			world.btWorld->stepSimulation(1.0 / tick_rate, 0);
+		}
+		double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+		unsigned int awake = 0;
+		for(Collider* c : world.moving) {
+			if(c->btBody->isActive()) awake++;
+		}
+
+		printf("%u resting bodies, %s: %.4f ms/step, %u awake\n", count, sleeping ? "left to sleep" : "kept awake", ms / ticks, awake);
+	}
+}
+
+void World::SceneBenchmark(unsigned int count) {
+
+	if(!count) return;
+
+	// count spheres off one template, each with its own name and place
+	std::ostringstream text;
+	text << "{\"templates\": {\"sphere\": {\"type\": \"sphere\", \"shape\": 0.4, \"mass\": 1, \"tag\": \"ball\", \"restitution\": 0.5}},\n\"objects\": [\n";
+	for(unsigned int n = 0; n < count; n++) {
+		text << (n ? ",\n" : "") << "{\"template\": \"sphere\", \"name\": \"Sphere " << n << "\", \"position\": [" << n % 100 << ", " << 0.5f + n / 10000 << ", " << n / 100 % 100 << "]}";
+	}
+	text << "\n]}\n";
+
+	const std::string path = "scene_benchmark.json";
+	std::ofstream fout(path, std::ios::binary);
+	fout << text.str();
+	fout.close();
+	std::remove((path + ".bin").c_str());
+
+	SceneFile& reader = Object::Reader();
+	unsigned int seen = 0;
+	auto counter = [&](const SceneFile::Fields&) { seen++; return true; };
+
+	// what a DOM parser does with the same text before a single object's been made
+	auto start = std::chrono::high_resolution_clock::now();
+	picojson::value dom;
+	std::string err = picojson::parse(dom, text.str());
+	double dom_ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	if(!err.empty()) std::cerr << "picojson: " << err << std::endl;
+
+	// first load parses the text and writes the compiled form, the second reads that
+	bool ok = reader.Load(path, counter);
+	double text_ms = reader.load_ms;
+	ok = ok && reader.Load(path, counter) && reader.from_cache;
+	double cached_ms = reader.load_ms;
+
+	// and with the objects made too, as LoadScene does
+	double create_ms = 0.0;
+	ok = ok && reader.Load(path, [&](const SceneFile::Fields& fields) {
+		auto made = std::chrono::high_resolution_clock::now();
+		delete Object::Create(fields);
+		create_ms += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - made).count();
+		return true;
+	});
+
+	std::remove(path.c_str());
+	std::remove((path + ".bin").c_str());
+
+	if(!ok || seen != 2 * count) {
+		std::cerr << "Scene benchmark failed, " << seen << " objects seen out of " << 2 * count << std::endl;
+		return;
+	}
+
+	printf("%u objects, %.1f KB of text:\n", count, text.str().size() / 1024.0);
+	printf("  picojson DOM %.2f ms, streamed from text %.2f ms, from the compiled file %.2f ms, making the objects %.2f ms more\n",
+	       dom_ms, text_ms, cached_ms, create_ms);
+}
+
+void World::MoveFlippers(float dt) {
+
+	// up fast while held, back down slower once let go
+	SwingFlipper(leftFlipper, left_angle, left_held ? FLIPPER_SWING : 0.0f, left_held ? FLIPPER_UP : FLIPPER_DOWN, dt);
+	SwingFlipper(rightFlipper, right_angle, right_held ? -FLIPPER_SWING : 0.0f, right_held ? FLIPPER_UP : FLIPPER_DOWN, dt);
+}
+
+void World::SwingFlipper(Collider* flipper, float& angle, float target, float speed, float dt) {
+
+	if(!flipper) return;
+
+	if(angle != target) {
+
+		float step = speed * dt;
+		angle = angle < target ? std::min(angle + step, target) : std::max(angle - step, target);
+
+		// a ball resting on it would otherwise only find out a step late
+		Wake(flipper->btBody);
+	}
+
+	// set every step, so a Reset that put it back flat doesn't stick while the button's held
+	btTransform transform(btQuaternion(btVector3(0, 1, 0), angle), btVector3(flipper->position.x, flipper->position.y, flipper->position.z));
+	flipper->btMotionState->setWorldTransform(transform);
+}
+
+void World::Wake(btRigidBody* body) {
+
+	for(int i = 0; i < dispatcher->getNumManifolds(); i++) {
+
+		btPersistentManifold* manifold = dispatcher->getManifoldByIndexInternal(i);
+		if(!manifold->getNumContacts()) continue;
+
+		const btCollisionObject* other = nullptr;
+		if(manifold->getBody0() == body) other = manifold->getBody1();
+		if(manifold->getBody1() == body) other = manifold->getBody0();
+
+		if(other && !other->isActive()) {
+			other->activate();
+		}
+	}
 }
 
 std::ostream& operator<<(std::ostream& out, glm::vec3 vec) {
@@ -253,31 +741,96 @@ std::ostream& operator<<(std::ostream& out, glm::vec3 vec) {
 
 void World::KeyboardEvts(SDL_Event e) {
 
-	if(e.type == SDL_KEYDOWN) {
+	if(e.type != SDL_KEYDOWN && e.type != SDL_KEYUP) return;
+	bool down = e.type == SDL_KEYDOWN;
 
-		if(e.key.keysym.sym == SDLK_RETURN && reset) {
-			reset = false;
+	// the flippers follow the key being held, so repeats don't mean anything to them
+	if(e.key.keysym.sym == SDLK_LEFT && !e.key.repeat) {
+		Input(INPUT_LEFT, down);
+	}
+	if(e.key.keysym.sym == SDLK_RIGHT && !e.key.repeat) {
+		Input(INPUT_RIGHT, down);
+	}
 
-			ball_c->btBody->applyCentralImpulse(btVector3(-27 - power * 3,0,0));
-			if(!playing) {
-				playing = true;
-				gameover = false;
-				score = 0;
-			} 
-			m_sound->Play("launch_ball");
+	if(down) {
+		if(e.key.keysym.sym == SDLK_BACKSPACE) {
+			Rewind();
+		}
+		if(e.key.keysym.sym == SDLK_RETURN) {
+			Input(INPUT_LAUNCH, true);
 		}
-
 		if(e.key.keysym.sym == SDLK_UP) {
-			power += 1;
-			if(power > 10) power = 10;
+			Input(INPUT_POWER_UP, true);
 		}
 		if(e.key.keysym.sym == SDLK_DOWN) {
-			power -= 1;
-			if(power < 0) power = 0;
+			Input(INPUT_POWER_DOWN, true);
 		}
 	}
 }
 
+void World::Input(int input, bool down) {
+
+	// the replay is in charge while it plays
+	if(replay && !replay->recording) return;
+
+	if(replay) {
+		replay->Record(tick, input, down);
+	}
+	Press(input, down);
+}
+
+void World::Press(int input, bool down) {
+
+	// once per press, not once per substep while it swings up
+	if((input == INPUT_LEFT && down && !left_held) || (input == INPUT_RIGHT && down && !right_held)) {
+		m_sound->Play("activate_flipper");
+	}
+
+	if(input == INPUT_LEFT) {
+		left_held = down;
+	}
+	if(input == INPUT_RIGHT) {
+		right_held = down;
+	}
+
+	if(input == INPUT_LAUNCH && down && reset) {
+		reset = false;
+
+		// it's been sitting there long enough to fall asleep, and an impulse alone doesn't wake it
+		ball_c->btBody->activate(true);
+		ball_c->btBody->applyCentralImpulse(btVector3(-27 - power * 3,0,0));
+		if(!playing) {
+			playing = true;
+			gameover = false;
+			score = 0;
+		} 
+		m_sound->Play("launch_ball");
+	}
+
+	if(input == INPUT_POWER_UP && down) {
+		power += 1;
+		if(power > 10) power = 10;
+	}
+	if(input == INPUT_POWER_DOWN && down) {
+		power -= 1;
+		if(power < 0) power = 0;
+	}
+}
+
+void World::SetReplay(Replay* replay) {
+
+	this->replay = replay;
+	if(!replay) return;
+
+	// a new world starts a new recording, or plays the old one from the top
+	if(replay->recording) {
+		replay->Clear();
+		replay->rate = tick_rate;
+	} else {
+		replay->Rewind();
+	}
+}
+
 void World::UI(Text* t) {
 
 	std::stringstream sscore, slives, spower;
@@ -301,17 +854,34 @@ void World::UI(Text* t) {
 		t->AddText("up/down to adjust power  |  left/right flippers", {-26, 4.5, 7.2}, {0, 0, -1}, 55.0f);
 	}
 
+	ImGui::Separator();
+	ImGui::Text("Physics");
+	ImGui::Text("Step: %.2f ms (solver %.2f ms), contacts: %.3f ms", physics_ms, solver_ms, contacts_ms);
+	ImGui::Text("Tick: %u, %u this frame at %u Hz, contact points: %u", tick, ticks, tick_rate, contact_points);
+	ImGui::Text("Substeps: %u, CCD hits: %u, escaped: %u", substeps, ccd_hits, escapes);
+	ImGui::Text("Bodies: %u awake, %u asleep, %u static", awake, asleep, (unsigned int)(components.colliders.size() - moving.size()));
+	if(replay && replay->recording) {
+		ImGui::Text("Recording replay");
+	} else if(replay && replay->diverged) {
+		ImGui::Text("Replay diverged at tick %u", replay->diverged);
+	} else if(replay) {
+		ImGui::Text("Replaying, %u hashes matched", replay->checked);
+	}
+	ImGui::Text("Contact events: %u (%u dropped), manifolds: %d", contact_events, contacts_dropped, dispatcher->getNumManifolds());
+	ImGui::Text("Objects: %u, object loops: %.3f ms", components.Size(), objects_ms);
+
 	if(ImGui::CollapsingHeader("Object Properties")) {
-		int idx = 0;
 		ImGui::Indent();
-		for(Object* o : objects) {
+		for(unsigned int idx = 0; idx < components.Size(); idx++) {
+			Object* o = components.objects[idx];
+			int ci = components.collider[idx], ri = components.renderable[idx], li = components.light[idx];
 			ImGui::PushID(idx);
-			idx++;
 
 			if(ImGui::CollapsingHeader(o->name.c_str())) {
 				ImGui::Indent();
 
-				if(Collider* c = dynamic_cast<Collider*>(o)) {
+				if(ci >= 0) {
+					Collider* c = components.colliders[ci];
 					ImGui::SliderFloat("Mass", &c->mass, 0.0f, 5.0f);
 					ImGui::SliderFloat("Restitution", &c->restitution, 0.0f, 1.0f);
 					if(ImGui::Button("Reset")) {
@@ -319,7 +889,8 @@ void World::UI(Text* t) {
 					}
 				}
 
-				if(Renderable* r = dynamic_cast<Renderable*>(o)) {
+				if(ri >= 0) {
+					Renderable* r = components.renderables[ri];
 
 					ImGui::Text("Model: %s", r->model.c_str());
 					ImGui::Text("Texture: %s", r->texture.c_str());
@@ -353,7 +924,8 @@ void World::UI(Text* t) {
 					ImGui::SliderFloat("Shine", &r->shine, 0.1f, 20.0f);
 				}
 
-				if(Light* l = dynamic_cast<Light*>(o)) {
+				if(li >= 0) {
+					Light* l = components.lights[li];
 					if(ImGui::CollapsingHeader("Position")) {
 						ImGui::PushID(3);
 						ImGui::Indent();
@@ -419,127 +991,255 @@ void World::UI(Text* t) {
 void World::Render(ShaderInfo info) {
 
 	// locations
-	GLint num_lights_loc, ambient_color_loc, model_loc;
+	GLint num_lights_loc, ambient_color_loc;
 	num_lights_loc = info.shader->GetUniformLocation("num_lights");
 	ambient_color_loc = info.shader->GetUniformLocation("ambient_color");
-	model_loc = info.shader->GetUniformLocation("model");
-
-	GLint obj_ambient_loc, obj_diffuse_loc, obj_specular_loc, obj_shine_loc;
-	obj_ambient_loc = info.shader->GetUniformLocation("object.ambient");
-	obj_diffuse_loc = info.shader->GetUniformLocation("object.diffuse");
-	obj_specular_loc = info.shader->GetUniformLocation("object.specular");
-	obj_shine_loc = info.shader->GetUniformLocation("object.shine");
 
 	int num_lights = 0;
-	for(Object* o : objects) {
+	for(Light* p : components.lights) {
 		if(num_lights >= 16) break;
 
-		if(Light* p = dynamic_cast<Light*>(o)) {
-
-			std::string light = "lights[" + std::to_string(num_lights) + "].";
+		std::string light = "lights[" + std::to_string(num_lights) + "].";
 
-			glUniform4fv(info.shader->GetUniformLocation((light + "pos").c_str()), 1, glm::value_ptr(p->position));
-			glUniform3fv(info.shader->GetUniformLocation((light + "diffuse_color").c_str()), 1, glm::value_ptr(p->diffuse_color));
-			glUniform3fv(info.shader->GetUniformLocation((light + "specular_color").c_str()), 1, glm::value_ptr(p->specular_color));
-			glUniform1f(info.shader->GetUniformLocation((light + "constant_attenuation").c_str()), p->constant_atten);
-			glUniform1f(info.shader->GetUniformLocation((light + "linear_attenuation").c_str()), p->linear_atten);
-			glUniform1f(info.shader->GetUniformLocation((light + "quadratic_attenuation").c_str()), p->quad_atten);
-			glUniform3fv(info.shader->GetUniformLocation((light + "spotlight_direction").c_str()), 1, glm::value_ptr(p->spotlight_dir));
-			glUniform1f(info.shader->GetUniformLocation((light + "spotlight_cutoff").c_str()), p->spotlight_cutoff);
-			glUniform1f(info.shader->GetUniformLocation((light + "spotlight_exponent").c_str()), p->spotlight_exp);
+		glUniform4fv(info.shader->GetUniformLocation((light + "pos").c_str()), 1, glm::value_ptr(p->position));
+		glUniform3fv(info.shader->GetUniformLocation((light + "diffuse_color").c_str()), 1, glm::value_ptr(p->diffuse_color));
+		glUniform3fv(info.shader->GetUniformLocation((light + "specular_color").c_str()), 1, glm::value_ptr(p->specular_color));
+		glUniform1f(info.shader->GetUniformLocation((light + "constant_attenuation").c_str()), p->constant_atten);
+		glUniform1f(info.shader->GetUniformLocation((light + "linear_attenuation").c_str()), p->linear_atten);
+		glUniform1f(info.shader->GetUniformLocation((light + "quadratic_attenuation").c_str()), p->quad_atten);
+		glUniform3fv(info.shader->GetUniformLocation((light + "spotlight_direction").c_str()), 1, glm::value_ptr(p->spotlight_dir));
+		glUniform1f(info.shader->GetUniformLocation((light + "spotlight_cutoff").c_str()), p->spotlight_cutoff);
+		glUniform1f(info.shader->GetUniformLocation((light + "spotlight_exponent").c_str()), p->spotlight_exp);
 
-			num_lights++;
-		}
+		num_lights++;
 	}
 	glUniform1i(num_lights_loc, num_lights);
+	glUniform3fv(ambient_color_loc, 1, glm::value_ptr(info.default_ambient));
 
-	for(Object* o : objects) {
+	auto start = std::chrono::high_resolution_clock::now();
 
-		if(Renderable* r = dynamic_cast<Renderable*>(o)) {
+	// model matrix and material go with each instance, objects sharing a model and texture are drawn together
+	for(Renderable* r : components.renderables) {
 
-			glm::mat4 scalemx = glm::scale(glm::mat4(1.0f), glm::vec3(r->scale));
+		Scene::Instance i;
+		i.model = r->modelmx * glm::scale(glm::mat4(1.0f), glm::vec3(r->scale));
+		i.ambient = r->ambient;
+		i.diffuse = r->diffuse + r->diffuse_boost;
+		i.specular = r->specular;
+		i.shine = r->shine;
 
-			glUniform3fv(ambient_color_loc, 1, glm::value_ptr(info.default_ambient));
-			glUniform3fv(obj_ambient_loc, 1, glm::value_ptr(r->ambient));
-			glUniform3fv(obj_diffuse_loc, 1, glm::value_ptr(r->diffuse + r->diffuse_boost));
-			glUniform3fv(obj_specular_loc, 1, glm::value_ptr(r->specular));
-			glUniform1f(obj_shine_loc, r->shine);
-			glUniformMatrix4fv(model_loc, 1, GL_FALSE, glm::value_ptr(r->modelmx * scalemx));
+		Instancer::Add(r->s, i);
+	}
+
+	objects_ms += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	Benchmark::objects_ms = objects_ms;
 
-			r->s.Render();
+	if(stress_source) {
+		for(const Scene::Instance& i : stress) {
+			Instancer::Add(stress_source->s, i);
 		}
 	}
+
+	Instancer::Flush();
 }
 
-bool World::LoadObjects(std::string dir) {
+void World::Stress(unsigned int count) {
+
+	stress.clear();
+	stress_source = ball_r;
+	if(!count || !stress_source) return;
 
-	DIR *directory;
-	dirent *entry;
-	std::string dirPath = dir;
+	// a cube of copies of the ball floating over the table, render only
+	int side = (int)ceil(cbrt((double)count));
+	float spacing = 0.6f;
+	glm::vec3 corner = glm::vec3(-side * spacing / 2.0f, 2.0f, -side * spacing / 2.0f);
 
-	if (dirPath.back() != '/' && dirPath.back() != '\\') {
-		dirPath.append("/");
+	stress.reserve(count);
+	for(unsigned int n = 0; n < count; n++) {
+
+		int x = n % side, y = n / side % side, z = n / (side * side);
+		glm::vec3 pos = corner + glm::vec3(x, y, z) * spacing;
+
+		Scene::Instance i;
+		i.model = glm::scale(glm::translate(glm::mat4(1.0f), pos), glm::vec3(stress_source->scale * 0.4f));
+		i.ambient = stress_source->ambient;
+		i.diffuse = glm::vec3(x, y, z) / (float)side;
+		i.specular = stress_source->specular;
+		i.shine = stress_source->shine;
+		stress.push_back(i);
 	}
 
-	directory = opendir(dirPath.c_str());
-	if (!directory) {
-		std::cerr << "Failed to open directory at " << dirPath << std::endl;
-		return false;
+	std::cout << "Stress test: " << count << " extra instances" << std::endl;
+}
+
+void World::Multiball(unsigned int count) {
+
+	if(!count) return;
+
+	const SceneFile::Fields* ball = Object::Reader().Template("ball");
+	if(!ball) {
+		std::cerr << "The scene has no ball template to copy" << std::endl;
+		return;
 	}
 
-	while((entry = readdir(directory))) {
-		std::string entryName = entry->d_name;
+	// a grid under the glass between the bumpers and the flippers, two layers deep
+	const float spacing = 0.9f;
+	const int rows = 13, columns = 24;
 
-		if(entryName != ".." && entryName != "." && isRegularFile(dirPath + entryName)) {
+	unsigned int added = 0;
+	for(unsigned int n = 0; n < count; n++) {
 
-			std::cout << "Loading object "<< entryName << std::endl;
-			if(!LoadObject(dirPath + entryName)) {
-				std::cerr << "Failed to load object from file " << entryName << std::endl;
-			}
+		int column = n % columns, row = n / columns % rows, layer = n / (columns * rows);
+		if(layer > 1) {
+			std::cerr << "Only room for " << added << " extra balls" << std::endl;
+			break;
+		}
+
+		Object* o = Object::Create(*ball);
+		Collider* c = dynamic_cast<Collider*>(o);
+		if(!c) {
+			std::cerr << "The ball template isn't a collider" << std::endl;
+			delete o;
+			break;
+		}
+
+		o->name = "Multiball";
+		c->position = glm::vec3(-17.0f + column * spacing, 0.8f + layer * spacing, -7.0f + row * spacing);
+		c->velocity = glm::vec3(0.0f);
+
+		if(!AddObject(o)) {
+			delete o;
+			break;
 		}
+		added++;
 	}
 
-	closedir(directory);
+	std::cout << "Multiball: " << added << " extra balls" << std::endl;
+}
 
-	return true;
+void World::Clutter(unsigned int count) {
+
+	if(!count) return;
+
+	const SceneFile::Fields* bumper = Object::Reader().Template("small_bumper");
+	if(!bumper) {
+		std::cerr << "The scene has no small_bumper template to copy" << std::endl;
+		return;
+	}
+
+	// a square of static bumpers under the table, out of the way of everything
+	const float spacing = 1.2f;
+	int side = (int)ceil(sqrt((double)count));
+
+	unsigned int added = 0;
+	for(unsigned int n = 0; n < count; n++) {
+
+		Object* o = Object::Create(*bumper);
+		Collider* c = dynamic_cast<Collider*>(o);
+		if(!c) {
+			std::cerr << "The small_bumper template isn't a collider" << std::endl;
+			delete o;
+			break;
+		}
+
+		o->name = "Clutter";
+		o->tag = TAG_NONE;
+		c->mass = 0;
+		c->position = glm::vec3((n % side - side / 2) * spacing, -4.0f, (n / side - side / 2) * spacing);
+
+		if(!AddObject(o)) {
+			delete o;
+			break;
+		}
+		added++;
+	}
+
+	std::cout << "Clutter: " << added << " extra objects" << std::endl;
 }
 
-bool World::LoadObject(std::string path) {
+bool World::LoadScene(std::string path) {
 
-	std::string contents;
-	std::ifstream fin(path);
-	getline(fin, contents, '\0');
+	// objects are made as the file's read, and bodies added after in the same order, so every run simulates the same
+	std::vector<Object*> loaded;
+	bool ok = Object::Reader().Load(path, [&](const SceneFile::Fields& fields) {
+		Object* o = Object::Create(fields);
+		if(!o) std::cerr << "Object " << loaded.size() << " in " << path << " has no type that exists" << std::endl;
+		loaded.push_back(o);
+		return true;
+	});
 
-	Object* o = Object::LoadJSON(contents);
-	if(!o) {
-		printf("Failed to load object from JSON\n");
+	if(!ok) {
+		for(Object* o : loaded) delete o;
+		std::cerr << "Failed to load scene " << path << std::endl;
 		return false;
 	}
 
+	const SceneFile& reader = Object::Reader();
+	printf("Scene %s: %u objects %s in %.2f ms\n", path.c_str(), reader.objects, reader.from_cache ? "read compiled" : "parsed", reader.load_ms);
+
+	// start every model and texture loading before a mesh collider has to wait on one
+	for(Object* o : loaded) {
+		if(Renderable* r = dynamic_cast<Renderable*>(o)) {
+			r->Renderable::Setup();
+		}
+	}
+
+	for(unsigned int i = 0; i < loaded.size(); i++) {
+
+		if(!loaded[i]) continue;
+		if(!AddObject(loaded[i])) {
+			std::cerr << "Failed to set up object " << i << ", " << loaded[i]->name << std::endl;
+			delete loaded[i];
+		}
+	}
+
+	return true;
+}
+
+bool World::AddObject(Object* o) {
+
 	if(!o->Setup()) {
 		return false;
 	}
 
+	unsigned int id = components.Add(o);
+	int ci = components.collider[id], ri = components.renderable[id], li = components.light[id];
+
 	if(o->name == "Ball") {
-		ball_r = dynamic_cast<Renderable*>(o);
-		ball_c = dynamic_cast<Collider*>(o);
+		ball_r = ri >= 0 ? components.renderables[ri] : nullptr;
+		ball_c = ci >= 0 ? components.colliders[ci] : nullptr;
 	}
 	if(o->name == "Spotlight") {
-		spotlight = dynamic_cast<Light*>(o);
+		spotlight = li >= 0 ? components.lights[li] : nullptr;
 	}
 
-	if(Collider* c = dynamic_cast<Collider*>(o)) {
-		btWorld->addRigidBody(c->btBody);
+	if(ci >= 0) {
+		Collider* c = components.colliders[ci];
+		btWorld->addRigidBody(c->btBody, 1 << o->tag, c->collides);
+		if(!c->btBody->isStaticObject()) {
+			moving.push_back(c);
+			if(c->ccd_radius > 0.0f && (max_travel == 0.0f || c->ccd_radius < max_travel)) {
+				max_travel = c->ccd_radius;
+			}
+		} else if((o->tag == TAG_SURFACE || o->tag == TAG_WALL) && c->btShape->getShapeType() != STATIC_PLANE_PROXYTYPE) {
+
+			btVector3 min, max;
+			c->btBody->getAabb(min, max);
+			if(!has_table) {
+				table_min = min;
+				table_max = max;
+				has_table = true;
+			}
+			table_min.setMin(min);
+			table_max.setMax(max);
+		}
 
+		// turned by MoveFlippers, they need to be kinematic for that
 		if(o->name == "Left Flipper") {
-			leftFlipper = c;
-			leftHinge = new btHingeConstraint(*(c->btBody), btVector3(0,0,0), btVector3(0,1,0), true);
-			btWorld->addConstraint(leftHinge);
+			leftFlipper = c->kinematic ? c : nullptr;
 		}
 		if(o->name == "Right Flipper") {
-			rightFlipper = c;
-			rightHinge = new btHingeConstraint(*(c->btBody), btVector3(0,0,0), btVector3(0,1,0), true);
-			btWorld->addConstraint(rightHinge);
+			rightFlipper = c->kinematic ? c : nullptr;
 		}
 		if(o->name == "Reset") {
 			c->btBody->setCollisionFlags(c->btBody->getCollisionFlags() | btCollisionObject::CF_NO_CONTACT_RESPONSE);
@@ -550,7 +1250,6 @@ bool World::LoadObject(std::string path) {
 			c->btBody->setCollisionFlags(c->btBody->getCollisionFlags() | btCollisionObject::CF_CUSTOM_MATERIAL_CALLBACK);
 		}
  	}
-	objects.push_back(o);
 
 	return true;
 }
@@ -11,6 +11,7 @@
 #include "imgui_impl.h"
 #include "sound.h"
 #include "world.h"
+#include "benchmark.h"
 
 class Engine {
 
@@ -22,6 +23,8 @@ public:
 	bool Initialize(std::vector<std::string> args);
 	// run the game loop
 	void Run();
+	// render a scripted, fixed-timestep run offscreen and report frame timings
+	void RunHeadless();
 	// process SDL events
 	void Events();
 	// get time delta in milliseconds since last frame
@@ -29,6 +32,9 @@ public:
   
 private:
 
+	// simulate and render a single frame over dT
+	void Frame(double dT);
+
 	// process SDL keyboard events
 	void KeyboardEvts();
 	// process SDL mouse events
@@ -53,6 +59,7 @@ private:
 	World* m_world;
 	
 	// Timing
+	Benchmark m_benchmark;
 	double m_DT = 0.0;
 	uint64_t perfcounter = 0;
 	bool m_running = false;
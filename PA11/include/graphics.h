@@ -23,8 +23,8 @@ public:
 	Graphics();
 	~Graphics();
 
-	// setup openGL
-	bool Initialize(int width, int height);
+	// setup openGL - headless renders into an offscreen framebuffer instead of the window
+	bool Initialize(int width, int height, bool headless = false);
 	
 	// update camera simulation
 	void Update(float dT);
@@ -52,14 +52,21 @@ public:
 	glm::mat4 GetProj();
 	// set the window width & height
 	void UpdateWH(int w, int h);
+	// place the camera along the scripted benchmark path, t in [0, 1)
+	void FollowCameraPath(float t);
 
 private:
 
 	int w, h;
 
+	// offscreen render target for headless mode
+	bool CreateOffscreenTarget();
+	bool headless = false;
+	GLuint offscreen_fbo = 0, offscreen_color = 0, offscreen_depth = 0;
+
 	// cubemap
 	bool CreateCubeMap(std::string file);
-	GLuint cubemap_tex = 0, cubemap_vbo = 0, cubemap_vao = 0, scene_VAO = 0;
+	GLuint cubemap_tex = 0, cubemap_vbo = 0, cubemap_vao = 0;
 	Shader *m_cubemap_shader = nullptr;
 	
 	// cameras
@@ -27,7 +27,8 @@ private:
 
 	struct Mesh {
 
-		GLuint VBO, IBO;
+		// VAO holds the buffer bindings and attribute layout, configured once at load
+		GLuint VAO, VBO, IBO;
 
 		std::vector<Vertex> 		vertices;
 		std::vector<unsigned int> 	indices;
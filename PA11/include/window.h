@@ -13,6 +13,8 @@ public:
 
 	// create window & openGL context
 	bool Initialize(const string &name, int* width, int* height);
+	// create an offscreen openGL context with no window or display (EGL surfaceless)
+	bool InitializeHeadless(int width, int height);
 	// swap window buffers 
 	void Swap();
 
@@ -24,6 +26,11 @@ public:
 private:
 	SDL_Window* gWindow;
 	SDL_GLContext gContext;
+
+	// EGLDisplay / EGLContext for headless mode - kept opaque so EGL headers stay out of the engine
+	bool headless;
+	void* eglDisplay;
+	void* eglContext;
 };
 
 #endif /* WINDOW_H */
@@ -12,7 +12,7 @@ FreeCamera::FreeCamera() {
 	btRigidBody::btRigidBodyConstructionInfo btBodyCTI(mass, btMotionState, btShape, btInertia);
 	btBody = new btRigidBody(btBodyCTI);
 
-	btBody->setActivationState(DISABLE_DEACTIVATION);
+	// allowed to sleep while standing still, PlayerMovement wakes it when it's given somewhere to go
 	btBody->setLinearVelocity(btVector3(0,0,0));
 	btBody->setRestitution(0);
 
@@ -32,16 +32,23 @@ Engine::~Engine() {
 
 bool Engine::Initialize(std::vector<std::string> args) {
 
+	m_benchmark.ParseArgs(args);
+
   	// Start a window
 	m_window = new Window();
-	if(!m_window->Initialize(m_WINDOW_NAME, &w, &h)) {
+	if(m_benchmark.headless) {
+		if(!m_window->InitializeHeadless(w, h)) {
+			std::cerr << "The headless context failed to initialize." << std::endl;
+			return false;
+		}
+	} else if(!m_window->Initialize(m_WINDOW_NAME, &w, &h)) {
 		std::cerr << "The window failed to initialize." << std::endl;
 		return false;
 	}
 
 	// Start the graphics
 	m_graphics = new Graphics();
-	if(!m_graphics->Initialize(w, h)) {
+	if(!m_graphics->Initialize(w, h, m_benchmark.headless)) {
 		std::cerr << "The graphics failed to initialize." << std::endl;
 		return false;
 	}
@@ -57,8 +64,10 @@ bool Engine::Initialize(std::vector<std::string> args) {
 
 	ImGui_ImplSdlGL3_Init(m_window->GetWindow());
 
-	SDL_CaptureMouse(SDL_TRUE);
-	SDL_ShowCursor(SDL_FALSE);
+	if(!m_benchmark.headless) {
+		SDL_CaptureMouse(SDL_TRUE);
+		SDL_ShowCursor(SDL_FALSE);
+	}
 
 	// No errors
 	return true;
@@ -66,6 +75,11 @@ bool Engine::Initialize(std::vector<std::string> args) {
 
 void Engine::Run() {
 
+	if(m_benchmark.headless) {
+		RunHeadless();
+		return;
+	}
+
 	m_running = true;
 	m_world->StartGenerating();
 
@@ -77,27 +91,54 @@ void Engine::Run() {
 		m_DT = getDT();
 		Events();
 
-		ImGui::Begin("Menu", nullptr, ImGuiWindowFlags_AlwaysAutoResize);
-		ImGui::Text("Frametime: %f", m_DT);
-		ImGui::Text("FPS: %f", 1.0 / m_DT);
-		ImGui::End();
+		Frame(m_DT);
+		m_window->Swap();
+	}
+}
 
-		m_graphics->Update(m_DT);
-		m_graphics->Clear();
-		m_graphics->RenderSkybox();
+void Engine::RunHeadless() {
 
-		ShaderInfo info = m_graphics->BeginWorld();
-		m_world->Simulate(m_DT);
-		m_world->Render(info);
+	ImGui::GetIO().DisplaySize = ImVec2((float)w, (float)h);
+	m_world->StartGenerating();
 
-		info = m_graphics->BeginScene();
-		m_world->RenderPlayer(info);
+	// fixed timestep so every run simulates and renders the same frames
+	const double dT = 1.0 / 60.0;
 
-		m_graphics->UI();
-		m_world->UI();
-		m_graphics->EndRender();
-		m_window->Swap();
+	while(!m_benchmark.Done()) {
+
+		m_benchmark.BeginFrame();
+		ImGui_ImplSdlGL3_NewFrame(nullptr);
+
+		m_graphics->FollowCameraPath(m_benchmark.Progress());
+		Frame(dT);
+
+		m_benchmark.EndFrame(w, h);
 	}
+
+	m_benchmark.Report();
+}
+
+void Engine::Frame(double dT) {
+
+	ImGui::Begin("Menu", nullptr, ImGuiWindowFlags_AlwaysAutoResize);
+	ImGui::Text("Frametime: %f", dT);
+	ImGui::Text("FPS: %f", 1.0 / dT);
+	ImGui::End();
+
+	m_graphics->Update(dT);
+	m_graphics->Clear();
+	m_graphics->RenderSkybox();
+
+	ShaderInfo info = m_graphics->BeginWorld();
+	m_world->Simulate(dT);
+	m_world->Render(info);
+
+	info = m_graphics->BeginScene();
+	m_world->RenderPlayer(info);
+
+	m_graphics->UI();
+	m_world->UI();
+	m_graphics->EndRender();
 }
 
 void Engine::Events() {
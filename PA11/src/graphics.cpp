@@ -1,5 +1,7 @@
 
 #include "graphics.h"
+#include "benchmark.h"
+#include "glstate.h"
 #include <imgui.h>
 #include <stb_image.h>
 #include <SDL2/SDL.h>
@@ -69,8 +71,6 @@ ShaderInfo Graphics::BeginScene() {
 	ShaderInfo ret;
 	ret.shader = m_scene_shader;
 
-	glBindVertexArray(scene_VAO);
-
 	m_scene_shader->Enable();
 
 	glUniformMatrix4fv(m_scene_shader->GetUniformLocation("proj"), 1, GL_FALSE, glm::value_ptr(free_camera.GetProjection(w, h))); 
@@ -97,9 +97,14 @@ Graphics::~Graphics() {
 	}
 
 	glDeleteBuffers(1, &cubemap_vbo);
-	glDeleteTextures(1, &cubemap_tex);
-	glDeleteVertexArrays(1, &cubemap_vao);
-	glDeleteVertexArrays(1, &scene_VAO);
+	GLState::DeleteTexture(cubemap_tex);
+	GLState::DeleteVertexArray(cubemap_vao);
+
+	if(offscreen_fbo) {
+		glDeleteFramebuffers(1, &offscreen_fbo);
+		glDeleteRenderbuffers(1, &offscreen_color);
+		glDeleteRenderbuffers(1, &offscreen_depth);
+	}
 }
 
 bool Graphics::ReloadShaders() {
@@ -201,13 +206,21 @@ bool Graphics::ReloadShaders() {
 	return true;
 }
 
-bool Graphics::Initialize(int width, int height) {
+bool Graphics::Initialize(int width, int height, bool _headless) {
 
 	glewExperimental = GL_TRUE;
 
 	w = width; h = height;
+	headless = _headless;
 	auto status = glewInit();
 
+#ifdef GLEW_ERROR_NO_GLX_DISPLAY
+	// an EGL context has no GLX display, but the core GL entry points are still loaded
+	if(headless && status == GLEW_ERROR_NO_GLX_DISPLAY) {
+		status = GLEW_OK;
+	}
+#endif
+
 	// This is here to grab the error that comes from glew init.
 	// This error is an GL_INVALID_ENUM that has no effects on the performance
 	glGetError();
@@ -228,6 +241,10 @@ bool Graphics::Initialize(int width, int height) {
 		return false;
 	}
 
+	if(headless && !CreateOffscreenTarget()) {
+		return false;
+	}
+
 	// Set up the shaders
 	if(!ReloadShaders()) {
 		return false;
@@ -239,11 +256,9 @@ bool Graphics::Initialize(int width, int height) {
 	}
 
 	//enable depth testing
-	glEnable(GL_DEPTH_TEST);
+	GLState::Enable(GL_DEPTH_TEST, true);
 	free_camera.LoadModel();
 
-	glGenVertexArrays(1, &scene_VAO);
-
 	return true;
 }
 
@@ -258,10 +273,10 @@ bool Graphics::CreateCubeMap(std::string file) {
 	glGenVertexArrays(1, &cubemap_vao);
 	glGenTextures(1, &cubemap_tex);
 
-	glBindVertexArray(cubemap_vao);
-	glBindBuffer(GL_ARRAY_BUFFER, cubemap_vbo);
-	glBindTexture(GL_TEXTURE_CUBE_MAP, cubemap_tex);
 	glActiveTexture(GL_TEXTURE0);
+	GLState::BindVertexArray(cubemap_vao);
+	glBindBuffer(GL_ARRAY_BUFFER, cubemap_vbo);
+	GLState::BindTexture(GL_TEXTURE_CUBE_MAP, cubemap_tex);
 
 	glBufferData(GL_ARRAY_BUFFER, 3 * 36 * sizeof(float), &cubemap_points, GL_STATIC_DRAW);
 
@@ -290,11 +305,58 @@ bool Graphics::CreateCubeMap(std::string file) {
 	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 	glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
 
-	glBindVertexArray(0);
+	GLState::BindVertexArray(0);
+
+	return true;
+}
+
+bool Graphics::CreateOffscreenTarget() {
+
+	glGenFramebuffers(1, &offscreen_fbo);
+	glGenRenderbuffers(1, &offscreen_color);
+	glGenRenderbuffers(1, &offscreen_depth);
+
+	glBindRenderbuffer(GL_RENDERBUFFER, offscreen_color);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, w, h);
+	glBindRenderbuffer(GL_RENDERBUFFER, offscreen_depth);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, w, h);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, offscreen_fbo);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, offscreen_color);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, offscreen_depth);
+
+	if(glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+		std::cerr << "Offscreen framebuffer incomplete" << std::endl;
+		return false;
+	}
+
+	// everything (including reads for PNG output) goes through this framebuffer from now on
+	glViewport(0, 0, w, h);
+	glScissor(0, 0, w, h);
 
 	return true;
 }
 
+void Graphics::FollowCameraPath(float t) {
+
+	// fly a slow circle over the terrain, looking along the direction of travel
+	float angle = glm::radians(360.0f * t);
+	glm::vec3 pos = glm::vec3(8.0f + 48.0f * cos(angle), 140.0f, 8.0f + 48.0f * sin(angle));
+
+	btTransform transform(btQuaternion(0,0,0,1), btVector3(pos.x, pos.y, pos.z));
+	free_camera.btMotionState->setWorldTransform(transform);
+	free_camera.btBody->setWorldTransform(transform);
+	free_camera.btBody->setLinearVelocity(btVector3(0,0,0));
+	free_camera.btBody->activate();
+
+	// flying keeps World::PlayerMovement from applying gravity to the scripted camera
+	free_camera.flying = true;
+	free_camera.yaw = 360.0f * t + 90.0f;
+	free_camera.pitch = -30.0f;
+	free_camera.update();
+}
+
 void Graphics::MoveCamera(int dx, int dy) {
 
 	free_camera.move(dx, dy);
@@ -302,6 +364,9 @@ void Graphics::MoveCamera(int dx, int dy) {
 
 void Graphics::Clear() {
 
+	// a frame starts here
+	GLState::ResetCounters();
+
 	glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 }
@@ -323,16 +388,16 @@ void Graphics::UpdateWH(int _w, int _h) {
 
 void Graphics::RenderSkybox() {
 
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-	glDepthMask(GL_FALSE);
-	glBindVertexArray(cubemap_vao);
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_CUBE_MAP, cubemap_tex);
+	GLState::BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	GLState::DepthMask(false);
+	GLState::BindVertexArray(cubemap_vao);
+	GLState::BindTexture(GL_TEXTURE_CUBE_MAP, cubemap_tex);
 	m_cubemap_shader->Enable();
 	glUniformMatrix4fv(m_cubemap_shader->GetUniformLocation("proj"), 1, GL_FALSE, glm::value_ptr(free_camera.GetProjection(w, h)));
 	glUniformMatrix4fv(m_cubemap_shader->GetUniformLocation("view"), 1, GL_FALSE, glm::value_ptr(free_camera.GetViewWithoutTranslate()));
 	glDrawArrays(GL_TRIANGLES, 0, 36);
-	glDepthMask(GL_TRUE);
+	Benchmark::draw_calls++;
+	GLState::DepthMask(true);
 }
 
 void Graphics::UI() {
@@ -343,6 +408,7 @@ void Graphics::UI() {
 	ImGui::SliderFloat("FOV", &free_camera.fov, 10.0f, 150.0f);
 	ImGui::Checkbox("Lock", &free_camera.lock);
 	ImGui::SliderFloat("Speed", &free_camera.speed, 5.0f, 100.0f);
+	ImGui::Text("GL state changes: %u (%u skipped)", GLState::last_changes, GLState::last_skipped);
 	ImGui::Separator();
 	ImGui::End();
 }
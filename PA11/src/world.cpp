@@ -1,5 +1,7 @@
 
 #include "world.h"
+#include "benchmark.h"
+#include "glstate.h"
 #include <iostream>
 #include <dirent.h>
 #include <sys/stat.h>
@@ -30,7 +32,7 @@ Chunk::~Chunk() {
 		glDeleteBuffers(1, &VBO);
 	}
 	if(VAO) {
-		glDeleteVertexArrays(1, &VAO);
+		GLState::DeleteVertexArray(VAO);
 	}
 
 	if(hasPhysics) DeletePhysics();
@@ -85,13 +87,13 @@ void Chunk::Render(ShaderInfo info, const std::vector<light>& near_lights) {
 	glm::mat4 transform = glm::translate(glm::mat4(1.0f), glm::vec3(pos.x * CHUNK_SIZE_XZ, 0, pos.z * CHUNK_SIZE_XZ));
 	glUniformMatrix4fv(model_loc, 1, GL_FALSE, glm::value_ptr(transform));
 
-	glBindVertexArray(VAO);
+	GLState::BindVertexArray(VAO);
 	if(info.wireframe) {
 		glDrawArrays(GL_LINES, 0, buffered_quads * 6);
 	} else {
 		glDrawArrays(GL_TRIANGLES, 0, buffered_quads * 6);
 	}
-	glBindVertexArray(0);
+	Benchmark::draw_calls++;
 }
 
 void Chunk::Generate() {
@@ -148,7 +150,7 @@ void Chunk::OpenGL() {
 	}
 	glGenBuffers(1, &VBO);
 
-	glBindVertexArray(VAO);
+	GLState::BindVertexArray(VAO);
 	glBindBuffer(GL_ARRAY_BUFFER, VBO);
 	glBufferData(GL_ARRAY_BUFFER, mesh.size() * sizeof(vertex), mesh.data(), GL_STATIC_DRAW);
 	mesh.clear();
@@ -390,7 +392,7 @@ World::World(FreeCamera* c, int* _w, int* _h) : pool(4) {
 
 	glGenTextures(1, &textures);
 	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D_ARRAY, textures);
+	GLState::BindTexture(GL_TEXTURE_2D_ARRAY, textures);
 	glTexStorage3D(GL_TEXTURE_2D_ARRAY, 1, GL_RGBA8, 32, 32, 255);
 	LoadTextures();
 	glTexParameteri(GL_TEXTURE_2D_ARRAY,GL_TEXTURE_MIN_FILTER,GL_NEAREST);
@@ -570,13 +572,12 @@ bool World::LoadTexture(std::string file, int index) {
 	GLuint copy_because_imgui;
 	glGenTextures(1, &copy_because_imgui);
 	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, copy_because_imgui);
+	GLState::BindTexture(GL_TEXTURE_2D, copy_because_imgui);
 	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, bitmap);
 	glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MIN_FILTER,GL_NEAREST);
 	glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MAG_FILTER,GL_NEAREST);
 	glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_WRAP_S,GL_CLAMP_TO_EDGE);
 	glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_WRAP_T,GL_CLAMP_TO_EDGE);
-	glBindTexture(GL_TEXTURE_2D, 0);
 	textures_as_a_list.push_back(copy_because_imgui);
 
 	stbi_image_free(bitmap);
@@ -586,9 +587,9 @@ bool World::LoadTexture(std::string file, int index) {
 
 World::~World() {
 
-	glDeleteTextures(1, &textures);
+	GLState::DeleteTexture(textures);
 	for(auto t : textures_as_a_list) {
-		glDeleteTextures(1, &t);
+		GLState::DeleteTexture(t);
 	}
 
 	for(auto& c : chunks) {
@@ -676,6 +677,15 @@ void World::UI() {
 
 	ImGui::Text("Chunks: %d", num_chunks);
 	ImGui::Text("Quads: %d", num_quads);
+
+	int awake = 0, asleep = 0, fixed = 0;
+	for(int i = 0; i < btWorld->getNumCollisionObjects(); i++) {
+		btCollisionObject* o = btWorld->getCollisionObjectArray()[i];
+		if(o->isStaticObject()) fixed++;
+		else if(o->isActive()) awake++;
+		else asleep++;
+	}
+	ImGui::Text("Bodies: %d awake, %d asleep, %d static", awake, asleep, fixed);
 	ImGui::Text("Camera: %f %f %f", cam->pos.x, cam->pos.y, cam->pos.z);
 	ImGui::SliderInt("View Distance: ", &view_distance, 0, 16);
 	ImGui::End();
@@ -967,6 +977,10 @@ void World::PlayerMovement(double dT) {
     }
   }
 
+  // setting a velocity doesn't wake a sleeping body
+  if(target != glm::vec3(0, 0, 0)) {
+    cam->btBody->activate();
+  }
   cam->btBody->setLinearVelocity(btVector3(target.x, target.y, target.z));
 }
 